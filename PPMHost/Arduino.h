@@ -0,0 +1,212 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * Minimal stand-in for the Arduino core.
+ *
+ * Only what is needed to compile the hardware independent parts of
+ * PPMInspect (PPMDecoder and friends, TextUI and the screens) on a Linux host.
+ * The AVR registers PPM.cpp uses are modelled below, so host tools can run
+ * its ISRs and scan control against register states they set up.
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+
+#define PROGMEM
+#define F(s) ((const __FlashStringHelper *)(s))
+/* For TextUI */
+#define TEXTUI_FLASH_STRINGS
+
+#define PGM_P const char *
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_ptr(p) (*(void * const *)(p))
+
+#define bit(b) (1UL << (b))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+/* Serial output goes to stderr */
+class HardwareSerial {
+
+    public:
+        void begin(unsigned long) {}
+        int availableForWrite() { return 63; }
+        size_t write(uint8_t) { return 1; }
+        size_t write(const uint8_t *, size_t n) { return n; }
+        size_t print(const char *s) { return fprintf(stderr, "%s", s); }
+        size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+        size_t print(char c) { return fprintf(stderr, "%c", c); }
+        size_t print(long v) { return fprintf(stderr, "%ld", v); }
+        size_t print(unsigned long v) { return fprintf(stderr, "%lu", v); }
+        size_t print(int v) { return print((long)v); }
+        size_t print(unsigned v) { return print((unsigned long)v); }
+        size_t println() { return print('\n'); }
+        template <typename T> size_t println(T v) { return print(v) + println(); }
+};
+
+inline HardwareSerial Serial;
+
+/* Simulated time, host tools advance it */
+inline unsigned long hostMillis = 0;
+
+inline unsigned long millis() { return hostMillis; }
+inline void delay(unsigned long ms) { hostMillis += ms; }
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+#define A0     14
+#define A3     17
+
+/* Digital pins read hostPins, bit n is pin n */
+inline uint32_t hostPins = 0;
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return (hostPins >> pin) & 1; }
+
+/* Interrupts never preempt host code, atomic blocks run once */
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for (uint8_t _atomic = 1; _atomic; _atomic = 0)
+
+/* Interrupt handlers are plain functions the host tools call */
+#define ISR(vector) void vector(void)
+
+enum {
+    PRADC = 0,
+    REFS0 = 6, ADLAR = 5,
+    ADEN = 7, ADSC = 6, ADATE = 5, ADIF = 4, ADIE = 3, ADPS2 = 2, ADPS1 = 1, ADPS0 = 0,
+    ADTS2 = 2, ADTS1 = 1, ADTS0 = 0,
+    ICNC1 = 7, ICES1 = 6, WGM13 = 4, WGM12 = 3, CS12 = 2, CS11 = 1, CS10 = 0,
+    ICIE1 = 5, OCIE1B = 2, OCIE1A = 1, TOIE1 = 0,
+    ICF1 = 5, OCF1B = 2, OCF1A = 1, TOV1 = 0,
+    PCIE0 = 0, PCIF0 = 0,
+    PCINT0 = 0, PCINT1 = 1, PCINT2 = 2, PCINT3 = 3, PCINT4 = 4, PCINT5 = 5
+};
+
+/*
+ * AVR I/O register. Every write is passed to hostRegHook, so host tools can
+ * check the order of register writes. Every read is announced to hostRegRead
+ * first, so a simulated timer can run on while an ISR executes.
+ * Interrupt flags are cleared by writing a one. In the flag registers "|="
+ * clears only the bits written, like SBI on the ATmega328P. ADCSRA is out of
+ * SBI reach, "|=" and "&=" write back a set ADIF and clear it.
+ */
+inline void (*hostRegHook)(const char *name, uint16_t value) = nullptr;
+inline void (*hostRegRead)(const char *name) = nullptr;
+
+class HostReg {
+
+    public:
+        HostReg(const char *regName, uint16_t flagBits = 0, bool bitAccess = false)
+            : name(regName), flags(flagBits), sbi(bitAccess) {}
+
+        operator uint16_t() const {
+            if (hostRegRead) {
+                hostRegRead(name);
+            }
+            return value;
+        }
+
+        HostReg &operator=(unsigned long v) { write((uint16_t)v); return *this; }
+        HostReg &operator=(const HostReg &r) { write(r.value); return *this; }
+        HostReg &operator|=(unsigned long v) { write(sbi ? (uint16_t)v : (uint16_t)(value | v)); return *this; }
+        HostReg &operator&=(unsigned long v) { write((uint16_t)(value & v)); return *this; }
+        HostReg &operator^=(unsigned long v) { write((uint16_t)(value ^ v)); return *this; }
+        HostReg &operator+=(unsigned long v) { write((uint16_t)(value + v)); return *this; }
+
+        /* Set by the simulated hardware, not logged */
+        uint16_t value = 0;
+        const char *name;
+
+    private:
+        /* Bits cleared by writing a one */
+        uint16_t flags;
+        bool sbi;
+
+        void write(uint16_t v) {
+            if (hostRegHook) {
+                hostRegHook(name, v);
+            }
+            value = (value & flags & ~v) | (v & ~flags);
+        }
+};
+
+#define HOST_REG(r)        inline HostReg r(#r)
+#define HOST_FLAG_REG(r)   inline HostReg r(#r, 0xffff, true)
+
+HOST_REG(PRR);
+HOST_REG(ADMUX);
+inline HostReg ADCSRA("ADCSRA", bit(ADIF));
+HOST_REG(ADCSRB);
+HOST_REG(DIDR0);
+HOST_REG(ADC);
+HOST_REG(TCCR1A);
+HOST_REG(TCCR1B);
+HOST_REG(TCCR1C);
+HOST_REG(TCNT1);
+HOST_REG(ICR1);
+HOST_REG(OCR1A);
+HOST_REG(OCR1B);
+HOST_REG(TIMSK1);
+HOST_FLAG_REG(TIFR1);
+HOST_REG(PINB);
+HOST_REG(DDRB);
+HOST_REG(PORTB);
+HOST_REG(PCICR);
+HOST_REG(PCMSK0);
+HOST_FLAG_REG(PCIFR);
+
+#define ADCL    ((uint8_t)(uint16_t)ADC)
+#define ADCH    ((uint8_t)((uint16_t)ADC >> 8))
+#define ICR1L   ((uint8_t)(uint16_t)ICR1)
+#define ICR1H   ((uint8_t)((uint16_t)ICR1 >> 8))
+
+#define _SFR_MEM_ADDR(r)  0
+#define _SFR_IO_ADDR(r)   0
+
+#ifndef _BV
+#define _BV(b) (1 << (b))
+#endif
+
+#endif
@@ -0,0 +1,290 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * Stand-in for PPMInspect/PPM.cpp on the host.
+ *
+ * Screens get a synthetic 8 channel PPM signal instead of the hardware.
+ * The channels move slowly with millis(). Only what the screens in
+ * ppmlcd need is implemented, there is no deep capture.
+ * hostInterrupts() counts the interrupts the running scan would take.
+ */
+
+#include <math.h>
+
+#include "PPM.h"
+
+#define HOST_CHANNELS          8
+#define HOST_FRAME_USEC    22500
+#define HOST_PULSE_USEC      300
+#define HOST_SERVO_PERIOD  20000
+/* ADC counts, 15 V is about 255 */
+#define HOST_ADC_HIGH         85
+#define HOST_ADC_LOW           3
+
+/* Input interrupts per second of the running scan or scope */
+static uint32_t hostIrqRate = 0;
+
+static ppmstats_t hostStats;
+static forensic_t hostForensic;
+static latency_t hostLatency;
+static uint8_t hostMin[SCOPE_SAMPLES];
+static uint8_t hostPre;
+static uint8_t hostShadow[2 * SCOPE_SAMPLES];
+
+static uint16_t channelUsec(uint8_t ch, unsigned long msec) {
+
+    return 1500 + (int16_t)(400.0 * sin(msec / 1000.0 * (ch + 1) / 4));
+}
+
+/* Signal level at t usec after the start of a frame */
+static bool ppmLevel(unsigned long msec, uint32_t t) {
+
+    uint32_t start = 0;
+
+    for (uint8_t ch = 0; ch <= HOST_CHANNELS; ch++) {
+        if (t >= start && t < start + HOST_PULSE_USEC) {
+            return false;
+        }
+        if (ch < HOST_CHANNELS) {
+            start += channelUsec(ch, msec);
+        }
+    }
+    return true;
+}
+
+/* Interrupts from fromMsec to toMsec, for the wakeup count of ppmlcd */
+uint32_t hostInterrupts(unsigned long fromMsec, unsigned long toMsec) {
+
+    return (uint64_t)hostIrqRate * (toMsec - fromMsec) / 1000;
+}
+
+void PPM::startPPMScan() {
+
+    /* Capture interrupt on both edges of every pulse */
+    hostIrqRate = 2 * (HOST_CHANNELS + 1) * 1000000UL / HOST_FRAME_USEC;
+
+    memset(&ppm[exportSet], 0, sizeof(ppm_t));
+}
+
+ppm_t *PPM::getPPM() {
+
+    ppm_t *p = &ppm[exportSet];
+    unsigned long msec = millis();
+
+    p->sync = true;
+    p->channels = HOST_CHANNELS;
+    p->frameMin_usec = p->frameMax_usec = HOST_FRAME_USEC;
+    p->pulseMin_us10 = p->pulseMax_us10 = HOST_PULSE_USEC * 10;
+    p->vLevel_low = 2;
+    p->vLevel_high = 50;
+    p->vLevelMin_low = 1;
+    p->vLevelMax_low = 3;
+    p->vLevelMin_high = 49;
+    p->vLevelMax_high = 51;
+    p->pulseLevel = false;
+    p->frames = msec * 1000 / HOST_FRAME_USEC;
+
+    for (uint8_t ch = 0; ch < HOST_CHANNELS; ch++) {
+        uint16_t v = channelUsec(ch, msec);
+        uint16_t v10 = v * 10;
+
+        p->channel_us10[ch] = v10;
+        if (p->channelMin_us10[ch] == 0 || v10 < p->channelMin_us10[ch]) {
+            p->channelMin_us10[ch] = v10;
+        }
+        if (v10 > p->channelMax_us10[ch]) {
+            p->channelMax_us10[ch] = v10;
+        }
+        hostStats.mean_q8[ch] = (uint32_t)v * 256;
+    }
+
+    return p;
+}
+
+const ppmstats_t *PPM::getPPMStats() {
+
+    return &hostStats;
+}
+
+const forensic_t *PPM::getForensic() {
+
+    return &hostForensic;
+}
+
+void PPM::rearmForensic() {
+
+    memset(&hostForensic, 0, sizeof(hostForensic));
+}
+
+void PPM::startPWMScan() {
+
+    hostIrqRate = 2 * 1000000UL / HOST_SERVO_PERIOD;
+
+    memset(&pwm[exportSet], 0, sizeof(pwm_t));
+}
+
+pwm_t *PPM::getPWM() {
+
+    pwm_t *p = &pwm[exportSet];
+    unsigned long msec = millis();
+    uint32_t frames = msec * 1000 / HOST_SERVO_PERIOD;
+
+    p->sync = true;
+    p->frameMin_usec = p->frameMax_usec = HOST_SERVO_PERIOD;
+
+    /* Fill the history up to the current frame */
+    while (p->frames < frames) {
+        uint16_t h = channelUsec(0, p->frames * HOST_SERVO_PERIOD / 1000);
+
+        p->frames++;
+        p->lastUsed = (p->lastUsed + 1) % PWM_HISTORY;
+        p->pulseH_us10[p->lastUsed] = (uint32_t)h * 10;
+        p->pulseL_us10[p->lastUsed] = (uint32_t)(HOST_SERVO_PERIOD - h) * 10;
+    }
+
+    return p;
+}
+
+void PPM::startServoScan() {
+
+    /* Pin change interrupt on both edges of every output */
+    hostIrqRate = 2 * SERVO_CHANNELS * 1000000UL / HOST_SERVO_PERIOD;
+
+    memset(&servo[exportSet], 0, sizeof(servo_t));
+}
+
+/* SERVO_CHANNELS outputs one after the other, 2 msec apart */
+servo_t *PPM::getServo() {
+
+    servo_t *p = &servo[exportSet];
+    unsigned long msec = millis();
+
+    p->active = SERVO_PIN_MASK;
+    p->reference = 0;
+    p->frames = msec * 1000 / HOST_SERVO_PERIOD;
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        int32_t skew_us10 = (int32_t)ch * 20000 + (msec % 7);
+
+        p->ch[ch].pulse_us10 = channelUsec(ch, msec) * 10;
+        p->ch[ch].period_usec = HOST_SERVO_PERIOD;
+        p->ch[ch].skew_us10 = ch ? skew_us10 : 0;
+        p->ch[ch].skewMin_us10 = ch ? skew_us10 - 3 : 0;
+        p->ch[ch].skewMax_us10 = ch ? skew_us10 + 4 : 0;
+        p->rank[ch] = ch + 1;
+    }
+
+    return p;
+}
+
+void PPM::startLatencyScan(uint8_t channel) {
+
+    startPPMScan();
+    /* and the PWM output */
+    hostIrqRate += 2 * 1000000UL / HOST_SERVO_PERIOD;
+    memset(&hostLatency, 0, sizeof(latency_t));
+    hostLatency.channel = channel;
+}
+
+/* A change every 500 msec, 12 - 17 msec later on the output, one in 20 missed */
+const latency_t *PPM::getLatency() {
+
+    latency_t *p = &hostLatency;
+    unsigned long msec = millis();
+
+    p->ppm_us10 = channelUsec(p->channel, msec) * 10;
+    p->pwm_us10 = p->ppm_us10;
+    p->changes = msec / 500;
+    p->missed = p->changes / 20;
+    p->matched = p->changes - p->missed;
+    p->last_usec = 12000 + (msec * 7) % 5000;
+    p->min_usec = 12000;
+    p->max_usec = 17000;
+    p->sum_usec = p->matched * 14500UL;
+    p->sumCount = p->matched;
+
+    for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+        p->hist[b] = (b >= 6 && b <= 8) ? p->matched / (1 + (b & 1)) : 0;
+    }
+
+    return p;
+}
+
+void PPM::stopScan() {
+
+    hostIrqRate = 0;
+}
+
+void PPM::sendArray(const uint8_t dataArray[], const adcblock_t *blk) {
+}
+
+/* Every call returns a capture triggered at the start of the frame */
+boolean PPM::fetchArray(uint8_t dataArray[], uint8_t minArray[], uint8_t sz, const scopeparam_t *param) {
+
+    unsigned long msec = millis();
+    uint32_t t;
+
+    /* ADC interrupt per sample, the trigger search runs faster */
+    hostIrqRate = 1000000UL / param->resUsec;
+    hostPre = (uint16_t)sz * param->pretrigger / 100;
+
+    for (uint8_t i = 0; i < sz; i++) {
+        t = ((uint32_t)i * param->resUsec + param->triggerDelay) % HOST_FRAME_USEC;
+        dataArray[i] = ppmLevel(msec, t) ? HOST_ADC_HIGH : HOST_ADC_LOW;
+        if (minArray) {
+            minArray[i] = dataArray[i];
+        }
+    }
+
+    return true;
+}
+
+uint32_t PPM::deepWindow(uint32_t first, uint16_t step, uint8_t dataArray[], uint8_t minArray[], uint8_t sz) {
+
+    return 0;
+}
+
+void PPM::stopScope() {
+
+    hostIrqRate = 0;
+}
+
+/* Where the screen puts the marker, the capture itself has no pre-trigger */
+uint8_t PPM::getScopePre() {
+
+    return hostPre;
+}
+
+uint8_t *PPM::getMinArray() {
+
+    return hostMin;
+}
+
+uint8_t *PPM::getGridShadow() {
+
+    return hostShadow;
+}
@@ -0,0 +1,314 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmadc
+ *
+ * Runs the ADC request scheduling (PPMInspect/AdcQueue.h) against a
+ * simulated ADC, like PPM scan with the voltmeter and the battery check
+ * active. Checks that
+ *  - PPM level sampling waits for at most one other conversion,
+ *  - voltmeter and Vcc requests wait for at most three conversions,
+ *  - every result is handed to the type that requested it,
+ *  - requests made while the scope owns the ADC run after release().
+ *
+ * Compares with the former blocking readADC()/readVCC(), which skipped PPM
+ * level samples while the ADC was busy and stalled loop() until the
+ * conversion was done.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmadc PPMAdc.cpp
+ *
+ * Usage:
+ *   ppmadc [-t msec] [-l loop usec] [-s scope msec]
+ *
+ * Time is simulated in usec. loop() passes every loop usec plus the time
+ * it stalls. With -s the scope takes the ADC for scope msec every second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "AdcQueue.h"
+
+/* 13 ADC clocks at 125 kHz */
+#define SIM_CONVERT_USEC     104
+/* Vcc check interval of checkBattery() */
+#define SIM_VCC_USEC      500000L
+
+typedef struct stats_t {
+    uint32_t started;
+    uint32_t merged;
+    uint32_t maxWait;
+} stats_t;
+
+/* The ADC and the ADC ISR */
+class SimAdc {
+
+    public:
+        SimAdc(AdcQueue &q) : queue(q) {}
+
+        uint32_t doneAt = 0;
+        uint8_t type = ADC_IDLE;
+        uint32_t requested[ADCQ_LAST + 1] = {};
+        stats_t stats[ADCQ_LAST + 1] = {};
+        uint16_t seq = 0;
+
+        /* Start what the queue returned */
+        void start(uint8_t t, uint32_t now) {
+
+            if (t == ADC_IDLE) {
+                return;
+            }
+            if (type != ADC_IDLE) {
+                fprintf(stderr, "%u: type %u started while %u converts\n", now, t, type);
+                exit(1);
+            }
+            if (now - requested[t] > stats[t].maxWait) {
+                stats[t].maxWait = now - requested[t];
+            }
+            stats[t].started++;
+            type = t;
+            doneAt = now + SIM_CONVERT_USEC;
+        }
+
+        void request(uint8_t t, uint32_t now) {
+
+            if (queue.isPending(t)) {
+                stats[t].merged++;
+            }
+            else {
+                requested[t] = now;
+            }
+            start(queue.request(t), now);
+        }
+
+        /* The ISR. The result tells the type it belongs to. */
+        void run(uint32_t now) {
+
+            if (type != ADC_IDLE && doneAt <= now) {
+                uint16_t v = type * 1000 + seq++ % 1000;
+                type = ADC_IDLE;
+                start(queue.done(v), now);
+            }
+        }
+
+    private:
+        AdcQueue &queue;
+};
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-t msec] [-l loop usec] [-s scope msec]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint32_t msec = 10000;
+    uint32_t loopUsec = 300;
+    uint32_t scopeMsec = 0;
+    AdcQueue queue;
+    SimAdc adc(queue);
+    uint32_t now = 0;
+    uint32_t nextEdge = 0;
+    uint32_t nextLoop = 0;
+    uint32_t nextVcc = 0;
+    uint32_t scopeUntil = 0;
+    uint32_t nextScope = 0;
+    uint32_t scopes = 0;
+    bool edges = false;
+    bool scope = false;
+    uint32_t vmResults = 0;
+    uint32_t vccResults = 0;
+    uint32_t loops = 0;
+    int errors = 0;
+    uint16_t v;
+    uint8_t t;
+
+    /* The former blocking code */
+    uint32_t oldDoneAt = 0;
+    uint32_t oldSkipped = 0;
+    uint32_t oldSamples = 0;
+    uint32_t oldStall = 0;
+    uint32_t oldMaxStall = 0;
+    uint32_t oldLoops = 0;
+    uint32_t oldNextLoop = 0;
+    bool oldEdges = false;
+
+    while ((opt = getopt(argc, argv, "t:l:s:")) != -1) {
+        switch (opt) {
+        case 't': msec = atoi(optarg); break;
+        case 'l': loopUsec = atoi(optarg); break;
+        case 's': scopeMsec = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (msec == 0 || loopUsec == 0 || scopeMsec >= 1000) {
+        fprintf(stderr, "msec > 0, loop usec > 0, scope msec < 1000\n");
+        return 1;
+    }
+
+    srand(1);
+
+    for (now = 0; now < msec * 1000; now++) {
+
+        /* PPM edges, pulses and channels of 0.3 to 2.1 msec */
+        if (now >= nextEdge) {
+            edges = oldEdges = true;
+            nextEdge = now + 300 + rand() % 1800;
+        }
+
+        adc.run(now);
+
+        /* Scope acquisition every second */
+        if (scopeMsec) {
+            /* fetchArray() tries again while a conversion runs */
+            if (!scope && now >= nextScope && queue.claim()) {
+                scope = true;
+                scopeUntil = now + scopeMsec * 1000;
+                scopes++;
+                nextScope += 1000000;
+            }
+            if (scope && now >= scopeUntil) {
+                scope = false;
+                adc.start(queue.release(), now);
+            }
+        }
+
+        if (now >= nextLoop) {
+            loops++;
+            nextLoop = now + loopUsec;
+
+            /* processEdges() */
+            if (edges && !scope) {
+                adc.request(ADC_PPM, now);
+                edges = false;
+            }
+
+            /* VMeterScreen::update() */
+            if (queue.fetch(ADC_VM, &v)) {
+                if (v / 1000 != ADC_VM) {
+                    fprintf(stderr, "%u: voltmeter got a result of type %u\n", now, v / 1000);
+                    errors++;
+                }
+                vmResults++;
+            }
+            adc.request(ADC_VM, now);
+
+            /* checkBattery() */
+            if (queue.fetch(ADC_VCC, &v)) {
+                if (v / 1000 != ADC_VCC) {
+                    fprintf(stderr, "%u: Vcc got a result of type %u\n", now, v / 1000);
+                    errors++;
+                }
+                vccResults++;
+            }
+            if (now >= nextVcc) {
+                adc.request(ADC_VCC, now);
+                nextVcc = now + SIM_VCC_USEC;
+            }
+        }
+
+        /* Former code: PPM sample skipped if the ADC is busy, readADC() waits */
+        if (now >= oldNextLoop) {
+            uint32_t stall = 0;
+
+            oldLoops++;
+
+            if (oldEdges) {
+                if (oldDoneAt > now) {
+                    oldSkipped++;
+                }
+                else {
+                    oldSamples++;
+                    oldDoneAt = now + SIM_CONVERT_USEC;
+                }
+                oldEdges = false;
+            }
+
+            if (oldDoneAt > now) {
+                stall = oldDoneAt - now;
+            }
+            stall += SIM_CONVERT_USEC;
+            oldDoneAt = now + stall;
+
+            oldStall += stall;
+            if (stall > oldMaxStall) {
+                oldMaxStall = stall;
+            }
+            oldNextLoop = now + stall + loopUsec;
+        }
+    }
+
+    /* No more requests. Everything pending must complete. */
+    if (scope) {
+        adc.start(queue.release(), now);
+    }
+    for (uint32_t end = now + 4 * SIM_CONVERT_USEC; now < end; now++) {
+        adc.run(now);
+    }
+    if (!queue.idle()) {
+        fprintf(stderr, "requests left over\n");
+        errors++;
+    }
+
+    if (!scopeMsec && adc.stats[ADC_PPM].maxWait > SIM_CONVERT_USEC) {
+        fprintf(stderr, "PPM level waited %u usec\n", adc.stats[ADC_PPM].maxWait);
+        errors++;
+    }
+    for (t = ADC_VM; t <= ADCQ_LAST; t++) {
+        if (!scopeMsec && adc.stats[t].maxWait > 3 * SIM_CONVERT_USEC) {
+            fprintf(stderr, "type %u waited %u usec\n", t, adc.stats[t].maxWait);
+            errors++;
+        }
+    }
+    if (scopeMsec && adc.stats[ADC_VCC].maxWait > scopeMsec * 1000 + 3 * SIM_CONVERT_USEC) {
+        fprintf(stderr, "Vcc waited %u usec for the scope\n", adc.stats[ADC_VCC].maxWait);
+        errors++;
+    }
+
+    printf("queue:   %u loops, no stall, %u scope acquisitions\n", loops, scopes);
+    printf("  PPM    %7u conversions, %6u merged, max wait %6u usec\n",
+        adc.stats[ADC_PPM].started, adc.stats[ADC_PPM].merged, adc.stats[ADC_PPM].maxWait);
+    printf("  VM     %7u conversions, %6u results, max wait %6u usec\n",
+        adc.stats[ADC_VM].started, vmResults, adc.stats[ADC_VM].maxWait);
+    printf("  Vcc    %7u conversions, %6u results, max wait %6u usec\n",
+        adc.stats[ADC_VCC].started, vccResults, adc.stats[ADC_VCC].maxWait);
+    printf("blocking: %u loops, stalled %u msec, max %u usec\n", oldLoops, oldStall / 1000, oldMaxStall);
+    printf("  PPM    %7u conversions, %6u skipped\n", oldSamples, oldSkipped);
+
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,430 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMAdcOrder
+ *
+ * Checks the register write order of the scope sampling in PPM.cpp on a Linux host.
+ *
+ * The scope runs the ADC auto triggered by Timer 1 compare match B. PPM.cpp is
+ * compiled against the register model in Arduino.h and every register write
+ * is checked against the state of the model right before it:
+ *
+ * - Auto trigger (ADATE) only gets enabled with compare match B as trigger
+ *   source, OCR1B set and no stale compare match B flag.
+ * - The trigger source is never switched while auto triggering.
+ * - Timer 1 only starts with TCNT1 and OCR1A in CTC mode set, OCR1B as well
+ *   with auto trigger, and no stale compare match B flag.
+ * - The capture interrupt only gets enabled with no stale capture flag.
+ * - OCR1B is only moved ahead of the running counter.
+ * - The ADC only gets disabled after the capture interrupt and Timer 1 are.
+ *
+ * A simulated compare match B starts each conversion, its ISR runs a few
+ * ticks later. On top, each path has its own order: ADC_vect clears OCF1B
+ * first and the trigger resets TCNT1 before it moves OCR1A and OCR1B.
+ *
+ * Runs a triggered capture, equivalent time sampling with one late edge,
+ * and stopScope() while armed and between ETS passes.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmadcorder PPMAdcOrder.cpp PPMHost.cpp ../PPMInspect/PPM.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/ServoDecoder.cpp ../PPMInspect/LatencyMeter.cpp ../PPMInspect/EdgeStream.cpp
+ *
+ * Usage:
+ *   ppmadcorder [-v]
+ *
+ * -v prints the register writes of every path.
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "PPM.h"
+
+extern PPM ppm;
+
+ISR(ADC_vect);
+ISR(TIMER1_CAPT_vect);
+
+/* Timer 1 runs on by this much per register write */
+#define ORDER_WRITE_TICKS      1
+/* From compare match B to the ADC ISR: 13 ADC clocks at 8 MHz plus latency */
+#define ORDER_ADC_TICKS        6
+/* From the edge to the capture ISR reading TCNT1 */
+#define ORDER_CAPT_TICKS       8
+/* PPM frame, edges for ETS */
+#define ORDER_FRAME_TICKS  45000
+/* Too late for the first sample of any pass */
+#define ORDER_LATE_TICKS     200
+
+/* ETS at 2 usec takes 5 */
+#define ORDER_MAX_PASSES      20
+
+/* Register writes of one path */
+#define ORDER_MAX_WRITES      48
+
+#define TIMER1_CLOCK   (bit(CS12) | bit(CS11) | bit(CS10))
+#define ADC_AUTO       (bit(ADEN) | bit(ADATE))
+#define TRIGGER_OCF1B  (bit(ADTS2) | bit(ADTS0))
+
+static const char *pathName = "";
+static const char *writeName[ORDER_MAX_WRITES];
+static uint16_t writeValue[ORDER_MAX_WRITES];
+static uint8_t writes;
+
+static bool verbose = false;
+static uint32_t failed;
+
+static void fail(const char *what) {
+
+    printf("FAIL %s: %s\n", pathName, what);
+    failed++;
+}
+
+static bool timerRunning() {
+    return (TCCR1B.value & TIMER1_CLOCK) != 0;
+}
+
+static bool autoTrigger() {
+    return (ADCSRA.value & ADC_AUTO) == ADC_AUTO;
+}
+
+/* Index of the first write to reg in the current path, -1 if none */
+static int8_t firstWrite(const char *reg) {
+
+    for (uint8_t i = 0; i < writes; i++) {
+        if (!strcmp(writeName[i], reg)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Both written, a first */
+static void order(const char *a, const char *b) {
+
+    int8_t ia = firstWrite(a);
+    int8_t ib = firstWrite(b);
+    char what[64];
+
+    if (ia < 0 || ib < 0 || ia > ib) {
+        snprintf(what, sizeof(what), "%s is not written before %s", a, b);
+        fail(what);
+    }
+}
+
+static void beginPath(const char *name) {
+
+    pathName = name;
+    writes = 0;
+}
+
+static void endPath() {
+
+    if (!verbose) {
+        return;
+    }
+    printf("%-20s", pathName);
+    for (uint8_t i = 0; i < writes; i++) {
+        printf(" %s=%02x", writeName[i], writeValue[i]);
+    }
+    printf("\n");
+}
+
+/* Checks a write against the model, which still holds the old value */
+static void regWrite(const char *name, uint16_t v) {
+
+    if (writes < ORDER_MAX_WRITES) {
+        writeName[writes] = name;
+        writeValue[writes] = v;
+        writes++;
+    }
+
+    if (!strcmp(name, "ADCSRA")) {
+
+        if ((v & ADC_AUTO) == ADC_AUTO && !autoTrigger()) {
+            if (ADCSRB.value != TRIGGER_OCF1B) {
+                fail("auto trigger enabled before the trigger source is compare match B");
+            }
+            if (TIFR1.value & bit(OCF1B)) {
+                fail("auto trigger enabled with compare match B pending");
+            }
+            if (firstWrite("OCR1B") < 0) {
+                fail("auto trigger enabled before OCR1B is set");
+            }
+        }
+        if (!(v & bit(ADEN)) && (ADCSRA.value & bit(ADEN))) {
+            if (timerRunning()) {
+                fail("ADC disabled before Timer 1 is stopped");
+            }
+            if (TIMSK1.value & bit(ICIE1)) {
+                fail("ADC disabled before the capture interrupt");
+            }
+        }
+    }
+    else if (!strcmp(name, "ADCSRB")) {
+        if (autoTrigger() && v != ADCSRB.value) {
+            fail("trigger source switched while auto triggering");
+        }
+    }
+    else if (!strcmp(name, "TCCR1B")) {
+        if ((v & TIMER1_CLOCK) && !timerRunning()) {
+            if (firstWrite("TCNT1") < 0) {
+                fail("Timer 1 started before TCNT1 is set");
+            }
+            if (autoTrigger() && firstWrite("OCR1B") < 0) {
+                fail("Timer 1 started with auto trigger before OCR1B is set");
+            }
+            if ((v & bit(WGM12)) && firstWrite("OCR1A") < 0) {
+                fail("Timer 1 started in CTC mode before OCR1A is set");
+            }
+            if (TIFR1.value & bit(OCF1B)) {
+                fail("Timer 1 started with compare match B pending");
+            }
+        }
+    }
+    else if (!strcmp(name, "TIMSK1")) {
+        if ((v & bit(ICIE1)) && !(TIMSK1.value & bit(ICIE1)) && (TIFR1.value & bit(ICF1))) {
+            fail("capture interrupt enabled with a stale capture pending");
+        }
+    }
+    else if (!strcmp(name, "OCR1B")) {
+        if (timerRunning() && (uint16_t)(v - TCNT1.value) >= 0x8000) {
+            fail("OCR1B set behind the running counter");
+        }
+    }
+
+    if (timerRunning()) {
+        TCNT1.value += ORDER_WRITE_TICKS;
+    }
+}
+
+/*
+ * Compare match B starts a conversion, the ADC ISR runs with the result v.
+ * Returns false if the conversion never starts.
+ */
+static bool convert(uint8_t v) {
+
+    if (!timerRunning() || !autoTrigger()) {
+        return false;
+    }
+    if (TIFR1.value & bit(OCF1B)) {
+        /* Auto trigger needs a rising flag */
+        fail("compare match B flag still set, no conversion");
+        return false;
+    }
+    TIFR1.value |= bit(OCF1B);
+    /* In CTC mode compare match B at TOP restarts the counter */
+    TCNT1.value = ((TCCR1B.value & bit(WGM12)) ? 0 : OCR1B.value) + ORDER_ADC_TICKS;
+    ADC.value = (uint16_t)v << 8;
+
+    /* The ISR clears ADIF on entry */
+    beginPath("ADC_vect");
+    ADC_vect();
+    if (writes == 0 || strcmp(writeName[0], "TIFR1") || !(writeValue[0] & bit(OCF1B))) {
+        fail("OCF1B is not cleared first");
+    }
+    if (firstWrite("TCNT1") >= 0) {
+        /* Trigger */
+        order("TCNT1", "OCR1A");
+        order("TCNT1", "OCR1B");
+    }
+    endPath();
+
+    return true;
+}
+
+/* Free running Timer 1 runs on, compare match B sets its flag */
+static void runTimer(uint32_t ticks) {
+
+    uint32_t toMatch = (uint16_t)(OCR1B.value - TCNT1.value);
+
+    if (ticks >= (toMatch ? toMatch : 0x10000)) {
+        TIFR1.value |= bit(OCF1B);
+    }
+    TCNT1.value += ticks;
+}
+
+/* Edge after ticks, the capture ISR runs elapsed ticks later */
+static void edge(uint32_t ticks, uint16_t elapsed) {
+
+    runTimer(ticks);
+    ICR1.value = TCNT1.value;
+    runTimer(elapsed);
+
+    beginPath(elapsed < ORDER_LATE_TICKS ? "TIMER1_CAPT_vect" : "late edge");
+    TIMER1_CAPT_vect();
+    if (elapsed >= ORDER_LATE_TICKS && writes) {
+        fail("late edge starts a pass");
+    }
+    endPath();
+}
+
+/* Conversions of one pass or capture */
+static uint32_t convertAll(uint8_t v) {
+
+    uint32_t n = 0;
+
+    while (n <= SCOPE_SAMPLES && convert(v)) {
+        n++;
+    }
+    return n;
+}
+
+/* Left over from an aborted capture */
+static void staleFlags() {
+
+    TIFR1.value = bit(ICF1) | bit(OCF1B) | bit(OCF1A) | bit(TOV1);
+}
+
+static void start(const scopeparam_t *param) {
+
+    static uint8_t data[SCOPE_SAMPLES];
+
+    beginPath("start");
+    ppm.fetchArray(data, ppm.getMinArray(), SCOPE_SAMPLES, param);
+    endPath();
+}
+
+static void stop(const char *name) {
+
+    beginPath(name);
+    ppm.stopScope();
+    order("TIMSK1", "TCCR1B");
+    order("TCCR1B", "ADCSRA");
+    if (timerRunning() || autoTrigger() || (TIMSK1.value & bit(ICIE1))) {
+        fail("still sampling");
+    }
+    endPath();
+}
+
+static void stopped(uint32_t samples, uint32_t expect) {
+
+    char what[64];
+
+    beginPath("complete");
+    if (timerRunning() || autoTrigger() || (TIMSK1.value & bit(ICIE1))) {
+        fail("still sampling");
+    }
+    if (samples != expect) {
+        snprintf(what, sizeof(what), "%u samples, expected %u", samples, expect);
+        fail(what);
+    }
+}
+
+/* Rising trigger at the second sample, then the sample period */
+static void runTriggered() {
+
+    scopeparam_t param = { 20, 0, 50, ACQ_OS_OFF, ACQ_TRIGGER_RISING, 0 };
+    uint32_t samples = 0;
+
+    /* Scope memory is taken from a running scan */
+    hostRegHook = nullptr;
+    ppm.startPPMScan();
+    hostRegHook = regWrite;
+    staleFlags();
+    start(&param);
+
+    /* Below and above 5V */
+    convert(0);
+    samples = 1 + convertAll(255);
+    stopped(samples, SCOPE_SAMPLES);
+
+    printf("triggered: %u conversions\n", samples);
+
+    /* Stop while armed */
+    staleFlags();
+    start(&param);
+    convert(0);
+    stop("stopScope armed");
+}
+
+/* Equivalent time sampling at 2 usec, 5 passes */
+static void runETS() {
+
+    scopeparam_t param = { 2, 0, 50, ACQ_OS_OFF, ACQ_TRIGGER_RISING, 0 };
+    uint32_t samples = 0;
+    uint32_t passes = 0;
+
+    staleFlags();
+    start(&param);
+    if (autoTrigger()) {
+        fail("auto trigger enabled before the first edge");
+    }
+
+    /* Between passes the timer runs past the old OCR1B */
+    while (timerRunning() && passes < ORDER_MAX_PASSES) {
+        edge(ORDER_FRAME_TICKS, ORDER_LATE_TICKS);
+        edge(ORDER_FRAME_TICKS, ORDER_CAPT_TICKS);
+        if (!autoTrigger()) {
+            fail("edge does not start a pass");
+            break;
+        }
+        passes++;
+        samples += convertAll(128);
+        if (autoTrigger()) {
+            fail("auto trigger still enabled after the pass");
+            break;
+        }
+    }
+    stopped(samples, SCOPE_SAMPLES);
+
+    printf("ETS: %u passes, %u conversions\n", passes, samples);
+
+    /* Stop between passes */
+    staleFlags();
+    start(&param);
+    edge(ORDER_FRAME_TICKS, ORDER_CAPT_TICKS);
+    convertAll(128);
+    stop("stopScope ETS");
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        switch (opt) {
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    setDefaults();
+    hostRegHook = regWrite;
+
+    runTriggered();
+    runETS();
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PPMCap.h"
+
+/********* Writer **********/
+
+bool PPMCapWriter::open(const char *fname, uint8_t mode, const config_t &cfg, uint32_t tick_nsec, uint32_t startTicks) {
+
+    close();
+
+    file = fopen(fname, "wb");
+    if (file == nullptr) {
+        perror(fname);
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PPMCAP_MAGIC, sizeof(header.magic));
+    header.version = PPMCAP_VERSION;
+    header.headerSize = sizeof(ppmcap_header_t);
+    header.mode = mode;
+    header.tick_nsec = tick_nsec;
+    header.startTicks = startTicks;
+    header.pulseValidMin_usec = cfg.pulseValidMin_usec;
+    header.pulseValidMax_usec = cfg.pulseValidMax_usec;
+    header.servoValidMin_usec = cfg.servoValidMin_usec;
+    header.servoValidMax_usec = cfg.servoValidMax_usec;
+    header.syncValidMin_usec = cfg.syncValidMin_usec;
+
+    lastTicks = startTicks;
+    len = 0;
+
+    /* records stays 0 until close() */
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool PPMCapWriter::flush() {
+
+    if (len > 0 && fwrite(buf, 1, len, file) != len) {
+        perror("ppmcap write");
+        return false;
+    }
+    len = 0;
+
+    return true;
+}
+
+bool PPMCapWriter::edge(uint32_t ticks, uint8_t flags) {
+
+    if (len > sizeof(buf) - EDGESTREAM_RECORD_MAX && !flush()) {
+        return false;
+    }
+
+    len += edgeStreamEncode(&buf[len], ticks - lastTicks, flags);
+
+    if (!(flags & EDGE_NONE)) {
+        lastTicks = ticks;
+    }
+    header.records++;
+
+    return true;
+}
+
+bool PPMCapWriter::adcBlock(uint32_t msec, const adcblock_t *blk, const uint8_t *samples) {
+
+    if (len > sizeof(buf) - (sizeof(msec) + sizeof(adcblock_t) + 255) && !flush()) {
+        return false;
+    }
+
+    memcpy(&buf[len], &msec, sizeof(msec));
+    len += sizeof(msec);
+    memcpy(&buf[len], blk, sizeof(adcblock_t));
+    len += sizeof(adcblock_t);
+    memcpy(&buf[len], samples, blk->count);
+    len += blk->count;
+
+    header.records++;
+
+    return true;
+}
+
+bool PPMCapWriter::close() {
+
+    bool ok;
+
+    if (file == nullptr) {
+        return true;
+    }
+
+    ok = flush()
+         && fseek(file, 0, SEEK_SET) == 0
+         && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+
+    return ok;
+}
+
+/********* Reader **********/
+
+bool PPMCapReader::open(const char *fname) {
+
+    struct stat st;
+    int fd;
+    void *m;
+
+    close();
+
+    fd = ::open(fname, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(fname);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    if ((size_t)st.st_size < sizeof(ppmcap_header_t)) {
+        fprintf(stderr, "%s: too short\n", fname);
+        ::close(fd);
+        return false;
+    }
+
+    m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (m == MAP_FAILED) {
+        perror(fname);
+        return false;
+    }
+
+    base = (const uint8_t *)m;
+    size = st.st_size;
+    madvise(m, size, MADV_SEQUENTIAL);
+
+    memcpy(&header, base, sizeof(header));
+
+    if (memcmp(header.magic, PPMCAP_MAGIC, sizeof(header.magic)) != 0
+        || header.headerSize < sizeof(ppmcap_header_t) || header.headerSize > size) {
+        fprintf(stderr, "%s: not a ppmcap file\n", fname);
+        close();
+        return false;
+    }
+
+    if (header.version > PPMCAP_VERSION) {
+        fprintf(stderr, "%s: version %u, newer fields are ignored\n", fname, header.version);
+    }
+
+    data = base + header.headerSize;
+    end = base + size;
+    rewind();
+
+    return true;
+}
+
+void PPMCapReader::close() {
+
+    if (base) {
+        munmap((void *)base, size);
+        base = nullptr;
+        size = 0;
+    }
+}
+
+void PPMCapReader::rewind() {
+
+    pos = data;
+    ticks = header.startTicks;
+}
+
+bool PPMCapReader::nextBlock(uint32_t *msec, const adcblock_t **blk, const uint8_t **samples) {
+
+    if ((size_t)(end - pos) < sizeof(uint32_t) + sizeof(adcblock_t)) {
+        return false;
+    }
+
+    memcpy(msec, pos, sizeof(uint32_t));
+    memcpy(&block, pos + sizeof(uint32_t), sizeof(adcblock_t));
+
+    if ((size_t)(end - pos) < sizeof(uint32_t) + sizeof(adcblock_t) + block.count) {
+        return false;
+    }
+
+    *blk = &block;
+    *samples = pos + sizeof(uint32_t) + sizeof(adcblock_t);
+    pos += sizeof(uint32_t) + sizeof(adcblock_t) + block.count;
+
+    return true;
+}
@@ -0,0 +1,146 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * .ppmcap capture files.
+ *
+ * File layout, all values little endian:
+ *
+ *   ppmcap_header_t
+ *   PPMCAP_MODE_EDGES: edge records as in PPMInspect/EdgeStream.h,
+ *                      the first delta refers to header.startTicks
+ *   PPMCAP_MODE_ADC:   blocks of uint32 msec, adcblock_t, count samples
+ *
+ * Readers must skip headerSize bytes, later versions may append fields.
+ * records is 0 if the writer did not close the file. Readers then read
+ * up to the end of the file.
+ */
+
+#ifndef _PPMCap_h_
+#define _PPMCap_h_
+
+#include <stdio.h>
+
+#include "PPMDecoder.h"
+#include "EdgeStream.h"
+
+#define PPMCAP_MAGIC        "PPMCAP\x1a\n"
+#define PPMCAP_VERSION      1
+
+#define PPMCAP_MODE_EDGES   1
+#define PPMCAP_MODE_ADC     2
+
+typedef struct ppmcap_header_t {
+    char     magic[8];
+    uint16_t version;
+    uint16_t headerSize;
+    uint8_t  mode;              /* PPMCAP_MODE_* */
+    uint8_t  reserved[3];
+    uint32_t tick_nsec;         /* Timer resolution, 500 for Timer 1 with prescaler /8 */
+    uint32_t startTicks;
+    uint64_t records;           /* Edges or ADC blocks */
+
+    /* config_t validity windows at capture time */
+    uint16_t pulseValidMin_usec;
+    uint16_t pulseValidMax_usec;
+    uint16_t servoValidMin_usec;
+    uint16_t servoValidMax_usec;
+    uint16_t syncValidMin_usec;
+    uint16_t reserved2[3];
+} ppmcap_header_t;
+
+static_assert(sizeof(ppmcap_header_t) == 48, "ppmcap header layout");
+
+class PPMCapWriter {
+
+    private:
+        FILE *file = nullptr;
+        ppmcap_header_t header;
+        uint32_t lastTicks;
+        uint8_t buf[64 * 1024];
+        size_t len;
+
+        bool flush();
+
+    public:
+        ~PPMCapWriter() { close(); }
+
+        bool open( const char *fname, uint8_t mode, const config_t &cfg, uint32_t tick_nsec, uint32_t startTicks);
+
+        /* flags are EDGE_* from EdgeRing.h */
+        bool edge( uint32_t ticks, uint8_t flags);
+        bool adcBlock( uint32_t msec, const adcblock_t *blk, const uint8_t *samples);
+
+        /* Writes the record count into the header */
+        bool close();
+};
+
+/* Reads .ppmcap files through mmap */
+class PPMCapReader {
+
+    private:
+        const uint8_t *base = nullptr;
+        size_t size = 0;
+        const uint8_t *data;
+        const uint8_t *pos;
+        const uint8_t *end;
+        ppmcap_header_t header;
+        uint32_t ticks;
+        adcblock_t block;
+
+    public:
+        ~PPMCapReader() { close(); }
+
+        bool open( const char *fname);
+        void close();
+
+        const ppmcap_header_t &getHeader() const { return header; }
+        size_t getSize() const { return size; }
+
+        /* Restart at the first record */
+        void rewind();
+
+        /* Next edge. Returns false at the end of the file. */
+        inline bool nextEdge( uint32_t *t, uint8_t *flags) {
+
+            uint32_t delta;
+            uint8_t n = edgeStreamDecode(pos, end, &delta, flags);
+
+            if (n == 0) {
+                return false;
+            }
+            pos += n;
+            ticks += delta;
+            *t = ticks;
+
+            return true;
+        }
+
+        /* Next ADC block. Returns false at the end of the file. */
+        bool nextBlock( uint32_t *msec, const adcblock_t **blk, const uint8_t **samples);
+};
+
+#endif
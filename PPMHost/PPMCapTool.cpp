@@ -0,0 +1,349 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmcap
+ *
+ * Create, inspect and convert .ppmcap capture files (see PPMCap.h).
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmcap PPMCapTool.cpp PPMCap.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmcap info file.ppmcap
+ *   ppmcap decode file.ppmcap          Decode edges with PPMDecoder
+ *   ppmcap vcd file.ppmcap out.vcd     Value change dump for waveform viewers
+ *   ppmcap csv file.ppmcap out.csv
+ *   ppmcap import edgefile out.ppmcap  Edge file of ppmreplay / ppmstream -o
+ *   ppmcap [-c channels] [-f frames] [-j jitter_usec] [-b badframe] gen out.ppmcap
+ *   ppmcap bench file.ppmcap           Parse and decode speed
+ *
+ * ppmstream -w writes .ppmcap files directly.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "PPMCap.h"
+
+/* Timer 1 with prescaler /8 */
+#define TICK_NSEC  500
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s info|decode|bench file.ppmcap\n"
+                    "       %s vcd|csv file.ppmcap out\n"
+                    "       %s import edgefile out.ppmcap\n"
+                    "       %s [-c channels] [-f frames] [-j jitter_usec] [-b badframe] gen out.ppmcap\n",
+            name, name, name, name);
+}
+
+static int info(PPMCapReader &reader) {
+
+    const ppmcap_header_t &h = reader.getHeader();
+
+    printf("version %u, %s, %zu bytes\n", h.version,
+           (h.mode == PPMCAP_MODE_EDGES) ? "edges" : (h.mode == PPMCAP_MODE_ADC) ? "adc blocks" : "unknown mode",
+           reader.getSize());
+    printf("tick %u nsec, start %u, records %" PRIu64 "%s\n", h.tick_nsec, h.startTicks, h.records,
+           h.records ? "" : " (not closed)");
+    printf("pulse %u - %u usec, servo %u - %u usec, sync > %u usec\n",
+           h.pulseValidMin_usec, h.pulseValidMax_usec, h.servoValidMin_usec, h.servoValidMax_usec, h.syncValidMin_usec);
+
+    return 0;
+}
+
+/* Use the validity windows of the capture */
+static void setCaptureSettings(const ppmcap_header_t &h) {
+
+    setDefaults();
+
+    settings.pulseValidMin_usec = h.pulseValidMin_usec;
+    settings.pulseValidMax_usec = h.pulseValidMax_usec;
+    settings.servoValidMin_usec = h.servoValidMin_usec;
+    settings.servoValidMax_usec = h.servoValidMax_usec;
+    settings.syncValidMin_usec = h.syncValidMin_usec;
+}
+
+static int decode(PPMCapReader &reader) {
+
+    HostPPM host;
+    uint32_t ticks;
+    uint8_t flags;
+
+    if (reader.getHeader().mode != PPMCAP_MODE_EDGES) {
+        fprintf(stderr, "no edges\n");
+        return 1;
+    }
+
+    setCaptureSettings(reader.getHeader());
+    host.reset(reader.getHeader().startTicks);
+
+    while (reader.nextEdge(&ticks, &flags)) {
+        host.edge(ticks, flags);
+    }
+
+    printPPM(&host.stableSet);
+    printForensic(host.getDecoder().getForensic());
+
+    return 0;
+}
+
+static int exportFile(PPMCapReader &reader, const char *outName, bool vcd) {
+
+    const ppmcap_header_t &h = reader.getHeader();
+    FILE *out = fopen(outName, "w");
+    uint32_t ticks, last;
+    uint8_t flags;
+    uint64_t t = 0;
+    uint32_t msec;
+    const adcblock_t *blk;
+    const uint8_t *samples;
+    uint32_t block = 0;
+
+    if (out == nullptr) {
+        perror(outName);
+        return 1;
+    }
+
+    if (vcd) {
+        fprintf(out, "$version PPMInspect ppmcap $end\n$timescale 1 ns $end\n$scope module ppminspect $end\n");
+        if (h.mode == PPMCAP_MODE_EDGES) {
+            fprintf(out, "$var wire 1 ! ppm $end\n$var event 1 \" timeout $end\n");
+        }
+        else {
+            fprintf(out, "$var real 64 # adc $end\n");
+        }
+        fprintf(out, "$upscope $end\n$enddefinitions $end\n");
+    }
+    else {
+        fprintf(out, (h.mode == PPMCAP_MODE_EDGES) ? "time_usec,level,timeout\n" : "block,time_usec,volt\n");
+    }
+
+    if (h.mode == PPMCAP_MODE_EDGES) {
+        last = h.startTicks;
+
+        while (reader.nextEdge(&ticks, &flags)) {
+            /* 64 bit time, ticks wrap at 32 bit */
+            t += ticks - last;
+            last = ticks;
+
+            if (vcd) {
+                if (flags & (EDGE_TIMEOUT | EDGE_LOST)) {
+                    fprintf(out, "#%" PRIu64 "\n1\"\n", t * h.tick_nsec);
+                }
+                if (!(flags & EDGE_NONE)) {
+                    fprintf(out, "#%" PRIu64 "\n%c!\n", t * h.tick_nsec, (flags & EDGE_LEVEL) ? '1' : '0');
+                }
+            }
+            else if (!(flags & EDGE_NONE)) {
+                fprintf(out, "%.1f,%u,%u\n", (double)(t * h.tick_nsec) / 1000.0,
+                        (flags & EDGE_LEVEL) ? 1 : 0, (flags & (EDGE_TIMEOUT | EDGE_LOST)) ? 1 : 0);
+            }
+        }
+    }
+    else {
+        while (reader.nextBlock(&msec, &blk, &samples)) {
+            for (uint8_t i = 0; i < blk->count; i++) {
+                t = (uint64_t)msec * 1000 + (uint64_t)i * blk->sample_usec;
+                if (vcd) {
+                    fprintf(out, "#%" PRIu64 "\nr%.3f #\n", t * 1000, samples[i] * blk->lsb_mV / 1000.0);
+                }
+                else {
+                    fprintf(out, "%u,%" PRIu64 ",%.3f\n", block, t, samples[i] * blk->lsb_mV / 1000.0);
+                }
+            }
+            block++;
+        }
+    }
+
+    return (fclose(out) == 0) ? 0 : 1;
+}
+
+static int import(const char *edgeName, const char *outName) {
+
+    std::vector<tickedge_t> edges;
+    PPMCapWriter writer;
+
+    if (!readEdges(edgeName, edges)) {
+        return 1;
+    }
+
+    setDefaults();
+
+    if (!writer.open(outName, PPMCAP_MODE_EDGES, settings, TICK_NSEC, edges.empty() ? 0 : edges[0].ticks)) {
+        return 1;
+    }
+
+    for (const tickedge_t &e : edges) {
+        writer.edge(e.ticks, e.level ? EDGE_LEVEL : 0);
+    }
+
+    return writer.close() ? 0 : 1;
+}
+
+/* Generate in chunks, so that large files do not need the edges in memory */
+static int gen(const char *outName, uint8_t channels, uint32_t frames, uint16_t jitter_usec, uint32_t badFrame) {
+
+    const uint32_t chunk = 10000;
+    std::vector<tickedge_t> edges;
+    PPMCapWriter writer;
+    uint32_t offset;
+
+    setDefaults();
+
+    if (!writer.open(outName, PPMCAP_MODE_EDGES, settings, TICK_NSEC, 0)) {
+        return 1;
+    }
+
+    for (uint32_t f = 0; f < frames; f += chunk) {
+        edges.clear();
+        generateEdges(channels, (frames - f < chunk) ? frames - f : chunk, jitter_usec,
+                      (badFrame >= f) ? badFrame - f : UINT32_MAX, edges);
+
+        /* 22.5 msec frames */
+        offset = f * 22500 * 2;
+        for (const tickedge_t &e : edges) {
+            if (!writer.edge(e.ticks + offset, e.level ? EDGE_LEVEL : 0)) {
+                return 1;
+            }
+        }
+    }
+
+    return writer.close() ? 0 : 1;
+}
+
+static int bench(PPMCapReader &reader) {
+
+    HostPPM host;
+    uint32_t ticks;
+    uint8_t flags;
+    uint64_t start, parse, total;
+    uint64_t edges = 0;
+    uint32_t sum = 0;
+    double mb = reader.getSize() / 1e6;
+
+    if (reader.getHeader().mode != PPMCAP_MODE_EDGES) {
+        fprintf(stderr, "no edges\n");
+        return 1;
+    }
+
+    setCaptureSettings(reader.getHeader());
+
+    /* Pass 1: parse only. First touch of the mapping is included. */
+    start = nowNsec();
+    while (reader.nextEdge(&ticks, &flags)) {
+        sum += ticks ^ flags;
+        edges++;
+    }
+    parse = nowNsec() - start;
+
+    /* Pass 2: parse and decode */
+    reader.rewind();
+    host.reset(reader.getHeader().startTicks);
+
+    start = nowNsec();
+    while (reader.nextEdge(&ticks, &flags)) {
+        host.edge(ticks, flags);
+    }
+    total = nowNsec() - start;
+
+    printf("%.1f MB, %" PRIu64 " edges, %.2f bytes/edge (checksum %08x)\n", mb, edges, reader.getSize() / (double)edges, sum);
+    printf("parse:          %7.1f MB/s %7.1f Medges/s\n", mb * 1e9 / parse, edges * 1e3 / parse);
+    printf("parse + decode: %7.1f MB/s %7.1f Medges/s, %u frames\n", mb * 1e9 / total, edges * 1e3 / total,
+           host.stableSet.frames);
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+    PPMCapReader reader;
+    const char *cmd;
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t frames = 1000;
+    uint16_t jitter_usec = 0;
+    uint32_t badFrame = UINT32_MAX;
+
+    while ((opt = getopt(argc, argv, "c:f:j:b:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'f': frames = atoi(optarg); break;
+        case 'j': jitter_usec = atoi(optarg); break;
+        case 'b': badFrame = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    cmd = argv[optind];
+
+    if (strcmp(cmd, "gen") == 0) {
+        if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS) {
+            fprintf(stderr, "channels must be %d - %d\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS);
+            return 1;
+        }
+        return gen(argv[optind + 1], channels, frames, jitter_usec, badFrame);
+    }
+
+    if (strcmp(cmd, "import") == 0) {
+        if (argc - optind < 3) {
+            usage(argv[0]);
+            return 1;
+        }
+        return import(argv[optind + 1], argv[optind + 2]);
+    }
+
+    if (!reader.open(argv[optind + 1])) {
+        return 1;
+    }
+
+    if (strcmp(cmd, "info") == 0) {
+        return info(reader);
+    }
+    if (strcmp(cmd, "decode") == 0) {
+        return decode(reader);
+    }
+    if (strcmp(cmd, "bench") == 0) {
+        return bench(reader);
+    }
+    if ((strcmp(cmd, "vcd") == 0 || strcmp(cmd, "csv") == 0) && argc - optind >= 3) {
+        return exportFile(reader, argv[optind + 2], cmd[0] == 'v');
+    }
+
+    usage(argv[0]);
+    return 1;
+}
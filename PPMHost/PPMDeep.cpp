@@ -0,0 +1,465 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmdeep
+ *
+ * Runs the deep capture (PPMInspect/CaptureStore.h) of the scope and the
+ * logic analyzer against a synthetic PPM or servo PWM signal.
+ * The scope part feeds ScopeAcq with conversions paced like Timer 1 does it,
+ * the logic part stores edge runs like sampleLogicDeep() in PPM.cpp.
+ * Checks that every sample decodes back to the signal, at every zoom step,
+ * and reports compression and decode time.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmdeep PPMDeep.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmdeep [-c channels] [-w] [-r res_usec] [-t f|+|-] [-s slew_usec] [-N noise_lsb] [-n captures]
+ *
+ * -w uses a 50 Hz servo PWM signal instead of PPM.
+ * -s ramps the analog level linearly over slew_usec after each edge.
+ * -N adds random noise of +- noise_lsb to every conversion.
+ * Decode times are host times, they only compare the access patterns.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "PPMHost.h"
+#include "ScopeAcq.h"
+#include "LogicAcq.h"
+
+/* Raw 8 bit ADC values, 15.3V == 255 */
+#define SIM_LOW      2
+#define SIM_HIGH    83
+
+/* Pixel per screen */
+#define SIM_PIXEL  128
+
+/* Decode runs per time measurement */
+#define SIM_BENCH_RUNS  200
+
+/* Positive 1 - 2 msec pulse every 20 msec */
+static void generatePWM(uint32_t frames, std::vector<tickedge_t> &edges) {
+
+    uint32_t t = 0;
+
+    for (uint32_t f = 0; f < frames; f++) {
+        edges.push_back({ t, true });
+        edges.push_back({ t + (1000 + (f * 37) % 1000) * 2, false });
+        t += 20000 * 2;
+    }
+}
+
+/* Signal level of an edge list, low before the first edge */
+static bool levelAt(const std::vector<tickedge_t> &edges, uint32_t t, uint32_t *since) {
+
+    auto it = std::upper_bound(edges.begin(), edges.end(), t,
+                               [](uint32_t v, const tickedge_t &e) { return v < e.ticks; });
+
+    if (it == edges.begin()) {
+        *since = UINT32_MAX;
+        return !edges.front().level;
+    }
+    --it;
+    *since = t - it->ticks;
+    return it->level;
+}
+
+/* Analog level with slew and noise */
+static uint8_t analogAt(const std::vector<tickedge_t> &edges, uint32_t t, uint32_t slew, int noise) {
+
+    uint32_t since;
+    bool level = levelAt(edges, t, &since);
+    int to = level ? SIM_HIGH : SIM_LOW;
+    int from = level ? SIM_LOW : SIM_HIGH;
+    int v = (since >= slew) ? to : from + (to - from) * (int)since / (int)slew;
+
+    if (noise) {
+        v += rand() % (2 * noise + 1) - noise;
+    }
+    return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+/* Compare all pixels of a window with the reference samples */
+static int checkWindow(const CaptureStore &store, const std::vector<uint8_t> &ref, uint32_t first, uint16_t step) {
+
+    uint8_t max[SIM_PIXEL];
+    uint8_t min[SIM_PIXEL];
+    uint8_t filled;
+    uint8_t hi;
+    uint8_t lo;
+    uint32_t samples = store.getSamples();
+    int errors = 0;
+
+    filled = store.window(first, step, SIM_PIXEL, max, min);
+
+    for (uint8_t p = 0; p < SIM_PIXEL; p++) {
+
+        uint32_t from = first + (uint32_t)p * step;
+        uint32_t to = std::min(from + step, samples);
+
+        if (from >= samples) {
+            if (p < filled || max[p] || min[p]) {
+                errors++;
+            }
+            continue;
+        }
+
+        hi = 0;
+        lo = 255;
+        for (uint32_t i = from; i < to; i++) {
+            hi = std::max(hi, ref[i]);
+            lo = std::min(lo, ref[i]);
+        }
+        if (max[p] != hi || min[p] != lo) {
+            if (errors++ < 3) {
+                fprintf(stderr, "window %u step %u pixel %u: %u - %u, expected %u - %u\n",
+                        first, step, p, min[p], max[p], lo, hi);
+            }
+        }
+    }
+
+    return errors;
+}
+
+/* Check valueAt() and nextChange() against the reference */
+static int checkValues(const CaptureStore &store, const std::vector<uint8_t> &ref) {
+
+    uint32_t samples = store.getSamples();
+    uint32_t next;
+    int errors = 0;
+
+    for (uint32_t i = 0; i < samples; i = next) {
+
+        next = store.nextChange(i);
+        if (store.valueAt(i) != ref[i]) {
+            errors++;
+        }
+        for (uint32_t j = i + 1; j < next && j < samples; j++) {
+            if (ref[j] != ref[i]) {
+                errors++;
+                break;
+            }
+        }
+        if (next < samples && ref[next] == ref[i]) {
+            errors++;
+        }
+        if (next <= i) {
+            return errors + 1;
+        }
+    }
+
+    return errors;
+}
+
+/* Mean host nsec of one full screen window decode */
+static uint64_t benchWindow(const CaptureStore &store, uint32_t first, uint16_t step) {
+
+    uint8_t max[SIM_PIXEL];
+    uint8_t min[SIM_PIXEL];
+    uint64_t t0 = nowNsec();
+    uint32_t sink = 0;
+
+    for (int r = 0; r < SIM_BENCH_RUNS; r++) {
+        sink += store.window(first, step, SIM_PIXEL, max, min) + max[r % SIM_PIXEL];
+    }
+
+    if (sink == 0) {
+        printf(" ");
+    }
+    return (nowNsec() - t0) / SIM_BENCH_RUNS;
+}
+
+/* Scope deep capture. Returns the number of errors, -1 if the signal ended. */
+static int scopeCapture(const std::vector<tickedge_t> &edges, const scopeparam_t *param,
+                        uint32_t slew, int noise, uint32_t *t, bool report) {
+
+    ScopeAcq acq;
+    std::vector<uint8_t> ref;
+    uint32_t period;
+    uint32_t samples;
+    uint8_t last = 0;
+    uint8_t v;
+    uint8_t ev;
+    bool running;
+    int errors = 0;
+
+    acq.start(SCOPE_SAMPLES, param);
+    period = acq.startTicks;
+
+    do {
+        *t += period;
+        if (*t >= edges.back().ticks) {
+            return -1;
+        }
+
+        v = analogAt(edges, *t, slew, noise);
+        running = (acq.state == ACQ_RUNNING);
+        ev = acq.sample(v);
+
+        if (ev == ACQ_EV_TRIGGER) {
+            ref.push_back(last);
+            ref.push_back(v);
+            period = acq.sampleTicks;
+        }
+        else if (running) {
+            ref.push_back(v);
+        }
+        last = v;
+
+    } while (ev != ACQ_EV_DONE);
+
+    const CaptureStore &store = *acq.getStore();
+    samples = store.getSamples();
+
+    if (samples > ref.size() || samples < 2) {
+        fprintf(stderr, "scope: %u samples stored, %zu taken\n", samples, ref.size());
+        return 1;
+    }
+
+    errors += checkValues(store, ref);
+    for (uint8_t zoom = 0; zoom <= 5; zoom++) {
+        uint16_t step = 1 << zoom;
+        for (uint32_t first = 0; first < samples; first += SIM_PIXEL / 2 * step) {
+            errors += checkWindow(store, ref, first, step);
+        }
+    }
+    /* Whole record on one screen */
+    errors += checkWindow(store, ref, 0, samples / SIM_PIXEL + 1);
+
+    if (report) {
+        printf("scope %u usec: %u samples (%.1f msec) in %u bytes, %.1f samples/byte\n",
+               param->resUsec, samples, samples * param->resUsec / 1000.0, store.getBytes(),
+               (double)samples / store.getBytes());
+        printf("  decode nsec: first screen %llu, last screen %llu, whole record %llu\n",
+               (unsigned long long)benchWindow(store, 0, 1),
+               (unsigned long long)benchWindow(store, samples > SIM_PIXEL ? samples - SIM_PIXEL : 0, 1),
+               (unsigned long long)benchWindow(store, 0, samples / SIM_PIXEL + 1));
+    }
+
+    return errors;
+}
+
+/* Logic analyzer deep capture like sampleLogicDeep(). Returns the number of errors, -1 if the signal ended. */
+static int logicCapture(const std::vector<tickedge_t> &edges, uint8_t triggerMode, uint32_t *t, bool report) {
+
+    LogicAcq logic;
+    std::vector<uint32_t> expect;
+    uint32_t start;
+    uint32_t last;
+    uint32_t end;
+    uint32_t since;
+    uint32_t n;
+    uint32_t i;
+    uint32_t k;
+    uint32_t samples;
+    uint32_t found = 0;
+    uint8_t level;
+    uint64_t t0;
+    int errors = 0;
+
+    logic.rate = LOGIC_RATE_DEEP;
+    logic.triggerMode = triggerMode;
+    logic.startCycles = 0;
+    logic.store.begin(logic.bits, sizeof(logic.bits));
+
+    /* Start at the next trigger edge, or anywhere without trigger */
+    k = std::upper_bound(edges.begin(), edges.end(), *t,
+                         [](uint32_t v, const tickedge_t &e) { return v < e.ticks; }) - edges.begin();
+    if (triggerMode != ACQ_TRIGGER_FREE) {
+        while (k < edges.size() && edges[k].level != (triggerMode == ACQ_TRIGGER_RISING)) {
+            k++;
+        }
+        if (k >= edges.size()) {
+            return -1;
+        }
+        start = edges[k].ticks;
+        level = edges[k].level;
+        k++;
+    }
+    else {
+        start = *t;
+        level = levelAt(edges, start, &since);
+    }
+
+    last = start;
+    end = start + LOGIC_DEEP_MSEC * 2000UL;
+
+    for (;; k++) {
+
+        if (k >= edges.size()) {
+            return -1;
+        }
+
+        bool full = false;
+        uint32_t e = std::min(edges[k].ticks, end);
+
+        /* Long runs before Timer 1 wraps */
+        while (e - last >= 0x8000 && !full) {
+            full = !logic.store.putRun(level, 0x8000);
+            last += 0x8000;
+        }
+        if (full || !logic.store.putRun(level, e - last)) {
+            break;
+        }
+        if (e == end) {
+            break;
+        }
+        expect.push_back(e - start);
+        level ^= 1;
+        last = e;
+    }
+    *t = last;
+
+    samples = logic.getSamples();
+
+    /* Every stored edge at its tick */
+    for (i = logic.nextEdge(0); i < samples; i = logic.nextEdge(i)) {
+        if (found >= expect.size() || expect[found] != i) {
+            if (errors++ < 3) {
+                fprintf(stderr, "logic: edge %u at %u, expected %u\n", found, i,
+                        found < expect.size() ? expect[found] : 0);
+            }
+        }
+        found++;
+    }
+    /* The last edge may be lost if the store is full */
+    n = std::count_if(expect.begin(), expect.end(), [samples](uint32_t e) { return e < samples; });
+    if (found != n) {
+        fprintf(stderr, "logic: %u edges, expected %u\n", found, n);
+        errors++;
+    }
+
+    if (report) {
+        t0 = nowNsec();
+        for (int r = 0; r < SIM_BENCH_RUNS; r++) {
+            n = 0;
+            for (i = logic.nextEdge(0); i < samples; i = logic.nextEdge(i)) {
+                n++;
+            }
+        }
+        printf("logic deep: %u edges in %.2f msec, %u bytes, %.2f bytes/edge, %u bytes packed at 2 MHz\n",
+               n, samples / 2000.0, logic.store.getBytes(), n ? (double)logic.store.getBytes() / n : 0.0,
+               (samples + 7) / 8);
+        printf("  decode nsec: all edges %llu, whole record %llu\n",
+               (unsigned long long)((nowNsec() - t0) / SIM_BENCH_RUNS),
+               (unsigned long long)benchWindow(logic.store, 0, samples / SIM_PIXEL + 1));
+    }
+
+    return errors;
+}
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-c channels] [-w] [-r res_usec] [-t f|+|-] [-s slew_usec] [-N noise_lsb] [-n captures]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    std::vector<tickedge_t> edges;
+    scopeparam_t param;
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t captures = 10;
+    uint16_t slew_usec = 0;
+    int noise = 0;
+    bool pwm = false;
+
+    uint32_t t = 0;
+    int errors;
+    uint32_t failed = 0;
+
+    param.resUsec = 10;
+    param.oversampling = ACQ_OS_DEEP;
+    param.triggerMode = ACQ_TRIGGER_RISING;
+    param.triggerLevel = 20;
+    param.triggerDelay = 0;
+    param.pretrigger = 0;
+
+    while ((opt = getopt(argc, argv, "c:wr:t:s:N:n:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'w': pwm = true; break;
+        case 'r': param.resUsec = atoi(optarg); break;
+        case 't':
+            param.triggerMode = (optarg[0] == '+') ? ACQ_TRIGGER_RISING
+                              : (optarg[0] == '-') ? ACQ_TRIGGER_FALLING : ACQ_TRIGGER_FREE;
+            break;
+        case 's': slew_usec = atoi(optarg); break;
+        case 'N': noise = atoi(optarg); break;
+        case 'n': captures = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || param.resUsec < SCOPE_ARM_USEC
+        || captures == 0 || noise < 0 || noise > 31) {
+        fprintf(stderr, "channels must be %d - %d, res_usec >= %d, noise 0 - 31\n",
+                PPM_MIN_CHANNELS, PPM_MAX_CHANNELS, SCOPE_ARM_USEC);
+        return 1;
+    }
+
+    setDefaults();
+    srand(1);
+
+    /* Each capture takes up to SCOPE_DEEP_SAMPLES * res_usec and LOGIC_DEEP_MSEC */
+    uint32_t frames = captures * ((uint32_t)SCOPE_DEEP_SAMPLES * param.resUsec / 20000 + LOGIC_DEEP_MSEC / 20 + 4);
+    if (pwm) {
+        generatePWM(frames, edges);
+    }
+    else {
+        generateEdges(channels, frames, 0, UINT32_MAX, edges);
+    }
+
+    for (uint32_t c = 0; c < captures; c++) {
+        errors = scopeCapture(edges, &param, slew_usec * 2U, noise, &t, c == 0);
+        if (errors < 0) {
+            fprintf(stderr, "capture %u: signal ended\n", c);
+            return 1;
+        }
+        failed += errors ? 1 : 0;
+    }
+    printf("scope: %u captures, %u failed\n", captures, failed);
+
+    failed = 0;
+    for (uint32_t c = 0; c < captures; c++) {
+        errors = logicCapture(edges, param.triggerMode, &t, c == 0);
+        if (errors < 0) {
+            fprintf(stderr, "capture %u: signal ended\n", c);
+            return 1;
+        }
+        failed += errors ? 1 : 0;
+    }
+    printf("logic: %u captures, %u failed\n", captures, failed);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,246 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmgrid
+ *
+ * Counts the bytes on the I2C bus per drawGrid() frame (PPMInspect/TextUILcdSSD1306.cpp)
+ * against a mock display (SSD1306AsciiWire.h in this directory).
+ *   before   drawGrid() as it was: every byte of the graph in its own transfer
+ *   full     drawGrid() without a shadow, see TextUILcd::setGridShadow()
+ *   diff     drawGrid() sending changed bytes only
+ * Checks that all three leave the same display content.
+ *
+ * Build:
+ *   g++ -O2 -fno-rtti -I. -I../PPMInspect -o ppmgrid PPMGrid.cpp ../PPMInspect/TextUILcdSSD1306.cpp ../PPMInspect/TextUILcd.cpp
+ *
+ * -fno-rtti like the Arduino build, TextUILcd::drawGrid() has no implementation.
+ *
+ * Usage:
+ *   ppmgrid [-f frames] [-N noise]
+ *
+ * Frames are 128 x 56 pixel like the MicroScope with grid.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "TextUILcdSSD1306.h"
+
+#define SIM_WIDTH   128
+
+/* Graph area of the MicroScope */
+#define SIM_X0        0
+#define SIM_Y0        8
+#define SIM_X1      127
+#define SIM_Y1       63
+#define SIM_GRID     10
+#define SIM_MAX      55
+
+#define SIM_LOW       2
+#define SIM_HIGH     40
+
+/* drawGrid() before the shadow, for comparison */
+static void drawGridBefore(SSD1306AsciiWire &lcd, uint8_t dataArray[], uint8_t sz, uint8_t si,
+                           uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t gridX, bool marker) {
+
+    uint8_t m;
+    uint8_t y;
+    uint8_t prevY;
+    uint8_t x;
+    uint8_t ii;
+    uint8_t d0y;
+    uint8_t d1y;
+
+    for (uint8_t row = y0 / 8; row <= y1 / 8; row++) {
+        lcd.setCol(x0);
+        lcd.setRow(row);
+
+        prevY = y1 - dataArray[si];
+        ii = 1;
+
+        for (x = x0; (x <= x1) && (ii < sz); x++) {
+            y = y1 - dataArray[(si + ii) % sz];
+            ii++;
+
+            d0y = (prevY < y) ? prevY : y;
+            d1y = (prevY > y) ? prevY : y;
+
+            m = 0;
+            for (uint8_t b = 0; b < 8; b++) {
+                if (row * 8 + b >= d0y && row * 8 + b <= d1y) {
+                    m |= 1 << b;
+                }
+            }
+            if (gridX && ((x % gridX) == 0)) {
+                m |= 0b10000000;
+            }
+
+            lcd.ssd1306WriteRam(m);
+            prevY = y;
+        }
+
+        for (; x <= x1; x++) {
+            lcd.ssd1306WriteRam(0);
+        }
+    }
+
+    if (marker) {
+        lcd.setCol(x1);
+        lcd.setRow(y0 / 8);
+        lcd.ssd1306WriteRam(0x0f);
+    }
+}
+
+static uint8_t clip(int v) {
+
+    return (v < 0) ? 0 : (v > SIM_MAX) ? SIM_MAX : v;
+}
+
+/* Triggered PPM trace. Frame f moves one channel by one sample every 4 frames. */
+static void ppmFrame(uint32_t f, int noise, uint8_t data[]) {
+
+    uint8_t x = 0;
+
+    for (uint8_t ch = 0; x < SIM_WIDTH; ch++) {
+        uint8_t pulse = 6;
+        uint8_t servo = 20 + (ch == 2 ? (f / 4) % 20 : 0);
+        for (uint8_t i = 0; i < servo && x < SIM_WIDTH; i++, x++) {
+            data[x] = (i < pulse) ? SIM_LOW : SIM_HIGH;
+        }
+    }
+    for (x = 0; x < SIM_WIDTH; x++) {
+        data[x] = clip(data[x] + (noise ? rand() % (2 * noise + 1) - noise : 0));
+    }
+}
+
+/* Roll mode: slowly sagging battery voltage with load steps, scrolled by 2 samples a frame */
+static void rollFrame(uint32_t f, int noise, uint8_t data[]) {
+
+    for (uint8_t x = 0; x < SIM_WIDTH; x++) {
+        uint32_t t = f * 2 + x;
+        int v = 45 - (int)(t / 50) % 10 - (((t / 37) % 3 == 0) ? 4 : 0);
+        data[x] = clip(v + (noise ? rand() % (2 * noise + 1) - noise : 0));
+    }
+}
+
+/* Free running sine, changes every frame */
+static void sineFrame(uint32_t f, int noise, uint8_t data[]) {
+
+    for (uint8_t x = 0; x < SIM_WIDTH; x++) {
+        double v = 27 + 20 * sin((x + f * 3) * 2 * M_PI / 64);
+        data[x] = clip((int)v + (noise ? rand() % (2 * noise + 1) - noise : 0));
+    }
+}
+
+typedef void (*frame_f)(uint32_t f, int noise, uint8_t data[]);
+
+static bool sameRam(const SSD1306AsciiWire &a, const SSD1306AsciiWire &b) {
+
+    return memcmp(a.ram, b.ram, sizeof(a.ram)) == 0;
+}
+
+static int run(const char *name, frame_f gen, uint32_t frames, int noise) {
+
+    uint8_t data[SIM_WIDTH];
+    uint8_t shadow[2 * TEXTUI_GRID_WIDTH];
+    SSD1306AsciiWire before;
+    int errors = 0;
+
+    TextUILcdSSD1306 full(&Adafruit128x64);
+    SSD1306AsciiWire &fullLcd = *SSD1306AsciiWire::lastBegun;
+    TextUILcdSSD1306 diff(&Adafruit128x64);
+    SSD1306AsciiWire &diffLcd = *SSD1306AsciiWire::lastBegun;
+
+    diff.setGridShadow(shadow);
+
+    before.begin(&Adafruit128x64, 0);
+    before.clear();
+
+    /* Counting starts with the first frame */
+    before.resetCounts();
+    fullLcd.resetCounts();
+    diffLcd.resetCounts();
+
+    for (uint32_t f = 0; f < frames; f++) {
+
+        gen(f, noise, data);
+
+        drawGridBefore(before, data, SIM_WIDTH, 0, SIM_X0, SIM_Y0, SIM_X1, SIM_Y1, SIM_GRID, f & 1);
+        full.drawGrid(data, nullptr, SIM_WIDTH, 0, SIM_X0, SIM_Y0, SIM_X1, SIM_Y1, SIM_GRID, f & 1, 0);
+        diff.drawGrid(data, nullptr, SIM_WIDTH, 0, SIM_X0, SIM_Y0, SIM_X1, SIM_Y1, SIM_GRID, f & 1, 0);
+
+        if (!sameRam(before, fullLcd) || !sameRam(before, diffLcd)) {
+            if (errors++ < 3) {
+                fprintf(stderr, "%s frame %u: display content differs\n", name, f);
+            }
+        }
+    }
+
+    printf("%-6s bus bytes/frame: before %5u, full %5u, diff %5u  transfers/frame: %4u %4u %4u  %s\n", name,
+           before.busBytes / frames, fullLcd.busBytes / frames, diffLcd.busBytes / frames,
+           before.transfers / frames, fullLcd.transfers / frames, diffLcd.transfers / frames,
+           errors ? "FAILED" : "ok");
+
+    return errors;
+}
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-f frames] [-N noise]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint32_t frames = 100;
+    int noise = 0;
+    int errors = 0;
+
+    while ((opt = getopt(argc, argv, "f:N:")) != -1) {
+        switch (opt) {
+        case 'f': frames = atoi(optarg); break;
+        case 'N': noise = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (frames == 0 || noise < 0 || noise > 10) {
+        fprintf(stderr, "frames > 0, noise 0 - 10\n");
+        return 1;
+    }
+
+    srand(1);
+
+    errors += run("ppm", ppmFrame, frames, noise);
+    errors += run("roll", rollFrame, frames, noise);
+    errors += run("sine", sineFrame, frames, noise);
+
+    return errors ? 1 : 0;
+}
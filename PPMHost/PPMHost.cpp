@@ -0,0 +1,166 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "PPMHost.h"
+
+config_t settings;
+
+uint64_t nowNsec() {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void setDefaults() {
+
+    memset(&settings, 0, sizeof(config_t));
+
+    settings.pulseValidMin_usec = PULSEVALIDMIN_usec;
+    settings.pulseValidMax_usec = PULSEVALIDMAX_USEC;
+    settings.servoValidMin_usec = SERVOVALIDMIN_USEC;
+    settings.servoValidMax_usec = SERVOVALIDMAX_USEC;
+    settings.syncValidMin_usec = SYNCVALIDMIN_usec;
+}
+
+bool readEdges(const char *fname, std::vector<tickedge_t> &edges) {
+
+    FILE *f = fopen(fname, "r");
+    unsigned long ticks;
+    int level;
+
+    if (f == nullptr) {
+        perror(fname);
+        return false;
+    }
+
+    while (fscanf(f, "%lu %d", &ticks, &level) == 2) {
+        edges.push_back({ (uint32_t)ticks, level != 0 });
+    }
+
+    fclose(f);
+    return true;
+}
+
+void generateEdges(uint8_t channels, uint32_t frames, uint16_t jitter_usec, uint32_t badFrame,
+                   std::vector<tickedge_t> &edges) {
+
+    uint32_t t = 0;
+    uint32_t frameStart;
+    uint16_t servo_usec;
+
+    for (uint32_t f = 0; f < frames; f++) {
+
+        frameStart = t;
+
+        for (uint8_t ch = 0; ch <= channels; ch++) {
+            if (f == badFrame && ch == channels - 1) {
+                continue;
+            }
+            edges.push_back({ t, false });
+            t += 300 * 2;
+            edges.push_back({ t, true });
+
+            if (ch < channels) {
+                servo_usec = 1000 + (f * 7 + ch * 100) % 1000;
+                if (jitter_usec) {
+                    servo_usec += rand() % (2 * jitter_usec + 1) - jitter_usec;
+                }
+                t += (servo_usec - 300) * 2;
+            }
+        }
+
+        /* Sync gap up to end of frame */
+        t = frameStart + 22500 * 2;
+    }
+}
+
+void printPPM(const ppm_t *p) {
+
+    printf("sync %s channels %u frames %u\n", p->sync ? "yes" : "no", p->channels, p->frames);
+    printf("frame %u - %u usec, pulse %u.%u - %u.%u usec\n",
+           p->frameMin_usec, p->frameMax_usec,
+           p->pulseMin_us10 / 10, p->pulseMin_us10 % 10, p->pulseMax_us10 / 10, p->pulseMax_us10 % 10);
+    printf("bad frames %u, bad count %u, bad pulse %u\n", p->badFrames, p->badCount, p->badPulse);
+
+    for (uint8_t ch = 0; ch < p->channels; ch++) {
+        printf("  C%-2u %5u.%u  %5u.%u - %5u.%u usec\n", ch + 1,
+               p->channel_us10[ch] / 10, p->channel_us10[ch] % 10,
+               p->channelMin_us10[ch] / 10, p->channelMin_us10[ch] % 10,
+               p->channelMax_us10[ch] / 10, p->channelMax_us10[ch] % 10);
+    }
+}
+
+void printForensic(const forensic_t *fc) {
+
+    static const char *reasons[] = { "none", "long frame", "channel count", "pulse time" };
+    const ppmframe_t *fr;
+
+    printf("bad frame capture: %s%s\n", reasons[fc->reason], fc->frozen ? "" : " (incomplete)");
+
+    if (!fc->frozen) {
+        return;
+    }
+
+    for (int i = -FORENSIC_PRE_FRAMES; i <= FORENSIC_POST_FRAMES; i++) {
+        fr = &fc->frame[(fc->badSlot + FORENSIC_SLOTS + i) % FORENSIC_SLOTS];
+        printf("  %+d %2u:", i, fr->count);
+        for (uint8_t p = 0; p < fr->count; p++) {
+            printf(" %u", fr->pulse_usec[p]);
+        }
+        printf("\n");
+    }
+}
+
+/********* HostPPM **********/
+
+void HostPPM::reset(uint32_t ticks, uint8_t shift) {
+
+    memset(&wSet, 0, sizeof(ppm_t));
+    memset(&stableSet, 0, sizeof(ppm_t));
+    published = 0;
+    decoder.reset(DETECT_STEP_INIT, ticks, shift);
+}
+
+/* Same as dispatchEdge() in PPM.cpp, without the triple buffer */
+void HostPPM::edge(uint32_t ticks, uint8_t flags) {
+
+    if (flags & (EDGE_TIMEOUT | EDGE_LOST)) {
+        if (decoder.ppmTimeout(&wSet)) {
+            memcpy(&stableSet, &wSet, sizeof(ppm_t));
+            published++;
+        }
+    }
+
+    if (!(flags & EDGE_NONE) && decoder.ppmEdge(&wSet, ticks, flags & EDGE_LEVEL)) {
+        memcpy(&stableSet, &wSet, sizeof(ppm_t));
+        published++;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * Shared helpers of the PPMHost tools.
+ */
+
+#ifndef _PPMHost_h_
+#define _PPMHost_h_
+
+#include <vector>
+
+#include "PPMDecoder.h"
+#include "EdgeRing.h"
+
+/* One edge with full 32 bit timestamp (0.5 usec ticks) */
+typedef struct tickedge_t {
+    uint32_t ticks;
+    bool     level;
+} tickedge_t;
+
+/* Decoder settings, defined in PPMHost.cpp */
+extern config_t settings;
+
+uint64_t nowNsec();
+
+/* Load config_t defaults from Config.h */
+void setDefaults();
+
+/* Edge file: one edge per line "<ticks> <level>" */
+bool readEdges(const char *fname, std::vector<tickedge_t> &edges);
+
+/*
+ * Generate a negative PPM stream: 300 usec low pulse followed by high level.
+ * Frame length is 22.5 msec. Channels sweep across the servo range.
+ * The last channel of frame badFrame is dropped (UINT32_MAX for none).
+ */
+void generateEdges(uint8_t channels, uint32_t frames, uint16_t jitter_usec, uint32_t badFrame,
+                   std::vector<tickedge_t> &edges);
+
+void printPPM(const ppm_t *p);
+void printForensic(const forensic_t *fc);
+
+/*
+ * Host side of PPM.cpp. Feeds edges with EDGE_* flags into the decoder
+ * and keeps a copy of the last published set.
+ */
+class HostPPM {
+
+    private:
+        PPMDecoder decoder;
+        ppm_t wSet;
+
+    public:
+        ppm_t stableSet;
+        uint32_t published;
+
+        void reset(uint32_t ticks, uint8_t shift = DECODER_SHIFT_500NS);
+        void edge(uint32_t ticks, uint8_t flags);
+
+        const PPMDecoder &getDecoder() const { return decoder; }
+};
+
+#endif
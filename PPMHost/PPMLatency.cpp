@@ -0,0 +1,407 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMLatency
+ *
+ * Checks LatencyMeter, the receiver latency scan, on a Linux host.
+ *
+ * A PPM stream steps one channel every LATENCY_SIM_STEP_FRAMES frames, the other
+ * channels jitter by a few usec. A receiver or flight controller model turns the
+ * channel into a free running PWM output: a new value is taken over after a
+ * processing delay, optionally reversed, scaled or filtered, and some changes
+ * are never passed on. PPM edges are timestamped by input capture, PWM edges
+ * by the pin change interrupt, late by its latency. Both go through PPMDecoder
+ * and LatencyMeter in interrupt order like PPM::processEdges().
+ *
+ * The expected latency of each change comes from the exact signal: end of the
+ * channel to the first pulse starting after it that moved by LATENCY_STEP_USEC / 2.
+ * Min, avg, max, counts and histogram must match within the interrupt latency
+ * and one tick. Each scenario runs at 0.5 usec and 62.5 nsec with the 32 bit
+ * tick count wrapping.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmlatency PPMLatency.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/LatencyMeter.cpp
+ *
+ * Usage:
+ *   ppmlatency [-f frames] [-j jitter_nsec] [-v]
+ *
+ * -j adds a random pin change interrupt latency of up to jitter_nsec.
+ * -v prints every change with its expected latency.
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "PPMHost.h"
+#include "LatencyMeter.h"
+
+#define SIM_CHANNELS             8
+#define SIM_FRAME_NSEC    22500000ULL
+#define SIM_PULSE_NSEC      300000ULL
+/* Longer than LATENCY_TIMEOUT_MSEC, changes never overlap */
+#define SIM_STEP_FRAMES         15
+
+/* Capture ISR queues an edge this long after it, the pin change ISR reads Timer 1 after ISR_LATENCY_NSEC */
+#define CAPTURE_QUEUE_NSEC    2000
+#define ISR_LATENCY_NSEC      2500
+
+/* Ticks left before the 32 bit timestamp wraps */
+#define WRAP_TICKS          100000UL
+
+typedef struct scenario_t {
+    const char *name;
+    uint8_t  channel;         /* Watched PPM channel, 0 based */
+    uint64_t period_ns;       /* PWM output period */
+    uint64_t phase_ns;        /* First rising edge */
+    uint64_t delay_ns;        /* Processing delay of the receiver */
+    double   gain;            /* Output = 1500 + gain * (value - 1500) */
+    double   alpha;           /* Low pass per output pulse, 1.0 for none */
+    uint8_t  holdEvery;       /* Every n-th change is not passed on, 0 for none */
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "receiver 50Hz",  2, 20000000,  7300000, 1200000,  1.0, 1.0, 0 },
+    { "receiver 333Hz", 0,  3003000,   100000,  800000,  1.0, 1.0, 0 },
+    { "fc 490Hz rev",   3,  2040800,   333000, 4500000, -0.6, 1.0, 0 },
+    { "fc filtered",    7,  2500000,  1000000,  500000,  1.0, 0.3, 0 },
+    { "fc hold",        1,  4000000,  2100000, 9000000,  1.0, 1.0, 4 },
+};
+
+/* One signal edge, exact time in nsec */
+typedef struct simedge_t {
+    uint64_t t;
+    uint64_t queued;   /* When the ISR put it into the ring */
+    bool     pwm;
+    bool     level;
+} simedge_t;
+
+/* End of the watched channel in a frame and its value */
+typedef struct change_t {
+    uint64_t t;
+    uint32_t value_ns;
+} change_t;
+
+static uint32_t jitter_ns = 0;
+static bool verbose = false;
+static uint32_t failed;
+
+/* Watched channel steps through 1100, 1500, 1900, 1500 usec, others are fixed */
+static uint32_t channelNsec(const scenario_t *sc, uint32_t f, uint8_t ch) {
+
+    static const uint32_t levels[4] = { 1100000, 1500000, 1900000, 1500000 };
+    uint32_t noise = (rand() % 7000) - 3000;
+
+    if (ch == sc->channel) {
+        return levels[(f / SIM_STEP_FRAMES) % 4] + noise;
+    }
+    return 1000000 + ch * 100000 + noise;
+}
+
+/* PPM edges and the end time and value of the watched channel per frame */
+static void generatePPM(const scenario_t *sc, uint32_t frames,
+                        std::vector<simedge_t> &edges, std::vector<change_t> &ends) {
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint64_t t = (uint64_t)f * SIM_FRAME_NSEC;
+
+        for (uint8_t ch = 0; ch <= SIM_CHANNELS; ch++) {
+            edges.push_back({ t, t + CAPTURE_QUEUE_NSEC, false, false });
+            edges.push_back({ t + SIM_PULSE_NSEC, t + SIM_PULSE_NSEC + CAPTURE_QUEUE_NSEC, false, true });
+
+            if (ch < SIM_CHANNELS) {
+                uint32_t v = channelNsec(sc, f, ch);
+
+                t += v;
+                if (ch == sc->channel) {
+                    /* Ends with the next pulse */
+                    ends.push_back({ t, v });
+                }
+            }
+        }
+    }
+}
+
+/* Receiver output. Pulse k starts at phase + k * period with the value available then. */
+static void generatePWM(const scenario_t *sc, uint64_t end_ns, const std::vector<change_t> &ends,
+                        std::vector<simedge_t> &edges, std::vector<simedge_t> &pulses) {
+
+    size_t next = 0;
+    double target = 1500000;
+    double width = 1500000;
+    uint32_t held = 0;
+    uint32_t changes = 0;
+    uint32_t lastValue = 1500000;
+
+    for (uint64_t r = sc->phase_ns; r + 3000000 < end_ns; r += sc->period_ns) {
+
+        while (next < ends.size() && ends[next].t + sc->delay_ns <= r) {
+            uint32_t v = ends[next].value_ns;
+
+            /* A step of the PPM generator, not just noise */
+            if ((v > lastValue ? v - lastValue : lastValue - v) > 200000) {
+                changes++;
+                held = (sc->holdEvery && (changes % sc->holdEvery) == 0);
+            }
+            lastValue = v;
+            if (!held) {
+                target = 1500000 + sc->gain * ((double)v - 1500000);
+            }
+            next++;
+        }
+
+        width += sc->alpha * (target - width);
+
+        uint64_t w = (uint64_t)width;
+        uint64_t jr = jitter_ns ? rand() % (jitter_ns + 1) : 0;
+        uint64_t jf = jitter_ns ? rand() % (jitter_ns + 1) : 0;
+
+        edges.push_back({ r, r + ISR_LATENCY_NSEC + jr, true, true });
+        edges.push_back({ r + w, r + w + ISR_LATENCY_NSEC + jf, true, false });
+        pulses.push_back({ r, r + w, true, true });
+    }
+}
+
+/* The reference: latency of every change from the exact signal, UINT64_MAX if missed */
+static void expectLatency(const std::vector<change_t> &ends, const std::vector<simedge_t> &pulses,
+                          std::vector<uint64_t> &expected) {
+
+    uint32_t base = 0;
+    bool baseValid = false;
+    size_t p = 0;
+
+    for (const change_t &c : ends) {
+
+        /* Pulses completed before the change */
+        while (p < pulses.size() && pulses[p].queued < c.t) {
+            p++;
+        }
+        if (p == 0) {
+            continue;
+        }
+        if (!baseValid) {
+            base = c.value_ns;
+            baseValid = true;
+            continue;
+        }
+        if ((c.value_ns > base ? c.value_ns - base : base - c.value_ns) < LATENCY_STEP_USEC * 1000) {
+            continue;
+        }
+        base = c.value_ns;
+
+        uint64_t before = pulses[p - 1].queued - pulses[p - 1].t;
+        uint64_t lat = UINT64_MAX;
+
+        for (size_t q = p - 1; q < pulses.size(); q++) {
+            uint64_t w = pulses[q].queued - pulses[q].t;
+
+            if (pulses[q].t < c.t) {
+                continue;
+            }
+            if (pulses[q].t - c.t > (uint64_t)LATENCY_TIMEOUT_MSEC * 1000000) {
+                break;
+            }
+            if ((w > before ? w - before : before - w) >= LATENCY_STEP_USEC * 500) {
+                lat = pulses[q].t - c.t;
+                break;
+            }
+        }
+        expected.push_back(lat);
+    }
+}
+
+static uint8_t latencyBin(uint64_t usec) {
+
+    return (uint8_t)std::min(usec / LATENCY_BIN_USEC, (uint64_t)LATENCY_BINS - 1);
+}
+
+static void check(const char *name, const char *what, long got_us, long exp_us, long tol_us) {
+
+    if (labs(got_us - exp_us) > tol_us) {
+        printf("FAIL %-22s %-8s got %ld usec, expected %ld usec\n", name, what, got_us, exp_us);
+        failed++;
+    }
+}
+
+static void run(const scenario_t *sc, uint32_t frames, uint8_t shift) {
+
+    std::vector<simedge_t> edges;
+    std::vector<simedge_t> pulses;
+    std::vector<change_t> ends;
+    std::vector<uint64_t> expected;
+    PPMDecoder decoder;
+    LatencyMeter meter;
+    ppm_t wSet;
+    uint32_t start = UINT32_MAX - WRAP_TICKS;
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s/%s", sc->name, (shift == DECODER_SHIFT_62NS) ? "62ns" : "500ns");
+
+    generatePPM(sc, frames, edges, ends);
+    generatePWM(sc, (uint64_t)frames * SIM_FRAME_NSEC, ends, edges, pulses);
+    expectLatency(ends, pulses, expected);
+
+    /* Ring order */
+    std::stable_sort(edges.begin(), edges.end(),
+                     [](const simedge_t &a, const simedge_t &b) { return a.queued < b.queued; });
+
+    memset(&wSet, 0, sizeof(ppm_t));
+    decoder.reset(DETECT_STEP_INIT, start, shift);
+    meter.reset(sc->channel, shift);
+
+    for (const simedge_t &e : edges) {
+        /* The pin change ISR reads Timer 1 on entry */
+        uint64_t t = e.pwm ? e.queued : e.t;
+        uint32_t ticks = start + (uint32_t)((t << shift) / 1000);
+
+        if (e.pwm) {
+            meter.pwmEdge(ticks, e.level);
+        }
+        else {
+            decoder.ppmEdge(&wSet, ticks, e.level);
+            meter.ppmEdge(ticks, decoder.getStoredChannels(), &wSet);
+        }
+    }
+
+    /* Expected statistics, shifted by the interrupt latency */
+    uint32_t matched = 0;
+    uint32_t missed = 0;
+    uint64_t sum = 0;
+    uint64_t minLat = UINT64_MAX;
+    uint64_t maxLat = 0;
+    uint64_t lastLat = 0;
+    uint32_t hist[LATENCY_BINS] = { 0 };
+    /* Latencies within the tolerance of a bin boundary may go either way */
+    uint32_t slack[LATENCY_BINS] = { 0 };
+    /* One tick, the pin change jitter and truncation to usec */
+    long tol = 1 + (jitter_ns + 999) / 1000 + 1;
+
+    for (uint64_t lat : expected) {
+        if (lat == UINT64_MAX) {
+            missed++;
+            continue;
+        }
+        lat = (lat + ISR_LATENCY_NSEC) / 1000;
+        matched++;
+        sum += lat;
+        minLat = std::min(minLat, lat);
+        maxLat = std::max(maxLat, lat);
+        lastLat = lat;
+        /* Halved like the meter when a bin saturates, differences round either way */
+        if (hist[latencyBin(lat)] == UINT8_MAX) {
+            for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+                hist[b] >>= 1;
+                slack[b] = (slack[b] + 1) / 2 + 1;
+            }
+        }
+        hist[latencyBin(lat)]++;
+        if (latencyBin(lat - tol) != latencyBin(lat + tol)) {
+            slack[latencyBin(lat - tol)]++;
+            slack[latencyBin(lat + tol)]++;
+        }
+    }
+
+    const latency_t *l = meter.getLatency();
+
+    printf("%-22s %4u changes, %4u matched, %3u missed, latency %6.1f / %6.1f / %6.1f msec\n",
+           name, l->changes, l->matched, l->missed, l->min_usec / 1000.0,
+           l->sumCount ? (double)l->sum_usec / l->sumCount / 1000.0 : 0.0, l->max_usec / 1000.0);
+
+    if (verbose) {
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (expected[i] == UINT64_MAX) {
+                printf("  change %3zu missed\n", i + 1);
+            }
+            else {
+                printf("  change %3zu %8.3f msec\n", i + 1, expected[i] / 1000000.0);
+            }
+        }
+        printf("  histogram");
+        for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+            printf(" %u", l->hist[b]);
+        }
+        printf("\n");
+    }
+
+    /* The last change may still be pending */
+    if (l->changes < expected.size() || l->changes > expected.size() + 1) {
+        check(name, "changes", l->changes, expected.size(), 0);
+    }
+    check(name, "matched", l->matched, matched, 0);
+    check(name, "missed", l->missed, missed, (l->changes > expected.size()) ? 1 : 0);
+
+    if (matched == 0) {
+        return;
+    }
+
+    check(name, "min", l->min_usec, minLat, tol);
+    check(name, "max", l->max_usec, maxLat, tol);
+    check(name, "last", l->last_usec, lastLat, tol);
+    check(name, "avg", l->sumCount ? l->sum_usec / l->sumCount : 0, sum / matched, tol);
+
+    for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+        if ((uint32_t)abs((int)l->hist[b] - (int)hist[b]) > slack[b]) {
+            printf("FAIL %-22s bin %-4u got %u, expected %u\n", name, b, l->hist[b], hist[b]);
+            failed++;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint32_t frames = 2000;
+
+    while ((opt = getopt(argc, argv, "f:j:v")) != -1) {
+        switch (opt) {
+        case 'f': frames = atoi(optarg); break;
+        case 'j': jitter_ns = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-f frames] [-j jitter_nsec] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    setDefaults();
+
+    for (const scenario_t &sc : scenarios) {
+        srand(1);
+        run(&sc, frames, DECODER_SHIFT_500NS);
+        srand(1);
+        run(&sc, frames, DECODER_SHIFT_62NS);
+    }
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
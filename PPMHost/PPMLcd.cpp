@@ -0,0 +1,276 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmlcd
+ *
+ * Runs PPMInspect screens on the host with the emulated display (TextUILcdHost.h)
+ * and a synthetic PPM signal (HostPPM.cpp). Prints the bytes on the I2C bus
+ * for every refresh and dumps the frames.
+ *
+ * The loop runs like loop() in PPMInspect.ino: it sleeps until the next
+ * timer or tick event unless there is work. The summary shows how often
+ * the loop woke up and dispatched an event. Every interrupt ends the sleep:
+ * Timer 0 (millis) every 1.024 msec and the inputs of the running scan
+ * (hostInterrupts() in HostPPM.cpp). Each wakeup is one pass through loop().
+ *
+ * Build:
+ *   g++ -O2 -fno-rtti -DTEXTUI_NO_DEBUG -I. -I../PPMInspect -o ppmlcd PPMLcd.cpp HostPPM.cpp TextUILcdHost.cpp
+ *       ../PPMInspect/{TextUI,TextUIHandler,TextUIMenu,TextUILcd,TextUILcdSSD1306,Cell}.cpp
+ *       ../PPMInspect/{DataScreen,ChannelScreen,ForensicScreen,PWMScreen,ServoScreen,LatencyScreen,ScopeScreen}.cpp
+ *
+ * Usage:
+ *   ppmlcd [-s data|pwm|servo|latency|scope] [-n refreshes] [-k keys] [-o prefix] [-p] [-t]
+ *
+ *   -k  keys pressed one per refresh: u up, d down, e enter, f function, c clear, r reset
+ *   -o  writes prefix_NNN.pgm for every refresh, -p writes PBM instead
+ *   -t  prints every frame to the terminal
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "TextUILcdHost.h"
+#include "DataScreen.h"
+#include "PWMScreen.h"
+#include "ServoScreen.h"
+#include "LatencyScreen.h"
+#include "ScopeScreen.h"
+#include "ChannelScreen.h"
+#include "ForensicScreen.h"
+
+/* Loop pass while a screen is busy and how long to wait for a refresh */
+#define SIM_BUSY_MSEC         1
+#define SIM_IDLE_MSEC     10000
+
+/* Timer 0 overflow, millis() interrupt */
+#define SIM_TIMER0_USEC    1024
+
+/* Pixel per display pixel in the dumps */
+#define SIM_SCALE             4
+
+PPM ppm;
+config_t settings;
+
+DataScreen dataScreen(ppm);
+PWMScreen pwmScreen(ppm);
+ServoScreen servoScreen(ppm);
+LatencyScreen latencyScreen(ppm);
+ScopeScreen scopeScreen(ppm);
+ChannelScreen channelScreen(ppm);
+ForensicScreen forensicScreen(ppm);
+
+uint32_t hostInterrupts(unsigned long fromMsec, unsigned long toMsec);
+
+/* Timer 0 overflows from fromMsec to toMsec */
+static uint32_t timer0Overflows(unsigned long fromMsec, unsigned long toMsec) {
+
+    return (uint64_t)toMsec * 1000 / SIM_TIMER0_USEC - (uint64_t)fromMsec * 1000 / SIM_TIMER0_USEC;
+}
+
+/* Key presses from the command line */
+class ScriptInput : public TextUIInput {
+
+    private:
+        const char *keys;
+        bool due = false;
+
+    public:
+        ScriptInput(const char *k) : keys(k) {}
+
+        /* Release the next key */
+        void next() { due = (*keys != '\0'); }
+
+        bool pending() { return due; }
+
+        void setEvent(Event *e) {
+
+            uint8_t k;
+
+            switch (*keys++) {
+            case 'u': k = KEY_UP; break;
+            case 'd': k = KEY_DOWN; break;
+            case 'e': k = KEY_ENTER; break;
+            case 'f': k = KEY_FUNCTION; break;
+            case 'c': k = KEY_CLEAR; break;
+            case 'r': k = KEY_RESET; break;
+            default:  k = KEY_NONE; break;
+            }
+            due = false;
+            if (k != KEY_NONE) {
+                e->setKeyEvent(k, 1);
+            }
+        }
+};
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-s data|pwm|servo|latency|scope] [-n refreshes] [-k keys] [-o prefix] [-p] [-t]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    const char *screenName = "data";
+    const char *keys = "";
+    const char *prefix = nullptr;
+    bool pbm = false;
+    bool terminal = false;
+    uint32_t refreshes = 10;
+    uint32_t n = 0;
+    uint32_t total = 0;
+    uint32_t maxBytes = 0;
+    uint32_t timer0Wakeups = 0;
+    uint32_t inputWakeups = 0;
+    uint32_t dispatches = 0;
+    unsigned long idleSince;
+    unsigned long sleepSince;
+    TextUIScreen *screen;
+    Event *e;
+    char path[256];
+
+    while ((opt = getopt(argc, argv, "s:n:k:o:pt")) != -1) {
+        switch (opt) {
+        case 's': screenName = optarg; break;
+        case 'n': refreshes = atoi(optarg); break;
+        case 'k': keys = optarg; break;
+        case 'o': prefix = optarg; break;
+        case 'p': pbm = true; break;
+        case 't': terminal = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (strcmp(screenName, "data") == 0) {
+        screen = &dataScreen;
+    }
+    else if (strcmp(screenName, "pwm") == 0) {
+        screen = &pwmScreen;
+    }
+    else if (strcmp(screenName, "servo") == 0) {
+        screen = &servoScreen;
+    }
+    else if (strcmp(screenName, "latency") == 0) {
+        screen = &latencyScreen;
+    }
+    else if (strcmp(screenName, "scope") == 0) {
+        screen = &scopeScreen;
+    }
+    else {
+        usage(argv[0]);
+        return 1;
+    }
+
+    settings.pulseValidMin_usec = PULSEVALIDMIN_usec;
+    settings.pulseValidMax_usec = PULSEVALIDMAX_USEC;
+    settings.servoValidMin_usec = SERVOVALIDMIN_USEC;
+    settings.servoValidMax_usec = SERVOVALIDMAX_USEC;
+    settings.syncValidMin_usec = SYNCVALIDMIN_usec;
+
+    TextUI textUI(15);
+    TextUILcdHost *lcd = new TextUILcdHost();
+    ScriptInput *input = new ScriptInput(keys);
+
+    /* Like setup() in PPMInspect.ino */
+    textUI.setDisplay(lcd);
+    textUI.setInput(input);
+    textUI.setReversedNav(true);
+    textUI.setTimer(500);
+    textUI.setHomeScreen(screen);
+
+    lcd->startRefresh();
+    idleSince = millis();
+
+    while (n < refreshes) {
+
+        if (millis() - idleSince > SIM_IDLE_MSEC) {
+            fprintf(stderr, "no refresh for %d msec\n", SIM_IDLE_MSEC);
+            return 1;
+        }
+
+        e = textUI.getEvent();
+
+        if (e->getType() == EVENT_TYPE_NONE && !textUI.isBusy()) {
+            /* idle() until the deadline, Timer 0 notices it */
+            sleepSince = millis();
+            if ((int32_t)(textUI.nextEventTime() - sleepSince) > 0) {
+                hostMillis = textUI.nextEventTime();
+            }
+            else {
+                delay(1);
+            }
+            timer0Wakeups += timer0Overflows(sleepSince, millis());
+            inputWakeups += hostInterrupts(sleepSince, millis());
+            continue;
+        }
+
+        textUI.handle(e);
+        dispatches++;
+
+        if (lcd->busBytes() == 0) {
+            if (e->getType() == EVENT_TYPE_NONE) {
+                delay(SIM_BUSY_MSEC);
+            }
+            continue;
+        }
+
+        printf("%4u %8lu msec  bus bytes %5u  transfers %4u  data bytes %5u\n",
+               n, millis(), lcd->busBytes(), lcd->transfers(), lcd->dataBytes());
+
+        if (prefix) {
+            snprintf(path, sizeof(path), "%s_%03u.%s", prefix, n, pbm ? "pbm" : "pgm");
+            if (!(pbm ? lcd->writePBM(path, SIM_SCALE) : lcd->writePGM(path, SIM_SCALE))) {
+                perror(path);
+                return 1;
+            }
+        }
+        if (terminal) {
+            lcd->printTerminal(stdout);
+        }
+
+        total += lcd->busBytes();
+        if (lcd->busBytes() > maxBytes) {
+            maxBytes = lcd->busBytes();
+        }
+        n++;
+
+        input->next();
+        lcd->startRefresh();
+        idleSince = millis();
+    }
+
+    printf("%s: %u refreshes, bus bytes average %u, max %u\n", screenName, n, total / n, maxBytes);
+    if (millis() > 0) {
+        printf("per second: %lu wakeups (%lu Timer 0, %lu inputs), %lu events dispatched\n",
+               (timer0Wakeups + inputWakeups) * 1000UL / millis(),
+               timer0Wakeups * 1000UL / millis(), inputWakeups * 1000UL / millis(),
+               dispatches * 1000UL / millis());
+    }
+
+    return 0;
+}
@@ -0,0 +1,384 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmlogic
+ *
+ * Reference model of the logic analyzer sampling loop (sampleLogic() in PPMInspect/PPM.cpp).
+ * Runs the loop instruction by instruction with its cycle counts against a synthetic
+ * PPM signal and checks
+ *   - every sample is read LOGIC_CYCLES(rate) cycles after the previous one
+ *   - the bit packing read back by LogicAcq (PPMInspect/LogicAcq.h)
+ *   - every edge and pulse width found by LogicAcq is within one sample of the signal
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmlogic PPMLogic.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmlogic [-c channels] [-r rate] [-t f|+|-] [-n captures] [-j jitter_usec] [-v]
+ *
+ * rate is 0 - 3 (4 MHz .. 500 kHz), all rates without -r.
+ * The deep rate does not use the sampling loop, see ppmdeep.
+ * -v lists the pulses of the first capture like the Logic screen.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "PPMHost.h"
+#include "ScopeAcq.h"
+#include "LogicAcq.h"
+
+/* CPU cycles per 0.5 usec timer tick */
+#define SIM_CYCLES_PER_TICK  8
+
+/* Cycles from the trigger edge to reading TCNT1: polling, millis() and cli */
+#define SIM_LATENCY_MIN      6
+#define SIM_LATENCY_MAX    400
+
+/* Instructions of the sampling loop */
+enum {
+    IN_A, IN_B, LSR_A, LSR_B, ROL, MOV, ST_OUT, ST_ACC, NOP, PAD, DEC_BRNE
+};
+
+/* Loop body in the order of the asm in sampleLogic() */
+static const uint8_t loopBody[] = {
+    IN_B, PAD, LSR_A, ROL, MOV,
+    IN_A, PAD, LSR_B, ROL, LSR_A,
+    IN_B, PAD, ROL, LSR_B, ROL,
+    IN_A, PAD, ST_OUT, LSR_A,
+    IN_A, PAD, ROL, LSR_A, ROL,
+    IN_A, PAD, LSR_A, ROL, NOP,
+    IN_A, PAD, LSR_A, ROL, NOP,
+    IN_A, PAD, DEC_BRNE
+};
+
+static const uint8_t loopEnd[] = {
+    LSR_A, ROL, ST_ACC
+};
+
+/* Signal level in CPU cycles. High before the first edge. */
+class SimSignal {
+
+    private:
+        std::vector<tickedge_t> edges;
+
+    public:
+        explicit SimSignal(const std::vector<tickedge_t> &e) : edges(e) {}
+
+        uint64_t edgeCycles(size_t i) const { return (uint64_t)edges[i].ticks * SIM_CYCLES_PER_TICK; }
+        bool edgeLevel(size_t i) const { return edges[i].level; }
+        size_t count() const { return edges.size(); }
+
+        /* An edge at cycle c is seen by a read at c */
+        uint8_t at(uint64_t c) const {
+
+            auto it = std::upper_bound(edges.begin(), edges.end(), c,
+                                       [](uint64_t v, const tickedge_t &e) { return v < (uint64_t)e.ticks * SIM_CYCLES_PER_TICK; });
+
+            return (it == edges.begin()) ? 1 : (--it)->level;
+        }
+};
+
+/*
+ * Run the sampling loop. The first sample is read at cycle c.
+ * Returns false if the samples are not evenly spaced.
+ */
+static bool runLoop(const SimSignal &sig, uint64_t c, uint8_t rate, uint8_t *p) {
+
+    uint8_t pad = LOGIC_CYCLES(rate) - 4;
+    uint8_t n = LOGIC_BYTES;
+    uint8_t a = 0x55;
+    uint8_t b = 0xaa;
+    uint8_t acc = 0x33;
+    uint8_t out = 0xcc;
+    uint8_t carry = 0;
+    uint64_t lastIn = 0;
+    bool first = true;
+    bool ok = true;
+    size_t pc = 0;
+    bool done = false;
+
+    auto in = [&](uint8_t &r) {
+        if (!first && c - lastIn != LOGIC_CYCLES(rate)) {
+            ok = false;
+        }
+        first = false;
+        lastIn = c;
+        /* PORT_PPM_IN is PB0 */
+        r = sig.at(c) | 0xfe;
+        c++;
+    };
+
+    while (!done) {
+        switch (loopBody[pc++]) {
+        case IN_A:   in(a); break;
+        case IN_B:   in(b); break;
+        case LSR_A:  carry = a & 1; a >>= 1; c++; break;
+        case LSR_B:  carry = b & 1; b >>= 1; c++; break;
+        case ROL:    acc = (uint8_t)(acc << 1) | carry; c++; break;
+        case MOV:    out = acc; c++; break;
+        case ST_OUT: *p++ = out; c += 2; break;
+        case NOP:    c++; break;
+        case PAD:    c += pad; break;
+        case DEC_BRNE:
+            if (--n) {
+                c += 3;
+                pc = 0;
+            }
+            else {
+                c += 2;
+                done = true;
+            }
+            break;
+        }
+    }
+
+    for (uint8_t op : loopEnd) {
+        switch (op) {
+        case LSR_A:  carry = a & 1; a >>= 1; break;
+        case ROL:    acc = (uint8_t)(acc << 1) | carry; break;
+        case ST_ACC: *p++ = acc; break;
+        }
+    }
+
+    return ok;
+}
+
+/* Time of cycle c in nsec after the trigger edge at e */
+static uint32_t cyclesToNsec(uint64_t c, uint64_t e) {
+
+    return (uint32_t)((c - e) * 125 / 2);
+}
+
+/*
+ * Capture at the trigger edge e (or free running from e) and check it.
+ * Returns the number of errors.
+ */
+static int capture(const SimSignal &sig, uint64_t e, uint8_t rate, uint8_t triggerMode,
+                   LogicAcq &acq, uint32_t *checked) {
+
+    uint64_t tcnt = e + SIM_LATENCY_MIN + rand() % (SIM_LATENCY_MAX - SIM_LATENCY_MIN);
+    uint64_t s0;
+    uint16_t t;
+    uint16_t icr;
+    uint16_t i;
+    uint16_t prev = 0;
+    uint32_t nsec;
+    uint32_t sampleNsec = LOGIC_CYCLES(rate) * 125 / 2;
+    int errors = 0;
+    size_t k;
+
+    acq.rate = rate;
+    acq.triggerMode = triggerMode;
+
+    if (triggerMode == ACQ_TRIGGER_FREE) {
+        /* Times are relative to sample 0 */
+        tcnt = e - LOGIC_START_CYCLES;
+    }
+    s0 = tcnt + LOGIC_START_CYCLES;
+
+    if (!runLoop(sig, s0, rate, acq.bits)) {
+        printf("samples not evenly spaced\n");
+        errors++;
+    }
+
+    /* Timer 1 counts CPU cycles and wraps at 16 bit, like on the device */
+    t = (uint16_t)tcnt;
+    icr = (uint16_t)e;
+    acq.startCycles = (triggerMode == ACQ_TRIGGER_FREE) ? 0 : (uint16_t)(t - icr) + LOGIC_START_CYCLES;
+
+    if (acq.startCycles != s0 - e) {
+        printf("start %u cycles, expected %lu\n", acq.startCycles, (unsigned long)(s0 - e));
+        errors++;
+    }
+
+    /* Packing: every sample matches the signal */
+    for (i = 0; i < LOGIC_SAMPLES; i++) {
+        if (acq.level(i) != sig.at(s0 + (uint64_t)i * LOGIC_CYCLES(rate))) {
+            printf("sample %u: wrong level\n", i);
+            errors++;
+            break;
+        }
+    }
+
+    /* First signal edge after sample 0 */
+    k = 0;
+    while (k < sig.count() && sig.edgeCycles(k) <= s0) {
+        k++;
+    }
+
+    /* Every edge found is the next signal edge, within one sample */
+    for (i = acq.nextEdge(0); i < LOGIC_SAMPLES; i = acq.nextEdge(i)) {
+
+        if (k >= sig.count()) {
+            printf("edge at sample %u: no signal edge\n", i);
+            errors++;
+            break;
+        }
+
+        nsec = cyclesToNsec(sig.edgeCycles(k), e);
+
+        if (acq.level(i) != sig.edgeLevel(k)
+            || acq.sampleNsec(i) < nsec || acq.sampleNsec(i) - nsec >= sampleNsec) {
+            printf("edge at sample %u: %u nsec, signal %u nsec\n", i, acq.sampleNsec(i), nsec);
+            errors++;
+        }
+
+        /* Pulse width within one sample */
+        if (prev) {
+            uint32_t w = acq.sampleNsec(i) - acq.sampleNsec(prev);
+            uint32_t sw = cyclesToNsec(sig.edgeCycles(k), sig.edgeCycles(k - 1));
+
+            if ((w > sw ? w - sw : sw - w) >= sampleNsec) {
+                printf("pulse at sample %u: %u nsec, signal %u nsec\n", prev, w, sw);
+                errors++;
+            }
+        }
+
+        prev = i;
+        k++;
+        (*checked)++;
+    }
+
+    /* No edge missed */
+    if (k < sig.count() && sig.edgeCycles(k) <= s0 + (uint64_t)(LOGIC_SAMPLES - 1) * LOGIC_CYCLES(rate)) {
+        printf("signal edge at %u nsec missed\n", cyclesToNsec(sig.edgeCycles(k), e));
+        errors++;
+    }
+
+    return errors;
+}
+
+/* Pulses as shown by LogicScreen */
+static void listPulses(const LogicAcq &acq) {
+
+    uint16_t i;
+    uint16_t next;
+
+    for (i = acq.nextEdge(0); i < LOGIC_SAMPLES; i = next) {
+        next = acq.nextEdge(i);
+        if (next >= LOGIC_SAMPLES) {
+            break;
+        }
+        printf("%c %10.2f %9.2f\n", acq.level(i) ? 'H' : 'L',
+               acq.sampleNsec(i) / 1000.0, (acq.sampleNsec(next) - acq.sampleNsec(i)) / 1000.0);
+    }
+}
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-c channels] [-r rate] [-t f|+|-] [-n captures] [-j jitter_usec] [-v]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    std::vector<tickedge_t> edges;
+    LogicAcq acq;
+
+    int opt;
+    uint8_t channels = 8;
+    int rate = -1;
+    uint8_t triggerMode = ACQ_TRIGGER_FALLING;
+    uint32_t captures = 100;
+    uint16_t jitter_usec = 10;
+    bool verbose = false;
+
+    uint32_t failed = 0;
+
+    while ((opt = getopt(argc, argv, "c:r:t:n:j:v")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'r': rate = atoi(optarg); break;
+        case 't':
+            triggerMode = (optarg[0] == '+') ? ACQ_TRIGGER_RISING
+                        : (optarg[0] == '-') ? ACQ_TRIGGER_FALLING : ACQ_TRIGGER_FREE;
+            break;
+        case 'n': captures = atoi(optarg); break;
+        case 'j': jitter_usec = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || rate >= LOGIC_RATE_DEEP || captures == 0) {
+        fprintf(stderr, "channels must be %d - %d, rate 0 - %d\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS, LOGIC_RATE_DEEP - 1);
+        return 1;
+    }
+
+    setDefaults();
+    srand(1);
+
+    /* The jitter moves edges off the sample grid */
+    generateEdges(channels, captures + 10, jitter_usec, UINT32_MAX, edges);
+
+    SimSignal sig(edges);
+
+    for (uint8_t r = 0; r < LOGIC_RATE_DEEP; r++) {
+
+        uint32_t checked = 0;
+        uint32_t errors = 0;
+        size_t k = 0;
+
+        if (rate >= 0 && r != rate) {
+            continue;
+        }
+
+        for (uint32_t c = 0; c < captures; c++) {
+
+            uint64_t e;
+
+            /* Spread the captures over the signal, on an edge of the trigger polarity */
+            k = (size_t)((uint64_t)c * (sig.count() - 2 * channels - 4) / captures) + rand() % (2 * channels);
+            if (triggerMode != ACQ_TRIGGER_FREE) {
+                while (sig.edgeLevel(k) != (triggerMode == ACQ_TRIGGER_RISING)) {
+                    k++;
+                }
+                e = sig.edgeCycles(k);
+            }
+            else {
+                e = sig.edgeCycles(k) + LOGIC_START_CYCLES + rand() % 1000;
+            }
+
+            errors += capture(sig, e, r, triggerMode, acq, &checked);
+
+            if (verbose && c == 0) {
+                listPulses(acq);
+            }
+        }
+
+        printf("%4u kHz: %u captures, %u edges, %s\n", 16000 / LOGIC_CYCLES(r), captures, checked,
+               errors ? "FAILED" : "ok");
+        if (errors) {
+            failed++;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,387 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMRace
+ *
+ * Checks the Timer 1 overflow race of the capture ISRs in PPM.cpp on a Linux host.
+ *
+ * PPM.cpp is compiled against the register model in Arduino.h. A simulated
+ * Timer 1 sets TOV1 on every overflow and ICF1 or the pin change flag on every
+ * edge. Pending interrupts run by AVR priority (PCINT0, TIMER1_CAPT, TIMER1_OVF)
+ * once interrupts are enabled again. Each edge comes with a window of disabled
+ * interrupts around it, so an overflow may be pending when the edge ISR runs.
+ * The timer also runs on between the register reads of an ISR.
+ *
+ * Edges are placed close to overflows. Every ISR sees one of four cases,
+ * ICR1 (or TCNT1 in PCINT0_vect) with bit 15 set or clear and an overflow
+ * pending or not. All four have to come up for both ISRs.
+ *
+ * TIMER1_CAPT_vect runs a PWM scan, every published high and low time must
+ * match the edge times exactly. PCINT0_vect runs a servo scan on D8, pulse
+ * and period must match the times Timer 1 was read by the ISR.
+ * Both run at 0.5 usec and 62.5 nsec.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmrace PPMRace.cpp PPMHost.cpp ../PPMInspect/PPM.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/ServoDecoder.cpp ../PPMInspect/LatencyMeter.cpp ../PPMInspect/EdgeStream.cpp
+ *
+ * Usage:
+ *   ppmrace [-n edges] [-v]
+ *
+ * -v prints the published times.
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "PPM.h"
+
+extern PPM ppm;
+
+ISR(TIMER1_OVF_vect);
+ISR(TIMER1_CAPT_vect);
+ISR(PCINT0_vect);
+
+/* Interrupts are disabled up to this long before and after an edge */
+#define RACE_BLOCK_TICKS      96
+/* Edges land within this distance of an overflow */
+#define RACE_NEAR_TICKS       48
+/* The timer runs up to this far between two register reads of an ISR */
+#define RACE_READ_TICKS        3
+
+/* Pulse and period in usec */
+#define RACE_PULSE_MIN      1000
+#define RACE_PULSE_MAX      2000
+#define RACE_PERIOD_MIN    15000
+
+#define ISR_NONE    0
+#define ISR_CAPT    1
+#define ISR_PCINT   2
+
+/* Absolute timer ticks */
+static uint64_t now;
+static uint8_t runningIsr = ISR_NONE;
+/* TCNT1 as read by PCINT0_vect */
+static uint16_t pcintTicks;
+static uint64_t pcintTime;
+
+/* Cases seen, [ISR_CAPT - 1 or ISR_PCINT - 1][bit 15][overflow pending] */
+static uint32_t cases[2][2][2];
+
+/* Edges input capture was not set up for */
+static uint32_t ignored;
+
+static bool verbose = false;
+static uint32_t failed;
+
+/* Run Timer 1 up to t, overflows set TOV1 */
+static void runTimer(uint64_t t) {
+
+    uint64_t next;
+
+    while (now < t) {
+        next = (now | 0xffff) + 1;
+        if (next <= t) {
+            now = next;
+            TIFR1.value |= bit(TOV1);
+        }
+        else {
+            now = t;
+        }
+    }
+    TCNT1.value = (uint16_t)now;
+}
+
+/* Register read within an ISR */
+static void regRead(const char *name) {
+
+    if (runningIsr == ISR_NONE) {
+        return;
+    }
+
+    runTimer(now + rand() % (RACE_READ_TICKS + 1));
+
+    if (runningIsr == ISR_PCINT && !strcmp(name, "TCNT1")) {
+        pcintTicks = TCNT1.value;
+        pcintTime = now;
+    }
+    else if (!strcmp(name, "TIFR1")) {
+        uint16_t ticks = (runningIsr == ISR_CAPT) ? ICR1.value : pcintTicks;
+        cases[runningIsr - 1][ticks >> 15][TIFR1.value & bit(TOV1)]++;
+    }
+}
+
+/* Run pending interrupts by priority. The hardware clears the flag on entry. */
+static void dispatch() {
+
+    for (;;) {
+        if ((PCICR.value & bit(PCIE0)) && (PCIFR.value & bit(PCIF0))) {
+            PCIFR.value &= ~bit(PCIF0);
+            runningIsr = ISR_PCINT;
+            PCINT0_vect();
+        }
+        else if ((TIMSK1.value & bit(ICIE1)) && (TIFR1.value & bit(ICF1))) {
+            TIFR1.value &= ~bit(ICF1);
+            runningIsr = ISR_CAPT;
+            TIMER1_CAPT_vect();
+        }
+        else if ((TIMSK1.value & bit(TOIE1)) && (TIFR1.value & bit(TOV1))) {
+            TIFR1.value &= ~bit(TOV1);
+            runningIsr = ISR_NONE;
+            TIMER1_OVF_vect();
+        }
+        else {
+            break;
+        }
+        runningIsr = ISR_NONE;
+    }
+}
+
+/* Run with interrupts enabled up to t */
+static void runEnabled(uint64_t t) {
+
+    uint64_t next;
+
+    while (now < t) {
+        next = (now | 0xffff) + 1;
+        runTimer((next < t) ? next : t);
+        dispatch();
+    }
+}
+
+/* Edge at t within a window of disabled interrupts */
+static void edge(uint64_t t, bool level, bool capture) {
+
+    runEnabled(t - rand() % (RACE_BLOCK_TICKS + 1));
+
+    runTimer(t);
+    if (capture) {
+        /* Input capture triggers on the edge selected by ICES1.
+         * The scan starts with a falling edge, the first rising one is missed.
+         */
+        if (((TCCR1B.value & bit(ICES1)) != 0) == level) {
+            ICR1.value = (uint16_t)now;
+            TIFR1.value |= bit(ICF1);
+        }
+        else {
+            ignored++;
+        }
+    }
+    else {
+        PCIFR.value |= bit(PCIF0);
+    }
+    PINB.value = level ? 1 : 0;
+
+    runTimer(t + rand() % (RACE_BLOCK_TICKS + 1));
+    dispatch();
+}
+
+/* Next edge time, after `after` and close to an overflow if near */
+static uint64_t nextEdge(uint64_t after, bool near) {
+
+    uint64_t ovf = (after | 0xffff) + 1;
+
+    if (!near) {
+        return after + rand() % 0x10000;
+    }
+    return ovf - RACE_NEAR_TICKS + rand() % (2 * RACE_NEAR_TICKS + 1);
+}
+
+static void check(const char *what, uint32_t got, uint32_t expect) {
+
+    if (got != expect) {
+        printf("FAIL %s %u, expected %u\n", what, got, expect);
+        failed++;
+    }
+}
+
+/*
+ * PWM scan. Rising or falling edge close to an overflow.
+ * Checks every published set against the last period.
+ */
+static void runCapture(uint32_t edges, uint8_t shift) {
+
+    uint32_t tpu = 1U << shift;
+    uint64_t rise = 0, fall = 0, lastRise, lastFall;
+    uint32_t published = 0;
+    uint32_t miss = 0;
+    const pwm_t *p;
+
+    ppm.startPWMScan();
+    now = 0;
+    TIFR1.value = 0;
+    ignored = 0;
+
+    for (uint32_t i = 0; i < edges; i++) {
+
+        uint32_t pulse = (RACE_PULSE_MIN + rand() % (RACE_PULSE_MAX - RACE_PULSE_MIN)) * tpu;
+        bool nearFall = rand() & 1;
+
+        lastRise = rise;
+        lastFall = fall;
+        rise = nextEdge(now + RACE_PERIOD_MIN * tpu, (rand() % 4) != 0);
+        if (nearFall) {
+            rise -= pulse;
+        }
+        fall = rise + pulse;
+
+        edge(rise, true, true);
+        ppm.processEdges();
+
+        p = ppm.getPWM();
+        if (p->frames != published) {
+            published = p->frames;
+            check("pwm high", p->pulseH_us10[p->lastUsed],
+                  PPMDecoder::toUs10((uint32_t)(lastFall - lastRise) << (4 - shift)));
+            check("pwm low", p->pulseL_us10[p->lastUsed],
+                  PPMDecoder::toUs10((uint32_t)(rise - lastFall) << (4 - shift)));
+            if (verbose) {
+                printf("H %u L %u usec10\n", p->pulseH_us10[p->lastUsed], p->pulseL_us10[p->lastUsed]);
+            }
+            miss = p->miss;
+        }
+
+        edge(fall, false, true);
+        ppm.processEdges();
+    }
+
+    ppm.stopScan();
+
+    printf("capture %s: %u periods published, %u timeouts\n",
+           shift == DECODER_SHIFT_62NS ? "62.5 nsec" : "0.5 usec", published, miss);
+    if (ignored > 1) {
+        printf("FAIL %u edges not captured\n", ignored);
+        failed++;
+    }
+    if (published + 3 < edges || miss) {
+        printf("FAIL periods lost\n");
+        failed++;
+    }
+}
+
+/*
+ * Servo scan, one output on D8. Timestamps are TCNT1 read by the ISR.
+ */
+static void runPinChange(uint32_t edges, uint8_t shift) {
+
+    uint32_t tpu = 1U << shift;
+    uint64_t rise = 0, riseRead = 0, lastRiseRead, fallRead = 0;
+    uint32_t published = 0;
+    const servo_t *s;
+
+    ppm.startServoScan();
+    now = 0;
+    TIFR1.value = 0;
+
+    for (uint32_t i = 0; i < edges; i++) {
+
+        uint32_t pulse = (RACE_PULSE_MIN + rand() % (RACE_PULSE_MAX - RACE_PULSE_MIN)) * tpu;
+        bool nearFall = rand() & 1;
+
+        rise = nextEdge(now + RACE_PERIOD_MIN * tpu, (rand() % 4) != 0);
+        if (nearFall) {
+            rise -= pulse;
+        }
+
+        lastRiseRead = riseRead;
+        edge(rise, true, false);
+        riseRead = pcintTime;
+        ppm.processEdges();
+
+        s = ppm.getServo();
+        if (s->frames != published && i > 1) {
+            published = s->frames;
+            check("servo pulse", s->ch[0].pulse_us10,
+                  PPMDecoder::toUs10((uint32_t)(fallRead - lastRiseRead) << (4 - shift)));
+            check("servo period", s->ch[0].period_usec, (uint32_t)(riseRead - lastRiseRead) >> shift);
+            if (verbose) {
+                printf("pulse %u usec10, period %u usec\n", s->ch[0].pulse_us10, s->ch[0].period_usec);
+            }
+        }
+
+        edge(rise + pulse, false, false);
+        fallRead = pcintTime;
+        ppm.processEdges();
+    }
+
+    ppm.stopScan();
+
+    printf("pin change %s: %u periods published\n",
+           shift == DECODER_SHIFT_62NS ? "62.5 nsec" : "0.5 usec", published);
+    if (published + 3 < edges) {
+        printf("FAIL periods lost\n");
+        failed++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    static const char *isrName[2] = { "TIMER1_CAPT_vect", "PCINT0_vect" };
+    int opt;
+    uint32_t edges = 20000;
+
+    while ((opt = getopt(argc, argv, "n:v")) != -1) {
+        switch (opt) {
+        case 'n': edges = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-n edges] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    setDefaults();
+    srand(1);
+    hostRegRead = regRead;
+
+    settings.captureRes = CAPTURE_RES_500NS;
+    runCapture(edges, DECODER_SHIFT_500NS);
+    runPinChange(edges, DECODER_SHIFT_500NS);
+    settings.captureRes = CAPTURE_RES_62NS;
+    runCapture(edges, DECODER_SHIFT_62NS);
+    runPinChange(edges, DECODER_SHIFT_62NS);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        printf("%-16s bit 15 clear: %6u, %6u pending   bit 15 set: %6u, %6u pending\n", isrName[i],
+               cases[i][0][0], cases[i][0][1], cases[i][1][0], cases[i][1][1]);
+        for (uint8_t h = 0; h < 2; h++) {
+            for (uint8_t o = 0; o < 2; o++) {
+                if (cases[i][h][o] == 0) {
+                    printf("FAIL %s never saw bit 15 %s, overflow %s\n", isrName[i],
+                           h ? "set" : "clear", o ? "pending" : "not pending");
+                    failed++;
+                }
+            }
+        }
+    }
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMReplay
+ *
+ * Feeds recorded or synthetic edge streams into PPMDecoder on a Linux host
+ * and reports the decoded result together with decoder throughput.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmreplay PPMReplay.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmreplay [-c channels] [-f frames] [-j jitter_usec] [-b badframe] [-r repeat] [edgefile]
+ *
+ * Without edgefile a synthetic PPM stream is generated.
+ * -b drops the last channel of the given frame to trigger a bad frame capture.
+ * An edgefile has one edge per line: "<ticks> <level>"
+ * ticks is the extended timer value in 0.5 usec units, level is 0 or 1.
+ * Timestamps wrap around at 32 bit.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+
+int main(int argc, char *argv[]) {
+
+    std::vector<tickedge_t> edges;
+    PPMDecoder decoder;
+    ppm_t wSet;
+    ppm_t stableSet;
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t frames = 1000;
+    uint16_t jitter_usec = 0;
+    uint32_t repeat = 100;
+    uint32_t badFrame = UINT32_MAX;
+
+    uint64_t start, t0, t1, total;
+    uint64_t worst = 0;
+    uint32_t published = 0;
+
+    while ((opt = getopt(argc, argv, "c:f:j:b:r:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'f': frames = atoi(optarg); break;
+        case 'j': jitter_usec = atoi(optarg); break;
+        case 'b': badFrame = atoi(optarg); break;
+        case 'r': repeat = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-c channels] [-f frames] [-j jitter_usec] [-b badframe] [-r repeat] [edgefile]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || repeat == 0) {
+        fprintf(stderr, "channels must be %d - %d, repeat > 0\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS);
+        return 1;
+    }
+
+    setDefaults();
+
+    if (optind < argc) {
+        if (!readEdges(argv[optind], edges)) {
+            return 1;
+        }
+    }
+    else {
+        generateEdges(channels, frames, jitter_usec, badFrame, edges);
+    }
+
+    if (edges.empty()) {
+        fprintf(stderr, "no edges\n");
+        return 1;
+    }
+
+    /* Pass 1: decode once, timing every single edge */
+    memset(&wSet, 0, sizeof(ppm_t));
+    memset(&stableSet, 0, sizeof(ppm_t));
+    decoder.reset(DETECT_STEP_INIT, edges[0].ticks);
+
+    for (const tickedge_t &e : edges) {
+        t0 = nowNsec();
+        if (decoder.ppmEdge(&wSet, e.ticks, e.level)) {
+            memcpy(&stableSet, &wSet, sizeof(ppm_t));
+            published++;
+        }
+        t1 = nowNsec();
+        if (t1 - t0 > worst) {
+            worst = t1 - t0;
+        }
+    }
+
+    printPPM(&stableSet);
+    printForensic(decoder.getForensic());
+
+    /* Pass 2: throughput */
+    start = nowNsec();
+
+    for (uint32_t r = 0; r < repeat; r++) {
+        memset(&wSet, 0, sizeof(ppm_t));
+        decoder.reset(DETECT_STEP_INIT, edges[0].ticks);
+
+        for (const tickedge_t &e : edges) {
+            if (decoder.ppmEdge(&wSet, e.ticks, e.level)) {
+                memcpy(&stableSet, &wSet, sizeof(ppm_t));
+            }
+        }
+    }
+
+    total = nowNsec() - start;
+
+    printf("\n%zu edges, %u published sets, %u runs\n", edges.size(), published, repeat);
+    printf("%.1f Medges/sec, %.1f nsec/edge avg, %lu nsec/edge worst (incl. clock overhead)\n",
+           (double)edges.size() * repeat * 1000.0 / total,
+           (double)total / ((double)edges.size() * repeat),
+           (unsigned long)worst);
+
+    return 0;
+}
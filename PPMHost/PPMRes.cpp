@@ -0,0 +1,227 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMRes
+ *
+ * Checks the decoder at both capture resolutions on a Linux host.
+ * Synthetic PPM and PWM signals with sub usec timing are quantized to
+ * 0.5 usec and 62.5 nsec ticks. Decoded pulse, channel and PWM times
+ * (0.1 usec) and the channel mean must match the exact values within
+ * one tick. The tick counter wraps around 32 bit during the run.
+ * The 10 Hz PWM checks edge times beyond UINT16_MAX usec and, with a
+ * 60 msec high time, the duty cycle beyond 32 bit of H * 10000.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmres PPMRes.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmres [-c channels] [-f frames]
+ *
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+
+/* Exact signal timing in nsec */
+#define RES_PULSE_NSEC       300200UL
+#define RES_FRAME_NSEC     22500000UL
+#define RES_PWM_HIGH_NSEC   1500300UL
+#define RES_PWM_NSEC       20000000UL
+/* 10 Hz, the low time is longer than UINT16_MAX usec */
+#define RES_PWM_SLOW_NSEC 100000000UL
+/* High time of the 10 Hz PWM with a long pulse */
+#define RES_PWM_LONG_NSEC  60000300UL
+
+/* Ticks left before the 32 bit timestamp wraps */
+#define RES_WRAP_TICKS      100000UL
+
+static uint32_t failed;
+
+/* Channel ch: 1000 usec + 100 usec per channel + a fraction */
+static uint32_t servoNsec(uint8_t ch) {
+
+    return 1000000UL + ch * 100000UL + 337UL + ch * 111UL;
+}
+
+static uint32_t toTicks(uint32_t start, uint64_t nsec, uint8_t shift) {
+
+    return start + (uint32_t)((nsec << shift) / 1000);
+}
+
+/* Expected value in 0.1 usec, must be within one tick plus rounding */
+static void check(const char *what, uint8_t ch, uint32_t got_us10, uint32_t exact_nsec, uint8_t shift) {
+
+    int32_t err = (int32_t)(got_us10 * 100) - (int32_t)exact_nsec;
+    int32_t limit = (1000 >> shift) + 50;
+
+    if (err < -limit || err > limit) {
+        printf("FAIL %-8s C%-2u got %u.%u usec, exact %u.%03u usec\n", what, ch + 1,
+               got_us10 / 10, got_us10 % 10, exact_nsec / 1000, exact_nsec % 1000);
+        failed++;
+    }
+}
+
+static void checkPPM(uint8_t channels, uint32_t frames, uint8_t shift) {
+
+    HostPPM host;
+    uint32_t start = UINT32_MAX - RES_WRAP_TICKS;
+    uint64_t t;
+    uint32_t publishedBefore;
+    const ppm_t *p = &host.stableSet;
+    const ppmstats_t *st;
+
+    host.reset(start, shift);
+
+    for (uint32_t f = 0; f < frames; f++) {
+
+        t = (uint64_t)f * RES_FRAME_NSEC;
+
+        for (uint8_t ch = 0; ch <= channels; ch++) {
+            host.edge(toTicks(start, t, shift), 0);
+            t += RES_PULSE_NSEC;
+            host.edge(toTicks(start, t, shift), EDGE_LEVEL);
+
+            if (ch < channels) {
+                t += servoNsec(ch) - RES_PULSE_NSEC;
+            }
+        }
+    }
+
+    /* Close the last frame */
+    publishedBefore = host.published;
+    host.edge(toTicks(start, (uint64_t)frames * RES_FRAME_NSEC, shift), 0);
+
+    printf("%s: %u published sets\n", (shift == DECODER_SHIFT_62NS) ? "62.5 nsec" : "0.5 usec", host.published);
+    printPPM(p);
+
+    if (!p->sync || p->channels != channels || host.published == publishedBefore) {
+        printf("FAIL no sync, %u channels\n", p->channels);
+        failed++;
+        return;
+    }
+
+    if (p->frameMin_usec < RES_FRAME_NSEC / 1000 - 1 || p->frameMax_usec > RES_FRAME_NSEC / 1000 + 1) {
+        printf("FAIL frame %u - %u usec\n", p->frameMin_usec, p->frameMax_usec);
+        failed++;
+    }
+
+    check("pulseMin", 0, p->pulseMin_us10, RES_PULSE_NSEC, shift);
+    check("pulseMax", 0, p->pulseMax_us10, RES_PULSE_NSEC, shift);
+
+    st = host.getDecoder().getStats();
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        check("channel", ch, p->channel_us10[ch], servoNsec(ch), shift);
+        check("min", ch, p->channelMin_us10[ch], servoNsec(ch), shift);
+        check("max", ch, p->channelMax_us10[ch], servoNsec(ch), shift);
+        /* mean_q8 is usec * 256, as 0.1 usec */
+        check("mean", ch, (uint32_t)((st->mean_q8[ch] * 10 + 128) / 256), servoNsec(ch), shift);
+    }
+}
+
+static void checkPWM(uint32_t frames, uint64_t period_nsec, uint64_t high_nsec, uint8_t shift) {
+
+    PPMDecoder decoder;
+    pwm_t wSet;
+    uint32_t start = UINT32_MAX - RES_WRAP_TICKS;
+    uint64_t t;
+    double duty;
+    uint16_t got;
+
+    memset(&wSet, 0, sizeof(pwm_t));
+    decoder.reset(DETECT_STEP_PWM, start, shift);
+
+    for (uint32_t f = 0; f < frames; f++) {
+        t = (uint64_t)f * period_nsec;
+        decoder.pwmEdge(&wSet, toTicks(start, t, shift), true);
+        decoder.pwmEdge(&wSet, toTicks(start, t + high_nsec, shift), false);
+    }
+    decoder.pwmEdge(&wSet, toTicks(start, (uint64_t)frames * period_nsec, shift), true);
+
+    printf("PWM H %u.%u usec, L %u.%u usec, frame %u - %u usec\n",
+           wSet.pulseH_us10[wSet.lastUsed] / 10, wSet.pulseH_us10[wSet.lastUsed] % 10,
+           wSet.pulseL_us10[wSet.lastUsed] / 10, wSet.pulseL_us10[wSet.lastUsed] % 10,
+           wSet.frameMin_usec, wSet.frameMax_usec);
+
+    check("pwmH", 0, wSet.pulseH_us10[wSet.lastUsed], high_nsec, shift);
+    check("pwmL", 0, wSet.pulseL_us10[wSet.lastUsed], period_nsec - high_nsec, shift);
+
+    /* 0.01 %, scaling down may lose one step */
+    duty = 10000.0 * high_nsec / period_nsec;
+    got = pwmDuty(&wSet, wSet.lastUsed);
+    if (got > duty + 1 || got + 1 < duty) {
+        printf("FAIL pwm duty %u.%02u %%, expected %.4f %%\n", got / 100, got % 100, duty / 100);
+        failed++;
+    }
+
+    if (wSet.frameMin_usec < period_nsec / 1000 - 1 || wSet.frameMax_usec > period_nsec / 1000 + 1) {
+        printf("FAIL pwm frame %u - %u usec\n", wSet.frameMin_usec, wSet.frameMax_usec);
+        failed++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t frames = 200;
+
+    while ((opt = getopt(argc, argv, "c:f:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'f': frames = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-c channels] [-f frames]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || frames < 10) {
+        fprintf(stderr, "channels must be %d - %d, frames >= 10\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS);
+        return 1;
+    }
+
+    setDefaults();
+
+    checkPPM(channels, frames, DECODER_SHIFT_500NS);
+    checkPWM(frames, RES_PWM_NSEC, RES_PWM_HIGH_NSEC, DECODER_SHIFT_500NS);
+    checkPWM(frames, RES_PWM_SLOW_NSEC, RES_PWM_HIGH_NSEC, DECODER_SHIFT_500NS);
+    checkPWM(frames, RES_PWM_SLOW_NSEC, RES_PWM_LONG_NSEC, DECODER_SHIFT_500NS);
+    printf("\n");
+    checkPPM(channels, frames, DECODER_SHIFT_62NS);
+    checkPWM(frames, RES_PWM_NSEC, RES_PWM_HIGH_NSEC, DECODER_SHIFT_62NS);
+    checkPWM(frames, RES_PWM_SLOW_NSEC, RES_PWM_HIGH_NSEC, DECODER_SHIFT_62NS);
+    checkPWM(frames, RES_PWM_SLOW_NSEC, RES_PWM_LONG_NSEC, DECODER_SHIFT_62NS);
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
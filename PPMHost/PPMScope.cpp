@@ -0,0 +1,495 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmscope
+ *
+ * Runs the scope acquisition (PPMInspect/ScopeAcq.h) against a synthetic
+ * PPM signal. Conversions are paced like Timer 1 does it on the device.
+ * Checks that the trigger sample lands where the display expects it.
+ * With equivalent time sampling (res_usec < 10) every record index is checked
+ * against the signal at its time after the trigger edge.
+ * In roll mode (res_usec >= 500, as ScopeScreen sends it for "5m" and "10m") the
+ * display fetches with every 100 msec tick and each fetch is checked to end with
+ * the newest sample, without gaps.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmscope PPMScope.cpp PPMCap.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmscope [-c channels] [-r res_usec] [-o|-P] [-t f|+|-] [-l level_0.1V] [-d delay_usec] [-p pretrigger_pct]
+ *            [-g glitch_usec] [-s slew_usec] [-n captures] [-a] [-w out.ppmcap]
+ *
+ * The signal is a negative PPM stream, 0.1V low and 5V high.
+ * -o averages (oversampling), -P keeps min and max per sample (peak detect).
+ * -g adds a low glitch 15 msec into each frame, within the sync gap.
+ * -s ramps the level linearly over slew_usec after each edge.
+ * -a prints all sample values.
+ * Samples with min and max on both sides of the trigger level are shown as '|'.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "PPMHost.h"
+#include "PPMCap.h"
+#include "ScopeAcq.h"
+
+/* Raw 8 bit ADC values, 15.3V == 255 */
+#define SIM_LOW      2
+#define SIM_HIGH    83
+
+/* Conversion time and ISR entry until TCNT1 is reset on trigger */
+#define SIM_ISR_TICKS  4
+
+/* Input capture ISR entry after the edge */
+#define SIM_CAPT_TICKS  8
+
+/* Glitch position within the 22.5 msec frame */
+#define SIM_GLITCH_TICKS  (15000UL * 2)
+
+/* ScopeScreen restarts the capture with the next 100 msec tick */
+#define SIM_RESTART_TICKS  (100000UL * 2)
+
+/* Roll mode: ScopeScreen fetches with every 100 msec tick, 3 sec per capture */
+#define SIM_FETCH_TICKS  (100000UL * 2)
+#define SIM_ROLL_FETCHES   30
+
+/* Analog level of an edge list */
+class SimSignal {
+
+    private:
+        const std::vector<tickedge_t> &edges;
+        uint32_t slew;
+
+    public:
+        SimSignal(const std::vector<tickedge_t> &e, uint32_t slewTicks) : edges(e), slew(slewTicks) {}
+
+        bool atEnd(uint32_t t) const { return t >= edges.back().ticks; }
+
+        uint8_t at(uint32_t t) const {
+
+            auto it = std::upper_bound(edges.begin(), edges.end(), t,
+                                       [](uint32_t v, const tickedge_t &e) { return v < e.ticks; });
+
+            /* High before the first edge */
+            if (it == edges.begin()) {
+                return SIM_HIGH;
+            }
+            --it;
+
+            uint8_t to = it->level ? SIM_HIGH : SIM_LOW;
+            uint8_t from = it->level ? SIM_LOW : SIM_HIGH;
+            uint32_t since = t - it->ticks;
+
+            if (since >= slew) {
+                return to;
+            }
+            return from + ((int)to - from) * (int)since / (int)slew;
+        }
+
+        /* First edge after t with the level given. Returns false at the end. */
+        bool nextEdge(uint32_t t, bool level, uint32_t *e) const {
+
+            auto it = std::upper_bound(edges.begin(), edges.end(), t,
+                                       [](uint32_t v, const tickedge_t &e) { return v < e.ticks; });
+
+            for (; it != edges.end(); ++it) {
+                if (it->level == level) {
+                    *e = it->ticks;
+                    return true;
+                }
+            }
+            return false;
+        }
+};
+
+/* Real time sampling. Returns false if no trigger was found. */
+static bool captureRealTime(ScopeAcq &acq, const SimSignal &sig, uint32_t *t) {
+
+    uint32_t period = acq.startTicks;
+    uint8_t ev;
+
+    do {
+        *t += period;
+        if (sig.atEnd(*t)) {
+            return false;
+        }
+
+        ev = acq.sample(sig.at(*t));
+
+        if (ev == ACQ_EV_TRIGGER) {
+            /* TCNT1 = 0 in the ISR */
+            *t += SIM_ISR_TICKS;
+            period = acq.sampleTicks;
+        }
+    } while (ev != ACQ_EV_DONE);
+
+    return true;
+}
+
+/*
+ * Equivalent time sampling. Each edge starts a pass, like the input capture ISR does.
+ * Checks every record index against the signal at its time after the edge of its pass.
+ * first gets the ticks from the edge to the first sample of the record.
+ * Returns the number of mismatches or -1 if the signal ended.
+ */
+static int captureETS(ScopeAcq &acq, const SimSignal &sig, uint32_t *t, uint8_t phases, uint16_t *first) {
+
+    uint32_t edge;
+    uint32_t ts;
+    uint16_t offset;
+    uint16_t offset0 = 0;
+    uint8_t pass = 0;
+    uint8_t ev;
+    int errors = 0;
+    std::vector<uint32_t> passEdge;
+
+    do {
+        if (!sig.nextEdge(*t, acq.getTriggerMode() == ACQ_TRIGGER_RISING, &edge)) {
+            return -1;
+        }
+        *t = edge;
+
+        offset = acq.etsTrigger(SIM_CAPT_TICKS);
+        if (offset == 0) {
+            /* Too late for the first sample */
+            continue;
+        }
+        if (pass == 0) {
+            offset0 = offset;
+        }
+        passEdge.push_back(edge);
+        pass++;
+
+        /* Compare match B moves on by sampleTicks after each conversion */
+        ts = edge + offset;
+        do {
+            ev = acq.sample(sig.at(ts));
+            *t = ts;
+            ts += acq.sampleTicks;
+        } while (ev == ACQ_EV_NEXT);
+
+    } while (ev != ACQ_EV_DONE);
+
+    /* Index i was taken by pass i % phases, i / phases samples into the pass */
+    for (uint8_t i = 0; i < SCOPE_SAMPLES; i++) {
+        uint32_t ti = passEdge[i % phases] + offset0 + (uint32_t)i * (acq.sampleTicks / phases);
+        if (acq.getSamples()[i] != sig.at(ti)) {
+            errors++;
+        }
+    }
+    *first = offset0;
+
+    return errors;
+}
+
+/*
+ * Roll mode. Conversions run on while fetches unroll the buffer like PPM::fetchArray().
+ * Checks that stored samples are one sample period apart, that a fetch ends with
+ * the newest sample and holds the samples before it in order.
+ * Returns the number of mismatches or -1 if the signal ended.
+ */
+static int captureRoll(ScopeAcq &acq, const SimSignal &sig, uint32_t *t, uint16_t resUsec,
+                       uint8_t out[], uint8_t outMin[]) {
+
+    std::vector<uint8_t> stored;
+    uint32_t fetchAt = *t + SIM_FETCH_TICKS;
+    uint32_t last = 0;
+    uint8_t rolled = acq.rolled;
+    uint8_t fetches = 0;
+    uint8_t idx;
+    uint8_t v;
+    int errors = 0;
+
+    while (fetches < SIM_ROLL_FETCHES) {
+
+        *t += acq.sampleTicks;
+        if (sig.atEnd(*t)) {
+            return -1;
+        }
+
+        v = sig.at(*t);
+        if (acq.sample(v) != ACQ_EV_NONE) {
+            errors++;
+        }
+
+        if (acq.rolled != rolled) {
+            rolled = acq.rolled;
+            idx = acq.getFirst() ? acq.getFirst() - 1 : SCOPE_SAMPLES - 1;
+            stored.push_back(acq.getSamples()[idx]);
+            /* The signal is flat between edges, a plain sample is the last conversion */
+            if (acq.getMinSamples() == nullptr && acq.getSamples()[idx] != v && acq.sampleTicks == resUsec * 2U) {
+                errors++;
+            }
+            if (last && *t - last != resUsec * 2U) {
+                errors++;
+            }
+            last = *t;
+        }
+
+        if (*t >= fetchAt) {
+
+            const uint8_t *mins = acq.getMinSamples();
+
+            idx = acq.getFirst();
+            for (uint8_t i = 0; i < SCOPE_SAMPLES; i++) {
+                out[i] = acq.getSamples()[idx];
+                outMin[i] = mins ? mins[idx] : out[i];
+                if (++idx >= SCOPE_SAMPLES) {
+                    idx = 0;
+                }
+            }
+
+            /* Zero until the buffer is full once */
+            for (uint8_t i = 0; i < SCOPE_SAMPLES; i++) {
+                size_t back = SCOPE_SAMPLES - i;
+                uint8_t expect = (back <= stored.size()) ? stored[stored.size() - back] : 0;
+                if (out[i] != expect) {
+                    errors++;
+                }
+            }
+
+            fetchAt += SIM_FETCH_TICKS;
+            fetches++;
+        }
+    }
+
+    return errors;
+}
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-c channels] [-r res_usec] [-o|-P] [-t f|+|-] [-l level_0.1V] [-d delay_usec] [-p pretrigger_pct]\n"
+                    "       [-g glitch_usec] [-s slew_usec] [-n captures] [-a] [-w out.ppmcap]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    std::vector<tickedge_t> edges;
+    ScopeAcq acq;
+    scopeparam_t param;
+    PPMCapWriter writer;
+    adcblock_t blk;
+    uint8_t out[SCOPE_SAMPLES];
+    uint8_t outMin[SCOPE_SAMPLES];
+    const uint8_t *mins;
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t captures = 1;
+    uint16_t glitch_usec = 0;
+    uint16_t slew_usec = 0;
+    bool values = false;
+    const char *wname = nullptr;
+
+    uint32_t t = 0;
+    uint32_t t0;
+    uint8_t idx;
+    uint8_t level;
+    uint8_t pre;
+    uint16_t first = 0;
+    int errors = 0;
+    uint32_t failed = 0;
+
+    param.resUsec = 10;
+    param.oversampling = 0;
+    param.triggerMode = ACQ_TRIGGER_RISING;
+    param.triggerLevel = 20;
+    param.triggerDelay = 2500;
+    param.pretrigger = 0;
+
+    while ((opt = getopt(argc, argv, "c:r:oPt:l:d:p:g:s:n:aw:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'r': param.resUsec = atoi(optarg); break;
+        case 'o': param.oversampling = ACQ_OS_AVERAGE; break;
+        case 'P': param.oversampling = ACQ_OS_PEAK; break;
+        case 't':
+            param.triggerMode = (optarg[0] == '+') ? ACQ_TRIGGER_RISING
+                              : (optarg[0] == '-') ? ACQ_TRIGGER_FALLING : ACQ_TRIGGER_FREE;
+            break;
+        case 'l': param.triggerLevel = atoi(optarg); break;
+        case 'd': param.triggerDelay = atoi(optarg); break;
+        case 'p': param.pretrigger = atoi(optarg); break;
+        case 'g': glitch_usec = atoi(optarg); break;
+        case 's': slew_usec = atoi(optarg); break;
+        case 'n': captures = atoi(optarg); break;
+        case 'a': values = true; break;
+        case 'w': wname = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || param.resUsec == 0
+        || (param.resUsec < SCOPE_ARM_USEC && SCOPE_ARM_USEC % param.resUsec) || param.pretrigger > 99) {
+        fprintf(stderr, "channels must be %d - %d, res_usec a divisor or multiple of %d, pretrigger < 100\n",
+                PPM_MIN_CHANNELS, PPM_MAX_CHANNELS, SCOPE_ARM_USEC);
+        return 1;
+    }
+
+    setDefaults();
+
+    /* Enough frames for all captures. A roll mode capture takes SIM_ROLL_FETCHES ticks. */
+    uint32_t frames = (param.resUsec >= SCOPE_ROLL_USEC) ? SIM_ROLL_FETCHES * SIM_FETCH_TICKS / (22500 * 2) + 1 : 10;
+    generateEdges(channels, captures * frames + 10, 0, UINT32_MAX, edges);
+
+    if (glitch_usec) {
+        std::vector<tickedge_t> g;
+        uint32_t gt = SIM_GLITCH_TICKS;
+
+        for (const tickedge_t &e : edges) {
+            /* The sync gap is high, the first edge of a frame ends it */
+            if (e.ticks >= gt) {
+                g.push_back({ gt, false });
+                g.push_back({ gt + glitch_usec * 2U, true });
+                gt += 22500 * 2;
+            }
+            g.push_back(e);
+        }
+        edges.swap(g);
+    }
+
+    SimSignal sig(edges, slew_usec * 2);
+
+    if (wname && !writer.open(wname, PPMCAP_MODE_ADC, settings, 500, 0)) {
+        return 1;
+    }
+
+    level = (uint8_t)(param.triggerLevel * 5 / 3);
+
+    for (uint32_t c = 0; c < captures; c++) {
+
+        acq.start(SCOPE_SAMPLES, &param);
+        pre = acq.getPre();
+        t0 = t;
+
+        if (acq.isRoll()) {
+            errors = captureRoll(acq, sig, &t, param.resUsec, out, outMin);
+            if (errors < 0) {
+                fprintf(stderr, "capture %u: signal ended\n", c);
+                return 1;
+            }
+        }
+        else if (acq.isETS()) {
+            errors = captureETS(acq, sig, &t, SCOPE_ARM_USEC / param.resUsec, &first);
+            if (errors < 0) {
+                fprintf(stderr, "capture %u: not enough edges\n", c);
+                return 1;
+            }
+        }
+        else if (!captureRealTime(acq, sig, &t)) {
+            fprintf(stderr, "capture %u: no trigger\n", c);
+            return 1;
+        }
+
+        /* Unroll like PPM::fetchArray(). Roll mode did it with the last fetch. */
+        mins = acq.getMinSamples();
+        idx = acq.getFirst();
+        for (uint8_t i = 0; i < SCOPE_SAMPLES && !acq.isRoll(); i++) {
+            out[i] = acq.getSamples()[idx];
+            outMin[i] = mins ? mins[idx] : out[i];
+            if (++idx >= SCOPE_SAMPLES) {
+                idx = 0;
+            }
+        }
+
+        printf("capture %u: %.1f msec, first %u, pre %u\n", c, (t - t0) / 2000.0, acq.getFirst(), pre);
+
+        if (values) {
+            for (uint8_t i = 0; i < SCOPE_SAMPLES; i++) {
+                printf("%u %u %u\n", i, outMin[i], out[i]);
+            }
+        }
+
+        for (uint8_t i = 0; i < SCOPE_SAMPLES; i++) {
+            putchar((outMin[i] < level && out[i] > level) ? '|' : out[i] > level ? '#' : '_');
+        }
+        putchar('\n');
+
+        if (acq.isRoll()) {
+
+            printf("roll %s, %d mismatches\n", errors ? "FAILED" : "ok", errors);
+            if (errors) {
+                failed++;
+            }
+        }
+        else if (acq.isETS()) {
+
+            printf("equivalent time %s, %d mismatches\n", errors ? "FAILED" : "ok", errors);
+            if (errors) {
+                failed++;
+            }
+
+            /* The trigger point is triggerDelay after the edge, in the record as taken */
+            uint16_t firstUsec = first / 2;
+            uint8_t expect = (param.triggerDelay > firstUsec) ? (param.triggerDelay - firstUsec) / param.resUsec : 0;
+
+            printf("record starts %u usec after the edge, trigger at %u %s\n",
+                   firstUsec, pre, (pre == expect) ? "ok" : "FAILED");
+            if (pre != expect) {
+                failed++;
+            }
+        }
+        else if (param.triggerMode != ACQ_TRIGGER_FREE) {
+
+            /* Trigger sample is at index pre, or 1 without pre-trigger */
+            uint8_t ti = pre ? pre : 1;
+            /* Peak detect triggers on max (rising) or min (falling) */
+            bool ok = (param.triggerMode == ACQ_TRIGGER_RISING)
+                    ? (out[ti - 1] < level && out[ti] > level)
+                    : (outMin[ti - 1] > level && outMin[ti] < level);
+
+            printf("%*s^ trigger %s\n", ti, "", ok ? "ok" : "FAILED");
+            if (!ok) {
+                failed++;
+            }
+        }
+
+        if (wname) {
+            blk.sample_usec = param.resUsec;
+            blk.triggerDelay_usec = param.triggerDelay;
+            blk.triggerLevel = param.triggerLevel;
+            blk.lsb_mV = 60; /* 15.3V / 255 */
+            blk.oversampling = param.oversampling;
+            blk.triggerMode = param.triggerMode;
+            blk.count = SCOPE_SAMPLES;
+            blk.pretrigger = pre;
+            writer.adcBlock(t0 / 2000, &blk, out);
+        }
+
+        t += SIM_RESTART_TICKS;
+    }
+
+    if (wname && !writer.close()) {
+        return 1;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,423 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMServo
+ *
+ * Checks ServoDecoder, the servo scan on several inputs, on a Linux host.
+ *
+ * Servo outputs are generated as pin events in nsec. A model of the pin
+ * change interrupt turns them into port snapshots like PCINT0_vect in PPM.cpp:
+ * Timer 1 is read on interrupt entry, PINB a few cycles later. Edges until
+ * then share the snapshot, edges while the interrupt runs wait for the next one.
+ * Scenarios cover sequential and simultaneous outputs, mixed frame rates,
+ * dropped snapshots (ring full) and outputs that stop. Each runs at 0.5 usec
+ * and 62.5 nsec with the 32 bit tick count wrapping.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmservo PPMServo.cpp ../PPMInspect/ServoDecoder.cpp
+ *
+ * Usage:
+ *   ppmservo [-j jitter_nsec] [-v]
+ *
+ * -j adds a random interrupt latency of up to jitter_nsec (other interrupts running).
+ * -v prints the decoded channels of every scenario.
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ServoDecoder.h"
+
+/* Interrupt model */
+#define ISR_LATENCY_NSEC     2500
+#define ISR_PINREAD_NSEC      190
+#define ISR_BUSY_NSEC        5000
+
+/* Timer 1 overflow heartbeat, PWM_TIMEOUT_OVERFLOWS at 0.5 usec */
+#define HEARTBEAT_NSEC  (PWM_TIMEOUT_OVERFLOWS * 32768000ULL)
+
+#define RUN_NSEC        1000000000ULL
+#define NEVER           UINT64_MAX
+
+/* Ticks left before the 32 bit timestamp wraps */
+#define WRAP_TICKS      100000UL
+
+typedef struct chanspec_t {
+    uint32_t period_ns;   /* 0 if the pin is not connected */
+    int32_t  offset_ns;   /* First rising edge after 1 msec */
+    uint32_t pulse_ns;
+    uint64_t stop_ns;     /* No more pulses from here on */
+} chanspec_t;
+
+typedef struct scenario_t {
+    const char *name;
+    chanspec_t ch[SERVO_CHANNELS];
+    bool     sameRate;    /* Skew and rank are checked */
+    uint32_t dropEvery;   /* Drop snapshots to force SERVO_LOST, 0 for none */
+} scenario_t;
+
+typedef struct pinevent_t {
+    uint64_t t;
+    uint8_t  ch;
+    bool     level;
+} pinevent_t;
+
+typedef struct snapshot_t {
+    uint64_t t;
+    uint8_t  pins;
+} snapshot_t;
+
+static const scenario_t scenarios[] = {
+    { "sequential", {
+        { 20000000,       0, 1000300, NEVER },
+        { 20000000, 2500000, 1200700, NEVER },
+        { 20000000, 5000000, 1499900, NEVER },
+        { 20000000, 7500000, 1700100, NEVER },
+        { 20000000, 9800000, 1850500, NEVER },
+        { 20000000,12500000, 2000000, NEVER } }, true, 0 },
+    { "simultaneous", {
+        { 20000000,       0, 1100000, NEVER },
+        { 20000000,     300, 1300000, NEVER },
+        { 20000000,    1100, 1500000, NEVER },
+        { 20000000,  -40000, 1700000, NEVER },
+        { 20000000,   25000, 1900000, NEVER },
+        { 20000000,   60000, 2100000, NEVER } }, true, 0 },
+    { "mixed rate", {
+        { 20000000,       0, 1500000, NEVER },
+        {  3003000,  100000,  900400, NEVER },
+        {  2500000,  700000, 1520300, NEVER },
+        { 11000000, 3000000, 1100000, NEVER },
+        {        0,       0,       0, NEVER },
+        {        0,       0,       0, NEVER } }, false, 0 },
+    { "lost", {
+        { 14000000,       0, 1000000, NEVER },
+        { 14000000,    2000, 1250000, NEVER },
+        { 14000000,    4000, 1500000, NEVER },
+        { 14000000,    6000, 1750000, NEVER },
+        { 14000000,    8000, 1900000, NEVER },
+        { 14000000,   10000, 2000000, NEVER } }, true, 97 },
+    { "stop", {
+        { 20000000,       0, 1500000, RUN_NSEC / 2 },
+        { 20000000, 4000000, 1500000, NEVER },
+        { 20000000, 8000000, 1500000, NEVER },
+        { 20000000,12000000, 1500000, RUN_NSEC / 4 },
+        {        0,       0,       0, NEVER },
+        { 20000000,13000000, 1200000, NEVER } }, true, 0 },
+};
+
+static uint32_t jitter_ns = 0;
+static bool verbose = false;
+static uint32_t failed;
+
+static void fail(const char *what, const char *scenario, uint8_t ch, long got, long exp) {
+
+    printf("FAIL %-12s %-10s D%u got %ld, expected %ld\n", scenario, what, SERVO_FIRST_PIN + ch, got, exp);
+    failed++;
+}
+
+static void generate(const scenario_t *sc, std::vector<pinevent_t> &events) {
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        const chanspec_t *c = &sc->ch[ch];
+
+        if (c->period_ns == 0) {
+            continue;
+        }
+        for (uint64_t t = 1000000 + c->offset_ns; t + c->pulse_ns < RUN_NSEC && t < c->stop_ns; t += c->period_ns) {
+            events.push_back({ t, ch, true });
+            events.push_back({ t + c->pulse_ns, ch, false });
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const pinevent_t &a, const pinevent_t &b) { return a.t < b.t; });
+}
+
+/* Pin change interrupt model. Returns the number of snapshots with more than one changed pin. */
+static uint32_t interrupts(const std::vector<pinevent_t> &events, std::vector<snapshot_t> &snaps) {
+
+    size_t i = 0;
+    uint8_t pins = 0;
+    uint8_t last = 0;
+    uint64_t busyUntil = 0;
+    uint32_t multi = 0;
+    bool retrigger = false;
+
+    while (i < events.size() || retrigger) {
+
+        uint64_t trigger = retrigger ? busyUntil : std::max(events[i].t, busyUntil);
+        uint64_t entry = trigger + ISR_LATENCY_NSEC + (jitter_ns ? rand() % (jitter_ns + 1) : 0);
+        uint8_t changed;
+
+        retrigger = false;
+
+        /* The flag is cleared on entry, edges after it trigger again */
+        while (i < events.size() && events[i].t <= entry + ISR_PINREAD_NSEC) {
+            if (events[i].t > entry) {
+                retrigger = true;
+            }
+            if (events[i].level) {
+                pins |= 1 << events[i].ch;
+            }
+            else {
+                pins &= ~(1 << events[i].ch);
+            }
+            i++;
+        }
+
+        changed = pins ^ last;
+        last = pins;
+        if (changed & (changed - 1)) {
+            multi++;
+        }
+
+        snaps.push_back({ entry, pins });
+        busyUntil = entry + ISR_BUSY_NSEC;
+    }
+
+    return multi;
+}
+
+/* Timer 1 overflow ISR. SERVO_IDLE after HEARTBEAT_NSEC without a snapshot. */
+static void heartbeats(std::vector<snapshot_t> &snaps) {
+
+    std::vector<snapshot_t> out;
+    uint64_t last = 0;
+
+    for (const snapshot_t &s : snaps) {
+        while (s.t - last > HEARTBEAT_NSEC) {
+            last += HEARTBEAT_NSEC;
+            out.push_back({ last, SERVO_IDLE });
+        }
+        out.push_back(s);
+        last = s.t;
+    }
+    while (RUN_NSEC - last > HEARTBEAT_NSEC) {
+        last += HEARTBEAT_NSEC;
+        out.push_back({ last, SERVO_IDLE });
+    }
+
+    snaps.swap(out);
+}
+
+/* Drop two snapshots every dropEvery, the next one carries SERVO_LOST like queueEdge() */
+static uint32_t dropSnapshots(std::vector<snapshot_t> &snaps, uint32_t dropEvery) {
+
+    std::vector<snapshot_t> out;
+    uint32_t dropped = 0;
+    bool lost = false;
+
+    for (size_t i = 0; i < snaps.size(); i++) {
+        if (dropEvery && (i % dropEvery) < 2 && i > 0) {
+            dropped++;
+            lost = true;
+            continue;
+        }
+        out.push_back(snaps[i]);
+        if (lost) {
+            out.back().pins |= SERVO_LOST;
+            lost = false;
+        }
+    }
+
+    snaps.swap(out);
+    return dropped;
+}
+
+/* Skew of ch against ref within +/- half a period */
+static int32_t expectedSkew(const scenario_t *sc, uint8_t ch, uint8_t ref) {
+
+    int32_t period = sc->ch[ref].period_ns;
+    int32_t skew = (sc->ch[ch].offset_ns - sc->ch[ref].offset_ns) % period;
+
+    if (skew > period / 2) {
+        skew -= period;
+    }
+    else if (skew < -period / 2) {
+        skew += period;
+    }
+    return skew;
+}
+
+static void run(const scenario_t *sc, uint8_t shift) {
+
+    std::vector<pinevent_t> events;
+    std::vector<snapshot_t> snaps;
+    ServoDecoder decoder;
+    servo_t wSet;
+    servo_t stable;
+    uint32_t start = UINT32_MAX - WRAP_TICKS;
+    uint32_t published = 0;
+    uint32_t multi;
+    uint32_t dropped;
+    uint8_t expActive = 0;
+    uint8_t ref = SERVO_CHANNELS;
+    /* One tick, the interrupt jitter and an edge waiting for a busy interrupt */
+    long tol_ns = (1000 >> shift) + jitter_ns + ISR_BUSY_NSEC + ISR_LATENCY_NSEC;
+    /* Edges far apart are only off by the tick and the jitter, wrapped skews take three edges */
+    long tight_ns = (1000 >> shift) + 2 * jitter_ns + 100;
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s/%s", sc->name, (shift == DECODER_SHIFT_62NS) ? "62ns" : "500ns");
+
+    generate(sc, events);
+    multi = interrupts(events, snaps);
+    heartbeats(snaps);
+    dropped = dropSnapshots(snaps, sc->dropEvery);
+
+    memset(&wSet, 0, sizeof(servo_t));
+    memset(&stable, 0, sizeof(servo_t));
+    decoder.reset(0, shift);
+
+    for (const snapshot_t &s : snaps) {
+        uint32_t ticks = start + (uint32_t)((s.t << shift) / 1000);
+
+        if (decoder.portEdge(&wSet, ticks, s.pins)) {
+            memcpy(&stable, &wSet, sizeof(servo_t));
+            published++;
+
+            /* Every published pulse must be real, also right after lost snapshots */
+            for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+                long err = (long)stable.ch[ch].pulse_us10 * 100 - sc->ch[ch].pulse_ns;
+
+                if ((stable.active & (1 << ch)) && stable.ch[ch].pulse_us10 && labs(err) > tol_ns) {
+                    fail("pulse", name, ch, stable.ch[ch].pulse_us10 * 100, sc->ch[ch].pulse_ns);
+                }
+            }
+        }
+    }
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        if (sc->ch[ch].period_ns && sc->ch[ch].stop_ns == NEVER) {
+            expActive |= 1 << ch;
+            if (ref == SERVO_CHANNELS) {
+                ref = ch;
+            }
+        }
+    }
+
+    printf("%-18s %6zu snapshots, %4u with several pins, %3u dropped, %4u published, %u frames\n",
+           name, snaps.size(), multi, dropped, published, stable.frames);
+
+    if (verbose) {
+        printf("  pin     pulse  period     skew   range  rank\n");
+        for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+            const servoch_t *c = &stable.ch[ch];
+            printf("  D%-2u %7.1f %7u %8.1f %7.1f %5u%s\n", SERVO_FIRST_PIN + ch,
+                   c->pulse_us10 / 10.0, c->period_usec, c->skew_us10 / 10.0,
+                   (c->skewMax_us10 - c->skewMin_us10) / 10.0, stable.rank[ch],
+                   (stable.active & (1 << ch)) ? "" : "  inactive");
+        }
+    }
+
+    if (stable.active != expActive) {
+        fail("active", name, 0, stable.active, expActive);
+        return;
+    }
+    if (stable.reference != ref) {
+        fail("reference", name, ref, stable.reference, ref);
+    }
+    if (stable.frames == 0) {
+        fail("frames", name, ref, 0, 1);
+    }
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        const servoch_t *c = &stable.ch[ch];
+        long period_ns = (long)c->period_usec * 1000;
+
+        if (!(expActive & (1 << ch))) {
+            continue;
+        }
+
+        /* Period in whole usec */
+        if (labs(period_ns - (long)sc->ch[ch].period_ns) > tol_ns + 1000) {
+            fail("period", name, ch, period_ns, sc->ch[ch].period_ns);
+        }
+
+        if (!sc->sameRate) {
+            continue;
+        }
+
+        /* Outputs far apart are exact, close ones share an interrupt */
+        long skew_ns = (long)c->skew_us10 * 100;
+        long exp_ns = expectedSkew(sc, ch, ref);
+        bool close = false;
+
+        for (uint8_t o = 0; o < SERVO_CHANNELS; o++) {
+            if (o != ch && (expActive & (1 << o)) && labs(expectedSkew(sc, ch, o)) < tol_ns) {
+                close = true;
+            }
+        }
+
+        if (labs(skew_ns - exp_ns) > (close ? tol_ns : tight_ns)) {
+            fail("skew", name, ch, skew_ns, exp_ns);
+        }
+        if (!close && labs(((long)c->pulse_us10 * 100) - (long)sc->ch[ch].pulse_ns) > tight_ns) {
+            fail("pulse", name, ch, (long)c->pulse_us10 * 100, sc->ch[ch].pulse_ns);
+        }
+
+        /* Rank follows the skew unless the outputs are too close to tell */
+        for (uint8_t o = 0; o < SERVO_CHANNELS; o++) {
+            if (o != ch && (expActive & (1 << o))
+                    && expectedSkew(sc, o, ref) < exp_ns - tol_ns && stable.rank[o] >= stable.rank[ch]) {
+                fail("rank", name, ch, stable.rank[ch], stable.rank[o] + 1);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:v")) != -1) {
+        switch (opt) {
+        case 'j': jitter_ns = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-j jitter_nsec] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    srand(1);
+
+    for (const scenario_t &sc : scenarios) {
+        run(&sc, DECODER_SHIFT_500NS);
+        run(&sc, DECODER_SHIFT_62NS);
+    }
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
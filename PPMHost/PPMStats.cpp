@@ -0,0 +1,292 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+/*
+ * PPMStats
+ *
+ * Checks the running channel statistics of the decoder (PPMDecoder::storeStats())
+ * against a double precision reference on a Linux host.
+ * Each channel gets its own Gaussian jitter. The reference runs the same moving
+ * averages on the same quantized channel times and counts the same histogram,
+ * including halving all bins when one saturates.
+ *
+ * Tolerances:
+ *   mean     0.05 usec, the rounded fixed point average stops within 1/32 usec
+ *   std dev  0.05 usec + 2 %
+ *   jitter   all bins equal after every frame. A deviation closer than the mean
+ *            tolerance to a bin border may land in either bin, the reference
+ *            then takes over the decoder's bins.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmstats PPMStats.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp
+ *
+ * Usage:
+ *   ppmstats [-c channels] [-f frames] [-s seed]
+ *
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "PPMHost.h"
+
+/* Exact signal timing in nsec */
+#define STATS_PULSE_NSEC       300000UL
+#define STATS_FRAME_NSEC     22500000UL
+
+/* Jitter of channel ch, standard deviation in nsec */
+#define STATS_SIGMA_NSEC(ch)   (300UL + (ch) * 400UL)
+
+#define STATS_MEAN_TOL_USEC    0.05
+#define STATS_SIGMA_TOL_USEC   0.05
+#define STATS_SIGMA_TOL_REL    0.02
+
+/* Ticks left before the 32 bit timestamp wraps */
+#define STATS_WRAP_TICKS      100000UL
+
+typedef struct refstats_t {
+    bool     seeded;
+    double   mean;
+    double   var;
+    uint8_t  jitter[PPM_JITTER_BINS];
+} refstats_t;
+
+static uint32_t failed;
+
+/* Channel ch: 1000 usec + 100 usec per channel + a fraction */
+static uint32_t servoNsec(uint8_t ch) {
+
+    return 1000000UL + ch * 100000UL + 337UL + ch * 111UL;
+}
+
+static uint32_t toTicks(uint32_t start, uint64_t nsec, uint8_t shift) {
+
+    return start + (uint32_t)((nsec << shift) / 1000);
+}
+
+static double gauss() {
+
+    double u1 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* Same moving averages in double, x in usec.
+ * Returns true if the deviation is too close to a bin border to tell the bin.
+ */
+static bool refUpdate(refstats_t *r, double x) {
+
+    double d;
+    double border;
+    int bin;
+
+    if (!r->seeded) {
+        r->mean = x;
+        r->var = 0;
+        r->seeded = true;
+        return false;
+    }
+
+    d = x - r->mean;
+    border = d + 0.5 - floor(d + 0.5);
+    r->mean += d / (1 << PPM_STATS_SHIFT);
+
+    d = (d > 2048.0) ? 2048.0 : (d < -2048.0) ? -2048.0 : d;
+    r->var += (d * d - r->var) / (1 << PPM_STATS_SHIFT);
+
+    bin = (int)floor(d + 0.5) + PPM_JITTER_BINS / 2;
+    bin = (bin < 0) ? 0 : (bin >= PPM_JITTER_BINS) ? PPM_JITTER_BINS - 1 : bin;
+
+    if (r->jitter[bin] == PPM_JITTER_MAX) {
+        for (int b = 0; b < PPM_JITTER_BINS; b++) {
+            r->jitter[b] >>= 1;
+        }
+    }
+    r->jitter[bin]++;
+
+    return border < STATS_MEAN_TOL_USEC || border > 1.0 - STATS_MEAN_TOL_USEC;
+}
+
+/* Histogram of channel ch after a frame. Returns false on a real mismatch. */
+static bool checkJitter(uint8_t ch, const ppmstats_t *st, refstats_t *r, bool unsure) {
+
+    for (uint8_t b = 0; b < PPM_JITTER_BINS; b++) {
+        if (ppmJitter(st, ch, b) != r->jitter[b]) {
+            if (!unsure) {
+                return false;
+            }
+            for (b = 0; b < PPM_JITTER_BINS; b++) {
+                r->jitter[b] = ppmJitter(st, ch, b);
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+/* Digit of a histogram bar as ChannelScreen shows it, 0 for '.' */
+static int barDigit(uint8_t n, uint8_t max) {
+
+    return n ? (n * 9 + max - 1) / max : 0;
+}
+
+static void checkChannel(uint8_t ch, const ppmstats_t *st, const refstats_t *r) {
+
+    double mean = st->mean_q8[ch] / 256.0;
+    double sigma = sqrt(st->var_q8[ch] / 256.0);
+    double refSigma = sqrt(r->var);
+    uint8_t max = 0;
+    uint8_t refMax = 0;
+    uint8_t n;
+    char bars[PPM_JITTER_BINS + 1];
+    char refBars[PPM_JITTER_BINS + 1];
+
+    for (uint8_t b = 0; b < PPM_JITTER_BINS; b++) {
+        n = ppmJitter(st, ch, b);
+        max = (n > max) ? n : max;
+        refMax = (r->jitter[b] > refMax) ? r->jitter[b] : refMax;
+    }
+
+    for (uint8_t b = 0; b < PPM_JITTER_BINS; b++) {
+        int digit = barDigit(ppmJitter(st, ch, b), max);
+        int refDigit = barDigit(r->jitter[b], refMax);
+
+        bars[b] = digit ? '0' + digit : '.';
+        refBars[b] = refDigit ? '0' + refDigit : '.';
+    }
+    bars[PPM_JITTER_BINS] = refBars[PPM_JITTER_BINS] = '\0';
+
+    printf("C%-2u mean %9.3f ref %9.3f  sigma %6.3f ref %6.3f  %s ref %s\n",
+           ch + 1, mean, r->mean, sigma, refSigma, bars, refBars);
+
+    if (fabs(mean - r->mean) > STATS_MEAN_TOL_USEC) {
+        printf("FAIL C%u mean off by %.3f usec\n", ch + 1, mean - r->mean);
+        failed++;
+    }
+    if (fabs(sigma - refSigma) > STATS_SIGMA_TOL_USEC + refSigma * STATS_SIGMA_TOL_REL) {
+        printf("FAIL C%u std dev off by %.3f usec\n", ch + 1, sigma - refSigma);
+        failed++;
+    }
+}
+
+static void checkStats(uint8_t channels, uint32_t frames, uint8_t shift) {
+
+    HostPPM host;
+    refstats_t ref[PPM_MAX_CHANNELS];
+    uint32_t start = UINT32_MAX - STATS_WRAP_TICKS;
+    uint32_t pulseTicks[PPM_MAX_CHANNELS + 1];
+    uint64_t t;
+    const ppmstats_t *st = host.getDecoder().getStats();
+    uint32_t unsure = 0;
+    uint32_t wrongBins = 0;
+
+    memset(ref, 0, sizeof(ref));
+    host.reset(start, shift);
+
+    for (uint32_t f = 0; f < frames; f++) {
+
+        t = (uint64_t)f * STATS_FRAME_NSEC;
+
+        for (uint8_t ch = 0; ch <= channels; ch++) {
+            pulseTicks[ch] = toTicks(start, t, shift);
+            host.edge(pulseTicks[ch], 0);
+            host.edge(toTicks(start, t + STATS_PULSE_NSEC, shift), EDGE_LEVEL);
+
+            if (ch < channels) {
+                t += servoNsec(ch) + (int64_t)llround(gauss() * STATS_SIGMA_NSEC(ch));
+            }
+        }
+
+        /* The decoder sees the channel time between the quantized pulse starts.
+         * It starts the statistics in the frame its mean gets seeded.
+         */
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            if (ref[ch].seeded || st->mean_q8[ch] != 0) {
+                uint32_t q4 = (pulseTicks[ch + 1] - pulseTicks[ch]) << (4 - shift);
+                bool border = refUpdate(&ref[ch], q4 / 16.0);
+
+                if (!checkJitter(ch, st, &ref[ch], border)) {
+                    if (wrongBins++ < 3) {
+                        printf("FAIL C%u frame %u jitter histogram\n", ch + 1, f);
+                    }
+                    failed++;
+                }
+                unsure += border;
+            }
+        }
+    }
+
+    printf("%s, %u frames, %u deviations at a bin border\n",
+           (shift == DECODER_SHIFT_62NS) ? "62.5 nsec" : "0.5 usec", frames, unsure);
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        if (!ref[ch].seeded) {
+            printf("FAIL C%u no statistics\n", ch + 1);
+            failed++;
+            continue;
+        }
+        checkChannel(ch, st, &ref[ch]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint8_t channels = 8;
+    uint32_t frames = 2000;
+    unsigned seed = 1;
+
+    while ((opt = getopt(argc, argv, "c:f:s:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'f': frames = atoi(optarg); break;
+        case 's': seed = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-c channels] [-f frames] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || frames < 10) {
+        fprintf(stderr, "channels must be %d - %d, frames >= 10\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS);
+        return 1;
+    }
+
+    setDefaults();
+    srand(seed);
+
+    checkStats(channels, frames, DECODER_SHIFT_500NS);
+    printf("\n");
+    checkStats(channels, frames, DECODER_SHIFT_62NS);
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
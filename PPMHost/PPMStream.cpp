@@ -0,0 +1,275 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMStream
+ *
+ * Receives the binary edge stream of PPMInspect ("Edge stream" screen)
+ * and decodes it with PPMDecoder. See PPMInspect/EdgeStream.h for the format.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmstream PPMStream.cpp PPMHost.cpp PPMCap.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/EdgeStream.cpp
+ *
+ * Usage:
+ *   ppmstream [-b baud] [-i interval_sec] [-t seconds] [-o edgefile] [-w file.ppmcap] device|-
+ *
+ * Prints the decoded PPM set every interval seconds and at the end.
+ * -o writes all edges in the edge file format of ppmreplay.
+ * -w writes a capture file. The first packet decides between edges and
+ *    scope captures (frozen scope display), packets of the other kind are skipped.
+ * -t stops after the given time, otherwise runs until end of input.
+ * Use ppmstreamsim for a device stand-in.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "EdgeStream.h"
+#include "PPMCap.h"
+
+static speed_t toSpeed(long baud) {
+
+    switch (baud) {
+    case 9600: return B9600;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 500000: return B500000;
+    case 1000000: return B1000000;
+    default: return B0;
+    }
+}
+
+static bool setupTty(int fd, long baud) {
+
+    struct termios tio;
+    speed_t speed = toSpeed(baud);
+
+    if (speed == B0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return false;
+    }
+
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        return false;
+    }
+
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        return false;
+    }
+
+    return true;
+}
+
+static void printStatus(const EdgeStreamReader &reader, const HostPPM &host, uint64_t edges) {
+
+    printf("packets %u, crc errors %u, lost edges %u, edges %lu\n",
+           reader.packets, reader.crcErrors, reader.lostEdges, (unsigned long)edges);
+    printPPM(&host.stableSet);
+}
+
+/* Store a complete packet. Opens the capture file on the first packet. */
+static void writeCapture(PPMCapWriter &writer, uint8_t &mode, const char *capName, EdgeStreamReader &reader) {
+
+    uint16_t capture;
+    uint32_t msec;
+    const adcblock_t *blk;
+    const uint8_t *samples;
+    uint8_t m = reader.isADC() ? PPMCAP_MODE_ADC : PPMCAP_MODE_EDGES;
+
+    if (mode == 0) {
+        /* Timer 1 with prescaler /8 */
+        if (!writer.open(capName, m, settings, 500, reader.getTicks())) {
+            exit(1);
+        }
+        mode = m;
+    }
+
+    if (m == PPMCAP_MODE_ADC && mode == m && reader.getADC(&capture, &msec, &blk, &samples)) {
+        writer.adcBlock(msec, blk, samples);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    EdgeStreamReader reader;
+    PPMCapWriter writer;
+    uint8_t capMode = 0;
+    HostPPM host;
+    FILE *out = nullptr;
+    struct pollfd pfd;
+    uint8_t buf[256];
+    ssize_t n;
+
+    int opt;
+    int fd;
+    long baud = 115200;
+    uint32_t interval = 5;
+    uint32_t duration = 0;
+    const char *outName = nullptr;
+    const char *capName = nullptr;
+
+    uint64_t start, lastStatus, now;
+    uint64_t edges = 0;
+    uint32_t ticks;
+    uint8_t flags;
+    uint16_t capture;
+    uint32_t msec;
+    const adcblock_t *blk;
+    const uint8_t *samples;
+
+    while ((opt = getopt(argc, argv, "b:i:t:o:w:")) != -1) {
+        switch (opt) {
+        case 'b': baud = atol(optarg); break;
+        case 'i': interval = atoi(optarg); break;
+        case 't': duration = atoi(optarg); break;
+        case 'o': outName = optarg; break;
+        case 'w': capName = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-i interval_sec] [-t seconds] [-o edgefile] [-w file.ppmcap] device|-\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "no device\n");
+        return 1;
+    }
+
+    if (strcmp(argv[optind], "-") == 0) {
+        fd = STDIN_FILENO;
+    }
+    else {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    if (isatty(fd) && !setupTty(fd, baud)) {
+        return 1;
+    }
+
+    if (outName) {
+        out = fopen(outName, "w");
+        if (out == nullptr) {
+            perror(outName);
+            return 1;
+        }
+    }
+
+    setDefaults();
+    host.reset(0);
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    start = lastStatus = nowNsec();
+
+    for (;;) {
+        now = nowNsec();
+
+        if (duration && now - start >= duration * 1000000000ULL) {
+            break;
+        }
+
+        if (interval && now - lastStatus >= interval * 1000000000ULL) {
+            printStatus(reader, host, edges);
+            printf("\n");
+            fflush(stdout);
+            lastStatus = now;
+        }
+
+        if (poll(&pfd, 1, 100) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+
+        if (!(pfd.revents & (POLLIN | POLLHUP))) {
+            continue;
+        }
+
+        n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            /* End of file or the device went away */
+            break;
+        }
+
+        for (ssize_t i = 0; i < n; i++) {
+            if (!reader.put(buf[i])) {
+                continue;
+            }
+
+            if (capName) {
+                writeCapture(writer, capMode, capName, reader);
+            }
+
+            if (reader.getADC(&capture, &msec, &blk, &samples)) {
+                printf("scope capture %u, %u samples, %u usec, %u before trigger\n", capture, blk->count, blk->sample_usec, blk->pretrigger);
+            }
+
+            while (reader.getEdge(&ticks, &flags)) {
+                host.edge(ticks, flags);
+
+                if (capMode == PPMCAP_MODE_EDGES) {
+                    writer.edge(ticks, flags);
+                }
+
+                if (!(flags & EDGE_NONE)) {
+                    edges++;
+                    if (out) {
+                        fprintf(out, "%u %u\n", ticks, flags & EDGE_LEVEL);
+                    }
+                }
+            }
+        }
+    }
+
+    printStatus(reader, host, edges);
+    printForensic(host.getDecoder().getForensic());
+
+    if (out) {
+        fclose(out);
+    }
+
+    return writer.close() ? 0 : 1;
+}
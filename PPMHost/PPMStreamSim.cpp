@@ -0,0 +1,188 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMStreamSim
+ *
+ * Device stand-in for ppmstream. Opens a pseudo terminal, prints its name
+ * and sends a synthetic PPM signal as binary edge stream, paced in real time.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmstreamsim PPMStreamSim.cpp PPMHost.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/EdgeStream.cpp
+ *
+ * Usage:
+ *   ppmstreamsim [-c channels] [-f frames] [-j jitter_usec] [-b badframe] [-d dropevery] [-x speed]
+ *
+ *   ppmstreamsim -f 2000 &
+ *   ppmstream -t 30 /dev/pts/N
+ *
+ * -d drops every n-th packet like a full Serial transmit buffer on the device.
+ * -x runs n times faster than real time.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "EdgeStream.h"
+
+static bool writeAll(int fd, const uint8_t *p, size_t sz) {
+
+    ssize_t n;
+
+    while (sz > 0) {
+        n = write(fd, p, sz);
+        if (n < 0) {
+            perror("write");
+            return false;
+        }
+        p += n;
+        sz -= n;
+    }
+
+    return true;
+}
+
+/* Sleep until the edge is due */
+static void pace(uint64_t start, uint32_t ticks, uint32_t speed) {
+
+    uint64_t due = start + (uint64_t)ticks * 500 / speed;
+    uint64_t now = nowNsec();
+    struct timespec ts;
+
+    if (due > now) {
+        ts.tv_sec = (due - now) / 1000000000ULL;
+        ts.tv_nsec = (due - now) % 1000000000ULL;
+        nanosleep(&ts, nullptr);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    std::vector<tickedge_t> edges;
+    EdgeStreamWriter writer;
+    struct termios tio;
+
+    int opt;
+    int master, slave;
+    uint8_t channels = 8;
+    uint32_t frames = 1000;
+    uint16_t jitter_usec = 0;
+    uint32_t badFrame = UINT32_MAX;
+    uint32_t dropEvery = 0;
+    uint32_t speed = 1;
+    uint32_t packets = 0;
+    uint8_t sz;
+    uint64_t start;
+
+    while ((opt = getopt(argc, argv, "c:f:j:b:d:x:")) != -1) {
+        switch (opt) {
+        case 'c': channels = atoi(optarg); break;
+        case 'f': frames = atoi(optarg); break;
+        case 'j': jitter_usec = atoi(optarg); break;
+        case 'b': badFrame = atoi(optarg); break;
+        case 'd': dropEvery = atoi(optarg); break;
+        case 'x': speed = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-c channels] [-f frames] [-j jitter_usec] [-b badframe] [-d dropevery] [-x speed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (channels < PPM_MIN_CHANNELS || channels > PPM_MAX_CHANNELS || speed == 0) {
+        fprintf(stderr, "channels must be %d - %d, speed > 0\n", PPM_MIN_CHANNELS, PPM_MAX_CHANNELS);
+        return 1;
+    }
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+
+    /* Keep the slave open and raw, so nothing is lost or translated
+     * before the reader opens it.
+     */
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+        perror(ptsname(master));
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    setDefaults();
+    generateEdges(channels, frames, jitter_usec, badFrame, edges);
+
+    /* Stream starts with the scan at tick 0, give the reader time to open */
+    sleep(1);
+    writer.reset(0);
+    start = nowNsec();
+
+    for (const tickedge_t &e : edges) {
+        pace(start, e.ticks, speed);
+
+        writer.addEdge(e.ticks, e.level ? EDGE_LEVEL : 0);
+
+        if (writer.isFull()) {
+            sz = writer.finish();
+            packets++;
+
+            if (dropEvery && packets % dropEvery == 0) {
+                writer.next(false);
+            }
+            else {
+                if (!writeAll(master, writer.getPacket(), sz)) {
+                    return 1;
+                }
+                writer.next(true);
+            }
+        }
+    }
+
+    if (!writer.isEmpty()) {
+        sz = writer.finish();
+        writeAll(master, writer.getPacket(), sz);
+        writer.next(true);
+    }
+
+    /* Let the reader drain the pty */
+    tcdrain(slave);
+    sleep(1);
+
+    fprintf(stderr, "%zu edges, %u packets sent, %u dropped\n", edges.size(), writer.packets, writer.dropped);
+
+    close(slave);
+    close(master);
+
+    return 0;
+}
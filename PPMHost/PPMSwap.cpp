@@ -0,0 +1,202 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * PPMSwap
+ *
+ * Checks the triple buffered PPM sets of PPM.cpp on a Linux host.
+ *
+ * A writer stands in for the decoder. It fills the write set one field per
+ * step, every field derived from the frame number, and publishes it with
+ * switchPPMWriteSet(). A reader takes getPPM() and copies the set one field
+ * at a time. A random number of writer steps runs between two reads, like
+ * capture interrupts between the instructions of loop(), sometimes several
+ * frames.
+ *
+ * Every copy must hold a single frame (never torn) and it must be the frame
+ * published last before getPPM().
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmswap PPMSwap.cpp PPMHost.cpp ../PPMInspect/PPM.cpp ../PPMInspect/PPMDecoder.cpp ../PPMInspect/ServoDecoder.cpp ../PPMInspect/LatencyMeter.cpp ../PPMInspect/EdgeStream.cpp
+ *
+ * Usage:
+ *   ppmswap [-n reads]
+ *
+ * Exit code is 0 if all checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "PPMHost.h"
+#include "PPM.h"
+
+extern PPM ppm;
+
+/* Fields written per frame: frames, frame min/max and three per channel */
+#define SWAP_FIELDS     (3 + 3 * PPM_MAX_CHANNELS)
+
+/* Writer steps between two reads, mostly few, sometimes many frames */
+#define SWAP_STEPS_FEW       4
+#define SWAP_STEPS_MANY    (3 * SWAP_FIELDS)
+
+static uint32_t frame = 1;
+static uint8_t field;
+static uint32_t published;
+
+static uint16_t stamp(uint32_t n, uint8_t f) {
+
+    return (uint16_t)(n * 37 + f);
+}
+
+/* Write the next field of the current frame, publish after the last one */
+static void writerStep() {
+
+    ppm_t *w = ppm.getPPMWriteSet();
+    uint8_t ch;
+
+    if (field == 0) {
+        w->frames = frame;
+    }
+    else if (field == 1) {
+        w->frameMin_usec = stamp(frame, field);
+    }
+    else if (field == 2) {
+        w->frameMax_usec = stamp(frame, field);
+    }
+    else {
+        ch = (field - 3) / 3;
+        switch ((field - 3) % 3) {
+        case 0: w->channel_us10[ch] = stamp(frame, field); break;
+        case 1: w->channelMin_us10[ch] = stamp(frame, field); break;
+        default: w->channelMax_us10[ch] = stamp(frame, field); break;
+        }
+    }
+
+    if (++field == SWAP_FIELDS) {
+        ppm.switchPPMWriteSet();
+        published = frame++;
+        field = 0;
+    }
+}
+
+static void preempt() {
+
+    uint32_t steps = (rand() % 8) ? rand() % (SWAP_STEPS_FEW + 1) : rand() % (SWAP_STEPS_MANY + 1);
+
+    while (steps--) {
+        writerStep();
+    }
+}
+
+/* Copy one field of the set the reader holds, writer steps may run before */
+template <typename T>
+static T readField(const T &v) {
+
+    preempt();
+    return v;
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint32_t reads = 200000;
+    uint32_t failed = 0;
+    uint32_t torn = 0;
+    uint32_t stale = 0;
+    uint32_t fresh = 0;
+    uint32_t expect;
+    ppm_t copy;
+    const ppm_t *p;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n': reads = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-n reads]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    setDefaults();
+    srand(1);
+
+    ppm.startPPMScan();
+    ppm.stopScan();
+
+    for (uint32_t r = 0; r < reads; r++) {
+
+        preempt();
+
+        /* getPPM() runs with interrupts disabled */
+        expect = published;
+        p = ppm.getPPM();
+
+        copy.frames = readField(p->frames);
+        copy.frameMin_usec = readField(p->frameMin_usec);
+        copy.frameMax_usec = readField(p->frameMax_usec);
+        for (uint8_t ch = 0; ch < PPM_MAX_CHANNELS; ch++) {
+            copy.channel_us10[ch] = readField(p->channel_us10[ch]);
+            copy.channelMin_us10[ch] = readField(p->channelMin_us10[ch]);
+            copy.channelMax_us10[ch] = readField(p->channelMax_us10[ch]);
+        }
+
+        if (expect == 0) {
+            continue;
+        }
+
+        bool ok = copy.frameMin_usec == stamp(copy.frames, 1) && copy.frameMax_usec == stamp(copy.frames, 2);
+        for (uint8_t ch = 0; ch < PPM_MAX_CHANNELS; ch++) {
+            ok = ok && copy.channel_us10[ch] == stamp(copy.frames, 3 + 3 * ch)
+                    && copy.channelMin_us10[ch] == stamp(copy.frames, 4 + 3 * ch)
+                    && copy.channelMax_us10[ch] == stamp(copy.frames, 5 + 3 * ch);
+        }
+
+        if (!ok) {
+            if (torn++ < 10) {
+                printf("FAIL read %u: torn set, frames %u\n", r, copy.frames);
+            }
+            failed++;
+        }
+        else if (copy.frames != expect) {
+            if (stale++ < 10) {
+                printf("FAIL read %u: frame %u, newest was %u\n", r, copy.frames, expect);
+            }
+            failed++;
+        }
+        else {
+            fresh++;
+        }
+    }
+
+    printf("%u reads, %u frames published, %u newest, %u torn, %u stale\n",
+           reads, published, fresh, torn, stale);
+
+    printf("\n%s, %u failed checks\n", failed ? "FAILED" : "OK", failed);
+
+    return failed ? 1 : 0;
+}
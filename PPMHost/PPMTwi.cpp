@@ -0,0 +1,421 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * ppmtwi
+ *
+ * Runs the display transport queue and TWI state machine (PPMInspect/TwiQueue.h)
+ * against a simulated TWI peripheral and display.
+ * Checks that the display receives every command and data byte in order and
+ * of the right kind. With NACKs injected it checks that only dropped bytes
+ * are missing.
+ *
+ * Compares the time the drawing code is busy with the blocking Wire driver
+ * (SSD1306AsciiWire with OPTIMIZE_I2C), which waits for every transfer.
+ * With the queue the drawing code returns as soon as the rest of the frame
+ * fits into the queue.
+ *
+ * Build:
+ *   g++ -O2 -I. -I../PPMInspect -o ppmtwi PPMTwi.cpp
+ *
+ * Usage:
+ *   ppmtwi [-f frames] [-s spans] [-n nack permille] [-c cpu nsec per byte]
+ *
+ * A frame is like a drawGrid() update: spans of graph bytes, each addressed
+ * with 3 commands, followed by a line of text.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "TwiQueue.h"
+
+/* 400 kHz: 9 clocks per byte */
+#define SIM_BYTE_NSEC      22500
+#define SIM_START_NSEC      2500
+#define SIM_STOP_NSEC       2500
+/* TWI interrupt including entry and exit */
+#define SIM_ISR_NSEC        3000
+
+#define SIM_ADDRESS         0x3c
+
+/* SSD1306Ascii write modes */
+#define MODE_CMD            0
+#define MODE_RAM            1
+#define MODE_RAM_BUF        2
+
+typedef struct op_t {
+    uint8_t b;
+    uint8_t mode;
+} op_t;
+
+typedef struct rx_t {
+    uint8_t b;
+    uint8_t kind;
+} rx_t;
+
+/* The display on the bus */
+class SimDisplay {
+
+    public:
+        std::vector<rx_t> rx;
+        uint32_t transfers = 0;
+        int nackPermille = 0;
+
+        /* Start condition, the next byte is the address */
+        void start() {
+            state = WAIT_ADDRESS;
+        }
+
+        void stop() {
+            state = IDLE;
+        }
+
+        /* Returns true for ACK */
+        bool receive(uint8_t b) {
+
+            if (state == IDLE) {
+                fprintf(stderr, "byte without start\n");
+                bad++;
+                return false;
+            }
+
+            if (nackPermille && rand() % 1000 < nackPermille) {
+                state = IDLE;
+                return false;
+            }
+
+            switch (state) {
+            case WAIT_ADDRESS:
+                if (b != (SIM_ADDRESS << 1)) {
+                    fprintf(stderr, "wrong address %02x\n", b);
+                    bad++;
+                    return false;
+                }
+                transfers++;
+                state = WAIT_CONTROL;
+                break;
+
+            case WAIT_CONTROL:
+                if (b != TWIQ_CONTROL_CMD && b != TWIQ_CONTROL_DATA) {
+                    fprintf(stderr, "wrong control byte %02x\n", b);
+                    bad++;
+                    return false;
+                }
+                kind = (b == TWIQ_CONTROL_DATA) ? TWIQ_DATA : TWIQ_CMD;
+                state = RECEIVE;
+                break;
+
+            default:
+                rx.push_back({ b, kind });
+                break;
+            }
+
+            return true;
+        }
+
+        int errors() const { return bad; }
+
+    private:
+        enum { IDLE, WAIT_ADDRESS, WAIT_CONTROL, RECEIVE } state = IDLE;
+        uint8_t kind = TWIQ_CMD;
+        int bad = 0;
+};
+
+/* The TWI peripheral in master transmitter mode. Time in nsec. */
+class SimTwi {
+
+    public:
+        SimTwi(TwiQueue &q, SimDisplay &d) : queue(q), display(d) {}
+
+        /* Bus time of the last action */
+        uint64_t doneAt = 0;
+        /* TWINT is pending at doneAt */
+        bool pending = false;
+        uint32_t busBytes = 0;
+
+        /* TWCR write */
+        void action(uint8_t act, uint64_t now) {
+
+            uint64_t t = (now > doneAt) ? now : doneAt;
+
+            switch (act) {
+            case TWIQ_ACT_START:
+                status = owned ? TWIQ_ST_REP_START : TWIQ_ST_START;
+                owned = true;
+                display.start();
+                doneAt = t + SIM_START_NSEC;
+                pending = true;
+                break;
+
+            case TWIQ_ACT_SEND:
+                if (display.receive(queue.data)) {
+                    status = (status == TWIQ_ST_START || status == TWIQ_ST_REP_START) ? TWIQ_ST_SLA_ACK : TWIQ_ST_DATA_ACK;
+                }
+                else {
+                    status = (status == TWIQ_ST_START || status == TWIQ_ST_REP_START) ? TWIQ_ST_SLA_NACK : TWIQ_ST_DATA_NACK;
+                }
+                busBytes++;
+                doneAt = t + SIM_BYTE_NSEC;
+                pending = true;
+                break;
+
+            case TWIQ_ACT_STOP:
+                owned = false;
+                display.stop();
+                doneAt = t + SIM_STOP_NSEC;
+                pending = false;
+                break;
+            }
+        }
+
+        /* The interrupt. Returns its cpu time. */
+        uint64_t interrupt() {
+
+            pending = false;
+            action(queue.event(status), doneAt);
+
+            return SIM_ISR_NSEC;
+        }
+
+    private:
+        TwiQueue &queue;
+        SimDisplay &display;
+        uint8_t status = 0;
+        bool owned = false;
+};
+
+/* Display bytes of one frame */
+static void makeFrame(std::vector<op_t> &ops, int spans) {
+
+    int s;
+    int i;
+    int n;
+
+    for (s = 0; s < spans; s++) {
+        uint8_t col = rand() % 120;
+        /* setCol(), setRow() */
+        ops.push_back({ (uint8_t)(0x00 | (col & 0x0f)), MODE_CMD });
+        ops.push_back({ (uint8_t)(0x10 | (col >> 4)), MODE_CMD });
+        ops.push_back({ (uint8_t)(0xb0 | (1 + rand() % 7)), MODE_CMD });
+
+        n = 1 + rand() % 24;
+        for (i = 0; i < n; i++) {
+            ops.push_back({ (uint8_t)rand(), (uint8_t)((i == n - 1) ? MODE_RAM : MODE_RAM_BUF) });
+        }
+    }
+
+    /* 16 characters of text, 6 bytes each */
+    ops.push_back({ 0x00, MODE_CMD });
+    ops.push_back({ 0x10, MODE_CMD });
+    ops.push_back({ 0xb0, MODE_CMD });
+    for (i = 0; i < 16 * 6; i++) {
+        ops.push_back({ (uint8_t)rand(), (uint8_t)((i % 6 == 5) ? MODE_RAM : MODE_RAM_BUF) });
+    }
+}
+
+/* Bus time of the Wire driver, it returns when the bus is done */
+static uint64_t wireTime(const std::vector<op_t> &ops, uint32_t *transfers) {
+
+    uint64_t t = 0;
+    int nData = 0;
+    bool open = false;
+
+    *transfers = 0;
+
+    for (const op_t &op : ops) {
+        if (nData > 16 || (nData && op.mode == MODE_CMD)) {
+            open = false;
+            t += SIM_STOP_NSEC;
+            nData = 0;
+        }
+        if (!open) {
+            open = true;
+            (*transfers)++;
+            t += SIM_START_NSEC + 2 * SIM_BYTE_NSEC;
+        }
+        t += SIM_BYTE_NSEC;
+        if (op.mode == MODE_RAM_BUF) {
+            nData++;
+        }
+        else {
+            open = false;
+            t += SIM_STOP_NSEC;
+            nData = 0;
+        }
+    }
+
+    return t;
+}
+
+static void usage(const char *name) {
+
+    fprintf(stderr, "usage: %s [-f frames] [-s spans] [-n nack permille] [-c cpu nsec per byte]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    uint32_t frames = 100;
+    int spans = 6;
+    int nack = 0;
+    int cpuNsec = 4000;
+    int errors = 0;
+    std::vector<op_t> ops;
+    std::vector<op_t> frame;
+    TwiQueue queue;
+    SimDisplay display;
+    SimTwi twi(queue, display);
+    uint64_t now = 0;
+    uint64_t drawn = 0;
+    uint64_t blocked = 0;
+    uint64_t wire = 0;
+    uint32_t wireTransfers = 0;
+    uint32_t t;
+    uint32_t f;
+    size_t i;
+
+    while ((opt = getopt(argc, argv, "f:s:n:c:")) != -1) {
+        switch (opt) {
+        case 'f': frames = atoi(optarg); break;
+        case 's': spans = atoi(optarg); break;
+        case 'n': nack = atoi(optarg); break;
+        case 'c': cpuNsec = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (frames == 0 || spans < 0 || nack < 0 || nack > 1000 || cpuNsec < 0) {
+        fprintf(stderr, "frames > 0, spans >= 0, nack 0 - 1000, cpu >= 0\n");
+        return 1;
+    }
+
+    srand(1);
+    queue.begin(SIM_ADDRESS);
+    display.nackPermille = nack;
+
+    for (f = 0; f < frames; f++) {
+        uint64_t frameStart;
+
+        frame.clear();
+        makeFrame(frame, spans);
+        wire += wireTime(frame, &t);
+        wireTransfers += t;
+
+        frameStart = now;
+
+        for (i = 0; i < frame.size(); i++) {
+            const op_t &op = frame[i];
+            uint8_t kind = (op.mode == MODE_CMD) ? TWIQ_CMD : TWIQ_DATA;
+
+            /* The drawing code between two bytes, interrupted by the TWI */
+            t = rand() % (2 * cpuNsec + 1);
+            wire += t;
+            now += t;
+            while (twi.pending && twi.doneAt <= now) {
+                now += twi.interrupt();
+            }
+
+            /* writeDisplay() */
+            while (!queue.put(op.b, kind, op.mode == MODE_RAM)) {
+                /* Queue full, wait for the next interrupt */
+                if (!twi.pending) {
+                    fprintf(stderr, "queue full and bus idle\n");
+                    return 1;
+                }
+                if (twi.doneAt > now) {
+                    blocked += twi.doneAt - now;
+                    now = twi.doneAt;
+                }
+                now += twi.interrupt();
+            }
+            if (queue.start()) {
+                twi.action(TWIQ_ACT_START, now);
+            }
+            ops.push_back(op);
+        }
+
+        drawn += now - frameStart;
+
+        /* The rest of loop() */
+        now += rand() % (200 * cpuNsec + 1);
+        while (twi.pending && twi.doneAt <= now) {
+            now += twi.interrupt();
+        }
+    }
+
+    /* flush() */
+    queue.close();
+    if (queue.start()) {
+        twi.action(TWIQ_ACT_START, now);
+    }
+    while (!queue.idle()) {
+        if (!twi.pending) {
+            fprintf(stderr, "busy without a pending interrupt\n");
+            return 1;
+        }
+        now = (twi.doneAt > now) ? twi.doneAt : now;
+        now += twi.interrupt();
+    }
+
+    /* The display must have received the bytes in order, with NACKs a subsequence */
+    size_t r = 0;
+    for (i = 0; i < ops.size() && r < display.rx.size(); i++) {
+        uint8_t kind = (ops[i].mode == MODE_CMD) ? TWIQ_CMD : TWIQ_DATA;
+        if (ops[i].b == display.rx[r].b && kind == display.rx[r].kind) {
+            r++;
+        }
+        else if (nack == 0) {
+            break;
+        }
+    }
+
+    if (r != display.rx.size() || (nack == 0 && r != ops.size())) {
+        fprintf(stderr, "display stream differs at byte %zu of %zu (%zu received)\n", i, ops.size(), display.rx.size());
+        errors++;
+    }
+    if (nack == 0 && queue.errors) {
+        fprintf(stderr, "%u transfers dropped without NACK\n", queue.errors);
+        errors++;
+    }
+    errors += display.errors();
+
+    printf("bytes/frame        %8zu  received %zu of %zu, %u transfers dropped\n",
+           ops.size() / frames, display.rx.size(), ops.size(), queue.errors);
+    printf("transfers/frame    wire %6u  queue %6u\n",
+           wireTransfers / frames, display.transfers / frames);
+    printf("usec/frame drawing wire %6llu  queue %6llu (%llu blocked on a full queue)\n",
+           (unsigned long long)(wire / frames / 1000),
+           (unsigned long long)(drawn / frames / 1000),
+           (unsigned long long)(blocked / frames / 1000));
+    printf("bus bytes/frame              queue %6u  %s\n",
+           twi.busBytes / frames, errors ? "FAILED" : "ok");
+
+    return errors ? 1 : 0;
+}
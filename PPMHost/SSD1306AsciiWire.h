@@ -0,0 +1,255 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * Emulation of the SSD1306Ascii Wire driver and the display controller.
+ *
+ * Keeps the display RAM (8 rows of 128 columns, one byte is 8 pixel high)
+ * with the page and column addressing of the SSD1306 and counts the bytes
+ * on the I2C bus like SSD1306AsciiWire with OPTIMIZE_I2C:
+ * every transfer costs the address and a control byte, buffered RAM writes
+ * share a transfer up to 17 data bytes, commands and unbuffered writes end it.
+ * Text is drawn with a 5x7 font like Adafruit5x7, set2X() doubles it.
+ * Bytes written since resetCounts() are flagged in written.
+ */
+
+#ifndef _SSD1306AsciiWire_h_
+#define _SSD1306AsciiWire_h_
+
+#include "Arduino.h"
+
+#define MOCK_DISPLAY_WIDTH    128
+#define MOCK_DISPLAY_ROWS       8
+#define MOCK_FONT_WIDTH         5
+#define MOCK_LETTER_SPACING     1
+#define MOCK_FONT_FIRST        32
+#define MOCK_FONT_CHARS        95
+
+struct DevType {
+    uint8_t width;
+    uint8_t height;
+};
+
+const DevType Adafruit128x64 = { 128, 64 };
+const DevType SH1106_128x64 = { 128, 64 };
+const uint8_t Adafruit5x7[] = { 0 };
+
+/* Columns of the characters 32 - 126, bit 0 is the top pixel */
+const uint8_t mockFont5x7[MOCK_FONT_CHARS][MOCK_FONT_WIDTH] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7f, 0x14, 0x7f, 0x14 },
+    { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+    { 0x00, 0x1c, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x08, 0x2a, 0x1c, 0x2a, 0x08 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+    { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 },
+    { 0x18, 0x14, 0x12, 0x7f, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+    { 0x32, 0x49, 0x79, 0x41, 0x3e }, { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 }, { 0x3e, 0x41, 0x49, 0x49, 0x7a },
+    { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 },
+    { 0x7f, 0x40, 0x40, 0x40, 0x40 }, { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+    { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+    { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f }, { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f },
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+    { 0x38, 0x44, 0x44, 0x48, 0x7f }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x0c, 0x52, 0x52, 0x52, 0x3e },
+    { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3d, 0x00 }, { 0x7f, 0x10, 0x28, 0x44, 0x00 },
+    { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 }, { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+    { 0x7c, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7c }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c }, { 0x3c, 0x40, 0x30, 0x40, 0x3c },
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c }, { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+    { 0x00, 0x00, 0x7f, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 }
+};
+
+class TwoWire {
+
+    public:
+        void begin() {}
+        void setClock(uint32_t) {}
+        void beginTransmission(uint8_t) {}
+        uint8_t endTransmission() { return 0; }
+};
+
+inline TwoWire Wire;
+
+class SSD1306AsciiWire {
+
+    private:
+        uint8_t col_;
+        uint8_t row_;
+        /* 1 or 2 for set1X() / set2X() */
+        uint8_t mag;
+        uint8_t invertMask;
+        /* Data bytes in the open buffered transfer */
+        uint8_t nData;
+
+        void transfer(uint8_t b, bool cmd, bool buffered) {
+
+            if (nData > 16 || (nData && cmd)) {
+                nData = 0;
+            }
+            if (nData == 0) {
+                /* Address and control byte */
+                busBytes += 2;
+                transfers++;
+            }
+            busBytes++;
+            if (buffered) {
+                nData++;
+            }
+            else {
+                nData = 0;
+            }
+            (void)b;
+        }
+
+        void writeRam(uint8_t c, bool buffered) {
+
+            if (col_ >= MOCK_DISPLAY_WIDTH) {
+                return;
+            }
+            written[row_][col_] = 1;
+            ram[row_][col_++] = c ^ invertMask;
+            dataBytes++;
+            transfer(c, false, buffered);
+        }
+
+        /* Bits 0 - 3 of b, each twice */
+        static uint8_t doubleBits(uint8_t b) {
+
+            uint8_t d = 0;
+
+            for (uint8_t i = 0; i < 4; i++) {
+                if (b & (1 << i)) {
+                    d |= 3 << (2 * i);
+                }
+            }
+            return d;
+        }
+
+    public:
+        uint8_t ram[MOCK_DISPLAY_ROWS][MOCK_DISPLAY_WIDTH];
+        uint8_t written[MOCK_DISPLAY_ROWS][MOCK_DISPLAY_WIDTH];
+
+        uint32_t busBytes;
+        uint32_t transfers;
+        uint32_t dataBytes;
+
+        /* The driver of the display most recently begun */
+        static inline SSD1306AsciiWire *lastBegun = nullptr;
+
+        void begin(const DevType *, uint8_t) {
+            col_ = row_ = 0;
+            mag = 1;
+            invertMask = 0;
+            nData = 0;
+            memset(ram, 0, sizeof(ram));
+            resetCounts();
+            lastBegun = this;
+        }
+
+        void resetCounts() {
+            busBytes = transfers = dataBytes = 0;
+            memset(written, 0, sizeof(written));
+        }
+
+        void ssd1306WriteCmd(uint8_t c) { transfer(c, true, false); }
+        void ssd1306WriteRam(uint8_t c) { writeRam(c, false); }
+        void ssd1306WriteRamBuf(uint8_t c) { writeRam(c, true); }
+
+        void setCol(uint8_t c) {
+            col_ = c;
+            ssd1306WriteCmd(0x00 | (c & 0x0f));
+            ssd1306WriteCmd(0x10 | (c >> 4));
+        }
+        void setRow(uint8_t r) {
+            row_ = r % MOCK_DISPLAY_ROWS;
+            ssd1306WriteCmd(0xb0 | row_);
+        }
+        uint8_t col() const { return col_; }
+        uint8_t row() const { return row_; }
+
+        void clear() { clear(0, MOCK_DISPLAY_WIDTH - 1, 0, MOCK_DISPLAY_ROWS - 1); }
+        void clear(uint8_t c0, uint8_t c1, uint8_t r0, uint8_t r1) {
+            for (uint8_t r = r0; r <= r1 && r < MOCK_DISPLAY_ROWS; r++) {
+                setCol(c0);
+                setRow(r);
+                for (uint8_t c = c0; c <= c1 && c < MOCK_DISPLAY_WIDTH; c++) {
+                    ssd1306WriteRamBuf(0);
+                }
+            }
+            setCol(c0);
+            setRow(r0);
+        }
+        void clearToEOL() { clear(col_, MOCK_DISPLAY_WIDTH - 1, row_, row_ + fontRows() - 1); }
+
+        void setFont(const uint8_t *) {}
+        void setInvertMode(bool inv) { invertMask = inv ? 0xff : 0; }
+        void set1X() { mag = 1; }
+        void set2X() { mag = 2; }
+        uint8_t displayWidth() const { return MOCK_DISPLAY_WIDTH; }
+        uint8_t displayHeight() const { return MOCK_DISPLAY_ROWS * 8; }
+        uint8_t fontRows() const { return mag; }
+        uint8_t fontWidth() const { return mag * MOCK_FONT_WIDTH; }
+        uint8_t letterSpacing() const { return mag * MOCK_LETTER_SPACING; }
+
+        size_t write(uint8_t ch) {
+
+            uint8_t scol = col_;
+            uint8_t srow = row_;
+            const uint8_t *glyph;
+
+            if (ch < MOCK_FONT_FIRST || ch >= MOCK_FONT_FIRST + MOCK_FONT_CHARS) {
+                ch = '?';
+            }
+            glyph = mockFont5x7[ch - MOCK_FONT_FIRST];
+
+            for (uint8_t m = 0; m < mag; m++) {
+                if (m) {
+                    setCol(scol);
+                    setRow(srow + m);
+                }
+                for (uint8_t c = 0; c < MOCK_FONT_WIDTH; c++) {
+                    uint8_t b = glyph[c];
+                    if (mag == 2) {
+                        b = doubleBits(m ? b >> 4 : b & 0x0f);
+                        ssd1306WriteRamBuf(b);
+                    }
+                    ssd1306WriteRamBuf(b);
+                }
+                for (uint8_t i = 0; i < letterSpacing(); i++) {
+                    ssd1306WriteRamBuf(0);
+                }
+            }
+            if (mag > 1) {
+                setRow(srow);
+            }
+            return 1;
+        }
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "TextUILcdHost.h"
+
+#define HOST_GREY_ON        160
+#define HOST_GREY_WRITTEN    80
+
+TextUILcdHost::TextUILcdHost() : TextUILcdSSD1306(&SH1106_128x64) {
+
+    ctl = SSD1306AsciiWire::lastBegun;
+    ctl->resetCounts();
+}
+
+void TextUILcdHost::startRefresh() {
+
+    ctl->resetCounts();
+}
+
+bool TextUILcdHost::pixel(uint8_t x, uint8_t y) const {
+
+    return (ctl->ram[y / 8][x] >> (y % 8)) & 1;
+}
+
+bool TextUILcdHost::written(uint8_t x, uint8_t y) const {
+
+    return ctl->written[y / 8][x];
+}
+
+bool TextUILcdHost::writePBM(const char *path, uint8_t scale) const {
+
+    FILE *f;
+    uint8_t b;
+    uint16_t x;
+    uint16_t y;
+    uint8_t n;
+
+    f = fopen(path, "wb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    /* Binary PBM: 1 is black, 8 pixel per byte, rows padded to a byte */
+    fprintf(f, "P4\n%d %d\n", HOST_LCD_WIDTH * scale, HOST_LCD_HEIGHT * scale);
+
+    for (y = 0; y < HOST_LCD_HEIGHT * scale; y++) {
+        b = 0;
+        n = 0;
+        for (x = 0; x < HOST_LCD_WIDTH * scale; x++) {
+            b = (b << 1) | (pixel(x / scale, y / scale) ? 0 : 1);
+            if (++n == 8) {
+                fputc(b, f);
+                b = 0;
+                n = 0;
+            }
+        }
+        if (n) {
+            fputc(b << (8 - n), f);
+        }
+    }
+
+    return fclose(f) == 0;
+}
+
+bool TextUILcdHost::writePGM(const char *path, uint8_t scale) const {
+
+    FILE *f;
+    uint16_t x;
+    uint16_t y;
+    uint8_t v;
+
+    f = fopen(path, "wb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    fprintf(f, "P5\n%d %d\n255\n", HOST_LCD_WIDTH * scale, HOST_LCD_HEIGHT * scale);
+
+    for (y = 0; y < HOST_LCD_HEIGHT * scale; y++) {
+        for (x = 0; x < HOST_LCD_WIDTH * scale; x++) {
+            if (pixel(x / scale, y / scale)) {
+                v = written(x / scale, y / scale) ? 255 : HOST_GREY_ON;
+            }
+            else {
+                v = written(x / scale, y / scale) ? HOST_GREY_WRITTEN : 0;
+            }
+            fputc(v, f);
+        }
+    }
+
+    return fclose(f) == 0;
+}
+
+void TextUILcdHost::printTerminal(FILE *f) const {
+
+    static const char *blocks[4] = { " ", "▀", "▄", "█" };
+    uint8_t x;
+    uint8_t y;
+
+    for (y = 0; y < HOST_LCD_HEIGHT; y += 2) {
+        for (x = 0; x < HOST_LCD_WIDTH; x++) {
+            fputs(blocks[pixel(x, y) | (pixel(x, y + 1) << 1)], f);
+        }
+        fputc('\n', f);
+    }
+}
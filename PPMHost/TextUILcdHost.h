@@ -0,0 +1,79 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/*
+ * TextUILcd for Linux.
+ *
+ * The TextUILcdSSD1306 driver running on the emulated display controller
+ * in SSD1306AsciiWire.h. Screens draw exactly like on the device, the
+ * display RAM can be written to PBM/PGM files or the terminal.
+ *
+ * startRefresh() resets the bus counters and the written flags.
+ * The PGM dump shows what was written since then:
+ *   white  pixel on, written     grey   pixel on, unchanged
+ *   dark   pixel off, written    black  pixel off, unchanged
+ */
+
+#ifndef _TextUILcdHost_h_
+#define _TextUILcdHost_h_
+
+#include <stdio.h>
+
+#include "TextUILcdSSD1306.h"
+
+#define HOST_LCD_WIDTH      MOCK_DISPLAY_WIDTH
+#define HOST_LCD_HEIGHT     (MOCK_DISPLAY_ROWS * 8)
+
+class TextUILcdHost : public TextUILcdSSD1306 {
+
+    private:
+        SSD1306AsciiWire *ctl;
+
+    public:
+        TextUILcdHost();
+
+        void startRefresh();
+
+        /* Since startRefresh() */
+        uint32_t busBytes() const { return ctl->busBytes; }
+        uint32_t transfers() const { return ctl->transfers; }
+        uint32_t dataBytes() const { return ctl->dataBytes; }
+
+        bool pixel(uint8_t x, uint8_t y) const;
+        /* Written since startRefresh() */
+        bool written(uint8_t x, uint8_t y) const;
+
+        /* Display RAM of row r, HOST_LCD_WIDTH bytes */
+        const uint8_t *ramRow(uint8_t r) const { return ctl->ram[r]; }
+
+        /* scale pixel per display pixel. Return false on a file error. */
+        bool writePBM(const char *path, uint8_t scale) const;
+        bool writePGM(const char *path, uint8_t scale) const;
+        /* Two pixel rows per line with block characters */
+        void printTerminal(FILE *f) const;
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _AdcQueue_h_
+#define _AdcQueue_h_
+
+#include "Arduino.h"
+
+/* Owner of the ADC */
+#define ADC_IDLE            0
+/* Signal level sampled at a PPM edge */
+#define ADC_PPM             1
+/* Voltmeter */
+#define ADC_VM              2
+/* Vcc (Battery) */
+#define ADC_VCC             3
+/* ADC auto triggered by Timer 1 for the scope */
+#define ADC_SCOPE           4
+
+/* Single conversion types ADC_PPM .. ADCQ_LAST */
+#define ADCQ_LAST           ADC_VCC
+
+#define ADCQ_BIT(t)         ((uint8_t)(1 << (t)))
+
+/*
+ * Hardware independent scheduling of single ADC conversions.
+ *
+ * Every conversion type has one request slot. request() marks the type
+ * pending, a second request before the conversion started is merged.
+ * A conversion takes 104 usec (13 ADC clocks at 125 kHz), the ADC ISR
+ * reports the result with done() and starts the type returned.
+ *
+ * PPM level sampling goes first, so it waits for at most one other
+ * conversion. Right after a PPM conversion one other pending type gets
+ * its turn, so constant edges do not starve the voltmeter or the battery
+ * check. The other types take turns in round robin.
+ *
+ * The scope owns the ADC for a whole acquisition. claim() fails while a
+ * single conversion runs. Requests made meanwhile wait until release(),
+ * the scope gives the ADC up early if waiting() is true.
+ *
+ * Results are futures: fetch() returns true once after a conversion of
+ * the type completed. last() is the newest result.
+ *
+ * All methods must be called with interrupts disabled or from the ADC ISR.
+ * Methods returning a type ask the caller to start that conversion.
+ */
+class AdcQueue {
+
+    private:
+        volatile uint8_t running = ADC_IDLE;
+        volatile uint8_t pending = 0;
+        volatile uint8_t ready = 0;
+        /* Last started type and last started type other than ADC_PPM */
+        uint8_t lastType = ADC_IDLE;
+        uint8_t lastOther = ADCQ_LAST;
+        uint16_t value[ADCQ_LAST + 1] = {};
+
+        uint8_t next() {
+
+            uint8_t p = pending;
+            uint8_t t;
+
+            if( p == 0) {
+                running = ADC_IDLE;
+                return ADC_IDLE;
+            }
+
+            if( (p & ADCQ_BIT(ADC_PPM)) && (lastType != ADC_PPM || p == ADCQ_BIT(ADC_PPM))) {
+                t = ADC_PPM;
+            }
+            else {
+                t = lastOther;
+                do {
+                    t = (t == ADCQ_LAST) ? ADC_PPM + 1 : t + 1;
+                } while( !(p & ADCQ_BIT(t)));
+                lastOther = t;
+            }
+
+            pending = p & ~ADCQ_BIT(t);
+            running = lastType = t;
+
+            return t;
+        }
+
+    public:
+        uint8_t owner() const { return running; }
+
+        bool idle() const { return running == ADC_IDLE && pending == 0; }
+
+        /* Requests not started yet */
+        bool waiting() const { return pending != 0; }
+
+        bool isPending( uint8_t t) const { return pending & ADCQ_BIT(t); }
+
+        /* Returns the type to start or ADC_IDLE if the ADC is busy */
+        uint8_t request( uint8_t t) {
+
+            pending |= ADCQ_BIT(t);
+
+            return (running == ADC_IDLE) ? next() : ADC_IDLE;
+        }
+
+        /* Result of the running conversion. Returns the next type to start. */
+        uint8_t done( uint16_t v) {
+
+            uint8_t t = running;
+
+            if( t != ADC_IDLE && t <= ADCQ_LAST) {
+                value[t] = v;
+                ready |= ADCQ_BIT(t);
+            }
+
+            return next();
+        }
+
+        /* Take the ADC for the scope. Fails while a single conversion runs. */
+        bool claim() {
+
+            if( running != ADC_IDLE && running != ADC_SCOPE) {
+                return false;
+            }
+            running = ADC_SCOPE;
+            return true;
+        }
+
+        /* Scope done. Returns the next type to start. */
+        uint8_t release() {
+
+            if( running != ADC_SCOPE) {
+                return ADC_IDLE;
+            }
+            return next();
+        }
+
+        bool fetch( uint8_t t, uint16_t *v) {
+
+            if( !(ready & ADCQ_BIT(t))) {
+                return false;
+            }
+            ready &= ~ADCQ_BIT(t);
+            *v = value[t];
+            return true;
+        }
+
+        uint16_t last( uint8_t t) const { return value[t]; }
+};
+
+#endif
@@ -0,0 +1,295 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _CaptureStore_h_
+#define _CaptureStore_h_
+
+#include "Arduino.h"
+
+/*
+ * Run length and delta compressed 8 bit samples for deep captures.
+ *
+ * Tokens:
+ *   00nnnnnn             run, the last value n + 1 more times
+ *   01nnnnnn nnnnnnnn    long run, up to CAPTURE_RUN_MAX
+ *   10dddddd             one sample, last value + d (-32 .. 31)
+ *   11000000 vvvvvvvv    one sample with value v
+ *
+ * A flat signal costs 2 bytes per 16384 samples, an edge 1 - 2 bytes.
+ * Digital samples are 0 or 1, added as runs with putRun().
+ *
+ * The buffer is owned by the caller. Samples are appended until the buffer is full.
+ * Decoding walks the tokens from the start. Runs are skipped without expanding them.
+ */
+
+#define CAPTURE_RUN_MAX     16384
+#define CAPTURE_SHORT_MAX   64
+#define CAPTURE_NONE        0xffff
+
+class CaptureStore {
+
+    private:
+        uint8_t  *buf;
+        uint16_t size;
+        uint16_t len;
+        uint32_t samples;
+        uint8_t  last;
+        /* Open run token */
+        uint16_t runAt;
+        uint16_t run;
+
+        /* Decode the token at pos. Returns the position of the next token. */
+        uint16_t token( uint16_t pos, uint8_t *value, uint16_t *count) const {
+
+            uint8_t t = buf[pos++];
+
+            if (t < 0x40) {
+                *count = t + 1;
+            }
+            else if (t < 0x80) {
+                *count = (((uint16_t)(t & 0x3f) << 8) | buf[pos++]) + 1;
+            }
+            else if (t < 0xc0) {
+                /* Sign extend 6 bit */
+                *value += (int8_t)(t << 2) >> 2;
+                *count = 1;
+            }
+            else {
+                *value = buf[pos++];
+                *count = 1;
+            }
+
+            return pos;
+        }
+
+        /* Repeat the last value n times */
+        bool extend( uint32_t n) {
+
+            uint16_t take;
+
+            while (n) {
+
+                if (runAt == CAPTURE_NONE || run == CAPTURE_RUN_MAX) {
+                    if (len >= size) {
+                        return false;
+                    }
+                    runAt = len++;
+                    run = 0;
+                }
+
+                take = (n < (uint32_t)(CAPTURE_RUN_MAX - run)) ? n : CAPTURE_RUN_MAX - run;
+
+                if (run + take > CAPTURE_SHORT_MAX && run <= CAPTURE_SHORT_MAX) {
+                    /* Becomes a long run, needs a second byte */
+                    if (len >= size) {
+                        take = CAPTURE_SHORT_MAX - run;
+                        if (take == 0) {
+                            return false;
+                        }
+                    }
+                    else {
+                        len++;
+                    }
+                }
+
+                run += take;
+                if (run <= CAPTURE_SHORT_MAX) {
+                    buf[runAt] = run - 1;
+                }
+                else {
+                    buf[runAt] = 0x40 | ((run - 1) >> 8);
+                    buf[runAt + 1] = (run - 1) & 0xff;
+                }
+
+                samples += take;
+                n -= take;
+            }
+
+            return true;
+        }
+
+    public:
+        void begin( uint8_t *b, uint16_t sz) {
+
+            buf = b;
+            size = sz;
+            len = 0;
+            samples = 0;
+            last = 0;
+            runAt = CAPTURE_NONE;
+            run = 0;
+        }
+
+        uint32_t getSamples() const { return samples; }
+        uint16_t getBytes() const { return len; }
+
+        /* Append one sample. Returns false if the buffer is full. */
+        inline bool put( uint8_t v) {
+
+            int16_t d = (int16_t)v - last;
+
+            if (samples && d == 0) {
+                return extend(1);
+            }
+
+            runAt = CAPTURE_NONE;
+
+            if (samples && d >= -32 && d <= 31) {
+                if (len >= size) {
+                    return false;
+                }
+                buf[len++] = 0x80 | (d & 0x3f);
+            }
+            else {
+                if (len + 2 > size) {
+                    return false;
+                }
+                buf[len++] = 0xc0;
+                buf[len++] = v;
+            }
+
+            last = v;
+            samples++;
+            return true;
+        }
+
+        /* Append n samples of v. Returns false if the buffer is full. */
+        bool putRun( uint8_t v, uint32_t n) {
+
+            if (n == 0) {
+                return true;
+            }
+
+            if (samples == 0 || v != last) {
+                if (!put(v)) {
+                    return false;
+                }
+                n--;
+            }
+
+            return extend(n);
+        }
+
+        /* Value of sample i */
+        uint8_t valueAt( uint32_t i) const {
+
+            uint16_t pos = 0;
+            uint32_t idx = 0;
+            uint8_t value = 0;
+            uint16_t count;
+
+            while (pos < len) {
+                pos = token(pos, &value, &count);
+                idx += count;
+                if (i < idx) {
+                    break;
+                }
+            }
+
+            return value;
+        }
+
+        /* First sample after i with a different value. getSamples() if there is none. */
+        uint32_t nextChange( uint32_t i) const {
+
+            uint16_t pos = 0;
+            uint32_t idx = 0;
+            uint8_t value = 0;
+            uint8_t vi = 0;
+            uint16_t count;
+            bool found = false;
+
+            while (pos < len) {
+                pos = token(pos, &value, &count);
+                if (!found) {
+                    if (i < idx + count) {
+                        vi = value;
+                        found = true;
+                    }
+                }
+                else if (value != vi) {
+                    return idx;
+                }
+                idx += count;
+            }
+
+            return samples;
+        }
+
+        /*
+         * Decode n pixels of step samples each, starting at sample first.
+         * max and min get the range of each pixel, 0 past the end.
+         * Returns the number of pixels with samples.
+         */
+        uint8_t window( uint32_t first, uint16_t step, uint8_t n, uint8_t max[], uint8_t min[]) const {
+
+            uint32_t end = first + (uint32_t)n * step;
+            uint32_t idx = 0;
+            uint32_t from;
+            uint32_t to;
+            uint16_t pos = 0;
+            uint16_t count;
+            uint8_t value = 0;
+            uint8_t p;
+            uint8_t filled = 0;
+
+            for (p = 0; p < n; p++) {
+                max[p] = 0;
+                min[p] = 255;
+            }
+
+            while (pos < len && idx < end) {
+
+                pos = token(pos, &value, &count);
+
+                if (idx + count > first) {
+                    /* Pixels covered by this token */
+                    from = (idx > first) ? idx : first;
+                    to = (idx + count < end) ? idx + count : end;
+
+                    for (p = (from - first) / step; p <= (to - 1 - first) / step; p++) {
+                        if (value > max[p]) {
+                            max[p] = value;
+                        }
+                        if (value < min[p]) {
+                            min[p] = value;
+                        }
+                    }
+                    filled = p;
+                }
+
+                idx += count;
+            }
+
+            for (p = filled; p < n; p++) {
+                max[p] = min[p] = 0;
+            }
+
+            return filled;
+        }
+};
+
+#endif
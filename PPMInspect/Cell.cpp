@@ -287,7 +287,7 @@ void Cell::setLabel( uint8_t screenX, const char *v, uint8_t sz) {
     value.size = sz;
 }
 
-#ifdef ARDUINO
+#ifdef TEXTUI_FLASH_STRINGS
 void Cell::setLabel(uint8_t screenX, const __FlashStringHelper *v, uint8_t sz) {
 
     screenCol = screenX;
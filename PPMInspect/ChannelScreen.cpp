@@ -26,6 +26,34 @@
 
 #include "ChannelScreen.h"
 
+#ifdef ARDUINO
+#include <util/atomic.h>
+#endif
+
+/* Integer square root */
+static uint16_t isqrt(uint32_t v)
+{
+    uint32_t r = 0;
+    uint32_t b = 1UL << 30;
+
+    while (b > v) {
+        b >>= 2;
+    }
+
+    while (b) {
+        if (v >= r + b) {
+            v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+
+    return (uint16_t)r;
+}
+
 ChannelScreen::ChannelScreen(PPM& ppm) : ppmH(ppm)
 {
     strcpy(channelName, "C  ");
@@ -35,9 +63,45 @@ ChannelScreen::ChannelScreen(PPM& ppm) : ppmH(ppm)
 void ChannelScreen::update()
 {
     currentData = ppmH.getPPM();
+#ifdef ENABLE_EDGE_RING
+    /* Decoded in loop(), the statistics do not change while drawing */
+    currentStats = ppmH.getPPMStats();
+#else
+    /* The capture interrupt updates the statistics, draw a consistent copy */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        statsCopy = *ppmH.getPPMStats();
+    }
+    currentStats = &statsCopy;
+#endif
     hasNewData = true;
 }
 
+/* Scale histogram of channel ch to digits 1-9. Empty bins are shown as '.' */
+void ChannelScreen::formatJitter(uint8_t ch)
+{
+    uint8_t max = 0;
+    uint8_t n;
+
+    for (uint8_t b = 0; b < PPM_JITTER_BINS; b++) {
+        n = ppmJitter(currentStats, ch, b);
+        if (n > max) {
+            max = n;
+        }
+    }
+
+    for (uint8_t b = 0; b < PPM_JITTER_BINS; b++) {
+        n = ppmJitter(currentStats, ch, b);
+        if (n == 0) {
+            jitterBars[b] = '.';
+        }
+        else {
+            jitterBars[b] = '0' + (n * 9 + max - 1) / max;
+        }
+    }
+
+    jitterBars[PPM_JITTER_BINS] = '\0';
+}
+
 /* TextUI */
 
 const char* ChannelScreen::getHeader()
@@ -82,6 +146,14 @@ void ChannelScreen::handleEvent(TextUI* ui, Event* e)
             ui->popScreen();
             e->markProcessed();
             break;
+
+        case KEY_FUNCTION: // long Down
+            /* min/max => mean/std. deviation => jitter histogram */
+            view = (view + 1) % 3;
+            refresh = true;
+            hasNewData = true;
+            e->markProcessed();
+            break;
         }
     }
     else if (e->getType() == EVENT_TYPE_TIMER) {
@@ -89,9 +161,23 @@ void ChannelScreen::handleEvent(TextUI* ui, Event* e)
     }
 }
 
+bool ChannelScreen::needsRefresh()
+{
+    if (refresh) {
+        refresh = false;
+        return true;
+    }
+
+    return false;
+}
+
 uint8_t ChannelScreen::getColCount(uint8_t row)
 {
-    return 3;
+    if (row == 0 || view == CHANNELVIEW_MINMAX) {
+        return 3;
+    }
+
+    return (view == CHANNELVIEW_STATS) ? 4 : 1;
 }
 
 bool ChannelScreen::hasChanged(uint8_t row, uint8_t col)
@@ -119,16 +205,39 @@ void ChannelScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
         }
 
     }
+    else if (view == CHANNELVIEW_STATS) {
+
+        if (col == 0) {
+            /* mean_q8 * 10 / 256 */
+            cell->setFloat1(4, currentStats->mean_q8[row - 1] * 5 / 128, 6, 0, 0);
+        }
+        else if (col == 1) {
+            cell->setLabel(11, F("s"), 1);
+        }
+        else if (col == 2) {
+            /* sqrt( var_q8 / 256 ) * 10. var_q8 is limited to 2048^2 * 256 */
+            cell->setFloat1(13, (uint32_t)isqrt(currentStats->var_q8[row - 1]) * 5 / 8, 5, 0, 0);
+        }
+        else {
+            cell->setLabel(19, F("us"), 2);
+        }
+    }
+    else if (view == CHANNELVIEW_JITTER) {
+
+        formatJitter(row - 1);
+        cell->setLabel(4, jitterBars, PPM_JITTER_BINS);
+    }
     else {
 
         if (col == 0) {
-            cell->setInt16(4, currentData->channel_usec[row - 1], 5, 0, 0);
+            cell->setFloat1(3, currentData->channel_us10[row - 1], 6, 0, 0);
         }
+        /* No room for a decimal in min and max, rounded to usec */
         else if (col == 1) {
-            cell->setInt16(10, currentData->channelMin_usec[row - 1], 5, 0, 0);
+            cell->setInt16(10, (currentData->channelMin_us10[row - 1] + 5) / 10, 5, 0, 0);
         }
         else {
-            cell->setInt16(16, currentData->channelMax_usec[row - 1], 5, 0, 0);
+            cell->setInt16(16, (currentData->channelMax_us10[row - 1] + 5) / 10, 5, 0, 0);
         }
     }
 }
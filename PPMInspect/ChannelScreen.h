@@ -30,13 +30,28 @@
 #include "TextUI.h"
 #include "PPM.h"
 
+#define CHANNELVIEW_MINMAX   0
+#define CHANNELVIEW_STATS    1
+#define CHANNELVIEW_JITTER   2
+
 class ChannelScreen : public TextUIScreen
 {
 private:
     PPM &ppmH;
     ppm_t *currentData = nullptr;
+    const ppmstats_t *currentStats = nullptr;
+#ifndef ENABLE_EDGE_RING
+    ppmstats_t statsCopy;
+#endif
     bool hasNewData = true;
     char channelName[4];
+    char jitterBars[PPM_JITTER_BINS + 1];
+
+    /* CHANNELVIEW_MINMAX .. CHANNELVIEW_JITTER */
+    uint8_t view = CHANNELVIEW_MINMAX;
+    bool refresh = false;
+
+    void formatJitter(uint8_t ch);
 
 public:
     explicit ChannelScreen(PPM &ppm);
@@ -45,6 +60,7 @@ public:
 
     /* TextUI */
     void handleEvent(TextUI *ui, Event *e);
+    bool needsRefresh();
 
     const char *getHeader();
     const char *getMenuName();
@@ -97,6 +97,73 @@ do {                                          \
 
 #define PPM_MAX_PULSE              (2*PPM_MAX_CHANNELS +2)
 
+/* Capture ISR only queues edges into a ring buffer.
+ * Decoding is done in loop() by PPM::processEdges().
+ * Undefine to decode within the capture ISR.
+ */
+#define ENABLE_EDGE_RING
+
+/* Signal levels are sampled this long after an edge, on the plateau of the pulse or gap.
+ * A sample counts if no edge came before the conversion (104 usec) was done,
+ * so delay plus conversion must be shorter than the shortest pulse.
+ */
+#define PPM_LEVEL_DELAY_USEC       50
+
+/* Capture resolution of PPM, PWM, servo and latency scan, settings.captureRes.
+ * 62.5 nsec runs Timer 1 without prescaler, it overflows every 4.096 msec.
+ */
+#define CAPTURE_RES_500NS           0
+#define CAPTURE_RES_62NS            1
+
+/* Timer 1 overflows (32.768 msec each at 0.5 usec) without an edge until loss of signal */
+#define PPM_TIMEOUT_OVERFLOWS      2
+#define PWM_TIMEOUT_OVERFLOWS      4
+
+/* Servo scan. Up to SERVO_CHANNELS servo outputs on Port B, timestamped by pin change interrupt PCINT0.
+ * Bit 0 is D8 (PB0, same as PORT_PPM_IN) up to D13 (PB5). PB6 and PB7 hold the crystal.
+ */
+#define SERVO_CHANNELS              6
+#define SERVO_PIN_MASK             ((uint8_t)0x3f)
+#define SERVO_FIRST_PIN             8
+/* A channel without an edge for this long is inactive */
+#define SERVO_TIMEOUT_MSEC        100
+
+/* Latency scan. PPM on PORT_PPM_IN and one PWM output of the receiver or flight controller
+ * on D9 (PB1), timestamped by pin change interrupt PCINT1.
+ * A change of the PPM channel by LATENCY_STEP_USEC is matched with the first PWM pulse
+ * that moved by half of it.
+ */
+#define LATENCY_PIN                 9
+#define LATENCY_PIN_MASK           ((uint8_t)_BV(PCINT1))
+#define LATENCY_STEP_USEC          50
+/* A change without a matching pulse for this long is missed */
+#define LATENCY_TIMEOUT_MSEC      250
+/* Histogram. The last bin takes all longer latencies. */
+#define LATENCY_BINS               16
+#define LATENCY_BIN_USEC         2000
+
+/* Bad frame capture. Raw frames kept before and after the first bad frame */
+#define FORENSIC_PRE_FRAMES         1
+#define FORENSIC_POST_FRAMES        1
+
+/* Scope acquisition. Samples per capture and sample period while waiting for the trigger. */
+#define SCOPE_SAMPLES             128
+#define SCOPE_ARM_USEC             10
+/* Roll mode from this sample period on (usec per pixel, "5m" is 5 msec per division) */
+#define SCOPE_ROLL_USEC           500
+
+/* Logic analyzer. Bytes per capture (8 samples each) and how long to wait for the trigger edge. */
+#define LOGIC_BYTES               128
+#define LOGIC_TRIGGER_MSEC         30
+
+/* Deep capture, see CaptureStore.h. Scope samples, logic analyzer store size and capture time. */
+#define SCOPE_DEEP_SAMPLES       4096
+#define LOGIC_DEEP_BYTES          256
+#define LOGIC_DEEP_MSEC           150
+
+/* Bad frame dump and edge stream. 1000000 works too (16 MHz, U2X). */
+#define SERIAL_BAUD           115200
+
 #define PORT_PPM_IN                8
 #define PORT_ANALOG_IN             A3
 #define PORT_VCC                   A0
@@ -120,6 +187,7 @@ do {                                          \
 /* ================================================================== */
 
 #define BUTTON_COUNT                3
+/* Port D only, read by the pin change interrupt (TextUIPcintKbd) */
 #define BUTTON_PORTS          5, 6, 7
 /* Actions for short press */
 #define BUTTON_SHORT_KEYS      KEY_UP,    KEY_ENTER, KEY_DOWN
@@ -153,8 +221,13 @@ typedef struct config_t
     int8_t   vccAdjust;
     
     fixfloat1_t lowBattWarn;
+
+    /* CAPTURE_RES_* */
+    uint8_t  captureRes;
     
-    /* */
+    /* New settings go here. ConfigScreen::load() has to recognize
+     * the checksum of the shorter layout saved by older versions.
+     */
 
     checksum_t checksum;
 
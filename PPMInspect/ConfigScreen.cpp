@@ -24,16 +24,23 @@
   SOFTWARE.
 */
 
+#include <stddef.h>
+
 #include "ConfigScreen.h"
 #include "EEPROM.h"
 
 #ifdef ENABLE_MEMDEBUG
-  #define ROW_COUNT 9
+  #define ROW_COUNT 10
 extern size_t memdebug[4];
 #else
-  #define ROW_COUNT 8
+  #define ROW_COUNT 9
 #endif
 
+#define CAPTURE_RES_COUNT 2
+
+/* Settings before captureRes, the checksum followed lowBattWarn */
+#define CONFIG_NO_CAPTURE_SZ offsetof(config_t, captureRes)
+
 config_t settings;
 
 const char s1[] PROGMEM = "Pulse min";
@@ -44,17 +51,23 @@ const char s5[] PROGMEM = "Sync  min";
 const char s6[] PROGMEM = "Vppm +/-";
 const char s7[] PROGMEM = "Vcc  +/-";
 const char s8[] PROGMEM = "Low Batt";
+const char s9[] PROGMEM = "Capture";
 #ifdef ENABLE_MEMDEBUG
-const char s9[] PROGMEM = "Memfree";
+const char s10[] PROGMEM = "Memfree";
 #endif
 
 const char* const ConfigRowNames[ROW_COUNT] PROGMEM = {
-    s1, s2, s3, s4, s5, s6, s7, s8
+    s1, s2, s3, s4, s5, s6, s7, s8, s9
 #ifdef ENABLE_MEMDEBUG
-   , s9
+   , s10
 #endif
 };
 
+/* Indexed by CAPTURE_RES_* */
+const char* captureResNames[CAPTURE_RES_COUNT] = {
+    " 0.5us", "62.5ns"
+};
+
 ConfigScreen::ConfigScreen(PPM &ppm) : ppmH(ppm)
 {
     setDefaults();
@@ -76,16 +89,31 @@ void ConfigScreen::setDefaults() const
     settings.vccAdjust = 0;
 
     settings.lowBattWarn = 74; // 7.4 Volt
+
+    settings.captureRes = CAPTURE_RES_500NS;
 }
 
 void ConfigScreen::load()
 {
+    checksum_t oldChecksum;
+
     EEPROM.get(0, settings);
-    if (settings.checksum != computeChecksum(&settings))
+    if (settings.checksum == computeChecksum(&settings))
+    {
+        return;
+    }
+
+    /* Settings saved without captureRes keep their values */
+    EEPROM.get(CONFIG_NO_CAPTURE_SZ, oldChecksum);
+    if (oldChecksum == computeChecksum(&settings, CONFIG_NO_CAPTURE_SZ))
+    {
+        settings.captureRes = CAPTURE_RES_500NS;
+    }
+    else
     {
         setDefaults();
-        save();
     }
+    save();
 }
 
 void ConfigScreen::save()
@@ -95,16 +123,16 @@ void ConfigScreen::save()
 }
 
 /*
- * Recompute and return block checksum.
+ * Recompute and return block checksum of the first len bytes.
  * NOTE: The blocks checksum is NOT updated.
  */
-checksum_t ConfigScreen::computeChecksum(config_t *cfg) const
+checksum_t ConfigScreen::computeChecksum(config_t *cfg, uint16_t len) const
 {
     checksum_t checksum = 0;
 
     uint8_t *p = (uint8_t *)cfg;
 
-    for (uint16_t i = 0; i < (sizeof(config_t) - sizeof(checksum_t)); i++)
+    for (uint16_t i = 0; i < len; i++)
     {
         checksum = rotate(checksum);
         checksum ^= (i ^ *(p + i));
@@ -155,6 +183,9 @@ const char *ConfigScreen::getRowName(uint8_t row)
 
 uint8_t ConfigScreen::getColCount(uint8_t row)
 {
+    if (row == 8) {
+        return 1;
+    }
     return (row == 5 || row == 6) ? 3 : 2;
 }
 
@@ -215,9 +246,13 @@ void ConfigScreen::getValue(uint8_t row, uint8_t col, Cell *cell)
         {
             cell->setFloat1(15, settings.lowBattWarn, 4, 30, 150);
         }
+        else if (row == 8) // Capture resolution
+        {
+            cell->setList(15, captureResNames, CAPTURE_RES_COUNT, settings.captureRes);
+        }
 
 #ifdef ENABLE_MEMDEBUG
-        else if (row == 8) // Mem
+        else if (row == 9) // Mem
         {
             cell->setInt16(9, gapSize, 4, 0, 0);
         }
@@ -239,7 +274,7 @@ void ConfigScreen::getValue(uint8_t row, uint8_t col, Cell *cell)
         }
 
 #ifdef ENABLE_MEMDEBUG
-        else if (row == 8) // Mem
+        else if (row == 9) // Mem
         {
             cell->setInt16(16, gapFree, 5, 0, 0);
         }
@@ -289,4 +324,8 @@ void ConfigScreen::setValue(uint8_t row, uint8_t col, Cell *cell)
     {
         settings.lowBattWarn = cell->getFloat1();
     }
+    else if (row == 8)
+    {
+        settings.captureRes = cell->getList();
+    }
 }
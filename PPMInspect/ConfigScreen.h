@@ -35,7 +35,7 @@ class ConfigScreen : public TextUIScreen
 {
 private:
     PPM &ppmH;
-    checksum_t computeChecksum(config_t *cfg) const;
+    checksum_t computeChecksum(config_t *cfg, uint16_t len = sizeof(config_t) - sizeof(checksum_t)) const;
     checksum_t rotate(checksum_t v) const;
     fixfloat1_t lastVppm = 0;
     fixfloat1_t lastVcc = 0;
@@ -57,7 +57,7 @@ public:
     void activate(TextUI *ui);
     void deactivate(TextUI *ui);
 
-    bool isRowEditable(uint8_t row) { return (row < 8); }
+    bool isRowEditable(uint8_t row) { return (row < 9); }
     bool isColEditable(uint8_t row, uint8_t col) { return (col == 0); }
 
     uint8_t getRowCount();
@@ -26,25 +26,30 @@
 
 #include "DataScreen.h"
 #include "ChannelScreen.h"
+#include "ForensicScreen.h"
 
 extern ChannelScreen channelScreen;
+extern ForensicScreen forensicScreen;
 
-#define ROW_COUNT 9
+#define ROW_COUNT 12
 
 const char s1[] PROGMEM = "PPM";
 const char s2[] PROGMEM = "Frame";
 const char s3[] PROGMEM = "Pulse";
 const char s4[] PROGMEM = "Pulse";
 const char s5[] PROGMEM = "Level";
-const char s6[] PROGMEM = "Frames";
-const char s7[] PROGMEM = "E: Long frame";
-const char s8[] PROGMEM = "E: Ch. count";
-const char s9[] PROGMEM = "E: Pulse time";
+const char s6[] PROGMEM = " Low";
+const char s7[] PROGMEM = " High";
+const char s8[] PROGMEM = "Frames";
+const char s9[] PROGMEM = "E: Long frame";
+const char s10[] PROGMEM = "E: Ch. count";
+const char s11[] PROGMEM = "E: Pulse time";
+const char s12[] PROGMEM = "E: Edges lost";
 
-const char* const DataScreenRowNames[ROW_COUNT] PROGMEM = { s1, s2, s3, s4, s5, s6, s7, s8, s9 };
+const char* const DataScreenRowNames[ROW_COUNT] PROGMEM = { s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12 };
 
 const uint8_t Columns[ROW_COUNT] = {
-    3, 3, 3, 1, 4, 1, 1, 1, 1 };
+    3, 3, 3, 1, 4, 3, 3, 1, 1, 1, 1, 1 };
 
 DataScreen::DataScreen(PPM& ppm) : ppmH(ppm)
 {
@@ -118,6 +123,12 @@ void DataScreen::handleEvent(TextUI* ui, Event* e)
             ui->pushScreen(&channelScreen);
             e->markProcessed();
             break;
+
+        case KEY_FUNCTION: // long Down
+            keepActivated = true;
+            ui->pushScreen(&forensicScreen);
+            e->markProcessed();
+            break;
         }
     }
     else if (e->getType() == EVENT_TYPE_TIMER) {
@@ -166,10 +177,10 @@ void DataScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
     }
     else if (row == 2) {
         if (col == 0) {
-            cell->setInt16(7, currentData->pulseMin_usec, 5, 0, 0);
+            cell->setFloat1(7, currentData->pulseMin_us10, 5, 0, 0);
         }
         else if (col == 1) {
-            cell->setInt16(13, currentData->pulseMax_usec, 5, 0, 0);
+            cell->setFloat1(13, currentData->pulseMax_us10, 5, 0, 0);
         }
         else {
             cell->setLabel(19, F("us"), 2);
@@ -195,25 +206,53 @@ void DataScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
         }
     }
     else if (row == 5) {
+        /* Range of the low level within the last frame */
         if (col == 0) {
-            cell->setInt32(11, currentData->frames, 10, 0, 0);
+            cell->setFloat1(7, currentData->vLevelMin_low, 4, 0, 0);
+        }
+        else if (col == 1) {
+            cell->setFloat1(16, currentData->vLevelMax_low, 4, 0, 0);
+        }
+        else {
+            cell->setLabel(20, F("V"), 1);
         }
     }
     else if (row == 6) {
         if (col == 0) {
-            cell->setInt16(16, currentData->badFrames, 5, 0, 0);
+            cell->setFloat1(7, currentData->vLevelMin_high, 4, 0, 0);
+        }
+        else if (col == 1) {
+            cell->setFloat1(16, currentData->vLevelMax_high, 4, 0, 0);
+        }
+        else {
+            cell->setLabel(20, F("V"), 1);
         }
     }
     else if (row == 7) {
         if (col == 0) {
-            cell->setInt16(16, currentData->badCount, 5, 0, 0);
+            cell->setInt32(11, currentData->frames, 10, 0, 0);
         }
     }
     else if (row == 8) {
+        if (col == 0) {
+            cell->setInt16(16, currentData->badFrames, 5, 0, 0);
+        }
+    }
+    else if (row == 9) {
+        if (col == 0) {
+            cell->setInt16(16, currentData->badCount, 5, 0, 0);
+        }
+    }
+    else if (row == 10) {
         if (col == 0) {
             cell->setInt16(16, currentData->badPulse, 5, 0, 0);
         }
     }
+    else if (row == 11) {
+        if (col == 0) {
+            cell->setInt16(16, currentData->droppedEdges, 5, 0, 0);
+        }
+    }
 }
 
 void DataScreen::setValue(uint8_t row, uint8_t col, Cell* cell)
@@ -0,0 +1,118 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _EdgeRing_h_
+#define _EdgeRing_h_
+
+#include "Arduino.h"
+
+/* Edge flags */
+
+/* Signal level after the edge */
+#define EDGE_LEVEL      0x01
+/* There was no edge for a full timer period before this edge */
+#define EDGE_TIMEOUT    0x02
+/* Timeout only, no edge. EDGE_LEVEL is the current signal level */
+#define EDGE_NONE       0x04
+/* Edges got dropped before this edge because the ring was full */
+#define EDGE_LOST       0x08
+/* Edge on the PWM input of the latency scan, not on PORT_PPM_IN */
+#define EDGE_AUX        0x10
+
+/* Must be a power of 2 */
+#define EDGE_RING_SZ    64
+#define EDGE_RING_MASK  (EDGE_RING_SZ - 1)
+
+/* ticks is ICR1. ovf holds the lower 8 bits of the Timer 1 overflow count. */
+typedef struct edge_t {
+    uint16_t ticks;
+    uint8_t  ovf;
+    uint8_t  flags;
+} edge_t;
+
+/*
+ * Single producer / single consumer ring of captured edges.
+ *
+ * The capture ISR is the only producer and calls push().
+ * The main loop is the only consumer and calls pop().
+ * head is only written by the producer, tail only by the consumer.
+ * Both are 8 bit, so reads and writes are atomic on AVR and
+ * no interrupt locking is needed.
+ */
+class EdgeRing {
+
+    private:
+        volatile edge_t ring[EDGE_RING_SZ];
+        volatile uint8_t head = 0;
+        volatile uint8_t tail = 0;
+
+    public:
+        /* Only call while the producer is stopped */
+        void clear() {
+            head = tail = 0;
+        }
+
+        /* Returns false if the ring is full and the edge was dropped */
+        bool push( uint16_t ticks, uint8_t ovf, uint8_t flags) {
+
+            uint8_t h = head;
+            uint8_t next = (h + 1) & EDGE_RING_MASK;
+
+            if( next == tail) {
+                return false;
+            }
+
+            ring[h].ticks = ticks;
+            ring[h].ovf = ovf;
+            ring[h].flags = flags;
+            head = next;
+
+            return true;
+        }
+
+        bool empty() const {
+            return head == tail;
+        }
+
+        /* Returns false if the ring is empty */
+        bool pop( edge_t *e) {
+
+            uint8_t t = tail;
+
+            if( t == head) {
+                return false;
+            }
+
+            e->ticks = ring[t].ticks;
+            e->ovf = ring[t].ovf;
+            e->flags = ring[t].flags;
+            tail = (t + 1) & EDGE_RING_MASK;
+
+            return true;
+        }
+};
+
+#endif
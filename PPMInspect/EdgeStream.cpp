@@ -0,0 +1,238 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "EdgeStream.h"
+
+#define STATE_SYNC1    0
+#define STATE_SYNC2    1
+#define STATE_HEADER   2
+#define STATE_PAYLOAD  3
+#define STATE_CRC      4
+
+uint8_t edgeStreamCRC(uint8_t crc, uint8_t b) {
+
+    crc ^= b;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+    }
+
+    return crc;
+}
+
+/********* Writer **********/
+
+void EdgeStreamWriter::reset(uint32_t ticks) {
+
+    len = 0;
+    seq = 0;
+    lastTicks = ticks;
+    packets = 0;
+    dropped = 0;
+
+    next(true);
+}
+
+void EdgeStreamWriter::addEdge(uint32_t ticks, uint8_t flags) {
+
+    uint8_t* p = &packet[EDGESTREAM_HEADER + len];
+
+    if (len == 0) {
+        packet[2] = (uint8_t)seq;
+        packet[3] = (uint8_t)(seq >> 8);
+        packet[4] = (uint8_t)lastTicks;
+        packet[5] = (uint8_t)(lastTicks >> 8);
+        packet[6] = (uint8_t)(lastTicks >> 16);
+        packet[7] = (uint8_t)(lastTicks >> 24);
+    }
+
+    len += edgeStreamEncode(p, ticks - lastTicks, flags);
+
+    if (!(flags & EDGE_NONE)) {
+        lastTicks = ticks;
+    }
+    seq++;
+}
+
+uint8_t EdgeStreamWriter::finish() {
+
+    uint8_t crc = 0;
+
+    packet[8] = len;
+
+    for (uint8_t i = 2; i < EDGESTREAM_HEADER + len; i++) {
+        crc = edgeStreamCRC(crc, packet[i]);
+    }
+    packet[EDGESTREAM_HEADER + len] = crc;
+
+    return EDGESTREAM_HEADER + len + 1;
+}
+
+void EdgeStreamWriter::next(bool sent) {
+
+    if (len > 0) {
+        if (sent) {
+            packets++;
+        }
+        else {
+            dropped++;
+        }
+    }
+
+    packet[0] = EDGESTREAM_SYNC1;
+    packet[1] = EDGESTREAM_SYNC2;
+    len = 0;
+}
+
+/********* Reader **********/
+
+bool EdgeStreamReader::put(uint8_t b) {
+
+    uint8_t crc;
+
+    switch (state) {
+    case STATE_SYNC1:
+        if (b == EDGESTREAM_SYNC1) {
+            state = STATE_SYNC2;
+        }
+        break;
+
+    case STATE_SYNC2:
+        if (b == EDGESTREAM_SYNC2 || b == EDGESTREAM_SYNC2_ADC) {
+            adc = (b == EDGESTREAM_SYNC2_ADC);
+            pos = 0;
+            state = STATE_HEADER;
+        }
+        else if (b != EDGESTREAM_SYNC1) {
+            state = STATE_SYNC1;
+        }
+        break;
+
+    case STATE_HEADER:
+        buf[pos++] = b;
+        if (pos == EDGESTREAM_HEADER - 2) {
+            len = b;
+            if ((adc && len < sizeof(adcblock_t)) || (!adc && len > EDGESTREAM_PAYLOAD)) {
+                state = STATE_SYNC1;
+            }
+            else {
+                state = (len > 0) ? STATE_PAYLOAD : STATE_CRC;
+            }
+        }
+        break;
+
+    case STATE_PAYLOAD:
+        buf[pos++] = b;
+        if (pos == EDGESTREAM_HEADER - 2 + len) {
+            state = STATE_CRC;
+        }
+        break;
+
+    case STATE_CRC:
+        state = STATE_SYNC1;
+
+        crc = 0;
+        for (uint16_t i = 0; i < pos; i++) {
+            crc = edgeStreamCRC(crc, buf[i]);
+        }
+
+        if (crc != b) {
+            crcErrors++;
+            /* Resync inside the bad packet is not attempted */
+            return false;
+        }
+
+        seq = buf[0] | ((uint16_t)buf[1] << 8);
+        ticks = (uint32_t)buf[2] | ((uint32_t)buf[3] << 8) | ((uint32_t)buf[4] << 16) | ((uint32_t)buf[5] << 24);
+        rpos = EDGESTREAM_HEADER - 2;
+        packets++;
+
+        if (adc) {
+            return true;
+        }
+
+        disc = false;
+        if (started && seq != nextSeq) {
+            lostEdges += (uint16_t)(seq - nextSeq);
+            disc = true;
+        }
+        started = true;
+        nextSeq = seq;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool EdgeStreamReader::getEdge(uint32_t* t, uint8_t* flags) {
+
+    uint32_t delta;
+    uint8_t n;
+
+    if (adc || rpos >= pos) {
+        return false;
+    }
+
+    n = edgeStreamDecode(&buf[rpos], &buf[pos], &delta, flags);
+    if (n == 0) {
+        rpos = pos;
+        return false;
+    }
+    rpos += n;
+
+    if (disc) {
+        *flags |= EDGE_LOST;
+        disc = false;
+    }
+
+    ticks += delta;
+    *t = ticks;
+    nextSeq++;
+
+    return true;
+}
+
+bool EdgeStreamReader::getADC(uint16_t* capture, uint32_t* msec, const adcblock_t** blk, const uint8_t** samples) {
+
+    if (!adc) {
+        return false;
+    }
+
+    /* Payload is not aligned */
+    memcpy(&block, &buf[EDGESTREAM_HEADER - 2], sizeof(adcblock_t));
+
+    if (block.count > len - sizeof(adcblock_t)) {
+        return false;
+    }
+
+    *capture = seq;
+    *msec = ticks;
+    *blk = &block;
+    *samples = &buf[EDGESTREAM_HEADER - 2 + sizeof(adcblock_t)];
+
+    return true;
+}
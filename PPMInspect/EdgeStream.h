@@ -0,0 +1,238 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _EdgeStream_h_
+#define _EdgeStream_h_
+
+#include "Arduino.h"
+#include "EdgeRing.h"
+
+/*
+ * Binary edge stream. Captured edges are sent over Serial in packets.
+ *
+ * Packet:
+ *   0xA5 0x5A       sync
+ *   seq             uint16 LE, sequence number of the first edge in the packet
+ *   base            uint32 LE, timestamp (0.5 usec ticks) the first delta refers to
+ *   len             uint8, number of payload bytes
+ *   payload         len bytes of records
+ *   crc             CRC-8 (poly 0x07) over seq .. payload
+ *
+ * Record, one per edge, unsigned LEB128 varint of
+ *   (delta << 2) | (disc << 1) | level
+ *
+ *   delta    ticks since the previous edge, limited to EDGESTREAM_MAX_DELTA
+ *   disc     timeout or lost edges before this edge
+ *   level    signal level after the edge
+ *
+ * delta 0 with disc set is a timeout without an edge.
+ *
+ * Each edge increments the sequence number, also if its packet could not be
+ * sent. A gap in the sequence numbers is the number of edges lost.
+ * A typical PPM edge needs 2 bytes, a sync gap 3 bytes.
+ *
+ * Scope packet, sent when the scope display gets frozen:
+ *   0xA5 0x5B       sync
+ *   seq             uint16 LE, capture number
+ *   base            uint32 LE, millis() of the capture
+ *   len             uint8, sizeof(adcblock_t) + samples
+ *   payload         adcblock_t followed by the samples
+ *   crc             as above
+ *
+ * The same records and adcblock_t are used by the .ppmcap file format (PPMHost/PPMCap.h).
+ */
+
+#define EDGESTREAM_SYNC1        0xA5
+#define EDGESTREAM_SYNC2        0x5A
+#define EDGESTREAM_SYNC2_ADC    0x5B
+/* sync, seq, base, len */
+#define EDGESTREAM_HEADER       9
+/* Header, payload and crc fit into the 64 byte Serial transmit buffer */
+#define EDGESTREAM_PAYLOAD      48
+#define EDGESTREAM_PACKET       (EDGESTREAM_HEADER + EDGESTREAM_PAYLOAD + 1)
+/* Largest record is 5 bytes */
+#define EDGESTREAM_RECORD_MAX   5
+#define EDGESTREAM_MAX_DELTA    0x3fffffffUL
+
+#define EDGESTREAM_LEVEL        0x01
+#define EDGESTREAM_DISC         0x02
+
+/* Scope samples. Same layout on AVR and little endian hosts. */
+typedef struct adcblock_t {
+    uint16_t sample_usec;        /* Time between samples */
+    uint16_t triggerDelay_usec;
+    int16_t  triggerLevel;       /* 0.1 V */
+    uint16_t lsb_mV;             /* Voltage of one sample step */
+    uint8_t  oversampling;
+    uint8_t  triggerMode;
+    uint8_t  count;              /* Number of samples following */
+    uint8_t  pretrigger;         /* Samples before the trigger sample */
+} adcblock_t;
+
+#define EDGESTREAM_ADC_MAX      (255 - sizeof(adcblock_t))
+
+uint8_t edgeStreamCRC( uint8_t crc, uint8_t b);
+
+/*
+ * Encode one edge record at p. Returns the record length.
+ * delta is ignored for EDGE_NONE.
+ */
+inline uint8_t edgeStreamEncode( uint8_t *p, uint32_t delta, uint8_t flags) {
+
+    uint8_t *s = p;
+    uint32_t v;
+
+    if (flags & EDGE_NONE) {
+        delta = 0;
+    }
+    else if (delta > EDGESTREAM_MAX_DELTA) {
+        delta = EDGESTREAM_MAX_DELTA;
+    }
+    else if (delta == 0) {
+        /* Only the first edge of a scan can be at the reference time.
+         * delta 0 is reserved for timeouts.
+         */
+        delta = 1;
+    }
+
+    v = (delta << 2)
+        | ((flags & (EDGE_TIMEOUT | EDGE_LOST)) ? EDGESTREAM_DISC : 0)
+        | ((flags & EDGE_LEVEL) ? EDGESTREAM_LEVEL : 0);
+
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+
+    return p - s;
+}
+
+/*
+ * Decode one edge record from p up to end. flags are EDGE_* from EdgeRing.h.
+ * Returns the record length or 0 if the record is truncated.
+ */
+inline uint8_t edgeStreamDecode( const uint8_t *p, const uint8_t *end, uint32_t *delta, uint8_t *flags) {
+
+    const uint8_t *s = p;
+    uint32_t v = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+
+    do {
+        if (p == end || shift > 28) {
+            return 0;
+        }
+        b = *p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    *delta = v >> 2;
+    *flags = (v & EDGESTREAM_LEVEL) ? EDGE_LEVEL : 0;
+
+    if (v & EDGESTREAM_DISC) {
+        *flags |= (*delta == 0) ? (EDGE_TIMEOUT | EDGE_NONE) : EDGE_TIMEOUT;
+    }
+
+    return p - s;
+}
+
+/* Packs edges into packets. Used on the device. */
+class EdgeStreamWriter {
+
+    private:
+        uint8_t  packet[EDGESTREAM_PACKET];
+        uint8_t  len;
+        uint16_t seq;
+        uint32_t lastTicks;
+
+    public:
+        /* Counters for display */
+        uint32_t packets;
+        uint16_t dropped;
+
+        void reset( uint32_t ticks);
+
+        /* flags are EDGE_* from EdgeRing.h */
+        void addEdge( uint32_t ticks, uint8_t flags);
+
+        bool isEmpty() const { return len == 0; }
+        bool isFull() const { return len > EDGESTREAM_PAYLOAD - EDGESTREAM_RECORD_MAX; }
+
+        /* Complete the packet. Returns its size in bytes. */
+        uint8_t finish();
+        const uint8_t *getPacket() const { return packet; }
+
+        /* Start the next packet. sent is false if the packet was dropped. */
+        void next( bool sent);
+};
+
+/* Parses a byte stream back into edges and scope captures. Used on the host. */
+class EdgeStreamReader {
+
+    private:
+        uint8_t  state = 0;
+        /* seq .. payload */
+        uint8_t  buf[EDGESTREAM_HEADER - 2 + 255];
+        uint16_t pos;
+        uint8_t  len;
+        bool     adc;
+        adcblock_t block;
+
+        /* Decoding the payload of a complete packet */
+        uint16_t rpos;
+        uint16_t seq;
+        uint32_t ticks;
+        bool     disc;
+
+        bool     started = false;
+        uint16_t nextSeq;
+
+    public:
+        /* Counters */
+        uint32_t packets = 0;
+        uint32_t crcErrors = 0;
+        uint32_t lostEdges = 0;
+
+        /* Feed one byte. Returns true when a valid packet is complete. */
+        bool put( uint8_t b);
+
+        /* Timestamp of the last edge. The packet base right after put(). */
+        uint32_t getTicks() const { return ticks; }
+
+        /* The complete packet is a scope capture */
+        bool isADC() const { return adc; }
+        /* Scope capture. Returns false for edge packets. */
+        bool getADC( uint16_t *capture, uint32_t *msec, const adcblock_t **blk, const uint8_t **samples);
+
+        /* Next edge of the complete packet. Returns false at the end.
+         * flags are EDGE_* from EdgeRing.h
+         */
+        bool getEdge( uint32_t *t, uint8_t *flags);
+};
+
+#endif
@@ -0,0 +1,247 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "ForensicScreen.h"
+
+/* Reason row and one row per pulse/gap pair */
+#define ROW_COUNT  (1 + (PPM_MAX_PULSE + 1) / 2)
+
+const char r0[] PROGMEM = "armed";
+const char r1[] PROGMEM = "Long frame";
+const char r2[] PROGMEM = "Ch. count";
+const char r3[] PROGMEM = "Pulse time";
+
+const char* const ForensicReasons[] PROGMEM = { r0, r1, r2, r3 };
+
+ForensicScreen::ForensicScreen(PPM& ppm) : ppmH(ppm)
+{
+    strcpy(rowName, "P  ");
+    update();
+}
+
+void ForensicScreen::update()
+{
+    bool f;
+
+    currentData = ppmH.getForensic();
+    f = currentData->frozen;
+
+    if (f != frozen) {
+        frozen = f;
+        frame = FORENSIC_PRE_FRAMES;
+        refresh = true;
+    }
+    hasNewData = true;
+}
+
+/* Frame f of the context. Slot of the bad frame is at FORENSIC_PRE_FRAMES. */
+const ppmframe_t* ForensicScreen::getFrame(uint8_t f)
+{
+    uint8_t slot = (currentData->badSlot + FORENSIC_SLOTS - FORENSIC_PRE_FRAMES + f) % FORENSIC_SLOTS;
+
+    return &(currentData->frame[slot]);
+}
+
+/*
+ * One line per frame:
+ *   <position> <count>: <pulse> <gap> <pulse> ...
+ */
+void ForensicScreen::dump()
+{
+    const ppmframe_t* f;
+
+    Serial.print(F("Bad frame: "));
+    Serial.println((const __FlashStringHelper*)pgm_read_ptr(&ForensicReasons[currentData->reason]));
+
+    if (!frozen) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < FORENSIC_FRAMES; i++) {
+        f = getFrame(i);
+
+        Serial.print((int)i - FORENSIC_PRE_FRAMES);
+        Serial.print(' ');
+        Serial.print(f->count);
+        Serial.print(':');
+
+        for (uint8_t p = 0; p < f->count; p++) {
+            Serial.print(' ');
+            Serial.print(f->pulse_usec[p]);
+        }
+        Serial.println();
+    }
+}
+
+/* TextUI */
+
+const char* ForensicScreen::getHeader()
+{
+    return nullptr;
+}
+
+const char* ForensicScreen::getMenuName()
+{
+    return "Bad frames";
+}
+
+uint8_t ForensicScreen::getRowCount()
+{
+    return ROW_COUNT;
+}
+
+const char* ForensicScreen::getRowName(uint8_t row)
+{
+    if (row == 0) {
+        return "Bad";
+    }
+
+    if (!frozen || (row - 1) * 2 >= getFrame(frame)->count) {
+        return "";
+    }
+
+    if (row < 10) {
+        rowName[1] = '0' + row;
+        rowName[2] = ' ';
+    }
+    else {
+        rowName[1] = '1';
+        rowName[2] = '0' + row - 10;
+    }
+
+    return rowName;
+}
+
+void ForensicScreen::handleEvent(TextUI* ui, Event* e)
+{
+    if (e->getType() == EVENT_TYPE_KEY) {
+        switch (e->getKey()) {
+        case KEY_CLEAR: // long Enter
+            ui->popScreen();
+            e->markProcessed();
+            break;
+
+        case KEY_ENTER:
+            dump();
+            e->markProcessed();
+            break;
+
+        case KEY_RESET: // long Up
+            ppmH.rearmForensic();
+            update();
+            e->markProcessed();
+            break;
+
+        case KEY_FUNCTION: // long Down
+            frame = (frame + 1) % FORENSIC_FRAMES;
+            refresh = true;
+            hasNewData = true;
+            e->markProcessed();
+            break;
+        }
+    }
+    else if (e->getType() == EVENT_TYPE_TIMER) {
+        update();
+    }
+}
+
+bool ForensicScreen::needsRefresh()
+{
+    if (refresh) {
+        refresh = false;
+        return true;
+    }
+
+    return false;
+}
+
+uint8_t ForensicScreen::getColCount(uint8_t row)
+{
+    uint8_t count;
+
+    if (row == 0) {
+        return frozen ? 3 : 1;
+    }
+
+    if (!frozen) {
+        return 0;
+    }
+
+    count = getFrame(frame)->count;
+
+    if ((row - 1) * 2 >= count) {
+        return 0;
+    }
+
+    /* Last pulse may have no gap */
+    return ((row - 1) * 2 + 1 < count) ? 3 : 1;
+}
+
+bool ForensicScreen::hasChanged(uint8_t row, uint8_t col)
+{
+    return hasNewData;
+}
+
+void ForensicScreen::endRefresh()
+{
+    hasNewData = false;
+}
+
+void ForensicScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    const uint16_t* pulse_usec;
+
+    if (row == 0) {
+        if (col == 0) {
+            cell->setLabel(4, (const __FlashStringHelper*)pgm_read_ptr(&ForensicReasons[currentData->reason]), 10);
+        }
+        else if (col == 1) {
+            cell->setLabel(16, F("F"), 1);
+        }
+        else {
+            cell->setInt8(18, (int8_t)frame - FORENSIC_PRE_FRAMES, 2, 0, 0);
+        }
+    }
+    else {
+        pulse_usec = getFrame(frame)->pulse_usec + (row - 1) * 2;
+
+        if (col == 0) {
+            cell->setInt16(4, pulse_usec[0], 5, 0, 0);
+        }
+        else if (col == 1) {
+            cell->setInt16(10, pulse_usec[1], 5, 0, 0);
+        }
+        else {
+            /* Servo time of the channel */
+            cell->setInt16(16, pulse_usec[0] + pulse_usec[1], 5, 0, 0);
+        }
+    }
+}
+
+void ForensicScreen::setValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    /* noop */
+}
@@ -0,0 +1,89 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _ForensicScreen_h_
+#define _ForensicScreen_h_
+
+#include "TextUI.h"
+#include "PPM.h"
+
+/* Context frames shown: pre frames, the bad frame and post frames */
+#define FORENSIC_FRAMES  (FORENSIC_PRE_FRAMES + 1 + FORENSIC_POST_FRAMES)
+
+/*
+ * Browse the raw pulse times around the first bad PPM frame.
+ *
+ *   Up/Down     scroll
+ *   Enter       dump all frames to Serial
+ *   long Up     rearm capture
+ *   long Enter  back
+ *   long Down   next frame
+ */
+class ForensicScreen : public TextUIScreen
+{
+private:
+    PPM &ppmH;
+    const forensic_t *currentData = nullptr;
+    bool frozen = false;
+    bool hasNewData = true;
+    bool refresh = false;
+    char rowName[4];
+
+    /* 0 .. FORENSIC_FRAMES-1, FORENSIC_PRE_FRAMES is the bad frame */
+    uint8_t frame = FORENSIC_PRE_FRAMES;
+
+    const ppmframe_t *getFrame(uint8_t f);
+    void dump();
+
+public:
+    explicit ForensicScreen(PPM &ppm);
+
+    void update();
+
+    /* TextUI */
+    void handleEvent(TextUI *ui, Event *e);
+    bool needsRefresh();
+
+    const char *getHeader();
+    const char *getMenuName();
+
+    bool goBackItem() { return false; }
+
+    uint8_t getRowCount();
+    const char *getRowName(uint8_t row);
+
+    bool isRowEditable(uint8_t row) { return false; }
+
+    uint8_t getColCount(uint8_t row);
+
+    bool hasChanged(uint8_t row, uint8_t col);
+    void endRefresh();
+
+    void getValue(uint8_t row, uint8_t col, Cell *cell);
+    void setValue(uint8_t row, uint8_t col, Cell *cell);
+};
+
+#endif
@@ -29,21 +29,33 @@
 #include "HomeScreen.h"
 #include "DataScreen.h"
 #include "PWMScreen.h"
+#include "ServoScreen.h"
+#include "LatencyScreen.h"
 #include "ScopeScreen.h"
+#include "LogicScreen.h"
 #include "VMeterScreen.h"
 #include "ConfigScreen.h"
+#include "StreamScreen.h"
 
 extern DataScreen dataScreen;
 extern PWMScreen pwmScreen;
+extern ServoScreen servoScreen;
+extern LatencyScreen latencyScreen;
 extern ScopeScreen scopeScreen;
+extern LogicScreen logicScreen;
 extern VMeterScreen vMeterScreen;
 extern ConfigScreen configScreen;
+extern StreamScreen streamScreen;
 
 HomeScreen::HomeScreen() : TextUIMenu("PPMInspect " PPMINSPECT_VERSION){
 
     addScreen( &dataScreen);
     addScreen( &pwmScreen);
+    addScreen( &servoScreen);
+    addScreen( &latencyScreen);
     addScreen( &scopeScreen);
+    addScreen( &logicScreen);
     addScreen( &vMeterScreen);
+    addScreen( &streamScreen);
     addScreen( &configScreen);
 }
@@ -0,0 +1,156 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "LatencyMeter.h"
+
+static uint16_t sat16(uint32_t v) {
+
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+static uint16_t absDiff(uint16_t a, uint16_t b) {
+
+    return (a > b) ? a - b : b - a;
+}
+
+void LatencyMeter::reset(uint8_t channel, uint8_t shift) {
+
+    memset(&lat, 0, sizeof(latency_t));
+    lat.channel = channel;
+
+    tickShift = shift;
+    timeoutTicks = ((uint32_t)LATENCY_TIMEOUT_MSEC * 1000) << shift;
+    lastStored = 0;
+    ppmValid = false;
+    pwmValid = false;
+    pwmHigh = false;
+    pending = false;
+}
+
+void LatencyMeter::ppmEdge(uint32_t ticks, uint8_t stored, const ppm_t* wSet) {
+
+    expire(ticks);
+
+    if (stored != lastStored) {
+        lastStored = stored;
+        /* This edge ended the watched channel */
+        if (stored == lat.channel + 1) {
+            ppmChannel(ticks, wSet->channel_us10[lat.channel]);
+        }
+    }
+}
+
+void LatencyMeter::pwmEdge(uint32_t ticks, bool level) {
+
+    expire(ticks);
+
+    if (level) {
+        riseTicks = ticks;
+        pwmHigh = true;
+    }
+    else if (pwmHigh) {
+        uint32_t dt = ticks - riseTicks;
+
+        /* Keep q4 below 2^28 for toUs10() */
+        if (dt > ((uint32_t)UINT16_MAX << tickShift)) {
+            dt = (uint32_t)UINT16_MAX << tickShift;
+        }
+        pwmHigh = false;
+        pwmPulse(riseTicks, sat16(PPMDecoder::toUs10(dt << (4 - tickShift))));
+    }
+}
+
+void LatencyMeter::ppmChannel(uint32_t ticks, uint16_t value_us10) {
+
+    lat.ppm_us10 = value_us10;
+
+    /* Changes only count once there is a PWM pulse to compare with */
+    if (!ppmValid || !pwmValid) {
+        ppmBase_us10 = value_us10;
+        ppmValid = true;
+        return;
+    }
+
+    if (!pending && absDiff(value_us10, ppmBase_us10) >= LATENCY_STEP_USEC * 10) {
+        lat.changes++;
+        pending = true;
+        changeTicks = ticks;
+        ppmBase_us10 = value_us10;
+        pwmBase_us10 = lat.pwm_us10;
+    }
+}
+
+void LatencyMeter::pwmPulse(uint32_t rise, uint16_t width_us10) {
+
+    /* Pulses starting before the change cannot carry it */
+    if (pending && (int32_t)(rise - changeTicks) >= 0
+            && absDiff(width_us10, pwmBase_us10) >= LATENCY_STEP_USEC * 5) {
+        pending = false;
+        record(rise - changeTicks);
+    }
+
+    lat.pwm_us10 = width_us10;
+    pwmValid = true;
+}
+
+void LatencyMeter::expire(uint32_t ticks) {
+
+    if (pending && (int32_t)(ticks - changeTicks) > (int32_t)timeoutTicks) {
+        pending = false;
+        lat.missed++;
+    }
+}
+
+void LatencyMeter::record(uint32_t ticks) {
+
+    uint32_t usec = ticks >> tickShift;
+    uint8_t bin = (usec / LATENCY_BIN_USEC < LATENCY_BINS) ? usec / LATENCY_BIN_USEC : LATENCY_BINS - 1;
+
+    lat.matched++;
+    lat.last_usec = usec;
+    if (lat.matched == 1 || usec < lat.min_usec) {
+        lat.min_usec = usec;
+    }
+    if (usec > lat.max_usec) {
+        lat.max_usec = usec;
+    }
+
+    /* Halving both keeps the average */
+    if (lat.sum_usec > UINT32_MAX - usec || lat.sumCount == UINT16_MAX) {
+        lat.sum_usec >>= 1;
+        lat.sumCount >>= 1;
+    }
+    lat.sum_usec += usec;
+    lat.sumCount++;
+
+    /* Counts saturate. Halve all bins to keep the shape. */
+    if (lat.hist[bin] == UINT8_MAX) {
+        for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+            lat.hist[b] >>= 1;
+        }
+    }
+    lat.hist[bin]++;
+}
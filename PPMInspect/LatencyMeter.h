@@ -0,0 +1,103 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _LatencyMeter_h_
+#define _LatencyMeter_h_
+
+#include "Config.h"
+#include "PPMDecoder.h"
+
+/* Results. Latencies in usec from the end of the PPM channel to the start of the PWM pulse. */
+typedef struct latency_t {
+
+    uint8_t  channel;         /* PPM channel watched, 0 based */
+    uint16_t ppm_us10;        /* Last value of the channel */
+    uint16_t pwm_us10;        /* Last PWM pulse */
+    uint16_t changes;         /* Channel changes by LATENCY_STEP_USEC */
+    uint16_t missed;          /* Changes without a matching pulse */
+    uint16_t matched;
+    uint32_t last_usec;
+    uint32_t min_usec;
+    uint32_t max_usec;
+    /* Average is sum_usec / sumCount. Both are halved before sum_usec overflows. */
+    uint32_t sum_usec;
+    uint16_t sumCount;
+    /* LATENCY_BIN_USEC per bin. Counts are halved when one saturates. */
+    uint8_t  hist[LATENCY_BINS];
+} latency_t;
+
+/*
+ * Hardware independent latency meter. Correlates a PPM channel with a PWM output.
+ *
+ * ppmEdge() is called after every PPM edge passed to PPMDecoder. The edge that
+ * ends the watched channel is the time its new value is known. pwmEdge() gets
+ * the edges of the PWM output. Both timestamps are timer ticks, see PPMDecoder.
+ *
+ * A change of the channel by LATENCY_STEP_USEC arms the meter. The first PWM pulse
+ * starting after it with a width LATENCY_STEP_USEC / 2 away from the pulse before
+ * the change ends the measurement. Further changes are ignored until then.
+ * Direction and scale of the output do not matter, so reversed or mixed outputs
+ * of a flight controller work as long as a step moves them far enough.
+ */
+class LatencyMeter {
+
+    private:
+        latency_t lat;
+        uint8_t  tickShift;
+        uint32_t timeoutTicks;
+        /* PPMDecoder::getStoredChannels() after the previous PPM edge */
+        uint8_t  lastStored;
+        bool     ppmValid;
+        bool     pwmValid;
+        bool     pwmHigh;
+        bool     pending;
+        /* Channel value and PWM pulse the next change is measured against */
+        uint16_t ppmBase_us10;
+        uint16_t pwmBase_us10;
+        uint32_t changeTicks;
+        uint32_t riseTicks;
+
+        void ppmChannel( uint32_t ticks, uint16_t value_us10);
+        void pwmPulse( uint32_t rise, uint16_t width_us10);
+        void expire( uint32_t ticks);
+        void record( uint32_t ticks);
+
+    public:
+        /* channel is 0 based, shift is DECODER_SHIFT_* */
+        void reset( uint8_t channel, uint8_t shift = DECODER_SHIFT_500NS);
+
+        /* After each PPM edge. stored is PPMDecoder::getStoredChannels(), wSet the PPM write set. */
+        void ppmEdge( uint32_t ticks, uint8_t stored, const ppm_t *wSet);
+        /* PWM edge, level is the level after it */
+        void pwmEdge( uint32_t ticks, bool level);
+        /* Edges got dropped, the next rising edge starts over */
+        void pwmLost() { pwmHigh = false; }
+
+        uint8_t getChannel() const { return lat.channel; }
+        const latency_t *getLatency() const { return &lat; }
+};
+
+#endif
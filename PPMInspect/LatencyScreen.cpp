@@ -0,0 +1,230 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "LatencyScreen.h"
+
+#define ROW_COUNT 10
+
+/* Rows of last, min, avg and max latency */
+#define LATENCY_ROW  4
+
+const char l1[] PROGMEM = "PPM Ch";
+const char l2[] PROGMEM = "PWM D9";
+const char l3[] PROGMEM = "Changes";
+const char l4[] PROGMEM = "Missed";
+const char l5[] PROGMEM = "Last";
+const char l6[] PROGMEM = "Min";
+const char l7[] PROGMEM = "Avg";
+const char l8[] PROGMEM = "Max";
+const char l9[] PROGMEM = "Hist";
+const char l10[] PROGMEM = "E: Edges lost";
+
+const char* const LatencyScreenRowNames[ROW_COUNT] PROGMEM = {
+    l1, l2, l3, l4, l5, l6, l7, l8, l9, l10 };
+
+const uint8_t Columns[ROW_COUNT] = {
+    3, 2, 1, 1, 2, 2, 2, 2, 1, 1 };
+
+LatencyScreen::LatencyScreen(PPM& ppm) : ppmH(ppm)
+{
+    update();
+}
+
+void LatencyScreen::update()
+{
+    currentPPM = ppmH.getPPM();
+    currentData = ppmH.getLatency();
+    hasNewData = true;
+}
+
+/* Scale histogram to digits 1-9. Empty bins are shown as '.' */
+void LatencyScreen::formatHistogram()
+{
+    uint8_t max = 0;
+
+    for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+        if (currentData->hist[b] > max) {
+            max = currentData->hist[b];
+        }
+    }
+
+    for (uint8_t b = 0; b < LATENCY_BINS; b++) {
+        if (currentData->hist[b] == 0) {
+            histBars[b] = '.';
+        }
+        else {
+            histBars[b] = '0' + ((uint16_t)currentData->hist[b] * 9 + max - 1) / max;
+        }
+    }
+
+    histBars[LATENCY_BINS] = '\0';
+}
+
+/* TextUI */
+
+void LatencyScreen::activate(TextUI* ui)
+{
+    ppmH.startLatencyScan(channel);
+}
+
+void LatencyScreen::deactivate(TextUI* ui)
+{
+    ppmH.stopScan();
+}
+
+void LatencyScreen::handleEvent(TextUI* ui, Event* e)
+{
+    if (e->getType() == EVENT_TYPE_KEY) {
+
+        switch (e->getKey()) {
+        case KEY_CLEAR: // long Enter
+            ui->popScreen();
+            e->markProcessed();
+            break;
+
+        case KEY_RESET: // long Up
+            ppmH.stopScan();
+            delay(500);
+            ppmH.startLatencyScan(channel);
+            e->markProcessed();
+            break;
+
+        case KEY_FUNCTION: // long Down
+            /* Next channel of the current frame, starts over */
+            channel++;
+            if (channel >= ((currentPPM->channels > 0) ? currentPPM->channels : PPM_MAX_CHANNELS)) {
+                channel = 0;
+            }
+            ppmH.stopScan();
+            ppmH.startLatencyScan(channel);
+            update();
+            e->markProcessed();
+            break;
+        }
+    }
+    else if (e->getType() == EVENT_TYPE_TIMER) {
+        update();
+    }
+}
+
+const char* LatencyScreen::getHeader()
+{
+    return nullptr;
+}
+
+const char* LatencyScreen::getMenuName()
+{
+    return TextUI::copyToBuffer((const char*)F("Latency"));
+}
+
+uint8_t LatencyScreen::getRowCount()
+{
+    return ROW_COUNT;
+}
+
+const char* LatencyScreen::getRowName(uint8_t row)
+{
+    return TextUI::copyToBuffer((const char*)pgm_read_ptr(&LatencyScreenRowNames[row]));
+}
+
+uint8_t LatencyScreen::getColCount(uint8_t row)
+{
+    return Columns[row];
+}
+
+bool LatencyScreen::hasChanged(uint8_t row, uint8_t col)
+{
+    return hasNewData;
+}
+
+void LatencyScreen::endRefresh()
+{
+    hasNewData = false;
+}
+
+void LatencyScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    if (row == 0) {
+        if (col == 0) {
+            cell->setInt8(7, currentData->channel + 1, 2, 0, 0);
+        }
+        else if (col == 1) {
+            if (currentPPM->sync) {
+                cell->setFloat1(11, currentData->ppm_us10, 7, 0, 0);
+            }
+            else {
+                cell->setLabel(11, F("    ---"), 7);
+            }
+        }
+        else {
+            cell->setLabel(19, F("us"), 2);
+        }
+    }
+    else if (row == 1) {
+        if (col == 0) {
+            cell->setFloat1(11, currentData->pwm_us10, 7, 0, 0);
+        }
+        else {
+            cell->setLabel(19, F("us"), 2);
+        }
+    }
+    else if (row == 2) {
+        cell->setInt16(16, currentData->changes, 5, 0, 0);
+    }
+    else if (row == 3) {
+        cell->setInt16(16, currentData->missed, 5, 0, 0);
+    }
+    else if (row >= LATENCY_ROW && row < LATENCY_ROW + 4) {
+        /* Last, min, avg, max in 0.1 msec */
+        uint32_t usec;
+
+        if (col == 1) {
+            cell->setLabel(19, F("ms"), 2);
+            return;
+        }
+
+        if (currentData->matched == 0) {
+            cell->setLabel(11, F("    ---"), 7);
+            return;
+        }
+
+        switch (row - LATENCY_ROW) {
+        case 0: usec = currentData->last_usec; break;
+        case 1: usec = currentData->min_usec; break;
+        case 2: usec = currentData->sum_usec / currentData->sumCount; break;
+        default: usec = currentData->max_usec; break;
+        }
+
+        cell->setFloat1(11, (usec + 50) / 100, 7, 0, 0);
+    }
+    else if (row == ROW_COUNT - 2) {
+        formatHistogram();
+        cell->setLabel(5, histBars, LATENCY_BINS);
+    }
+    else if (row == ROW_COUNT - 1) {
+        cell->setInt16(16, currentPPM->droppedEdges, 5, 0, 0);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _LogicAcq_h_
+#define _LogicAcq_h_
+
+#include "Arduino.h"
+#include "Config.h"
+#include "CaptureStore.h"
+
+/* Samples per capture */
+#define LOGIC_SAMPLES        ((uint16_t)LOGIC_BYTES * 8)
+
+/* Sample rates */
+#define LOGIC_RATE_4M        0
+#define LOGIC_RATE_2M        1
+#define LOGIC_RATE_1M        2
+#define LOGIC_RATE_500K      3
+/* Deep capture, 2 MHz */
+#define LOGIC_RATE_DEEP      4
+
+#define LOGIC_RATES          5
+
+/* CPU cycles (16 MHz) per sample. Deep capture counts Timer 1 ticks of 0.5 usec. */
+#define LOGIC_CYCLES(rate)   ((uint8_t)(((rate) == LOGIC_RATE_DEEP) ? 8 : 4 << (rate)))
+
+/* Packed samples or deep capture store */
+#define LOGIC_BUF_BYTES      ((LOGIC_BYTES + 1 > LOGIC_DEEP_BYTES) ? LOGIC_BYTES + 1 : LOGIC_DEEP_BYTES)
+
+/* CPU cycles from reading TCNT1 to the first sample */
+#define LOGIC_START_CYCLES   3
+
+/*
+ * Hardware independent part of the logic analyzer.
+ *
+ * The sampling loop in PPM.cpp reads PINB every LOGIC_CYCLES(rate) cycles
+ * and shifts the PORT_PPM_IN bit into bits[], first sample in the MSB.
+ * bits[0] is scratch for the loop, sample 0 is the MSB of bits[1].
+ *
+ * With a trigger, Timer 1 runs at the CPU clock and input capture
+ * timestamps the trigger edge. startCycles is the time from that edge
+ * to sample 0. Without trigger sample 0 is time 0.
+ *
+ * Deep capture timestamps every edge with input capture at 0.5 usec
+ * and stores the levels run length compressed in bits[]. The record
+ * starts at the trigger edge and ends when the store is full or after
+ * LOGIC_DEEP_MSEC.
+ */
+class LogicAcq {
+
+    public:
+        uint8_t  bits[LOGIC_BUF_BYTES];
+        uint8_t  rate;
+        uint8_t  triggerMode;
+        uint16_t startCycles;
+        CaptureStore store;
+
+        bool isDeep() const { return rate == LOGIC_RATE_DEEP; }
+
+        uint32_t getSamples() const { return isDeep() ? store.getSamples() : LOGIC_SAMPLES; }
+
+        uint8_t level( uint32_t i) const {
+
+            if (isDeep()) {
+                return store.valueAt(i);
+            }
+
+            return (bits[1 + (i >> 3)] >> (7 - (i & 7))) & 1;
+        }
+
+        /* First sample after i with a different level. getSamples() if there is none. */
+        uint32_t nextEdge( uint32_t i) const {
+
+            if (isDeep()) {
+                return store.nextChange(i);
+            }
+
+            uint8_t l = level(i);
+            uint8_t same = l ? 0xff : 0x00;
+
+            for (i++; i < LOGIC_SAMPLES; i++) {
+                /* Skip bytes without an edge */
+                if ((i & 7) == 0) {
+                    while (i < LOGIC_SAMPLES && bits[1 + (i >> 3)] == same) {
+                        i += 8;
+                    }
+                    if (i >= LOGIC_SAMPLES) {
+                        break;
+                    }
+                }
+                if (level(i) != l) {
+                    return i;
+                }
+            }
+
+            return LOGIC_SAMPLES;
+        }
+
+        /* Time of sample i in nsec after the trigger edge */
+        uint32_t sampleNsec( uint32_t i) const {
+
+            return ((uint32_t)startCycles + (uint32_t)i * LOGIC_CYCLES(rate)) * 125 / 2;
+        }
+};
+
+#endif
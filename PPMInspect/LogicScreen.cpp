@@ -0,0 +1,273 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "LogicScreen.h"
+#include "ScopeScreen.h"
+
+/*
+ * |012345678901234567891|
+ * |500k T- E  42        |
+ * |  trace, rows 1 - 3  |
+ * |L    12.50   300.00  |
+ */
+
+#define ROW_COUNT 1
+
+/* Trace levels in pixel, rows 1 - 3 */
+#define TRACE_Y0      8
+#define TRACE_Y1     31
+#define TRACE_HIGH   18
+#define TRACE_LOW     2
+
+/* First row of the pulse list */
+#define LIST_ROW      4
+
+#define TRIGGER_MODES 3
+
+const char* logicTriggerModes[TRIGGER_MODES] = {
+    "f", "+", "-"
+};
+
+const char* logicRates[LOGIC_RATES] = {
+    "  4M", "  2M", "  1M", "500k", "deep"
+};
+
+/* Trace buffer is shared with the scope */
+extern uint8_t dataArray[ARRAY_SZ];
+
+LogicScreen::LogicScreen(PPM& ppm) : ppmH(ppm)
+{
+
+}
+
+void LogicScreen::activate(TextUI* ui)
+{
+    acq = nullptr;
+    edges = 0;
+    listStart = 0;
+    freeze = false;
+    hasNewData = true;
+}
+
+void LogicScreen::update(TextUI* ui)
+{
+    TextUILcd* lcd = ui->getDisplay();
+    const LogicAcq* a;
+    uint32_t i;
+
+    if (freeze) {
+        return;
+    }
+
+    /* No display interrupts during the capture */
+    lcd->flush();
+
+    /* Blocks until the trigger edge and the capture are done */
+    a = ppmH.fetchLogic(rate, triggerMode);
+    if (a == nullptr) {
+        return;
+    }
+    acq = a;
+
+    edges = 0;
+    for (i = acq->nextEdge(0); i < acq->getSamples(); i = acq->nextEdge(i)) {
+        edges++;
+    }
+    hasNewData = true;
+
+    drawTrace(lcd);
+    drawList(lcd);
+    marker = !marker;
+}
+
+/* One pixel per byte. A pixel with both levels is drawn as vertical line.
+ * A deep capture is fit to the screen width.
+ */
+void LogicScreen::drawTrace(TextUILcd* lcd)
+{
+    uint8_t b;
+    uint8_t *dataMin = ppmH.getMinArray();
+
+    if (acq->isDeep()) {
+        acq->store.window(0, acq->getSamples() / ARRAY_SZ + 1, ARRAY_SZ, dataArray, dataMin);
+
+        for (uint8_t x = 0; x < ARRAY_SZ; x++) {
+            dataArray[x] = dataArray[x] ? TRACE_HIGH : TRACE_LOW;
+            dataMin[x] = dataMin[x] ? TRACE_HIGH : TRACE_LOW;
+        }
+    }
+    else {
+        for (uint8_t x = 0; x < ARRAY_SZ && x < LOGIC_BYTES; x++) {
+            b = acq->bits[1 + x];
+            dataArray[x] = (b != 0x00) ? TRACE_HIGH : TRACE_LOW;
+            dataMin[x] = (b == 0xff) ? TRACE_HIGH : TRACE_LOW;
+        }
+    }
+
+    lcd->setGridShadow(ppmH.getGridShadow());
+    lcd->drawGrid(dataArray, dataMin, ARRAY_SZ, 0, 0, TRACE_Y0, 127, TRACE_Y1, 0, marker, 0);
+}
+
+/* Complete pulses from listStart on. Level, start after the trigger and width in usec. */
+void LogicScreen::drawList(TextUILcd* lcd)
+{
+    uint32_t i;
+    uint32_t next;
+    uint8_t pulse = 0;
+    uint8_t row = LIST_ROW;
+    uint32_t t;
+
+    i = acq->nextEdge(0);
+
+    while (row < LIST_ROW + LOGIC_LIST_ROWS) {
+
+        lcd->setCursor(row, 0);
+
+        next = (i < acq->getSamples()) ? acq->nextEdge(i) : acq->getSamples();
+
+        if (next < acq->getSamples()) {
+            if (pulse >= listStart) {
+                t = acq->sampleNsec(i);
+                lcd->printChar(acq->level(i) ? 'H' : 'L');
+                lcd->printFixFloat2(t / 10, 10);
+                lcd->printFixFloat2((acq->sampleNsec(next) - t) / 10, 9);
+                lcd->clearEOL();
+                row++;
+            }
+            pulse++;
+            i = next;
+        }
+        else {
+            lcd->clearEOL();
+            row++;
+        }
+    }
+}
+
+/* TextUI */
+
+const char* LogicScreen::getHeader()
+{
+    return nullptr;
+}
+
+const char* LogicScreen::getMenuName()
+{
+    return TextUI::copyToBuffer((const char*)F("Logic"));
+}
+
+uint8_t LogicScreen::getRowCount()
+{
+    return ROW_COUNT;
+}
+
+const char* LogicScreen::getRowName(uint8_t row)
+{
+    return "";
+}
+
+void LogicScreen::handleEvent(TextUI* ui, Event* e)
+{
+    if (!ui->inEditMode()) {
+
+        if (e->getType() == EVENT_TYPE_KEY) {
+
+            switch (e->getKey()) {
+
+            case KEY_RESET: // long Up
+                /* Next page of pulses, back to the first after the last */
+                listStart += LOGIC_LIST_ROWS;
+                if (edges < 2 || listStart >= edges - 1) {
+                    listStart = 0;
+                }
+                if (acq) {
+                    drawList(ui->getDisplay());
+                }
+                e->markProcessed();
+                break;
+
+            case KEY_CLEAR: // long Enter
+            case KEY_UP:
+                ui->popScreen();
+                e->markProcessed();
+                break;
+
+            case KEY_DOWN:
+                freeze = !freeze;
+                e->markProcessed();
+                break;
+            }
+        }
+        else if (e->getType() == EVENT_TYPE_TICK) {
+            update(ui);
+        }
+    }
+}
+
+uint8_t LogicScreen::getColCount(uint8_t row)
+{
+    return 5;
+}
+
+bool LogicScreen::hasChanged(uint8_t row, uint8_t col)
+{
+    return col == 4 && hasNewData;
+}
+
+void LogicScreen::endRefresh()
+{
+    hasNewData = false;
+}
+
+void LogicScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    if (col == 0) {
+        cell->setList(0, logicRates, LOGIC_RATES, rate);
+    }
+    else if (col == 1) {
+        cell->setLabel(5, F("T"), 1);
+    }
+    else if (col == 2) {
+        cell->setList(6, logicTriggerModes, TRIGGER_MODES, triggerMode);
+    }
+    else if (col == 3) {
+        cell->setLabel(8, F("E"), 1);
+    }
+    else if (col == 4) {
+        cell->setInt16(9, edges, 4, 0, 0);
+    }
+}
+
+void LogicScreen::setValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    if (col == 0) {
+        rate = cell->getList();
+    }
+    else if (col == 2) {
+        triggerMode = cell->getList();
+    }
+    listStart = 0;
+}
@@ -36,34 +36,102 @@ PPM ppm;
 /* Config */
 extern config_t settings;
 
-/* Detect PPM steps */
-#define DETECT_STEP_INIT         0
-#define DETECT_STEP_SYNCWAIT     1
-#define DETECT_STEP_CHANNELWAIT  2
-#define DETECT_STEP_VERIFY       3
-#define DETECT_STEP_SYNCED       4
-
-/* Detect PWM only */
-#define DETECT_STEP_PWM          5
-
-volatile uint8_t detectStep;
-volatile uint8_t channels;
-volatile uint8_t detectedChannels;
-volatile uint8_t pulseIdx;
-volatile uint16_t pulse_usec[PPM_MAX_PULSE];
-volatile uint16_t lastCount;
-
-#define ADC_IDLE  0
-/* ADC started from PPM scan ISR */
-#define ADC_PPM   1
-/* ADC started for Voltmeter */
-#define ADC_VM    2
-/* ADC started for Vcc (Battery) */
-#define ADC_VCC   3
-
-volatile uint8_t adcConvertType = ADC_IDLE;
-volatile uint16_t adcValue;
+/* PPM/PWM scan, scope acquisition and logic analyzer never run at the same time
+ * and share their working memory.
+ */
+struct scanmem_t {
+    /* Edge decoders. Fed with edges captured by Timer 1. Only one of them runs. */
+    union {
+        PPMDecoder decoder;
+        ServoDecoder servoDecoder;
+    };
+#ifdef ENABLE_EDGE_RING
+    EdgeRing edgeRing;
+    /* The latency scan does not stream */
+    union {
+        EdgeStreamWriter streamWriter;
+        LatencyMeter latency;
+    };
+#else
+    LatencyMeter latency;
+#endif
+
+    scanmem_t() : decoder() {}
+};
+
+/* Scope and logic analyzer. The display minimum and the display shadow
+ * of the trace only live as long as they do, see PPM::getMinArray().
+ */
+struct acqmem_t {
+    union {
+        ScopeAcq scope;
+        LogicAcq logic;
+    };
+    uint8_t minArray[SCOPE_SAMPLES];
+    uint8_t gridShadow[2 * SCOPE_SAMPLES];
+
+    acqmem_t() : scope() {}
+};
+
+union workmem_t {
+    scanmem_t scan;
+    acqmem_t acq;
+
+    workmem_t() : scan() {}
+};
+
+static workmem_t workMem;
+
+static PPMDecoder& decoder = workMem.scan.decoder;
+static ServoDecoder& servoDecoder = workMem.scan.servoDecoder;
+static LatencyMeter& latency = workMem.scan.latency;
+static ScopeAcq& scope = workMem.acq.scope;
+static LogicAcq& logic = workMem.acq.logic;
+
+/* Single conversions and the scope share the ADC, see AdcQueue.h */
+static AdcQueue adcQueue;
+
+/* Start a single conversion of convertType. Interrupts must be disabled. */
+static void convertADC(uint8_t convertType) {
+
+    if (convertType == ADC_IDLE) {
+        return;
+    }
+
+    /* Disable power reduction for ADC */
+    PRR &= ~bit(PRADC);
 
+    /* REFS1 = 0, REFS0 = 1   ==>   VCC with ext. cap. on AREF */
+    ADMUX = bit(REFS0) | (((convertType == ADC_VCC) ? PORT_VCC : PORT_ANALOG_IN) - A0);
+    ADCSRB = 0;
+
+    /* Prescaler /128   ==>   16MHz / 128 = 125KHz. Start conversion. */
+    ADCSRA = bit(ADEN) | bit(ADSC) | bit(ADIE) | bit(ADPS2) | bit(ADPS1) | bit(ADPS0);
+}
+
+/* PPM signal levels are sampled PPM_LEVEL_DELAY_USEC after an edge,
+ * on the plateau of the pulse or gap. See TIMER1_COMPA_vect.
+ */
+typedef struct levelacc_t {
+    uint16_t min;
+    uint16_t max;
+    uint16_t sum;
+    uint8_t count;
+} levelacc_t;
+
+/* Samples per level and frame. Keeps the sum of raw values within 16 bit. */
+#define LEVEL_MAX_SAMPLES   63
+
+/* Raw samples of the current frame, index is the input level.
+ * Written by the ADC ISR, taken with interrupts disabled.
+ */
+static levelacc_t levelAcc[2];
+static volatile bool levelSampling = false;
+/* Counts edges. A sample is valid if no edge came after its compare match. */
+static volatile uint8_t levelEdges;
+static volatile uint8_t levelTag;
+/* Input level after the last edge */
+static volatile uint8_t levelNow;
 
 /*
  * ADC conversion complete interrupt.
@@ -71,390 +139,572 @@ volatile uint16_t adcValue;
 ISR(ADC_vect) {
 
     uint16_t v;
+    uint8_t convertType = adcQueue.owner();
+
+    if (convertType == ADC_SCOPE) {
+
+        /* Compare match B starts the next conversion. Its flag is not
+         * cleared by an ISR, so clear it here.
+         */
+        TIFR1 = bit(OCF1B);
+
+        /* Result is left adjusted and we want the highest 8 bits only */
+        switch (scope.sample(ADCH)) {
+
+        case ACQ_EV_TRIGGER:
+            /* Continue with the sample period one period after the trigger */
+            TCNT1 = 0;
+            OCR1A = scope.sampleTicks - 1;
+            OCR1B = scope.sampleTicks - 1;
+            break;
+
+        case ACQ_EV_NEXT:
+            /* Equivalent time sampling. Timer 1 is free running. */
+            OCR1B += scope.sampleTicks;
+            break;
+
+        case ACQ_EV_PASS:
+            /* No conversions until the next edge */
+            ADCSRA &= ~bit(ADATE);
+            break;
+
+        case ACQ_EV_DONE:
+            TIMSK1 &= ~bit(ICIE1);
+            TCCR1B = 0;
+            ADCSRA = 0;
+            /* Conversions requested during the acquisition */
+            convertADC(adcQueue.release());
+            break;
+        }
+
+        return;
+    }
 
     /* MUST read ADCL first */
     v = ADCL;
     v |= (ADCH << 8);
 
-    if (adcConvertType == ADC_PPM) {
+    /* Chain the next queued conversion */
+    convertADC(adcQueue.done(v));
 
-        ppm_t* wSet = ppm.getPPMWriteSet();
-        fixfloat1_t newVcc = ppm.analogConvert(ADC_PPM, v);
+    /* No edge since the compare match, so the sample is from the plateau */
+    if (convertType == ADC_PPM && levelSampling && levelTag == levelEdges) {
 
-        if (newVcc < 20) {
-            wSet->vLevel_low = newVcc;
-        }
-        else {
-            wSet->vLevel_high = newVcc;
-        }
+        levelacc_t* acc = &levelAcc[levelNow];
 
+        if (acc->count < LEVEL_MAX_SAMPLES) {
+            if (acc->count == 0 || v < acc->min) {
+                acc->min = v;
+            }
+            if (acc->count == 0 || v > acc->max) {
+                acc->max = v;
+            }
+            acc->sum += v;
+            acc->count++;
+        }
     }
-    else {
+}
 
-        adcValue = v;
-    }
+/* Stop Timer 1 and the ADC. Only call while the scope owns the ADC. */
+static void haltScope() {
+
+    TIMSK1 &= ~bit(ICIE1);
+    TCCR1B = 0;
+    ADCSRA = 0;
+    scope.stop();
+    convertADC(adcQueue.release());
 }
 
-ISR(TIMER1_OVF_vect) {
+/*
+ * Pass one captured edge (or timeout) to the decoder
+ * and publish the write set if it is complete.
+ */
+static void dispatchEdge(uint32_t ticks, uint8_t flags) {
 
-    if (detectStep == DETECT_STEP_PWM) {
-        pwm_t* pwmWSet = ppm.getPWMWriteSet();
+    bool level = flags & EDGE_LEVEL;
 
-        pwmWSet->sync = false;
-        pwmWSet->miss++;
+    if (decoder.getDetectStep() == DETECT_STEP_PWM) {
 
-        pwmWSet->lastUsed = (pwmWSet->lastUsed + 1) % PWM_HISTORY;
-        bool level = digitalRead(PORT_PPM_IN);
+        pwm_t* pwmWSet = ppm.getPWMWriteSet();
 
-        if( level) {
-            pwmWSet->pulseL_usec[pwmWSet->lastUsed] = 0;
-            pwmWSet->pulseH_usec[pwmWSet->lastUsed] = 1;
+        if (flags & (EDGE_TIMEOUT | EDGE_LOST)) {
+            /* Level during the gap is the level before the edge */
+            if (decoder.pwmTimeout(pwmWSet, (flags & EDGE_NONE) ? level : !level)) {
+                ppm.switchPWMWriteSet();
+                pwmWSet = ppm.getPWMWriteSet();
+            }
         }
-        else {
-            pwmWSet->pulseL_usec[pwmWSet->lastUsed] = 1;
-            pwmWSet->pulseH_usec[pwmWSet->lastUsed] = 0;
+        if (!(flags & EDGE_NONE) && decoder.pwmEdge(pwmWSet, ticks, level)) {
+            ppm.switchPWMWriteSet();
         }
 
-        ppm.switchPWMWriteSet();
     }
     else {
-        ppm_t* ppmWSet = ppm.getPPMWriteSet();
 
-        ppmWSet->channels = 0;
-        ppmWSet->sync = false;
+        ppm_t* ppmWSet = ppm.getPPMWriteSet();
 
-        if (detectStep != DETECT_STEP_INIT) {
-            detectStep = DETECT_STEP_INIT;
-            ppmWSet->badFrames++;
+        if (flags & (EDGE_TIMEOUT | EDGE_LOST)) {
+            /* Restart detection */
+            if (decoder.ppmTimeout(ppmWSet)) {
+                decoder.setCarrySet(ppm.switchPPMWriteSet());
+                ppmWSet = ppm.getPPMWriteSet();
+            }
         }
+        if (!(flags & EDGE_NONE) && decoder.ppmEdge(ppmWSet, ticks, level)) {
+            decoder.setCarrySet(ppm.switchPPMWriteSet());
+        }
+    }
+}
+
+/* Software extension of Timer 1. Upper 16 bit of the 32 bit timestamp. */
+static volatile uint16_t timerOverflows;
+/* Overflows since the last edge */
+static volatile uint8_t idleOverflows;
+/* PPM_TIMEOUT_OVERFLOWS or PWM_TIMEOUT_OVERFLOWS, scaled to the timer clock */
+static uint8_t timeoutOverflows;
+/* Capture resolution of the running scan, DECODER_SHIFT_* */
+static uint8_t tickShift = DECODER_SHIFT_500NS;
+/* PPM_LEVEL_DELAY_USEC in ticks */
+static uint16_t levelDelayTicks;
+
+/*
+ * Timer 1 clock for the capture resolution in settings.captureRes.
+ * With prescaler /1 the timer overflows every 4.096 msec instead of
+ * 32.768 msec, the timeouts count 8 times as many overflows.
+ */
+static uint8_t startCapture(uint8_t timeout) {
+
+    tickShift = (settings.captureRes == CAPTURE_RES_62NS) ? DECODER_SHIFT_62NS : DECODER_SHIFT_500NS;
+    timeoutOverflows = timeout << (tickShift - DECODER_SHIFT_500NS);
+    levelDelayTicks = PPM_LEVEL_DELAY_USEC << tickShift;
+
+    return (tickShift == DECODER_SHIFT_62NS) ? bit(CS10) : bit(CS11);
+}
+
+#ifdef ENABLE_EDGE_RING
+
+static EdgeRing& edgeRing = workMem.scan.edgeRing;
+static EdgeStreamWriter& streamWriter = workMem.scan.streamWriter;
+static bool streaming = false;
+static volatile uint16_t droppedEdges;
+static volatile bool edgeLost;
+/* The ring is only valid while a scan runs, scope and logic analyzer reuse the memory */
+static bool scanning = false;
+/* Servo scan. Ring entries hold the pin levels of Port B instead of EDGE_* flags. */
+static bool servoScan = false;
+/* Latency scan. PPM scan plus EDGE_AUX entries of the PWM input. */
+static bool latencyScan = false;
+
+/* Consumer side of the overflow count. Upper 8 bit. */
+static uint8_t ovfHigh;
+static uint8_t lastOvf;
+
+/* Queue edge for PPM::processEdges(). Called from ISR only. */
+static void queueEdge(uint16_t ticks, uint16_t ovf, uint8_t flags) {
+
+    if (edgeLost) {
+        flags |= servoScan ? SERVO_LOST : EDGE_LOST;
+    }
 
-        ppm.switchPPMWriteSet();
+    if (edgeRing.push(ticks, (uint8_t)ovf, flags)) {
+        edgeLost = false;
+    }
+    else {
+        droppedEdges++;
+        edgeLost = true;
     }
 }
 
-ISR(TIMER1_CAPT_vect) {
+/*
+ * Rebuild the 32 bit timestamp from the 8 bit overflow count in the ring.
+ * Queued entries are at most timeoutOverflows apart, so the 8 bit count
+ * wraps at most once between two entries.
+ */
+static uint32_t extendTicks(const edge_t* e) {
 
-    ppm_t* ppmWSet;
-    pwm_t* pwmWSet;
+    if (e->ovf < lastOvf) {
+        ovfHigh++;
+    }
+    lastOvf = e->ovf;
 
-    uint8_t h, l;
-    uint16_t time_usec;
-    uint16_t diff;
-    bool level;
+    return ((uint32_t)(((uint16_t)ovfHigh << 8) | e->ovf) << 16) | e->ticks;
+}
 
-    l = ICR1L;
-    h = ICR1H;
+/* Send the current stream packet. Never blocks, the packet is dropped
+ * if the Serial transmit buffer has no room.
+ */
+static void sendStream() {
 
-    /* Flip detection edge */
-    TCCR1B ^= bit(ICES1);
-    TIFR1 |= bit(ICF1);
+    uint8_t sz = streamWriter.finish();
 
-    diff = (((uint16_t)h << 8) | l);
-    time_usec = diff - lastCount;
-    lastCount = diff;
-    time_usec >>= 1;  /* Divide by 2 because of 0.5 usec timer resolution */
+    if (Serial.availableForWrite() >= sz) {
+        Serial.write(streamWriter.getPacket(), sz);
+        streamWriter.next(true);
+    }
+    else {
+        streamWriter.next(false);
+    }
+}
 
-    level = digitalRead(PORT_PPM_IN);
+/* Stream timestamps stay in 0.5 usec ticks. At 62.5 nsec deltas are scaled,
+ * so that the stream keeps wrapping at 32 bit.
+ */
+static uint32_t streamTicks;
+static uint32_t streamLast;
 
-    if( detectStep == DETECT_STEP_PWM) {
+static uint32_t streamTime(uint32_t ticks) {
 
-        /* Get current timer and compute difference to ICR 
-         * as compensation for next interrupt. (lastCount)
-         */
-        l = TCNT1L;
-        h = TCNT1H;
-        TCNT1 = 0;
-        
-        diff = (((uint16_t)h << 8) | l);
-        
-        if( diff > lastCount) {
-            diff -= lastCount;
-            lastCount = -diff;
-        } else { // overrun => sync = false
-            lastCount = 0;
-        }
+    uint8_t shift = tickShift - DECODER_SHIFT_500NS;
+    uint32_t d = (ticks - streamLast) >> shift;
 
-        pwmWSet = ppm.getPWMWriteSet();
+    streamTicks += d;
+    streamLast += d << shift;
 
-        if( level) {
-            uint16_t H = pwmWSet->pulseH_usec[pwmWSet->lastUsed];
+    return streamTicks;
+}
 
-            pwmWSet->pulseL_usec[pwmWSet->lastUsed] = time_usec;
-                
-            if( H > 0) {
-                uint32_t fTime = (uint32_t)time_usec + H;
+#endif
 
-                if( pwmWSet->frameMax_usec == 0L) {
-                    pwmWSet->frameMax_usec = 1L; // skip first
-                    return;
+ISR(TIMER1_OVF_vect) {
 
-                } else if( fTime > pwmWSet->frameMax_usec || !pwmWSet->sync) {
-                    pwmWSet->frameMax_usec = fTime;
-                }
+    uint16_t ovf = ++timerOverflows;
 
-                if( pwmWSet->frameMin_usec == 0L) {
-                    pwmWSet->frameMin_usec = UINT32_MAX; // skip first
-                    return;
+    if (++idleOverflows >= timeoutOverflows) {
 
-                } else if ( fTime < pwmWSet->frameMin_usec || !pwmWSet->sync) {
-                    pwmWSet->frameMin_usec = fTime;
-                }
+        /* Waiting for a rising edge means the input is low */
+        uint8_t flags = EDGE_TIMEOUT | EDGE_NONE | ((TCCR1B & bit(ICES1)) ? 0 : EDGE_LEVEL);
+        idleOverflows = 0;
 
-                pwmWSet->frames++;
-                pwmWSet->sync = true;
-                ppm.switchPWMWriteSet();
-            }
-        } else {
-            pwmWSet->lastUsed = (pwmWSet->lastUsed + 1) % PWM_HISTORY;
-            pwmWSet->pulseH_usec[pwmWSet->lastUsed] = time_usec;
-        }
-
-    } else {
-
-        ppmWSet = ppm.getPPMWriteSet();
-        ppm.startADC(ADC_PPM);
-    
-        if (TIFR1 & bit(TOV1)) // timer overflow
-        {
-            /* This should actually never happen as we have overflow interrupt enabled */
-            TIFR1 |= bit(TOV1); /* clear overflow bit */
-            if( detectStep != DETECT_STEP_PWM) {
-                detectStep = DETECT_STEP_INIT;
-            }
+#ifdef ENABLE_EDGE_RING
+        if (servoScan) {
+            flags = SERVO_IDLE;
         }
-        else {
+        queueEdge(0, ovf, flags);
+#else
+        dispatchEdge((uint32_t)ovf << 16, flags);
+#endif
+    }
+}
 
-            switch (detectStep) {
-            case DETECT_STEP_INIT:
-                TCNT1 = 0;
-                lastCount = 0;
+ISR(TIMER1_CAPT_vect) {
 
-                pulseIdx = 0;
-                ppmWSet->channels = 0;
-                ppmWSet->sync = false;
-                ppm.switchPPMWriteSet();
-                detectStep = DETECT_STEP_SYNCWAIT;
-                break;
+    uint8_t h, l;
+    uint16_t ticks;
+    uint16_t ovf;
+    uint8_t flags;
 
-            case DETECT_STEP_SYNCWAIT:
-                if (time_usec > settings.syncValidMin_usec) {
-                    TCNT1 = 0;
-                    lastCount = 0;
+    l = ICR1L;
+    h = ICR1H;
+    ticks = (((uint16_t)h << 8) | l);
 
-                    ppmWSet->pulseLevel = level;
-                    channels = 0;
-                    detectedChannels = 0;
-                    detectStep = DETECT_STEP_CHANNELWAIT;
-                }
-                break;
+    if (adcQueue.owner() == ADC_SCOPE) {
+        /* Equivalent time sampling. The edge starts the next pass. */
+        uint16_t offset = scope.etsTrigger(TCNT1 - ticks);
 
-            case DETECT_STEP_CHANNELWAIT:
-                ppm.countChannels(ppmWSet, time_usec, level);
-                break;
+        if (offset) {
+            OCR1B = ticks + offset;
+            TIFR1 = bit(OCF1B);
+            ADCSRA |= bit(ADATE);
+        }
+        return;
+    }
 
-            case DETECT_STEP_VERIFY:
-            case DETECT_STEP_SYNCED:
-                if (ppm.storeFrame(ppmWSet, time_usec, level)) {
+    /* Captured on rising edge means the input is high now */
+    flags = (TCCR1B & bit(ICES1)) ? EDGE_LEVEL : 0;
 
-                    /* We don't set the timer back to 0.
-                     * Instead we get the current timer and compute the offset time
-                     * used by the ISR by subtracting the counter stored in lastCount.
-                     * This is the corrected new timer base.
-                     */
-                    l = TCNT1L;
-                    h = TCNT1H;
-                    time_usec = (((uint16_t)h << 8) | l) - lastCount + 2;
+    /* Flip detection edge */
+    TCCR1B ^= bit(ICES1);
+    TIFR1 |= bit(ICF1);
 
-                    TCNT1 = time_usec;
+    if (levelSampling) {
+        /* Sample the level once it has settled */
+        levelEdges++;
+        levelNow = flags & EDGE_LEVEL;
+        OCR1A = ticks + levelDelayTicks;
+        TIFR1 = bit(OCF1A);
+        TIMSK1 |= bit(OCIE1A);
+    }
 
-                    lastCount = 0;
-                }
-                break;
-            }
+    ovf = timerOverflows;
+
+    /* Capture and overflow pending together.
+     * The overflow ISR has lower priority and did not run yet.
+     * A small ICR1 value means the capture happened after the overflow,
+     * so the overflow is counted here. A large value means the capture
+     * happened just before the overflow, which is left to the overflow ISR.
+     */
+    if ((TIFR1 & bit(TOV1)) && !(h & 0x80)) {
+        TIFR1 |= bit(TOV1); /* clear overflow bit */
+        timerOverflows = ++ovf;
+
+        if (++idleOverflows >= timeoutOverflows) {
+            flags |= EDGE_TIMEOUT;
         }
     }
-}
 
-void PPM::countChannels(ppm_t* wSet, uint16_t time_usec, bool level) {
+    idleOverflows = 0;
 
-    uint16_t servo_usec;
+#ifdef ENABLE_EDGE_RING
+    queueEdge(ticks, ovf, flags);
+#else
+    dispatchEdge(((uint32_t)ovf << 16) | ticks, flags);
+#endif
+}
 
-    if (level == wSet->pulseLevel) { // previous was not a pulse
+/*
+ * Timer 1 compare match A, PPM_LEVEL_DELAY_USEC after the last edge.
+ * The signal has settled, sample its level.
+ */
+ISR(TIMER1_COMPA_vect) {
 
-        if (time_usec > settings.syncValidMin_usec) { // Sync detected
+    TIMSK1 &= ~bit(OCIE1A);
+    levelTag = levelEdges;
+    convertADC(adcQueue.request(ADC_PPM));
+}
 
-            if (channels >= PPM_MIN_CHANNELS) {
-                TCNT1 = 0;
-                lastCount = 0;
-                detectedChannels = channels;
-                channels = 0;
-                pulseIdx = 0;
-                detectStep = DETECT_STEP_VERIFY;
-            }
-            else {
-                detectStep = DETECT_STEP_INIT;
-            }
+#ifdef ENABLE_EDGE_RING
 
-        }
-        else {
-            if (pulseIdx > 0) {
-                servo_usec = time_usec + pulse_usec[pulseIdx - 1];
-                /* Check valid servo timing */
-                if (servo_usec >= settings.servoValidMin_usec && servo_usec <= settings.servoValidMax_usec) {
-                    channels++;
-                }
-                else {
-                    detectStep = DETECT_STEP_INIT;
-                }
-            }
-            else {
-                detectStep = DETECT_STEP_INIT;
-            }
-        }
+/*
+ * Pin change on a servo input or the PWM input of the latency scan.
+ * Timer 1 is read first, it is closest to the edge.
+ * Timestamps are late by the interrupt latency, which is the same for every
+ * edge unless another interrupt is running. Pins changing before PINB is read
+ * share the timestamp, ServoDecoder sorts them out.
+ */
+ISR(PCINT0_vect) {
+
+    uint16_t ticks = TCNT1;
+    uint8_t pins = PINB;
+    uint16_t ovf = timerOverflows;
 
+    /* Overflow pending, see TIMER1_CAPT_vect */
+    if ((TIFR1 & bit(TOV1)) && !(ticks & 0x8000)) {
+        TIFR1 |= bit(TOV1); /* clear overflow bit */
+        timerOverflows = ++ovf;
+        /* The overflow ISR checks the timeout */
+        idleOverflows++;
     }
-    else { // was a pulse
-        if (time_usec < settings.pulseValidMin_usec || time_usec > settings.pulseValidMax_usec) {
-            detectStep = DETECT_STEP_INIT;
-        }
+
+    if (latencyScan) {
+        /* PPM timeouts only count PPM edges */
+        queueEdge(ticks, ovf, EDGE_AUX | ((pins & LATENCY_PIN_MASK) ? EDGE_LEVEL : 0));
+        return;
     }
 
-    storePulse(wSet, time_usec);
+    idleOverflows = 0;
+
+    queueEdge(ticks, ovf, pins & SERVO_PIN_MASK);
 }
 
-boolean PPM::storeFrame(ppm_t* wSet, uint16_t time_usec, bool level) {
+#endif
 
-    uint16_t servo_usec;
+/* Level statistics of the frame just published.
+ * A level without samples keeps the values of the last frame.
+ */
+static void publishLevels(ppm_t* pSet) {
 
-    if (level == wSet->pulseLevel) { // previous was not a pulse
+    levelacc_t acc[2];
 
-        if (time_usec > settings.syncValidMin_usec) { // Sync detected
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        acc[0] = levelAcc[0];
+        acc[1] = levelAcc[1];
+        levelAcc[0].count = 0;
+        levelAcc[1].count = 0;
+    }
 
-            if (channels == detectedChannels) { // All channels scanned
+    if (acc[0].count) {
+        pSet->vLevelMin_low = ppm.analogConvert(ADC_PPM, acc[0].min);
+        pSet->vLevel_low = ppm.analogConvert(ADC_PPM, (acc[0].sum + acc[0].count / 2) / acc[0].count);
+        pSet->vLevelMax_low = ppm.analogConvert(ADC_PPM, acc[0].max);
+    }
+    if (acc[1].count) {
+        pSet->vLevelMin_high = ppm.analogConvert(ADC_PPM, acc[1].min);
+        pSet->vLevel_high = ppm.analogConvert(ADC_PPM, (acc[1].sum + acc[1].count / 2) / acc[1].count);
+        pSet->vLevelMax_high = ppm.analogConvert(ADC_PPM, acc[1].max);
+    }
+}
 
-                if (detectStep == DETECT_STEP_SYNCED) {
-                    storeFrameTime(wSet, lastCount >> 1);
+/*
+ * Decode queued edges.
+ * Must be called frequently from loop() while a scan is running.
+ */
+void PPM::processEdges() {
 
-                    wSet->channels = detectedChannels;
-                    wSet->frames++;
-                    wSet->sync = true;
-                    switchPPMWriteSet();
+#ifdef ENABLE_EDGE_RING
+    edge_t e;
+    uint32_t ticks;
+    uint16_t dropped;
+    bool any = false;
 
-                }
-                else { // DETECT_STEP_VERIFY => DETECT_STEP_SYNCED
-                    initTimings(wSet);
-                    detectStep = DETECT_STEP_SYNCED;
-                }
+    if (!scanning) {
+        return;
+    }
 
-                channels = 0;
-                pulseIdx = 0;
-                return true;
+    while (edgeRing.pop(&e)) {
+        ticks = extendTicks(&e);
 
+        if (servoScan) {
+            if (servoDecoder.portEdge(getServoWriteSet(), ticks, e.flags)) {
+                switchServoWriteSet();
             }
-            else { // servo channels missing
-                if (detectStep == DETECT_STEP_SYNCED) {
-                    wSet->badCount++;
-                }
-                detectStep = DETECT_STEP_INIT;
-            }
-
+            any = true;
+            continue;
         }
-        else { // No sync
 
-            if (pulseIdx > 0) {
-                servo_usec = time_usec + pulse_usec[pulseIdx - 1];
-                /* Check valid servo timing */
-                if (servo_usec >= settings.servoValidMin_usec && servo_usec <= settings.servoValidMax_usec) {
-                    if (detectStep == DETECT_STEP_SYNCED) {
-                        storeServoTime(wSet, servo_usec);
-                    }
-                    channels++;
-                }
-                else {
-                    detectStep = DETECT_STEP_INIT;
+        if (latencyScan) {
+            if (e.flags & EDGE_LOST) {
+                latency.pwmLost();
+            }
+            if (e.flags & EDGE_AUX) {
+                /* PPM edges may be lost too, restart detection */
+                if (e.flags & EDGE_LOST) {
+                    dispatchEdge(ticks, EDGE_LOST | EDGE_NONE);
                 }
-
+                latency.pwmEdge(ticks, e.flags & EDGE_LEVEL);
             }
             else {
-                detectStep = DETECT_STEP_INIT;
+                dispatchEdge(ticks, e.flags);
+                latency.ppmEdge(ticks, decoder.getStoredChannels(), getPPMWriteSet());
             }
+            any = true;
+            continue;
         }
 
-    }
-    else { // was a pulse
-        if (detectStep == DETECT_STEP_SYNCED) {
-            if (time_usec < wSet->pulseMin_usec) {
-                wSet->pulseMin_usec = time_usec;
-            }
-            if (time_usec > wSet->pulseMax_usec) {
-                wSet->pulseMax_usec = time_usec;
+        if (streaming) {
+            streamWriter.addEdge(streamTime(ticks), e.flags);
+            /* Flush on signal loss so that the host sees it immediately */
+            if (streamWriter.isFull() || (e.flags & EDGE_NONE)) {
+                sendStream();
             }
+        }
 
-            if (time_usec < settings.pulseValidMin_usec || time_usec > settings.pulseValidMax_usec) {
-                wSet->badPulse++;
-            }
+        dispatchEdge(ticks, e.flags);
+        any = true;
+    }
+
+    if (any && (servoScan || decoder.getDetectStep() != DETECT_STEP_PWM)) {
+
+        ATOMIC_BLOCK(ATOMIC_FORCEON) {
+            dropped = droppedEdges;
+        }
+        if (servoScan) {
+            getServoWriteSet()->droppedEdges = dropped;
+        }
+        else {
+            getPPMWriteSet()->droppedEdges = dropped;
         }
     }
+#endif
+}
 
-    storePulse(wSet, time_usec);
+bool PPM::edgesPending() {
 
+#ifdef ENABLE_EDGE_RING
+    return scanning && !edgeRing.empty();
+#else
     return false;
+#endif
 }
 
-void PPM::initTimings(ppm_t* wSet) {
+/*
+ * Send a scope capture as EdgeStream scope packet.
+ * Blocks until the Serial transmit buffer took all bytes.
+ */
+void PPM::sendArray(const uint8_t dataArray[], const adcblock_t* blk) {
+
+    static uint16_t capture = 0;
+    uint8_t hdr[EDGESTREAM_HEADER];
+    uint32_t msec = millis();
+    uint8_t crc = 0;
+    uint8_t i;
+
+    hdr[0] = EDGESTREAM_SYNC1;
+    hdr[1] = EDGESTREAM_SYNC2_ADC;
+    hdr[2] = (uint8_t)capture;
+    hdr[3] = (uint8_t)(capture >> 8);
+    hdr[4] = (uint8_t)msec;
+    hdr[5] = (uint8_t)(msec >> 8);
+    hdr[6] = (uint8_t)(msec >> 16);
+    hdr[7] = (uint8_t)(msec >> 24);
+    hdr[8] = sizeof(adcblock_t) + blk->count;
+
+    for (i = 2; i < EDGESTREAM_HEADER; i++) {
+        crc = edgeStreamCRC(crc, hdr[i]);
+    }
+    for (i = 0; i < sizeof(adcblock_t); i++) {
+        crc = edgeStreamCRC(crc, ((const uint8_t*)blk)[i]);
+    }
+    for (i = 0; i < blk->count; i++) {
+        crc = edgeStreamCRC(crc, dataArray[i]);
+    }
 
-    wSet->frameMin_usec = wSet->pulseMin_usec = UINT16_MAX;
-    wSet->frameMax_usec = wSet->pulseMax_usec = 0;
+    Serial.write(hdr, EDGESTREAM_HEADER);
+    Serial.write((const uint8_t*)blk, sizeof(adcblock_t));
+    Serial.write(dataArray, blk->count);
+    Serial.write(crc);
 
-    for (uint8_t ch = 0; ch < detectedChannels; ch++) {
-        wSet->channel_usec[ch] = 0;
-        wSet->channelMin_usec[ch] = UINT16_MAX;
-        wSet->channelMax_usec[ch] = 0;
-    }
+    capture++;
 }
 
-void PPM::storePulse(ppm_t* wSet, uint16_t time_usec) {
+void PPM::startStream() {
 
-    if (pulseIdx < PPM_MAX_PULSE) {
-        pulse_usec[pulseIdx] = time_usec;
-        pulseIdx++;
-    }
-    else {
-        detectStep = DETECT_STEP_INIT;
-    }
+#ifdef ENABLE_EDGE_RING
+    /* Timestamps start at 0 with the scan */
+    streamWriter.reset(0);
+    streamTicks = streamLast = 0;
+    streaming = true;
+#endif
 }
 
-void PPM::storeFrameTime(ppm_t* wSet, uint16_t frame_usec) {
+void PPM::stopStream() {
 
-    if (frame_usec < wSet->frameMin_usec) {
-        wSet->frameMin_usec = frame_usec;
-    }
-    if (frame_usec > wSet->frameMax_usec) {
-        wSet->frameMax_usec = frame_usec;
+#ifdef ENABLE_EDGE_RING
+    if (streaming && !streamWriter.isEmpty()) {
+        sendStream();
     }
+    streaming = false;
+#endif
 }
 
-void PPM::storeServoTime(ppm_t* wSet, uint16_t servo_usec) {
+const EdgeStreamWriter* PPM::getStream() {
 
-    wSet->channel_usec[channels] = servo_usec;
-    if (servo_usec < wSet->channelMin_usec[channels]) {
-        wSet->channelMin_usec[channels] = servo_usec;
-    }
-    if (servo_usec > wSet->channelMax_usec[channels]) {
-        wSet->channelMax_usec[channels] = servo_usec;
-    }
+#ifdef ENABLE_EDGE_RING
+    return streaming ? &streamWriter : nullptr;
+#else
+    return nullptr;
+#endif
 }
 
 void PPM::startPPMScan() {
 
+    uint8_t clock;
+
+    stopScope();
+
     ATOMIC_BLOCK(ATOMIC_FORCEON) {
 
-        pulseIdx = 0;
         writeSet = 0;
         stableSet = 1;
         exportSet = 2;
+        newSet = false;
         memset(&ppm[0], 0, PPM_SETS * sizeof(ppm_t));
-        detectStep = DETECT_STEP_INIT;
+        clock = startCapture(PPM_TIMEOUT_OVERFLOWS);
+        decoder.reset(DETECT_STEP_INIT, 0, tickShift);
+        timerOverflows = 0;
+        idleOverflows = 0;
+        levelAcc[0].count = 0;
+        levelAcc[1].count = 0;
+        levelSampling = true;
+#ifdef ENABLE_EDGE_RING
+        edgeRing.clear();
+        scanning = true;
+        servoScan = false;
+        latencyScan = false;
+        droppedEdges = 0;
+        edgeLost = false;
+        ovfHigh = 0;
+        lastOvf = 0;
+#endif
 
         pinMode(PORT_PPM_IN, INPUT);
         /* disable pull-up */
@@ -467,17 +717,19 @@ void PPM::startPPMScan() {
         TCCR1A = (byte)0;
 
         /* Enable Input Capture Noice Canceler
-         * Prescaler /8 = 2Mhz = 0.5 usec
+         * Prescaler /8 = 2Mhz = 0.5 usec or /1 = 16MHz = 62.5 nsec
          */
-        TCCR1B = bit(ICNC1) | bit(CS11);
+        TCCR1B = bit(ICNC1) | clock;
 
+        /* Timer is free running. Edges are timestamped with ICR1
+         * extended by the overflow count.
+         */
         TCNT1 = 0;
-        lastCount = 0;
 
         /* Enable timer overflow interrupt
          * Enable input capture interrupt
          */
-        TIFR1 |= bit(TOV1); /* clear overflow bit */
+        TIFR1 |= bit(ICF1) | bit(TOV1); /* clear pending flags */
         TIMSK1 |= bit(ICIE1) | bit(TOIE1);
     }
 }
@@ -485,7 +737,16 @@ void PPM::startPPMScan() {
 void PPM::stopScan() {
 
     ATOMIC_BLOCK(ATOMIC_FORCEON) {
-        TIMSK1 &= ~(bit(ICIE1) | bit(TOIE1));
+        TIMSK1 &= ~(bit(ICIE1) | bit(TOIE1) | bit(OCIE1A));
+        levelSampling = false;
+#ifdef ENABLE_EDGE_RING
+        scanning = false;
+        servoScan = false;
+        latencyScan = false;
+        /* Servo and latency scan inputs */
+        PCICR &= ~bit(PCIE0);
+        PCMSK0 = 0;
+#endif
     }
 }
 
@@ -494,19 +755,31 @@ ppm_t* PPM::getPPM() {
     uint8_t tmp;
 
     ATOMIC_BLOCK(ATOMIC_FORCEON) {
-        if( PWM_SETS == 3) {
+        if (newSet) {
             tmp = exportSet;
             exportSet = stableSet;
             stableSet = tmp;
-        } else {
-            memcpy(&(ppm[stableSet]), &(ppm[writeSet]), sizeof(ppm_t));
+            newSet = false;
         }
     }
 
-    if( PWM_SETS == 3) {
-        return &(ppm[exportSet]);
-    } else {
-        return &(ppm[stableSet]);
+    return &(ppm[exportSet]);
+}
+
+const ppmstats_t* PPM::getPPMStats() {
+
+    return decoder.getStats();
+}
+
+const forensic_t* PPM::getForensic() {
+
+    return decoder.getForensic();
+}
+
+void PPM::rearmForensic() {
+
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
+        decoder.rearmForensic();
     }
 }
 
@@ -515,25 +788,76 @@ ppm_t* PPM::getPPMWriteSet() {
     return &(ppm[writeSet]);
 }
 
-void PPM::switchPPMWriteSet() {
+const ppm_t* PPM::switchPPMWriteSet() {
 
-    if( PPM_SETS == 3) {
-        memcpy(&(ppm[stableSet]), &(ppm[writeSet]), sizeof(ppm_t));
-    }
+    uint8_t tmp;
+    ppm_t* wSet;
+    const ppm_t* pSet;
+
+    tmp = stableSet;
+    stableSet = writeSet;
+    writeSet = tmp;
+    newSet = true;
+
+    /* Carry running values forward into the new write set.
+     * Channel min/max are carried by the decoder when the next frame is stored.
+     */
+    wSet = &(ppm[writeSet]);
+    pSet = &(ppm[stableSet]);
+
+    publishLevels(&(ppm[stableSet]));
+
+    wSet->frameMin_usec = pSet->frameMin_usec;
+    wSet->frameMax_usec = pSet->frameMax_usec;
+    wSet->pulseMin_us10 = pSet->pulseMin_us10;
+    wSet->pulseMax_us10 = pSet->pulseMax_us10;
+    wSet->vLevel_low = pSet->vLevel_low;
+    wSet->vLevel_high = pSet->vLevel_high;
+    wSet->vLevelMin_low = pSet->vLevelMin_low;
+    wSet->vLevelMax_low = pSet->vLevelMax_low;
+    wSet->vLevelMin_high = pSet->vLevelMin_high;
+    wSet->vLevelMax_high = pSet->vLevelMax_high;
+    wSet->pulseLevel = pSet->pulseLevel;
+    wSet->frames = pSet->frames;
+    wSet->badFrames = pSet->badFrames;
+    wSet->badCount = pSet->badCount;
+    wSet->badPulse = pSet->badPulse;
+    wSet->droppedEdges = pSet->droppedEdges;
+
+    return pSet;
 }
 
 /********* PWM Scan **********/
 
 void PPM::startPWMScan() {
 
+    uint8_t clock;
+
+    stopScope();
+
     ATOMIC_BLOCK(ATOMIC_FORCEON) {
 
-        pulseIdx = 0;
         writeSet = 0;
         stableSet = 1;
         exportSet = 2;
+        newSet = false;
         memset(&pwm[0], 0, PWM_SETS * sizeof(pwm_t));
-        detectStep = DETECT_STEP_PWM;
+        clock = startCapture(PWM_TIMEOUT_OVERFLOWS);
+        decoder.reset(DETECT_STEP_PWM, 0, tickShift);
+        timerOverflows = 0;
+        idleOverflows = 0;
+        levelSampling = false;
+        TIMSK1 &= ~bit(OCIE1A);
+#ifdef ENABLE_EDGE_RING
+        edgeRing.clear();
+        scanning = true;
+        servoScan = false;
+        latencyScan = false;
+        droppedEdges = 0;
+        edgeLost = false;
+        ovfHigh = 0;
+        lastOvf = 0;
+#endif
 
         pinMode(PORT_PPM_IN, INPUT);
         /* disable pull-up */
@@ -546,17 +870,19 @@ void PPM::startPWMScan() {
         TCCR1A = (byte)0;
 
         /* Enable Input Capture Noice Canceler
-         * Prescaler /8 = 2Mhz = 0.5 usec
+         * Prescaler /8 = 2Mhz = 0.5 usec or /1 = 16MHz = 62.5 nsec
          */
-        TCCR1B = bit(ICNC1) | bit(CS11);
+        TCCR1B = bit(ICNC1) | clock;
 
+        /* Timer is free running. Edges are timestamped with ICR1
+         * extended by the overflow count.
+         */
         TCNT1 = 0;
-        lastCount = 0;
 
         /* Enable timer overflow interrupt
          * Enable input capture interrupt
          */
-        TIFR1 |= bit(TOV1); /* clear overflow bit */
+        TIFR1 |= bit(ICF1) | bit(TOV1); /* clear pending flags */
         TIMSK1 |= bit(ICIE1) | bit(TOIE1);
     }
 }
@@ -566,20 +892,15 @@ pwm_t* PPM::getPWM() {
     uint8_t tmp;
 
     ATOMIC_BLOCK(ATOMIC_FORCEON) {
-        if( PWM_SETS == 3) {
+        if (newSet) {
             tmp = exportSet;
             exportSet = stableSet;
             stableSet = tmp;
-        } else {
-            memcpy(&(pwm[stableSet]), &(pwm[writeSet]), sizeof(pwm_t));
+            newSet = false;
         }
     }
 
-    if( PWM_SETS == 3) {
-        return &(pwm[exportSet]);
-    } else {
-        return &(pwm[stableSet]);
-    }
+    return &(pwm[exportSet]);
 }
 
 pwm_t* PPM::getPWMWriteSet() {
@@ -587,71 +908,215 @@ pwm_t* PPM::getPWMWriteSet() {
     return &(pwm[writeSet]);
 }
 
-void PPM::switchPWMWriteSet() {
+const pwm_t* PPM::switchPWMWriteSet() {
 
-    if( PWM_SETS == 3) {
-        memcpy(&(pwm[stableSet]), &(pwm[writeSet]), sizeof(pwm_t));
+    uint8_t tmp;
+    uint8_t idx;
+    uint32_t missing;
+    pwm_t* wSet;
+    const pwm_t* pSet;
+
+    tmp = stableSet;
+    stableSet = writeSet;
+    writeSet = tmp;
+    newSet = true;
+
+    wSet = &(pwm[writeSet]);
+    pSet = &(pwm[stableSet]);
+
+    /* Every publish completes one history entry.
+     * Copy only the entries the new write set has not seen yet.
+     */
+    missing = (pSet->frames + pSet->miss) - (wSet->frames + wSet->miss);
+    if (missing > PWM_HISTORY) {
+        missing = PWM_HISTORY;
+    }
+
+    idx = pSet->lastUsed;
+    while (missing--) {
+        wSet->pulseL_us10[idx] = pSet->pulseL_us10[idx];
+        wSet->pulseH_us10[idx] = pSet->pulseH_us10[idx];
+        idx = (idx + PWM_HISTORY - 1) % PWM_HISTORY;
     }
+
+    wSet->sync = pSet->sync;
+    wSet->frameMin_usec = pSet->frameMin_usec;
+    wSet->frameMax_usec = pSet->frameMax_usec;
+    wSet->frames = pSet->frames;
+    wSet->miss = pSet->miss;
+    wSet->lastUsed = pSet->lastUsed;
+
+    return pSet;
 }
 
-/***************/
+/********* Servo Scan **********/
 
-void PPM::startADC(uint8_t convertType) {
+void PPM::startServoScan() {
 
-    uint8_t port;
+#ifdef ENABLE_EDGE_RING
+    uint8_t clock;
 
-    /* Skip this conversion if started from PPM Scan and ADC is not idle,
-     * We don't want to block the ISR.
-     */
-    if (convertType == ADC_PPM && adcConvertType != ADC_IDLE) { return; }
+    stopScope();
 
-    if (convertType == ADC_VCC) {
-        port = PORT_VCC;
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
+
+        writeSet = 0;
+        stableSet = 1;
+        exportSet = 2;
+        newSet = false;
+        memset(&servo[0], 0, SERVO_SETS * sizeof(servo_t));
+        clock = startCapture(PWM_TIMEOUT_OVERFLOWS);
+        timerOverflows = 0;
+        idleOverflows = 0;
+        levelSampling = false;
+        edgeRing.clear();
+        scanning = true;
+        servoScan = true;
+        latencyScan = false;
+        droppedEdges = 0;
+        edgeLost = false;
+        ovfHigh = 0;
+        lastOvf = 0;
+
+        /* Inputs, disable pull-ups */
+        DDRB &= ~SERVO_PIN_MASK;
+        PORTB &= ~SERVO_PIN_MASK;
+
+        /* COUNTER 1, normal mode. No input capture, pin changes read TCNT1. */
+        TCCR1A = (byte)0;
+        TCCR1B = clock;
+        TCNT1 = 0;
+
+        servoDecoder.reset(PINB, tickShift);
+
+        /* Enable timer overflow interrupt only */
+        TIMSK1 &= ~(bit(ICIE1) | bit(OCIE1A));
+        TIFR1 |= bit(TOV1); /* clear pending flag */
+        TIMSK1 |= bit(TOIE1);
+
+        /* Enable pin change interrupt PCINT0 */
+        PCMSK0 = SERVO_PIN_MASK;
+        PCIFR = bit(PCIF0);
+        PCICR |= bit(PCIE0);
     }
-    else {
-        port = PORT_ANALOG_IN;
+#endif
+}
+
+servo_t* PPM::getServo() {
+
+    uint8_t tmp;
+
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
+        if (newSet) {
+            tmp = exportSet;
+            exportSet = stableSet;
+            stableSet = tmp;
+            newSet = false;
+        }
+    }
+
+    return &(servo[exportSet]);
+}
+
+servo_t* PPM::getServoWriteSet() {
+
+    return &(servo[writeSet]);
+}
+
+const servo_t* PPM::switchServoWriteSet() {
+
+    uint8_t tmp;
+
+    tmp = stableSet;
+    stableSet = writeSet;
+    writeSet = tmp;
+    newSet = true;
+
+    /* Every value is current or running, the new write set starts as a copy */
+    memcpy(&(servo[writeSet]), &(servo[stableSet]), sizeof(servo_t));
+
+    return &(servo[stableSet]);
+}
+
+/********* Latency Scan **********/
+
+void PPM::startLatencyScan(uint8_t channel) {
+
+#ifdef ENABLE_EDGE_RING
+    startPPMScan();
+
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
+
+        /* No level sampling, the ADC interrupt would delay the PWM edges */
+        levelSampling = false;
+        TIMSK1 &= ~bit(OCIE1A);
+
+        latency.reset(channel, tickShift);
+        latencyScan = true;
+
+        /* PWM input, disable pull-up */
+        DDRB &= ~LATENCY_PIN_MASK;
+        PORTB &= ~LATENCY_PIN_MASK;
+
+        /* Enable pin change interrupt PCINT0 */
+        PCMSK0 = LATENCY_PIN_MASK;
+        PCIFR = bit(PCIF0);
+        PCICR |= bit(PCIE0);
+    }
+#endif
+}
+
+const latency_t* PPM::getLatency() {
+
+    return latency.getLatency();
+}
+
+/***************/
+
+void PPM::requestADC(uint8_t convertType) {
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        convertADC(adcQueue.request(convertType));
     }
+}
+
+boolean PPM::fetchADC(uint8_t convertType, fixfloat1_t* v) {
 
-    while (adcConvertType != ADC_IDLE);
-    adcConvertType = convertType;
+    uint16_t raw;
+    boolean ready;
 
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ready = adcQueue.fetch(convertType, &raw);
+    }
 
-        /* Disable power reduction for ADC */
-        PRR &= ~bit(PRADC);
+    if (ready) {
+        *v = analogConvert(convertType, raw);
+    }
 
-        /* REFS1 = 0, REFS0 = 1   ==>   VCC with ext. cap. on AREF */
-        ADMUX = bit(REFS0);
+    return ready;
+}
 
-        /* Prescaler /128   ==>   16MHz / 128 = 125KHz */
-        ADCSRA = bit(ADEN) | bit(ADPS2) | bit(ADPS1) | bit(ADPS0);
-        ADCSRB = 0;
+/* Newest result of convertType. Requests the next conversion. */
+fixfloat1_t PPM::readLast(uint8_t convertType) {
 
-        /* Set MUX */
-        ADMUX &= ~(bit(MUX3) | bit(MUX2) | bit(MUX1) | bit(MUX0));
-        ADMUX |= (port - A0);
+    uint16_t raw;
 
-        /* Start convertsion */
-        ADCSRA |= bit(ADSC) | bit(ADIE);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        raw = adcQueue.last(convertType);
+        convertADC(adcQueue.request(convertType));
     }
+
+    return analogConvert(convertType, raw);
 }
 
 fixfloat1_t PPM::readADC() {
 
-    startADC(ADC_VM);
-    /* Wait for completion */
-    while (ADCSRA & bit(ADSC));
-
-    return analogConvert(ADC_VM, adcValue);
+    return readLast(ADC_VM);
 }
 
 fixfloat1_t PPM::readVCC() {
 
-    startADC(ADC_VCC);
-    /* Wait for completion */
-    while (ADCSRA & bit(ADSC));
-
-    return analogConvert(ADC_VCC, adcValue);
+    return readLast(ADC_VCC);
 }
 
 fixfloat1_t PPM::analogConvert(uint8_t convertType, uint16_t rawADCvalue) const {
@@ -666,250 +1131,504 @@ fixfloat1_t PPM::analogConvert(uint8_t convertType, uint16_t rawADCvalue) const
     }
 
     vin = vin * ADC_VOLTAGE * (ADC_VOLTAGE_DIVIDER_R1 + ADC_VOLTAGE_DIVIDER_R2) / ADC_VOLTAGE_DIVIDER_R2 / ADC_VCC_RESOLUTION;
-    adcConvertType = ADC_IDLE;
 
     return (fixfloat1_t)vin;
 }
 
+/*********** Scope ***********/
+
+/* The scope owns workMem */
+static bool scopeActive = false;
+
+/* Settings of the running acquisition */
+static uint8_t scopeSz;
+static scopeparam_t scopeParam;
+/* A complete deep capture was handed out and is kept until the next fetchArray() */
+static bool scopeFetched;
+/* Roll mode, scope.rolled at the last fetchArray() */
+static uint8_t scopeRolled;
+
+static bool sameParam(const scopeparam_t* a, const scopeparam_t* b) {
+
+    return a->resUsec == b->resUsec
+        && a->oversampling == b->oversampling
+        && a->triggerMode == b->triggerMode
+        && a->triggerLevel == b->triggerLevel
+        && a->triggerDelay == b->triggerDelay
+        && a->pretrigger == b->pretrigger;
+}
+
 /*
- * triggerMode 0 = free running 1 = raising edge, 2 = falling edge
+ * Start an acquisition. The ADC is auto triggered by Timer 1 compare match B,
+ * so samples are paced by hardware. Samples are stored by the ADC ISR.
  */
-boolean PPM::fetchArray(uint8_t dataArray[], uint8_t sz, uint16_t resUsec, uint8_t oversampling, uint8_t triggerMode, fixfloat1_t triggerLevel, uint16_t triggerDelay) {
+static void startScope(uint8_t sz, const scopeparam_t* param) {
 
-    uint8_t p, v, o;
-    uint8_t level;
-    bool hit = false;
-    uint8_t sample = 0;
-    uint16_t v16;
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
 
-    uint8_t resUsecH;
-    uint8_t resUsecL;
+        /* Queued single conversions go first */
+        if (adcQueue.owner() == ADC_SCOPE) {
+            haltScope();
+        }
 
+        if (!adcQueue.claim()) {
+            /* Try again with the next fetchArray(). Do not hand out a done capture twice. */
+            if (scopeActive) {
+                scope.stop();
+            }
+            return;
+        }
 
-/* ***************** */
-/* A few handy macros make the code way more readable */
+        scopeSz = sz;
+        scopeParam = *param;
+        scopeFetched = false;
+        scopeRolled = 0;
 
-#define START_ADC_CONVERSION() \
-do { \
-  ADCSRA |= bit(ADSC); \
-} while (false)
+        scope.start(sz, param);
+        scopeActive = true;
 
-#define WAIT_ADC_COMPLETE() \
-do { \
-  while( ADCSRA & bit(ADSC)) { } \
-} while (false)
+        /* Disable power reduction for ADC */
+        PRR &= ~bit(PRADC);
 
-#define WAIT_TIMER_OVERFLOW() \
-do { \
-  TIFR1 |= bit(TOV1); \
-  while( (TIFR1 & bit(TOV1)) == 0) { } \
-} while (false)
+        /* Abort any conversion and clear a pending interrupt */
+        ADCSRA = bit(ADIF);
 
-#define CLEAR_TIMER_OVERFLOW() \
-do { \
-  TIFR1 |= bit(TOV1); \
-} while (false)
+        /* REFS1 = 0, REFS0 = 1   ==>   VCC with ext. cap. on AREF
+         * Left adjust result
+         */
+        ADMUX = bit(REFS0) | bit(ADLAR) | (PORT_ANALOG_IN - A0);
+        DIDR0 |= bit(PORT_ANALOG_IN - A0);
 
-#define SET_TIMER_TOPA( h, l) \
-do { \
-  OCR1AH = (byte)(h); \
-  OCR1AL = (byte)(l); \
-} while (false)
+        /* Auto trigger source Timer 1 compare match B */
+        ADCSRB = bit(ADTS2) | bit(ADTS0);
 
-#define SET_TIMER_TOPB( h, l) \
-do { \
-  OCR1BH = (byte)(h); \
-  OCR1BL = (byte)(l); \
-} while (false)
+        TCCR1A = (byte)0;
+        TCCR1B = (byte)0;
+        TCCR1C = (byte)0;
+        TCNT1 = 0;
 
-#define RESET_TIMER() \
-do { \
-  TCNT1H = (byte)0; \
-  TCNT1L = (byte)0; \
-} while (false)
+        if (scope.isETS()) {
 
-#define NO_TIMER_INTERRUPT ((TIFR1 & bit(TOV1)) == 0)
+            /* Prescaler /2   ==>   16MHz / 2 = 8000KHz
+             * Auto trigger gets enabled by the input capture ISR.
+             */
+            ADCSRA = bit(ADEN) | bit(ADIE) | bit(ADPS0);
 
-/* ***************** */
+            pinMode(PORT_PPM_IN, INPUT);
+            /* disable pull-up */
+            digitalWrite(PORT_PPM_IN, LOW);
 
-    if (oversampling) {
-        if (resUsec < 50) {
-            oversampling = 0;
-        }
-        else if (resUsec < 100) {
-            oversampling = 2;
-        }
-        else if (resUsec < 200) {
-            oversampling = 4;
+            /* Normal mode, free running. Compare match B is set per sample.
+             * Input capture noise canceler, prescaler /8 = 2Mhz = 0.5 usec
+             */
+            TIFR1 = bit(ICF1) | bit(OCF1B) | bit(OCF1A) | bit(TOV1);
+            TCCR1B = bit(ICNC1) | bit(CS11)
+                | ((scope.getTriggerMode() == ACQ_TRIGGER_RISING) ? bit(ICES1) : 0);
+            TIMSK1 |= bit(ICIE1);
         }
         else {
-            oversampling = 8;
+
+            /* CTC mode, TOP = OCR1A. Compare match B at TOP triggers the ADC.
+             * Prescaler /8 = 2Mhz = 0.5 usec
+             */
+            OCR1A = OCR1B = scope.startTicks - 1;
+
+            /* The auto trigger must not see a compare match B left over */
+            TIFR1 = bit(OCF1B) | bit(OCF1A) | bit(TOV1);
+
+            /* Prescaler /2   ==>   16MHz / 2 = 8000KHz */
+            ADCSRA = bit(ADEN) | bit(ADATE) | bit(ADIE) | bit(ADPS0);
+
+            TCCR1B = bit(WGM12) | bit(CS11);
         }
     }
+}
 
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+void PPM::stopScope() {
 
-        /* Disable power reduction for ADC */
-        PRR &= ~bit(PRADC);
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
+        if (adcQueue.owner() == ADC_SCOPE) {
+            haltScope();
+        }
+        scopeActive = false;
+    }
+}
 
-        /* REFS1 = 0, REFS0 = 1   ==>   VCC with ext. cap. on AREF */
-        ADMUX = bit(REFS0);
+uint8_t PPM::getScopePre() {
 
-        /* Prescaler /2   ==>   16MHz / 2 = 8000KHz */
-        ADCSRA = bit(ADEN) | bit(ADPS0);
-        ADCSRB = 0;
+    return scopeActive ? scope.getPre() : 0;
+}
 
-        /* Set mux and left adjusst result */
-        ADMUX &= ~(bit(MUX3) | bit(MUX2) | bit(MUX1) | bit(MUX0));
-        ADMUX |= bit(ADLAR) | (PORT_ANALOG_IN - A0);
+uint8_t* PPM::getMinArray() {
+    return workMem.acq.minArray;
+}
 
-        DIDR0 |= bit(PORT_ANALOG_IN - A0);
+uint8_t* PPM::getGridShadow() {
+    return workMem.acq.gridShadow;
+}
 
+/* Copy the round robin buffer to dataArray, oldest sample first */
+static void unrollScope(uint8_t dataArray[], uint8_t minArray[], uint8_t sz) {
 
-        /* Fast PWM mode */
-        TCCR1A = bit(WGM11) | bit(WGM10);
+    const uint8_t* mins = scope.getMinSamples();
+    uint8_t idx = scope.getFirst();
 
-        /* Prescaler /8 = 2Mhz = 0.5 usec */
-        TCCR1B = bit(WGM13) | bit(WGM12) | bit(CS11);
+    for (uint8_t i = 0; i < sz; i++) {
+        dataArray[i] = scope.getSamples()[idx];
+        /* No minimum without peak detect, e.g. with equivalent time sampling */
+        minArray[i] = mins ? mins[idx] : dataArray[i];
+        if (++idx >= sz) {
+            idx = 0;
+        }
+    }
+}
 
-        TCCR1C = (byte)0;
+/*
+ * Does not block. Starts an acquisition if none is running and returns true
+ * once a capture with these settings is complete and copied to dataArray.
+ * The display keeps running while waiting for the trigger.
+ * With peak detect minArray gets the minimum of each sample.
+ * A deep capture is not restarted right away. It stays available for
+ * deepWindow() until the next call.
+ * In roll mode the acquisition keeps running. Returns true whenever
+ * new samples came in, with the newest sample at the end of dataArray.
+ */
+boolean PPM::fetchArray(uint8_t dataArray[], uint8_t minArray[], uint8_t sz, const scopeparam_t* param) {
 
-        SET_TIMER_TOPA(0, 0);
-        SET_TIMER_TOPB(0, 0);
+    boolean done = false;
+    uint8_t state;
 
+    if (sz > SCOPE_SAMPLES) {
+        sz = SCOPE_SAMPLES;
+    }
 
-        resUsec <<= 1; // *2 because of 0.5 usec timer resolution
+    if (!scopeActive) {
+        /* Scan memory is about to be reused */
+        stopScan();
+        stopStream();
+        state = ACQ_IDLE;
+    }
+    else {
+        state = scope.state;
+    }
 
-        if (oversampling) {
-            resUsec /= oversampling;
+    /* An acquisition waiting for its trigger, rolling or collecting ETS passes
+     * may hold the ADC for long. Give it up to waiting single conversions.
+     */
+    if ((state == ACQ_ARMED || (state == ACQ_RUNNING && (scope.isRoll() || scope.isETS())))
+        && adcQueue.waiting()) {
+        ATOMIC_BLOCK(ATOMIC_FORCEON) {
+            if (adcQueue.owner() == ADC_SCOPE) {
+                haltScope();
+            }
         }
+        return false;
+    }
 
-        resUsecH = resUsec >> 8;
-        resUsecL = resUsec & 0xff;
+    if (state != ACQ_IDLE && (sz != scopeSz || !sameParam(param, &scopeParam))) {
+        /* Settings changed. Discard the running capture. */
+        state = ACQ_IDLE;
+    }
+    else if (state == ACQ_DONE && scope.isDeep()) {
+        if (!scopeFetched) {
+            deepWindow(0, 1, dataArray, minArray, sz);
+            scopeFetched = true;
+            return true;
+        }
+    }
+    else if (state == ACQ_RUNNING && scope.isRoll()) {
+        if (scope.rolled == scopeRolled) {
+            return false;
+        }
+        /* The ISR must not move the oldest sample while copying */
+        ATOMIC_BLOCK(ATOMIC_FORCEON) {
+            unrollScope(dataArray, minArray, sz);
+            scopeRolled = scope.rolled;
+        }
+        return true;
+    }
+    else if (state == ACQ_DONE) {
+        unrollScope(dataArray, minArray, sz);
+        done = true;
+    }
 
+    if (state == ACQ_IDLE || state == ACQ_DONE) {
+        startScope(sz, param);
+    }
 
-        switch (triggerMode) {
+    return done;
+}
 
-        case 1: // raising edge
-        case 2: // falling edge
+/*
+ * Decode sz pixels of the last deep capture, step samples per pixel from sample first on.
+ * Returns the number of samples in the capture, 0 if there is none.
+ */
+uint32_t PPM::deepWindow(uint32_t first, uint16_t step, uint8_t dataArray[], uint8_t minArray[], uint8_t sz) {
 
-            level = (byte)(triggerLevel * 5 / 3);
+    if (!scopeActive || scope.state != ACQ_DONE || !scope.isDeep()) {
+        return 0;
+    }
 
-            if (triggerDelay) {
+    scope.getStore()->window(first, step, sz, dataArray, minArray);
 
-                triggerDelay <<= 1; // *2 because of 0.5 usec timer resolution
+    return scope.getStore()->getSamples();
+}
 
-                RESET_TIMER();
-                SET_TIMER_TOPA(triggerDelay >> 8, triggerDelay);
-                WAIT_TIMER_OVERFLOW();
+/*********** Logic analyzer ***********/
 
-                /* Preload new TOP. Becomes active at timer overflow */
-                SET_TIMER_TOPA(resUsecH, resUsecL);
+#ifdef ARDUINO
 
-            }
-            else {
+/* Delay of n cycles. Keeps the carry flag. */
+#define LOGIC_PAD                                   \
+    ".if %[k]"                              "\n\t"  \
+    "ldi %[d], %[k]"                        "\n\t"  \
+    "0: dec %[d]"                           "\n\t"  \
+    "brne 0b"                               "\n\t"  \
+    ".endif"                                "\n\t"  \
+    ".rept %[r]"                            "\n\t"  \
+    "nop"                                   "\n\t"  \
+    ".endr"                                 "\n\t"
 
-                RESET_TIMER();
-                SET_TIMER_TOPA(resUsecH, resUsecL);
-                WAIT_TIMER_OVERFLOW();
-            }
+/*
+ * Sample PINB every 4 + PAD cycles into p[1] .. p[LOGIC_BYTES].
+ * Call with interrupts disabled. Returns TCNT1, read LOGIC_START_CYCLES before the first sample.
+ *
+ * Every sample is read with "in" exactly 4 + PAD cycles after the previous one.
+ * The bit is shifted into acc with lsr/rol. The last bit of a byte is shifted
+ * in after the loop jump, so the byte is stored one pass late from out.
+ * The first pass stores garbage into p[0].
+ */
+template <uint8_t PAD>
+static uint16_t sampleLogic(uint8_t* p) {
+
+    uint16_t t;
+    uint8_t n = LOGIC_BYTES;
+    uint8_t a;
+    uint8_t b;
+    uint8_t acc;
+    uint8_t out;
+    uint8_t d;
+
+    /* brne of the sampling loop reaches 63 words back */
+    static_assert(PAD % 3 < 2, "LOGIC_PAD too long");
+
+    asm volatile (
+        "lds %A[t], %[tcnt]"                "\n\t"
+        "lds %B[t], %[tcnt]+1"              "\n\t"
+        "1: in %[b], %[pin]"                "\n\t"  /* s0 */
+        LOGIC_PAD
+        "lsr %[a]"                          "\n\t"  /* s7 of the previous byte */
+        "rol %[acc]"                        "\n\t"
+        "mov %[out], %[acc]"                "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s1 */
+        LOGIC_PAD
+        "lsr %[b]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "lsr %[a]"                          "\n\t"
+        "in %[b], %[pin]"                   "\n\t"  /* s2 */
+        LOGIC_PAD
+        "rol %[acc]"                        "\n\t"
+        "lsr %[b]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s3 */
+        LOGIC_PAD
+        "st X+, %[out]"                     "\n\t"
+        "lsr %[a]"                          "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s4 */
+        LOGIC_PAD
+        "rol %[acc]"                        "\n\t"
+        "lsr %[a]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s5 */
+        LOGIC_PAD
+        "lsr %[a]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "nop"                               "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s6 */
+        LOGIC_PAD
+        "lsr %[a]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "nop"                               "\n\t"
+        "in %[a], %[pin]"                   "\n\t"  /* s7 */
+        LOGIC_PAD
+        "dec %[n]"                          "\n\t"
+        "brne 1b"                           "\n\t"
+        "lsr %[a]"                          "\n\t"
+        "rol %[acc]"                        "\n\t"
+        "st X+, %[acc]"                     "\n\t"
+        : [t] "=&r" (t), [p] "+x" (p), [n] "+r" (n),
+          [a] "=&r" (a), [b] "=&r" (b), [acc] "=&r" (acc), [out] "=&r" (out), [d] "=&d" (d)
+        : [tcnt] "n" (_SFR_MEM_ADDR(TCNT1)), [pin] "I" (_SFR_IO_ADDR(PINB)),
+          [k] "n" (PAD / 3), [r] "n" (PAD % 3)
+        : "memory"
+    );
+
+    return t;
+}
 
-            START_ADC_CONVERSION();
-            WAIT_ADC_COMPLETE();
-            p = ADCH;
+#else
 
-            CLEAR_TIMER_OVERFLOW();
+/* Host build. Same bit order, first sample in the highest bit, no timing. */
+template <uint8_t PAD>
+static uint16_t sampleLogic(uint8_t* p) {
 
-            for (uint16_t w = 0; w < 25000; w++) {
+    uint16_t t = TCNT1;
+    uint8_t acc;
 
-                START_ADC_CONVERSION();
-                WAIT_ADC_COMPLETE();
-                v = ADCH;
+    for (uint8_t n = 1; n <= LOGIC_BYTES; n++) {
+        acc = 0;
+        for (uint8_t b = 0; b < 8; b++) {
+            acc = (acc << 1) | (PINB & 1);
+        }
+        p[n] = acc;
+    }
 
-                if (((triggerMode == 1) && p < level && v > level)
-                    || ((triggerMode == 2) && p > level && v < level)) {
-                    if (triggerDelay && NO_TIMER_INTERRUPT) {
+    return t;
+}
 
-                        RESET_TIMER();
-                        CLEAR_TIMER_OVERFLOW();
+#endif
 
-                    }
-                    else {
+/*
+ * Deep capture. Polls input capture at 0.5 usec and stores the runs between edges.
+ * Interrupts stay enabled. An interrupt only delays the poll, the edge time is
+ * kept by ICR1. Called with Timer 1 running at 0.5 usec and edge detection set
+ * for the edge that ends level. The first run starts at last.
+ */
+static void sampleLogicDeep(uint8_t level, uint16_t last) {
 
-                        RESET_TIMER();
-                        WAIT_TIMER_OVERFLOW();
+    uint32_t start = millis();
+    uint16_t icr;
 
-                        dataArray[sample++] = p;
-                        dataArray[sample++] = v;
-                        hit = true;
-                        break;
-                    }
-                }
+    TIFR1 = bit(ICF1);
 
-                p = v;
-            }
-            break;
+    for (;;) {
 
-        case 0: // free running
-        default:
+        if (TIFR1 & bit(ICF1)) {
+            icr = ICR1;
+            /* Flip detection edge */
+            TCCR1B ^= bit(ICES1);
+            TIFR1 = bit(ICF1);
 
-            RESET_TIMER();
-            SET_TIMER_TOPA(resUsecH, resUsecL);
-            WAIT_TIMER_OVERFLOW();
+            if (!logic.store.putRun(level, (uint16_t)(icr - last))) {
+                break;
+            }
+            level ^= 1;
+            last = icr;
+        }
+        else if ((uint16_t)(TCNT1 - last) >= 0x8000) {
+            /* Long run, before Timer 1 wraps */
+            if (!logic.store.putRun(level, 0x8000)) {
+                break;
+            }
+            last += 0x8000;
+        }
 
-            hit = true;
+        if (millis() - start > LOGIC_DEEP_MSEC) {
+            logic.store.putRun(level, (uint16_t)(TCNT1 - last));
             break;
         }
+    }
+}
 
-        if (!hit) { return false; }
-
-        START_ADC_CONVERSION();
+/*
+ * Blocks for up to LOGIC_TRIGGER_MSEC plus the capture (2 msec at 500 kHz,
+ * LOGIC_DEEP_MSEC for deep capture).
+ * Returns nullptr if no trigger edge was seen.
+ * The capture is valid until the next scan, scope or logic capture.
+ */
+const LogicAcq* PPM::fetchLogic(uint8_t rate, uint8_t triggerMode) {
 
-        if (oversampling) {
+    uint32_t start;
+    uint16_t t;
+    uint16_t icr;
 
-            for (; sample < sz; ) {
+    /* Scan and scope memory is about to be reused */
+    stopScope();
+    stopScan();
+    stopStream();
 
-                v16 = 0;
+    logic.rate = rate;
+    logic.triggerMode = triggerMode;
+    logic.startCycles = 0;
+    logic.store.begin(logic.bits, sizeof(logic.bits));
 
-                for (o = 0; o < oversampling; o++) {
+    pinMode(PORT_PPM_IN, INPUT);
+    /* disable pull-up */
+    digitalWrite(PORT_PPM_IN, LOW);
 
-                    WAIT_ADC_COMPLETE();
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
 
-                    /* result is left adjusted and we want highest 8 bits only */
-                    v16 += ADCH;
+        /* Normal mode, no prescaler. Input capture timestamps the trigger edge.
+         * No noise canceler, it would delay the timestamp against PINB.
+         */
+        TCCR1A = (byte)0;
+        TCCR1B = (byte)0;
+        TCCR1C = (byte)0;
+        TCNT1 = 0;
+        TIFR1 = bit(ICF1) | bit(TOV1);
+        TCCR1B = ((rate == LOGIC_RATE_DEEP) ? bit(CS11) : bit(CS10))
+            | ((triggerMode == ACQ_TRIGGER_RISING) ? bit(ICES1) : 0);
+    }
 
-                    WAIT_TIMER_OVERFLOW();
-                    START_ADC_CONVERSION();
-                }
+    if (triggerMode != ACQ_TRIGGER_FREE) {
+        start = millis();
+        while (!(TIFR1 & bit(ICF1))) {
+            if (millis() - start > LOGIC_TRIGGER_MSEC) {
+                TCCR1B = 0;
+                return nullptr;
+            }
+        }
+    }
 
-                if (oversampling == 8) {
-                    v16 >>= 3;
-                }
-                else if (oversampling == 4) {
-                    v16 >>= 2;
-                }
-                else if (oversampling == 2) {
-                    v16 >>= 1;
-                }
+    if (rate == LOGIC_RATE_DEEP) {
 
-                dataArray[sample++] = (byte)v16;
-            }
+        if (triggerMode == ACQ_TRIGGER_FREE) {
+            uint8_t level = digitalRead(PORT_PPM_IN) == HIGH;
 
+            /* Wait for the edge away from the current level */
+            TCCR1B = bit(CS11) | (level ? 0 : bit(ICES1));
+            sampleLogicDeep(level, TCNT1);
         }
         else {
+            TCCR1B ^= bit(ICES1);
+            sampleLogicDeep(triggerMode == ACQ_TRIGGER_RISING, ICR1);
+        }
 
-            for (; sample < sz; ) {
+        TCCR1B = 0;
+        return &logic;
+    }
 
-                WAIT_ADC_COMPLETE();
+    ATOMIC_BLOCK(ATOMIC_FORCEON) {
 
-                /* result is left adjusted and we want highest 8 bits only */
-                dataArray[sample++] = ADCH;
+        icr = ICR1;
 
-                WAIT_TIMER_OVERFLOW();
-                START_ADC_CONVERSION();
-            }
+        switch (rate) {
+        case LOGIC_RATE_4M:
+            t = sampleLogic<LOGIC_CYCLES(LOGIC_RATE_4M) - 4>(logic.bits);
+            break;
+        case LOGIC_RATE_2M:
+            t = sampleLogic<LOGIC_CYCLES(LOGIC_RATE_2M) - 4>(logic.bits);
+            break;
+        case LOGIC_RATE_1M:
+            t = sampleLogic<LOGIC_CYCLES(LOGIC_RATE_1M) - 4>(logic.bits);
+            break;
+        default:
+            t = sampleLogic<LOGIC_CYCLES(LOGIC_RATE_500K) - 4>(logic.bits);
+            break;
         }
+
+        TCCR1B = 0;
+    }
+
+    if (triggerMode != ACQ_TRIGGER_FREE) {
+        /* Timer 1 wraps every 4 msec and the wait for the edge may take
+         * LOGIC_TRIGGER_MSEC, several wraps. t - icr is still right because
+         * sampling starts a few dozen cycles after ICF was seen, far less
+         * than one wrap. Keep it that way, nothing slow between the ICF poll
+         * and sampleLogic().
+         */
+        logic.startCycles = t - icr + LOGIC_START_CYCLES;
     }
 
-    return true;
+    return &logic;
 }
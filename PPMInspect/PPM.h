@@ -29,91 +29,126 @@
 
 #include "Config.h"
 #include "TextUI.h"
-
-typedef struct ppm_t {
-  
-    bool     sync;
-    uint8_t  channels;
-    uint16_t frameMin_usec;
-    uint16_t frameMax_usec;
-    uint16_t pulseMin_usec;
-    uint16_t pulseMax_usec;
-    fixfloat1_t vLevel_low;
-    fixfloat2_t vLevel_high;
-    bool     pulseLevel;
-    uint32_t frames;
-    uint16_t badFrames;
-    uint16_t badCount;
-    uint16_t badPulse;
-    uint16_t channel_usec[PPM_MAX_CHANNELS];
-    uint16_t channelMin_usec[PPM_MAX_CHANNELS];
-    uint16_t channelMax_usec[PPM_MAX_CHANNELS];
-} ppm_t;
-
-#define PWM_HISTORY 10
-
-typedef struct pwm_t {
-  
-    bool     sync;
-    uint32_t frameMin_usec;
-    uint32_t frameMax_usec;
-    uint32_t frames;
-    uint32_t miss;
-
-    int8_t   lastUsed;
-    uint16_t pulseL_usec[PWM_HISTORY];
-    uint16_t pulseH_usec[PWM_HISTORY];
-} pwm_t;
+#include "PPMDecoder.h"
+#include "ServoDecoder.h"
+#include "LatencyMeter.h"
+#include "EdgeRing.h"
+#include "AdcQueue.h"
+#include "EdgeStream.h"
+#include "ScopeAcq.h"
+#include "LogicAcq.h"
 
 #define PPM_SETS       3
 #define PWM_SETS       3
+#define SERVO_SETS     3
 
 class PPM {
 
     private:
-        /* Three sets of data. 
-         * ppm[0] may be inconsistent and is written by the ISR.
-         * ppm[1] and ppm[2] are always consistent.
-         * one set is exported to the data viewer while the other
-         * set is exchanged with ppm[0] when the set is complete and consistent.
+        /* Three sets of data, rotated by index. Nothing is copied.
+         * The write set is only written by the decoder.
+         * The stable set is the newest complete set.
+         * The export set is handed out to the data viewer.
+         *
+         * On publish the decoder swaps write and stable set and flags new data.
+         * getPPM()/getPWM() swap stable and export set if new data is flagged.
+         * Running min/max and counters are carried forward into the new
+         * write set by the switch methods.
          */
-        ppm_t ppm[PPM_SETS];
-        pwm_t pwm[PWM_SETS];
+        union {
+            /* PPM, PWM and servo scan never run at the same time */
+            ppm_t ppm[PPM_SETS];
+            pwm_t pwm[PWM_SETS];
+            servo_t servo[SERVO_SETS];
+        };
 
         uint8_t writeSet = 0;
         uint8_t stableSet = 1;
         uint8_t exportSet = 2;
+        volatile bool newSet = false;
+
+        fixfloat1_t readLast( uint8_t convertType);
 
     public:
-        void countChannels( ppm_t *wSet, uint16_t time_usec, bool level);
-        void initTimings( ppm_t *wSet);
-        boolean storeFrame( ppm_t *wSet, uint16_t time_usec, bool level);
-        void storePulse( ppm_t *wSet, uint16_t time_usec);
-        void storeFrameTime( ppm_t *wSet, uint16_t frame_usec);
-        void storeServoTime( ppm_t *wSet, uint16_t servo_usec);
-        
-        void startADC( uint8_t convertType);
+        /* Single conversions never block, see AdcQueue.h.
+         * requestADC() queues a conversion of ADC_PPM, ADC_VM or ADC_VCC.
+         * fetchADC() returns true once its result is there.
+         */
+        void requestADC( uint8_t convertType);
+        boolean fetchADC( uint8_t convertType, fixfloat1_t *v);
         fixfloat1_t analogConvert( uint8_t convertType, uint16_t v) const;
         
+        /* Newest Vppm and Vcc. Requests the next conversion and returns at once. */
         fixfloat1_t readADC();
         fixfloat1_t readVCC();
         
         void startPPMScan();
         ppm_t *getPPM();
+        /* Running channel statistics. Not buffered, updated by the decoder. */
+        const ppmstats_t *getPPMStats();
+        /* Bad frame capture. Frames are stable once frozen is set. */
+        const forensic_t *getForensic();
+        void rearmForensic();
 
         void startPWMScan();
         pwm_t *getPWM();
 
+        /* Servo outputs on Port B, see SERVO_PIN_MASK. Needs ENABLE_EDGE_RING. */
+        void startServoScan();
+        servo_t *getServo();
+
+        /* PPM on PORT_PPM_IN and one PWM output on LATENCY_PIN. Needs ENABLE_EDGE_RING.
+         * channel is the PPM channel watched, 0 based. The PPM data is in getPPM().
+         */
+        void startLatencyScan( uint8_t channel);
+        /* Not buffered, updated by the meter */
+        const latency_t *getLatency();
+
         void stopScan();
 
-        /* The following four methods should only get called from ISR */
+        /* Send all captured edges over Serial. Call right after startPPMScan().
+         * Needs ENABLE_EDGE_RING.
+         */
+        void startStream();
+        void stopStream();
+        /* nullptr if not streaming */
+        const EdgeStreamWriter *getStream();
+        /* Send scope samples over Serial. blk->count must not exceed EDGESTREAM_ADC_MAX. */
+        void sendArray( const uint8_t dataArray[], const adcblock_t *blk);
+
+        /* Decode edges queued by the capture ISR. Call from loop() */
+        void processEdges();
+        /* Edges waiting for processEdges(). Check with interrupts disabled before sleeping. */
+        bool edgesPending();
+
+        /* The following four methods should only get called from the decoder.
+         * switch*WriteSet() return the set just published.
+         */
         ppm_t *getPPMWriteSet();
-        void switchPPMWriteSet();
+        const ppm_t *switchPPMWriteSet();
 
         pwm_t *getPWMWriteSet();
-        void switchPWMWriteSet();
+        const pwm_t *switchPWMWriteSet();
+
+        servo_t *getServoWriteSet();
+        const servo_t *switchServoWriteSet();
+
+        /* Scope acquisition. Does not block, see PPM.cpp */
+        boolean fetchArray( uint8_t dataArray[], uint8_t minArray[], uint8_t sz, const scopeparam_t *param);
+        /* Zoom and pan through a deep capture */
+        uint32_t deepWindow( uint32_t first, uint16_t step, uint8_t dataArray[], uint8_t minArray[], uint8_t sz);
+        void stopScope();
+        /* Trigger index in the last capture, 0 if the trigger is not inside the record */
+        uint8_t getScopePre();
+        /* Minimum of peak detect and deep capture, SCOPE_SAMPLES bytes. Shares memory
+         * with the scans, only valid while the scope or the logic analyzer runs.
+         */
+        uint8_t *getMinArray();
+        /* Memory for TextUILcd::setGridShadow(), same lifetime as getMinArray() */
+        uint8_t *getGridShadow();
 
-        boolean fetchArray( uint8_t dataArray[], uint8_t sz, uint16_t resUsec, uint8_t oversampling, uint8_t triggerMode, fixfloat1_t triggerLevel,  uint16_t triggerDelay);
+        /* Logic analyzer on PORT_PPM_IN. Blocks, see PPM.cpp. triggerMode is ACQ_TRIGGER_* */
+        const LogicAcq *fetchLogic( uint8_t rate, uint8_t triggerMode);
 };
 
 #endif
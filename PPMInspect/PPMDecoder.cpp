@@ -0,0 +1,509 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "PPMDecoder.h"
+
+/* Config */
+extern config_t settings;
+
+/* Pulse and channel times are kept in 16 bit */
+static uint16_t sat16(uint32_t v) {
+
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+void PPMDecoder::reset(uint8_t step, uint32_t ticks, uint8_t shift) {
+
+    detectStep = step;
+    tickShift = shift;
+    prevPulse_q4 = 0;
+    channels = 0;
+    detectedChannels = 0;
+    pulseIdx = 0;
+    lastTicks = frameStartTicks = ticks;
+    carrySet = nullptr;
+
+    /* The decoder memory is shared with the scope. Nothing survives a reset. */
+    frameSlot = 0;
+    memset(&forensic, 0, sizeof(forensic_t));
+    memset(&stats, 0, sizeof(ppmstats_t));
+    statsSeeded = false;
+}
+
+void PPMDecoder::rearmForensic() {
+
+    forensic.reason = FORENSIC_NONE;
+    forensic.frozen = false;
+}
+
+/*
+ * Close the current frame and advance to the next slot.
+ * After the bad frame FORENSIC_POST_FRAMES more frames are kept, then the
+ * capture freezes and the decoder stays in the spare slot.
+ */
+void PPMDecoder::nextFrame() {
+
+    forensic.frame[frameSlot].count = pulseIdx;
+    pulseIdx = 0;
+
+    if (forensic.frozen) {
+        return;
+    }
+
+    if (forensic.reason != FORENSIC_NONE) {
+        if (forensic.postFrames == 0) {
+            forensic.frozen = true;
+        }
+        else {
+            forensic.postFrames--;
+        }
+    }
+
+    frameSlot = (frameSlot + 1) % FORENSIC_SLOTS;
+    forensic.frame[frameSlot].count = 0;
+}
+
+/* Remember the first bad frame until rearmed */
+void PPMDecoder::badFrame(uint8_t reason) {
+
+    if (forensic.reason == FORENSIC_NONE) {
+        forensic.reason = reason;
+        forensic.badSlot = frameSlot;
+        forensic.postFrames = FORENSIC_POST_FRAMES;
+    }
+}
+
+/*
+ * Ticks since the previous edge, not limited.
+ */
+uint32_t PPMDecoder::edgeTicks(uint32_t ticks) {
+
+    uint32_t dt;
+
+    dt = ticks - lastTicks;
+    lastTicks = ticks;
+
+    return dt;
+}
+
+/*
+ * Time since the previous edge in usec, edge_q4 gets it in 1/16 usec.
+ * Saturates at UINT16_MAX usec. Longer gaps are always invalid pulses or frames.
+ */
+uint16_t PPMDecoder::edgeTime(uint32_t ticks) {
+
+    uint32_t dt;
+
+    dt = edgeTicks(ticks);
+
+    if (dt > ((uint32_t)UINT16_MAX << tickShift)) {
+        dt = (uint32_t)UINT16_MAX << tickShift;
+    }
+    edge_q4 = dt << (4 - tickShift);
+
+    return (uint16_t)(edge_q4 >> 4);
+}
+
+boolean PPMDecoder::ppmEdge(ppm_t* wSet, uint32_t ticks, bool level) {
+
+    uint16_t time_usec;
+    boolean publish = false;
+
+    time_usec = edgeTime(ticks);
+
+    switch (detectStep) {
+    case DETECT_STEP_INIT:
+        if (pulseIdx > 0) {
+            nextFrame();
+        }
+        wSet->channels = 0;
+        wSet->sync = false;
+        publish = true;
+        detectStep = DETECT_STEP_SYNCWAIT;
+        break;
+
+    case DETECT_STEP_SYNCWAIT:
+        if (time_usec > settings.syncValidMin_usec) {
+            frameStartTicks = ticks;
+
+            wSet->pulseLevel = level;
+            channels = 0;
+            detectedChannels = 0;
+            detectStep = DETECT_STEP_CHANNELWAIT;
+        }
+        break;
+
+    case DETECT_STEP_CHANNELWAIT:
+        countChannels(wSet, time_usec, level);
+        break;
+
+    case DETECT_STEP_VERIFY:
+    case DETECT_STEP_SYNCED:
+        publish = (detectStep == DETECT_STEP_SYNCED);
+
+        if (storeFrame(wSet, time_usec, level)) {
+            /* Sync edge starts the next frame */
+            frameStartTicks = ticks;
+        }
+        else {
+            publish = false;
+        }
+        break;
+    }
+
+    return publish;
+}
+
+boolean PPMDecoder::ppmTimeout(ppm_t* wSet) {
+
+    wSet->channels = 0;
+    wSet->sync = false;
+
+    if (detectStep != DETECT_STEP_INIT) {
+        detectStep = DETECT_STEP_INIT;
+        wSet->badFrames++;
+        badFrame(FORENSIC_LONGFRAME);
+        /* Keep the frame even if the signal was lost right after sync */
+        nextFrame();
+    }
+
+    return true;
+}
+
+void PPMDecoder::countChannels(ppm_t* wSet, uint16_t time_usec, bool level) {
+
+    uint32_t servo_usec;
+
+    if (level == wSet->pulseLevel) { // previous was not a pulse
+
+        if (time_usec > settings.syncValidMin_usec) { // Sync detected
+
+            if (channels >= PPM_MIN_CHANNELS) {
+                frameStartTicks = lastTicks;
+                detectedChannels = channels;
+                channels = 0;
+                nextFrame();
+                detectStep = DETECT_STEP_VERIFY;
+            }
+            else {
+                detectStep = DETECT_STEP_INIT;
+            }
+
+        }
+        else {
+            if (pulseIdx > 0) {
+                servo_usec = (edge_q4 + prevPulse_q4) >> 4;
+                /* Check valid servo timing */
+                if (servo_usec >= settings.servoValidMin_usec && servo_usec <= settings.servoValidMax_usec) {
+                    channels++;
+                }
+                else {
+                    detectStep = DETECT_STEP_INIT;
+                }
+            }
+            else {
+                detectStep = DETECT_STEP_INIT;
+            }
+        }
+
+    }
+    else { // was a pulse
+        if (time_usec < settings.pulseValidMin_usec || time_usec > settings.pulseValidMax_usec) {
+            detectStep = DETECT_STEP_INIT;
+        }
+    }
+
+    storePulse(wSet, time_usec);
+}
+
+boolean PPMDecoder::storeFrame(ppm_t* wSet, uint16_t time_usec, bool level) {
+
+    uint32_t servo_q4;
+    uint32_t servo_usec;
+
+    if (level == wSet->pulseLevel) { // previous was not a pulse
+
+        if (time_usec > settings.syncValidMin_usec) { // Sync detected
+
+            if (channels == detectedChannels) { // All channels scanned
+
+                if (detectStep == DETECT_STEP_SYNCED) {
+                    uint32_t frame_usec = (lastTicks - frameStartTicks) >> tickShift;
+                    storeFrameTime(wSet, (frame_usec > UINT16_MAX) ? UINT16_MAX : (uint16_t)frame_usec);
+
+                    wSet->channels = detectedChannels;
+                    wSet->frames++;
+                    wSet->sync = true;
+                    statsSeeded = true;
+                }
+                else { // DETECT_STEP_VERIFY => DETECT_STEP_SYNCED
+                    initTimings(wSet);
+                    detectStep = DETECT_STEP_SYNCED;
+                }
+
+                channels = 0;
+                nextFrame();
+                return true;
+
+            }
+            else { // servo channels missing
+                if (detectStep == DETECT_STEP_SYNCED) {
+                    wSet->badCount++;
+                    badFrame(FORENSIC_CHCOUNT);
+                }
+                detectStep = DETECT_STEP_INIT;
+            }
+
+        }
+        else { // No sync
+
+            if (pulseIdx > 0) {
+                servo_q4 = edge_q4 + prevPulse_q4;
+                servo_usec = servo_q4 >> 4;
+                /* Check valid servo timing */
+                if (servo_usec >= settings.servoValidMin_usec && servo_usec <= settings.servoValidMax_usec) {
+                    if (detectStep == DETECT_STEP_SYNCED) {
+                        storeServoTime(wSet, servo_q4);
+                    }
+                    channels++;
+                }
+                else {
+                    detectStep = DETECT_STEP_INIT;
+                }
+
+            }
+            else {
+                detectStep = DETECT_STEP_INIT;
+            }
+        }
+
+    }
+    else { // was a pulse
+        if (detectStep == DETECT_STEP_SYNCED) {
+            uint16_t pulse_us10 = sat16(toUs10(edge_q4));
+
+            if (pulse_us10 < wSet->pulseMin_us10) {
+                wSet->pulseMin_us10 = pulse_us10;
+            }
+            if (pulse_us10 > wSet->pulseMax_us10) {
+                wSet->pulseMax_us10 = pulse_us10;
+            }
+
+            if (time_usec < settings.pulseValidMin_usec || time_usec > settings.pulseValidMax_usec) {
+                wSet->badPulse++;
+                badFrame(FORENSIC_PULSE);
+            }
+        }
+    }
+
+    storePulse(wSet, time_usec);
+
+    return false;
+}
+
+void PPMDecoder::initTimings(ppm_t* wSet) {
+
+    wSet->frameMin_usec = wSet->pulseMin_us10 = UINT16_MAX;
+    wSet->frameMax_usec = wSet->pulseMax_us10 = 0;
+
+    for (uint8_t ch = 0; ch < detectedChannels; ch++) {
+        wSet->channel_us10[ch] = 0;
+        wSet->channelMin_us10[ch] = UINT16_MAX;
+        wSet->channelMax_us10[ch] = 0;
+    }
+
+    carrySet = nullptr;
+
+    memset(&stats, 0, sizeof(ppmstats_t));
+    statsSeeded = false;
+}
+
+void PPMDecoder::storePulse(ppm_t* wSet, uint16_t time_usec) {
+
+    prevPulse_q4 = edge_q4;
+
+    if (pulseIdx < PPM_MAX_PULSE) {
+        pulses()[pulseIdx] = time_usec;
+        pulseIdx++;
+    }
+    else {
+        detectStep = DETECT_STEP_INIT;
+    }
+}
+
+void PPMDecoder::storeFrameTime(ppm_t* wSet, uint16_t frame_usec) {
+
+    if (frame_usec < wSet->frameMin_usec) {
+        wSet->frameMin_usec = frame_usec;
+    }
+    if (frame_usec > wSet->frameMax_usec) {
+        wSet->frameMax_usec = frame_usec;
+    }
+}
+
+void PPMDecoder::storeServoTime(ppm_t* wSet, uint32_t servo_q4) {
+
+    const ppm_t* cSet = carrySet ? carrySet : wSet;
+    uint16_t servo_us10 = sat16(toUs10(servo_q4));
+    uint16_t min_us10 = cSet->channelMin_us10[channels];
+    uint16_t max_us10 = cSet->channelMax_us10[channels];
+
+    wSet->channel_us10[channels] = servo_us10;
+    wSet->channelMin_us10[channels] = (servo_us10 < min_us10) ? servo_us10 : min_us10;
+    wSet->channelMax_us10[channels] = (servo_us10 > max_us10) ? servo_us10 : max_us10;
+
+    storeStats(servo_q4);
+}
+
+/*
+ * Update running mean, variance and jitter histogram of the current channel.
+ *
+ *   mean += (x - mean) / 2^PPM_STATS_SHIFT
+ *   var  += ((x - mean)^2 - var) / 2^PPM_STATS_SHIFT
+ *
+ * Both are kept with 8 fractional bits, 4 more than servo_q4 has. With only
+ * the resolution of servo_q4 the rounded update stops moving the mean within
+ * 0.5 usec of the signal and small variances stay at 0.
+ * The first frame after sync seeds the mean.
+ */
+void PPMDecoder::storeStats(uint32_t servo_q4) {
+
+    int32_t d_q8;
+    int32_t d_q4;
+    int8_t bin;
+    uint8_t* jitter = stats.jitter[channels];
+
+    if (!statsSeeded) {
+        stats.mean_q8[channels] = servo_q4 << 4;
+        stats.var_q8[channels] = 0;
+        return;
+    }
+
+    d_q8 = (int32_t)(servo_q4 << 4) - (int32_t)stats.mean_q8[channels];
+    stats.mean_q8[channels] += (d_q8 + (1 << (PPM_STATS_SHIFT - 1))) >> PPM_STATS_SHIFT;
+
+    /* Square with 4 fractional bits, limited to +-2048 usec so that it fits */
+    d_q4 = (d_q8 + 8) >> 4;
+    if (d_q4 > (2048L << 4)) {
+        d_q4 = 2048L << 4;
+    }
+    else if (d_q4 < -(2048L << 4)) {
+        d_q4 = -(2048L << 4);
+    }
+    stats.var_q8[channels] += (d_q4 * d_q4 - (int32_t)stats.var_q8[channels] + (1 << (PPM_STATS_SHIFT - 1))) >> PPM_STATS_SHIFT;
+
+    /* Round deviation to usec and center */
+    d_q8 = (d_q8 + 128) >> 8;
+    if (d_q8 < -(PPM_JITTER_BINS / 2)) {
+        bin = 0;
+    }
+    else if (d_q8 >= PPM_JITTER_BINS / 2) {
+        bin = PPM_JITTER_BINS - 1;
+    }
+    else {
+        bin = (int8_t)d_q8 + PPM_JITTER_BINS / 2;
+    }
+
+    /* Counts saturate. Halve all bins to keep the shape. */
+    if (ppmJitter(&stats, channels, bin) == PPM_JITTER_MAX) {
+        for (uint8_t b = 0; b < PPM_JITTER_BINS / 2; b++) {
+            jitter[b] = (jitter[b] >> 1) & 0x77;
+        }
+    }
+    jitter[bin >> 1] += (bin & 1) ? 0x10 : 0x01;
+}
+
+/********* PWM Scan **********/
+
+boolean PPMDecoder::pwmEdge(pwm_t* wSet, uint32_t ticks, bool level) {
+
+    uint32_t dt;
+    uint32_t time_us10;
+
+    /* PWM periods may exceed UINT16_MAX usec up to the timeout, keep all 32 bits.
+     * Only limited to keep toUs10() in range, far beyond PWM_TIMEOUT_OVERFLOWS.
+     */
+    dt = edgeTicks(ticks);
+    if (dt > (PWM_EDGE_MAX_Q4 >> (4 - tickShift))) {
+        dt = PWM_EDGE_MAX_Q4 >> (4 - tickShift);
+    }
+    edge_q4 = dt << (4 - tickShift);
+    time_us10 = toUs10(edge_q4);
+
+    if( level) {
+        uint32_t H = wSet->pulseH_us10[wSet->lastUsed];
+
+        wSet->pulseL_us10[wSet->lastUsed] = time_us10;
+            
+        if( H > 0) {
+            uint32_t fTime = (time_us10 + H + 5) / 10;
+
+            if( wSet->frameMax_usec == 0L) {
+                wSet->frameMax_usec = 1L; // skip first
+                return false;
+
+            } else if( fTime > wSet->frameMax_usec || !wSet->sync) {
+                wSet->frameMax_usec = fTime;
+            }
+
+            if( wSet->frameMin_usec == 0L) {
+                wSet->frameMin_usec = UINT32_MAX; // skip first
+                return false;
+
+            } else if ( fTime < wSet->frameMin_usec || !wSet->sync) {
+                wSet->frameMin_usec = fTime;
+            }
+
+            wSet->frames++;
+            wSet->sync = true;
+            return true;
+        }
+    } else {
+        wSet->lastUsed = (wSet->lastUsed + 1) % PWM_HISTORY;
+        wSet->pulseH_us10[wSet->lastUsed] = time_us10;
+    }
+
+    return false;
+}
+
+boolean PPMDecoder::pwmTimeout(pwm_t* wSet, bool level) {
+
+    wSet->sync = false;
+    wSet->miss++;
+
+    wSet->lastUsed = (wSet->lastUsed + 1) % PWM_HISTORY;
+
+    if( level) {
+        wSet->pulseL_us10[wSet->lastUsed] = 0;
+        wSet->pulseH_us10[wSet->lastUsed] = 1;
+    }
+    else {
+        wSet->pulseL_us10[wSet->lastUsed] = 1;
+        wSet->pulseH_us10[wSet->lastUsed] = 0;
+    }
+
+    return true;
+}
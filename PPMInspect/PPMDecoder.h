@@ -0,0 +1,266 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _PPMDecoder_h_
+#define _PPMDecoder_h_
+
+#include "Config.h"
+#include "TextUI.h"
+
+typedef struct ppm_t {
+  
+    bool     sync;
+    uint8_t  channels;
+    uint16_t frameMin_usec;
+    uint16_t frameMax_usec;
+    /* Pulse and channel times in 0.1 usec */
+    uint16_t pulseMin_us10;
+    uint16_t pulseMax_us10;
+    /* Signal levels of the last frame, average and range */
+    fixfloat1_t vLevel_low;
+    fixfloat2_t vLevel_high;
+    fixfloat1_t vLevelMin_low;
+    fixfloat1_t vLevelMax_low;
+    fixfloat1_t vLevelMin_high;
+    fixfloat1_t vLevelMax_high;
+    bool     pulseLevel;
+    uint32_t frames;
+    uint16_t badFrames;
+    uint16_t badCount;
+    uint16_t badPulse;
+    uint16_t droppedEdges;
+    uint16_t channel_us10[PPM_MAX_CHANNELS];
+    uint16_t channelMin_us10[PPM_MAX_CHANNELS];
+    uint16_t channelMax_us10[PPM_MAX_CHANNELS];
+} ppm_t;
+
+/* Longest PWM edge time in 1/16 usec, toUs10() needs it below 2^28 */
+#define PWM_EDGE_MAX_Q4    ((1UL << 28) - 1)
+
+/* Running channel statistics.
+ * Exponential moving average over about 2^PPM_STATS_SHIFT frames.
+ * Only shifts, no division per frame.
+ */
+#define PPM_STATS_SHIFT     4
+/* Jitter histogram, 1 usec per bin, centered at the running mean */
+#define PPM_JITTER_BINS    16
+/* Counts are 4 bit, two bins per byte */
+#define PPM_JITTER_MAX     15
+
+typedef struct ppmstats_t {
+
+    uint32_t mean_q8[PPM_MAX_CHANNELS];   /* usec * 256 */
+    uint32_t var_q8[PPM_MAX_CHANNELS];    /* usec^2 * 256 */
+    /* Bin 2n in the low nibble of byte n, bin 2n+1 in the high nibble */
+    uint8_t  jitter[PPM_MAX_CHANNELS][PPM_JITTER_BINS / 2];
+} ppmstats_t;
+
+/* Count of jitter histogram bin b of channel ch */
+static inline uint8_t ppmJitter(const ppmstats_t *st, uint8_t ch, uint8_t b) {
+
+    return (b & 1) ? (st->jitter[ch][b >> 1] >> 4) : (st->jitter[ch][b >> 1] & 0x0f);
+}
+
+/* Reason of a bad frame capture */
+#define FORENSIC_NONE            0
+#define FORENSIC_LONGFRAME       1
+#define FORENSIC_CHCOUNT         2
+#define FORENSIC_PULSE           3
+
+/* Context frames, the bad frame and one spare slot the decoder keeps
+ * using while the capture is frozen.
+ */
+#define FORENSIC_SLOTS  (FORENSIC_PRE_FRAMES + 1 + FORENSIC_POST_FRAMES + 1)
+
+/* Raw pulse and gap times of one frame, starting with the pulse after sync */
+typedef struct ppmframe_t {
+
+    uint8_t  count;
+    uint16_t pulse_usec[PPM_MAX_PULSE];
+} ppmframe_t;
+
+/* Ring of raw frames. The decoder works directly in the current slot.
+ * A frame is kept by advancing the slot index, nothing is copied.
+ */
+typedef struct forensic_t {
+
+    ppmframe_t frame[FORENSIC_SLOTS];
+    uint8_t  reason;      /* FORENSIC_NONE while armed */
+    uint8_t  badSlot;     /* Slot of the offending frame */
+    uint8_t  postFrames;  /* Frames still to capture after the bad frame */
+    bool     frozen;      /* Capture complete */
+} forensic_t;
+
+#define PWM_HISTORY 10
+
+typedef struct pwm_t {
+  
+    bool     sync;
+    uint32_t frameMin_usec;
+    uint32_t frameMax_usec;
+    uint32_t frames;
+    uint32_t miss;
+
+    int8_t   lastUsed;
+    /* 0.1 usec */
+    uint32_t pulseL_us10[PWM_HISTORY];
+    uint32_t pulseH_us10[PWM_HISTORY];
+} pwm_t;
+
+/* h * 10000 stays within 32 bit below this */
+#define PWM_DUTY_MAX_US10  (UINT32_MAX / 10000)
+
+/* Duty cycle of history entry i in 0.01 %.
+ * From 21.5 msec on both times are scaled down first, no 64 bit division.
+ */
+static inline uint16_t pwmDuty(const pwm_t *p, int8_t i) {
+
+    uint32_t h = p->pulseH_us10[i];
+    uint32_t l = p->pulseL_us10[i];
+
+    if (h == 0) {
+        return 0;
+    }
+    if (l == 0) {
+        return 10000;
+    }
+    while (h + l > PWM_DUTY_MAX_US10) {
+        h >>= 1;
+        l >>= 1;
+    }
+    return (uint16_t)(h * 10000 / (h + l));
+}
+
+/* Detect PPM steps */
+#define DETECT_STEP_INIT         0
+#define DETECT_STEP_SYNCWAIT     1
+#define DETECT_STEP_CHANNELWAIT  2
+#define DETECT_STEP_VERIFY       3
+#define DETECT_STEP_SYNCED       4
+
+/* Detect PWM only */
+#define DETECT_STEP_PWM          5
+
+/* Timestamp resolution. Ticks per usec as a power of 2. */
+/* Timer 1 prescaler /8, 0.5 usec */
+#define DECODER_SHIFT_500NS      1
+/* Timer 1 prescaler /1, 62.5 nsec */
+#define DECODER_SHIFT_62NS       4
+
+/*
+ * Hardware independent PPM and PWM decoder.
+ *
+ * The decoder is fed with edges. Each edge is a timestamp in timer ticks
+ * (0.5 usec or 62.5 nsec, 32 bit, Timer 1 extended by counting overflows)
+ * and the signal level after the edge. Decoded values go into the ppm_t / pwm_t
+ * write set passed by the caller.
+ *
+ * Edge times are kept in 1/16 usec, one 62.5 nsec tick, so both resolutions
+ * only need shifts. Frame detection works in whole usec like the settings.
+ * Pulse and channel times are stored in 0.1 usec.
+ *
+ * All methods returning boolean return 'true' if the write set is
+ * consistent and should be published to the reader.
+ *
+ * The decoder does not touch any AVR register. It is driven by the
+ * capture ISR on the target and by PPMHost/PPMReplay on Linux.
+ */
+class PPMDecoder {
+
+    private:
+        uint8_t  detectStep = DETECT_STEP_INIT;
+        uint8_t  channels;
+        uint8_t  detectedChannels;
+        uint8_t  pulseIdx;
+        /* Current slot in forensic.frame[]. Holds the pulses of the current frame. */
+        uint8_t  frameSlot = 0;
+        forensic_t forensic;
+
+        /* Timestamp of the previous edge and of the last sync edge */
+        uint32_t lastTicks;
+        uint32_t frameStartTicks;
+
+        /* DECODER_SHIFT_500NS or DECODER_SHIFT_62NS */
+        uint8_t  tickShift = DECODER_SHIFT_500NS;
+        /* Time since the previous edge and the previous pulse in 1/16 usec */
+        uint32_t edge_q4;
+        uint32_t prevPulse_q4;
+
+        /* Set holding the running channel min/max to carry forward.
+         * nullptr means the write set itself.
+         */
+        const ppm_t *carrySet = nullptr;
+
+        /* Not triple buffered. Channel statistics are updated in place. */
+        ppmstats_t stats;
+        bool statsSeeded;
+
+        uint32_t edgeTicks( uint32_t ticks);
+        uint16_t edgeTime( uint32_t ticks);
+        void countChannels( ppm_t *wSet, uint16_t time_usec, bool level);
+        void initTimings( ppm_t *wSet);
+        boolean storeFrame( ppm_t *wSet, uint16_t time_usec, bool level);
+        void storePulse( ppm_t *wSet, uint16_t time_usec);
+        void storeFrameTime( ppm_t *wSet, uint16_t frame_usec);
+        void storeServoTime( ppm_t *wSet, uint32_t servo_q4);
+        void storeStats( uint32_t servo_q4);
+        void nextFrame();
+        void badFrame( uint8_t reason);
+        uint16_t *pulses() { return forensic.frame[frameSlot].pulse_usec; }
+
+    public:
+        /* Restart detection. step is DETECT_STEP_INIT or DETECT_STEP_PWM,
+         * shift is the timestamp resolution DECODER_SHIFT_*.
+         */
+        void reset( uint8_t step, uint32_t ticks, uint8_t shift = DECODER_SHIFT_500NS);
+
+        /* 1/16 usec to 0.1 usec, rounded. q4 must be below 2^28. */
+        static uint32_t toUs10( uint32_t q4) { return (q4 * 5 + 4) >> 3; }
+        uint8_t getDetectStep() const { return detectStep; }
+        /* Channels of the current frame stored so far, 0 if not synced.
+         * Goes up by one on the edge that ends a channel.
+         */
+        uint8_t getStoredChannels() const { return (detectStep == DETECT_STEP_SYNCED) ? channels : 0; }
+
+        const ppmstats_t *getStats() const { return &stats; }
+
+        const forensic_t *getForensic() const { return &forensic; }
+        /* Discard a captured bad frame and wait for the next one */
+        void rearmForensic();
+
+        /* Called after a write set switch with the set just published */
+        void setCarrySet( const ppm_t *cSet) { carrySet = cSet; }
+
+        boolean ppmEdge( ppm_t *wSet, uint32_t ticks, bool level);
+        /* No edge within PPM_TIMEOUT_OVERFLOWS timer periods */
+        boolean ppmTimeout( ppm_t *wSet);
+
+        boolean pwmEdge( pwm_t *wSet, uint32_t ticks, bool level);
+        /* No edge within PWM_TIMEOUT_OVERFLOWS timer periods. level is the current input level */
+        boolean pwmTimeout( pwm_t *wSet, bool level);
+};
+
+#endif
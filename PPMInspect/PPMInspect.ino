@@ -47,6 +47,8 @@
  *   Button 3   7 (Port PD7 PCINT23 PCI2)
  *   Analog In A3 (Port PC3)
  *   PPM In     8 (Port PB0 ICP1)
+ *   Servo In   8 - 13 (Port PB0 - PB5 PCINT0 - PCINT5 PCI0)
+ *   PWM In     9 (Port PB1 PCINT1 PCI0, latency scan)
  *   Vcc       A0
  *   
  * Timer
@@ -55,21 +57,28 @@
  *   Timer 1  16 bit       PPM Timing (See PPM.cpp)
  */
 
+#include <avr/sleep.h>
+
 #include "Config.h"
 #include "TextUI.h"
 
 #include "TextUILcdSSD1306.h"
-#include "TextUISimpleKbd.h"
+#include "TextUIPcintKbd.h"
 
 #include "PPM.h"
 
 #include "HomeScreen.h"
 #include "DataScreen.h"
 #include "PWMScreen.h"
+#include "ServoScreen.h"
+#include "LatencyScreen.h"
 #include "ScopeScreen.h"
+#include "LogicScreen.h"
 #include "ChannelScreen.h"
+#include "ForensicScreen.h"
 #include "VMeterScreen.h"
 #include "ConfigScreen.h"
+#include "StreamScreen.h"
 
 
 #ifdef ENABLE_MEMDEBUG
@@ -84,10 +93,15 @@ extern config_t settings;
 
 DataScreen dataScreen(ppm);
 PWMScreen pwmScreen(ppm);
+ServoScreen servoScreen(ppm);
+LatencyScreen latencyScreen(ppm);
 ScopeScreen scopeScreen(ppm);
+LogicScreen logicScreen(ppm);
 ChannelScreen channelScreen(ppm);
+ForensicScreen forensicScreen(ppm);
 VMeterScreen vMeterScreen(ppm);
 ConfigScreen configScreen(ppm);
+StreamScreen streamScreen(ppm);
 
 uint8_t buttons[BUTTON_COUNT] = { BUTTON_PORTS };
 uint8_t skeys[BUTTON_COUNT] = { BUTTON_SHORT_KEYS };
@@ -95,10 +109,12 @@ uint8_t lkeys[BUTTON_COUNT] = { BUTTON_LONG_KEYS };
 
 void setup()
 {
+    Serial.begin(SERIAL_BAUD);
+
     configScreen.load();
 
     textUI.setDisplay(new TextUILcdSSD1306( &SH1106_128x64 ));
-    textUI.setInput(new TextUISimpleKbd(BUTTON_COUNT, buttons, skeys, lkeys));
+    textUI.setInput(new TextUIPcintKbd(BUTTON_COUNT, buttons, skeys, lkeys));
     textUI.setReversedNav( true);
 
     textUI.setTimer(500);
@@ -111,15 +127,46 @@ void setup()
 
 void loop()
 {
-    Event *e = textUI.getEvent();
+    Event *e;
+
+    ppm.processEdges();
+
+    e = textUI.getEvent();
 
-    if( checkBattery(e)) {
-        textUI.handle(e);
+    if( e->getType() != EVENT_TYPE_NONE || textUI.isBusy()) {
+        if( checkBattery(e)) {
+            textUI.handle(e);
+        }
     }
     
 #ifdef ENABLE_MEMDEBUG
     MEMDEBUG_CHECK();
 #endif
+
+    if( e->getType() == EVENT_TYPE_NONE && !textUI.isBusy()) {
+        idle();
+    }
+}
+
+/*
+ * Sleep until the next interrupt unless edges are waiting.
+ * Capture, keyboard, TWI, ADC and Serial interrupts wake up the loop.
+ * Timer 0 (millis) wakes up every 1.024 msec, so timer and tick events
+ * are on time. SLEEP_MODE_IDLE keeps all peripherals running.
+ */
+void idle()
+{
+    set_sleep_mode( SLEEP_MODE_IDLE);
+    cli();
+    if( ppm.edgesPending()) {
+        sei();
+        return;
+    }
+    sleep_enable();
+    /* sei() takes effect after the next instruction. An interrupt can not slip in before sleep_cpu(). */
+    sei();
+    sleep_cpu();
+    sleep_disable();
 }
 
 /*
@@ -142,7 +189,11 @@ bool checkBattery(Event *e)
         
         } else if( count >= 20) { // 10 Seconds
             
-            v = ppm.readVCC();
+            if( !ppm.fetchADC( ADC_VCC, &v)) {
+                // Result is there with the next timer event
+                ppm.requestADC( ADC_VCC);
+                return true;
+            }
         
             if( v < settings.lowBattWarn ) {
                 // Show battery warning
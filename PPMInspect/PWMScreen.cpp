@@ -164,7 +164,7 @@ void PWMScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
     }
     else if (row == 2) {
         if (col == 0) {
-            cell->setInt16(13, currentData->pulseL_usec[currentData->lastUsed], 5, 0, 0);
+            cell->setFloat1(11, currentData->pulseL_us10[currentData->lastUsed], 7, 0, 0);
         }
         else {
             cell->setLabel(19, F("us"), 2);
@@ -172,7 +172,7 @@ void PWMScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
     }
     else if (row == 3) {
         if (col == 0) {
-            cell->setInt16(13, currentData->pulseH_usec[currentData->lastUsed], 5, 0, 0);
+            cell->setFloat1(11, currentData->pulseH_us10[currentData->lastUsed], 7, 0, 0);
         }
         else {
             cell->setLabel(19, F("us"), 2);
@@ -180,17 +180,7 @@ void PWMScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
     }
     else if (row == 4) {
         if (col == 0) {
-            fixfloat2_t duty;
-            long H = currentData->pulseH_usec[currentData->lastUsed];
-            long L = currentData->pulseL_usec[currentData->lastUsed];
-            if( H == 0 ) {
-                duty = 0;
-            } else if( L == 0 ) {
-                duty = 10000;
-            } else {
-                duty = H * 10000 / (H+L);
-            }
-            cell->setFloat2(12, duty, 6, 0, 0);
+            cell->setFloat2(12, pwmDuty(currentData, currentData->lastUsed), 6, 0, 0);
         }
         else {
             cell->setLabel(19, F("%"), 1);
@@ -199,12 +189,12 @@ void PWMScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
     else if (row == 5) {
         if (col == 0) {
             fixfloat2_t freq;
-            long H = currentData->pulseH_usec[currentData->lastUsed];
-            long L = currentData->pulseL_usec[currentData->lastUsed];
+            long H = currentData->pulseH_us10[currentData->lastUsed];
+            long L = currentData->pulseL_us10[currentData->lastUsed];
             if( H == 0 || L == 0) {
                 freq = 0;
             } else {
-                freq = 100000000L / (H+L); // 2 digits right of dot
+                freq = 1000000000L / (H+L); // 2 digits right of dot, H and L in 0.1 usec
             }
             cell->setFloat2(9, freq, 9, 0, 0);
         }
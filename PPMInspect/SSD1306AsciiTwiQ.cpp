@@ -0,0 +1,134 @@
+/*
+  TextUI. A simple text based UI.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <util/atomic.h>
+
+#include "SSD1306AsciiTwiQ.h"
+
+static TwiQueue twiQueue;
+
+static inline void twiAction( uint8_t action) {
+
+  switch( action) {
+
+  case TWIQ_ACT_START:
+    TWCR = bit(TWINT) | bit(TWSTA) | bit(TWEN) | bit(TWIE);
+    break;
+
+  case TWIQ_ACT_SEND:
+    TWDR = twiQueue.data;
+    TWCR = bit(TWINT) | bit(TWEN) | bit(TWIE);
+    break;
+
+  case TWIQ_ACT_STOP:
+    /* No interrupt after the stop condition */
+    TWCR = bit(TWINT) | bit(TWSTO) | bit(TWEN);
+    break;
+  }
+}
+
+ISR(TWI_vect) {
+
+  twiAction( twiQueue.event( TWSR & 0xf8));
+}
+
+/* Start the bus if it is idle. Call with interrupts disabled. */
+static void twiStart() {
+
+  if( twiQueue.start()) {
+    /* A stop condition may still be on its way */
+    while( TWCR & bit(TWSTO))
+      ;
+    twiAction( TWIQ_ACT_START);
+  }
+}
+
+void SSD1306AsciiTwiQ::begin( const DevType* dev, uint8_t i2cAddr) {
+
+  twiQueue.begin( i2cAddr);
+
+  /* Internal pull-ups, like Wire */
+  digitalWrite( SDA, HIGH);
+  digitalWrite( SCL, HIGH);
+
+  /* Prescaler 1 */
+  TWSR = 0;
+  TWBR = ((F_CPU / TWIQ_CLOCK) - 16) / 2;
+  TWCR = bit(TWEN);
+
+  init( dev);
+}
+
+void SSD1306AsciiTwiQ::writeDisplay( uint8_t b, uint8_t mode) {
+
+  uint8_t kind = (mode == SSD1306_MODE_CMD) ? TWIQ_CMD : TWIQ_DATA;
+  /* SSD1306_MODE_RAM ends a buffered transfer like the Wire driver does */
+  bool last = (mode == SSD1306_MODE_RAM);
+  bool done;
+
+  for( ;;) {
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE) {
+      done = twiQueue.put( b, kind, last);
+      twiStart();
+    }
+
+    if( done) {
+      break;
+    }
+
+    if( !(SREG & bit(SREG_I))) {
+      /* Queue full with interrupts disabled. Drive the TWI by polling. */
+      while( !(TWCR & bit(TWINT)))
+        ;
+      twiAction( twiQueue.event( TWSR & 0xf8));
+    }
+  }
+}
+
+void SSD1306AsciiTwiQ::flush() {
+
+  ATOMIC_BLOCK( ATOMIC_RESTORESTATE) {
+    twiQueue.close();
+    twiStart();
+  }
+
+  while( !twiQueue.idle()) {
+    if( !(SREG & bit(SREG_I)) && (TWCR & bit(TWINT))) {
+      twiAction( twiQueue.event( TWSR & 0xf8));
+    }
+  }
+}
+
+uint16_t SSD1306AsciiTwiQ::errors() {
+
+  uint16_t e;
+
+  ATOMIC_BLOCK( ATOMIC_RESTORESTATE) {
+    e = twiQueue.errors;
+  }
+
+  return e;
+}
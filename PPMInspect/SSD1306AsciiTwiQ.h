@@ -0,0 +1,72 @@
+/*
+  TextUI. A simple text based UI.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _SSD1306AsciiTwiQ_h_
+#define _SSD1306AsciiTwiQ_h_
+
+#include "SSD1306Ascii.h"
+#include "TwiQueue.h"
+
+/* I2C clock */
+#define TWIQ_CLOCK   400000L
+
+/**
+ * @brief SSD1306Ascii driver with interrupt driven I2C transfers.
+ *
+ * Display bytes go into a TwiQueue and are sent by the TWI interrupt.
+ * Drawing only waits if the queue is full.
+ * Replaces Wire, it uses the TWI hardware directly.
+ * Only one display is supported.
+ */
+class SSD1306AsciiTwiQ : public SSD1306Ascii {
+
+  public:
+    /**
+     * @brief Set up the TWI and initialize the display.
+     * 
+     * @param dev Pointer to a OLED controller device structure.
+     * @param i2cAddr 7 bit I2C address.
+     */
+    void begin( const DevType* dev, uint8_t i2cAddr);
+
+    /**
+     * @brief Wait until all queued bytes are sent.
+     *
+     * Needed before anything that relies on the display content,
+     * e.g. before blocking with interrupts disabled.
+     */
+    void flush();
+
+    /**
+     * @return Transfers dropped because the display did not answer.
+     */
+    uint16_t errors();
+
+  protected:
+    void writeDisplay( uint8_t b, uint8_t mode);
+};
+
+#endif
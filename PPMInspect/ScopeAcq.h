@@ -0,0 +1,454 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _ScopeAcq_h_
+#define _ScopeAcq_h_
+
+#include "Arduino.h"
+#include "Config.h"
+#include "CaptureStore.h"
+
+/* Acquisition state */
+#define ACQ_IDLE        0
+/* Waiting for the trigger */
+#define ACQ_ARMED       1
+/* Storing samples */
+#define ACQ_RUNNING     2
+/* Buffer complete */
+#define ACQ_DONE        3
+
+/* Events returned by sample() */
+#define ACQ_EV_NONE     0
+/* Trigger found. Switch to the sample period. */
+#define ACQ_EV_TRIGGER  1
+/* Buffer complete. Stop the ADC. */
+#define ACQ_EV_DONE     2
+/* Equivalent time sampling: schedule the next conversion sampleTicks later */
+#define ACQ_EV_NEXT     3
+/* Equivalent time sampling: pass complete, wait for the next edge */
+#define ACQ_EV_PASS     4
+
+/* Equivalent time sampling: earliest first sample after the edge.
+ * Covers capture ISR latency.
+ */
+#define ACQ_ETS_MIN_TICKS   20
+
+/* triggerMode */
+#define ACQ_TRIGGER_FREE     0
+#define ACQ_TRIGGER_RISING   1
+#define ACQ_TRIGGER_FALLING  2
+
+/* oversampling */
+#define ACQ_OS_OFF           0
+/* Average 2, 4 or 8 conversions, depending on the sample period */
+#define ACQ_OS_AVERAGE       1
+/* Min and max of all conversions at SCOPE_ARM_USEC within the sample period */
+#define ACQ_OS_PEAK          2
+/* Deep capture: compressed samples after the trigger, see CaptureStore.h */
+#define ACQ_OS_DEEP          3
+
+/* Scope settings */
+typedef struct scopeparam_t {
+    uint16_t resUsec;            /* Time between samples */
+    uint16_t triggerDelay;       /* usec, see MANUAL.md */
+    int16_t  triggerLevel;       /* 0.1 V */
+    uint8_t  oversampling;       /* ACQ_OS_* */
+    uint8_t  triggerMode;        /* ACQ_TRIGGER_* */
+    uint8_t  pretrigger;         /* Percent of the samples before the trigger */
+} scopeparam_t;
+
+/*
+ * Hardware independent scope acquisition.
+ *
+ * sample() gets called from the ADC ISR with every auto triggered conversion.
+ * While armed the ADC runs at SCOPE_ARM_USEC and sample() looks for the trigger.
+ * A trigger is only accepted if no other trigger was seen during the
+ * holdoff samples before. The two samples around the trigger are stored first,
+ * the remaining samples are taken at the sample period.
+ *
+ * With pre-trigger the ADC runs at the sample period from the start.
+ * Samples run round robin through the buffer until the trigger fires
+ * after at least pre samples. Then the remaining samples are stored.
+ * The capture starts at getFirst() and the trigger sample is at index pre.
+ *
+ * With oversampling the ADC runs oversampling times faster and
+ * the average is stored.
+ * Peak detect runs the ADC at SCOPE_ARM_USEC and stores max and min
+ * of each sample period. A spike shorter than the sample period stays visible.
+ * The trigger then looks at the max (rising) or min (falling) values.
+ *
+ * The caller runs the ADC every startTicks and switches to sampleTicks
+ * on ACQ_EV_TRIGGER.
+ *
+ * Sample periods below SCOPE_ARM_USEC use equivalent time sampling (ETS)
+ * on a repetitive signal. The trigger is an edge on the digital input,
+ * timestamped by Timer 1 input capture. Each edge starts one pass that
+ * samples every SCOPE_ARM_USEC. The first sample of the pass is delayed
+ * by the pass number times the sample period. Pass p fills indices
+ * p, p + phases, p + 2 * phases ... where phases = SCOPE_ARM_USEC / resUsec.
+ * The record starts at triggerDelay minus the pre-trigger part after the edge,
+ * but not before ACQ_ETS_MIN_TICKS. pre is taken from the start actually used,
+ * it is 0 if the trigger point lies before the first sample.
+ *
+ * Deep capture stores up to SCOPE_DEEP_SAMPLES compressed samples into the
+ * whole sample buffer, starting with the two samples around the trigger.
+ * No pre-trigger and no oversampling.
+ *
+ * Sample periods from SCOPE_ROLL_USEC on run in roll mode. There is no trigger
+ * and the capture never completes. Samples run round robin through the buffer,
+ * getFirst() is the oldest one and rolled counts the samples stored.
+ */
+class ScopeAcq {
+
+    private:
+        /* Samples, followed by the peak detect minimum. Deep capture uses all of it. */
+        uint8_t  buf[2 * SCOPE_SAMPLES];
+        uint8_t  sz;
+        uint8_t  pos;
+        uint8_t  first;
+        uint8_t  remaining;
+
+        uint8_t  triggerMode;
+        uint8_t  level;
+        uint8_t  prev;
+        uint8_t  pre;
+        uint8_t  filled;
+        uint16_t holdoff;
+        uint16_t quiet;
+
+        /* Peak detect at 10 msec takes 1000 conversions per sample */
+        uint16_t oversampling;
+        uint8_t  shift;
+        uint16_t osCount;
+        uint16_t sum;
+        bool     peak;
+        uint8_t  peakMin;
+        uint8_t  peakMax;
+
+        bool     deep;
+        CaptureStore store;
+
+        bool     roll;
+
+        /* Equivalent time sampling */
+        bool     ets;
+        uint8_t  phases;
+        uint8_t  phase;
+        uint16_t phaseTicks;
+        uint16_t etsStart;
+
+        inline bool crossing( uint8_t v) const {
+            return (triggerMode == ACQ_TRIGGER_RISING && prev < level && v > level)
+                || (triggerMode == ACQ_TRIGGER_FALLING && prev > level && v < level);
+        }
+
+    public:
+        volatile uint8_t state;
+        /* Roll mode, samples stored so far. Wraps. */
+        volatile uint8_t rolled;
+
+        /* Timer ticks (0.5 usec) between conversions */
+        uint16_t startTicks;
+        uint16_t sampleTicks;
+
+        /* Set up a new capture of sz samples. */
+        void start( uint8_t sz, const scopeparam_t *param) {
+
+            uint16_t resUsec = param->resUsec;
+
+            /* Oversampling depends on the sample period */
+            oversampling = 1;
+            shift = 0;
+            peak = (param->oversampling == ACQ_OS_PEAK);
+            deep = (param->oversampling == ACQ_OS_DEEP);
+            roll = !deep && resUsec >= SCOPE_ROLL_USEC;
+            if (peak) {
+                oversampling = (resUsec > SCOPE_ARM_USEC) ? resUsec / SCOPE_ARM_USEC : 1;
+            }
+            else if (param->oversampling == ACQ_OS_AVERAGE && resUsec >= 50) {
+                shift = (resUsec < 100) ? 1 : (resUsec < 200) ? 2 : 3;
+                oversampling = 1 << shift;
+            }
+
+            this->sz = (sz > SCOPE_SAMPLES) ? SCOPE_SAMPLES : sz;
+            triggerMode = param->triggerMode;
+            ets = (resUsec < SCOPE_ARM_USEC);
+            if (roll) {
+                triggerMode = ACQ_TRIGGER_FREE;
+                /* Nothing left over from an earlier capture */
+                memset(buf, 0, sizeof(buf));
+            }
+            /* 15.3V == 255 */
+            level = (uint8_t)(param->triggerLevel * 5 / 3);
+
+            /* *2 because of 0.5 usec timer resolution */
+            sampleTicks = peak ? SCOPE_ARM_USEC << 1 : (resUsec << 1) >> shift;
+
+            if (ets) {
+                /* No holdoff, triggerDelay places the record */
+                uint16_t window = (uint16_t)this->sz * resUsec;
+                uint16_t before = window * param->pretrigger / 100;
+                uint16_t start = (param->triggerDelay > before) ? param->triggerDelay - before : 0;
+
+                etsStart = (start << 1 < ACQ_ETS_MIN_TICKS) ? ACQ_ETS_MIN_TICKS : start << 1;
+                /* Less pre-trigger than asked for if the start was moved */
+                start = etsStart >> 1;
+                pre = (param->triggerDelay > start) ? (param->triggerDelay - start) / resUsec : 0;
+                holdoff = 0;
+                oversampling = 1;
+                shift = 0;
+                peak = false;
+                deep = false;
+                phases = SCOPE_ARM_USEC / resUsec;
+                phaseTicks = resUsec << 1;
+                phase = 0;
+                sampleTicks = SCOPE_ARM_USEC << 1;
+                startTicks = sampleTicks;
+                if (triggerMode == ACQ_TRIGGER_FREE) {
+                    triggerMode = ACQ_TRIGGER_RISING;
+                }
+            }
+            else if (triggerMode == ACQ_TRIGGER_FREE) {
+                pre = 0;
+                holdoff = 0;
+                startTicks = sampleTicks;
+            }
+            else if (param->pretrigger && !deep) {
+                /* The trigger is searched at the sample period */
+                pre = (uint16_t)this->sz * param->pretrigger / 100;
+                if (pre >= this->sz) {
+                    pre = this->sz - 1;
+                }
+                holdoff = param->triggerDelay / resUsec;
+                startTicks = sampleTicks;
+            }
+            else {
+                pre = 0;
+                holdoff = param->triggerDelay / SCOPE_ARM_USEC;
+                startTicks = SCOPE_ARM_USEC << 1;
+            }
+
+            /* The first sample never triggers */
+            prev = level;
+            quiet = 0;
+            filled = 0;
+            pos = 0;
+            first = 0;
+            remaining = this->sz;
+            rolled = 0;
+            osCount = 0;
+            sum = 0;
+            peakMin = 255;
+            peakMax = 0;
+            store.begin(buf, sizeof(buf));
+
+            state = (triggerMode == ACQ_TRIGGER_FREE) ? ACQ_RUNNING : ACQ_ARMED;
+        }
+
+        void stop() { state = ACQ_IDLE; }
+
+        bool isETS() const { return ets; }
+        bool isDeep() const { return deep; }
+        bool isRoll() const { return roll; }
+        /* Deep capture samples */
+        const CaptureStore *getStore() const { return &store; }
+        /* ETS trigger edge, ACQ_TRIGGER_RISING or ACQ_TRIGGER_FALLING */
+        uint8_t getTriggerMode() const { return triggerMode; }
+
+        /*
+         * ETS: the trigger edge was captured elapsed ticks ago. Called from the capture ISR.
+         * Returns the ticks from the edge to the first sample of the pass.
+         * Returns 0 if the edge is ignored because it is too late to
+         * schedule the first sample.
+         */
+        inline uint16_t etsTrigger( uint16_t elapsed) {
+
+            uint16_t offset;
+
+            if (state != ACQ_ARMED) {
+                return 0;
+            }
+
+            offset = etsStart + phase * phaseTicks;
+            if (elapsed + 2 >= offset) {
+                return 0;
+            }
+
+            pos = phase;
+            state = ACQ_RUNNING;
+
+            return offset;
+        }
+
+        /* Samples are stored round robin. The capture starts at getFirst(). */
+        uint8_t getFirst() const { return roll ? pos : first; }
+        uint8_t getPre() const { return pre; }
+        const uint8_t *getSamples() const { return buf; }
+        /* Minimum per sample with peak detect, otherwise nullptr */
+        const uint8_t *getMinSamples() const { return peak ? buf + SCOPE_SAMPLES : nullptr; }
+
+        inline uint8_t sample( uint8_t v) {
+
+            if (ets) {
+
+                if (state != ACQ_RUNNING) {
+                    return ACQ_EV_NONE;
+                }
+
+                buf[pos] = v;
+                pos += phases;
+
+                if (pos < sz) {
+                    return ACQ_EV_NEXT;
+                }
+
+                if (++phase < phases) {
+                    state = ACQ_ARMED;
+                    return ACQ_EV_PASS;
+                }
+
+                state = ACQ_DONE;
+                return ACQ_EV_DONE;
+            }
+
+            if (state == ACQ_ARMED && pre == 0) {
+
+                if (quiet < holdoff) {
+                    quiet++;
+                }
+
+                if (crossing(v)) {
+
+                    if (quiet >= holdoff) {
+                        if (deep) {
+                            store.put(prev);
+                            store.put(v);
+                            state = ACQ_RUNNING;
+                            return ACQ_EV_TRIGGER;
+                        }
+                        buf[0] = buf[SCOPE_SAMPLES] = prev;
+                        buf[1] = buf[SCOPE_SAMPLES + 1] = v;
+                        pos = 2;
+                        remaining = sz - 2;
+                        state = ACQ_RUNNING;
+                        return ACQ_EV_TRIGGER;
+                    }
+
+                    quiet = 0;
+                }
+
+                prev = v;
+            }
+            else if (state == ACQ_ARMED || state == ACQ_RUNNING) {
+
+                if (peak) {
+                    if (v < peakMin) {
+                        peakMin = v;
+                    }
+                    if (v > peakMax) {
+                        peakMax = v;
+                    }
+                }
+                else {
+                    sum += v;
+                }
+
+                if (++osCount < oversampling) {
+                    return ACQ_EV_NONE;
+                }
+
+                osCount = 0;
+
+                if (deep) {
+                    sum = 0;
+                    if (!store.put(v) || store.getSamples() >= SCOPE_DEEP_SAMPLES) {
+                        state = ACQ_DONE;
+                        return ACQ_EV_DONE;
+                    }
+                    return ACQ_EV_NONE;
+                }
+
+                if (peak) {
+                    buf[pos] = peakMax;
+                    buf[SCOPE_SAMPLES + pos] = peakMin;
+                    v = (triggerMode == ACQ_TRIGGER_FALLING) ? peakMin : peakMax;
+                    peakMin = 255;
+                    peakMax = 0;
+                }
+                else {
+                    v = (uint8_t)(sum >> shift);
+                    sum = 0;
+                    buf[pos] = v;
+                }
+                if (++pos >= sz) {
+                    pos = 0;
+                }
+
+                if (state == ACQ_RUNNING) {
+
+                    if (roll) {
+                        rolled++;
+                    }
+                    else if (--remaining == 0) {
+                        state = ACQ_DONE;
+                        return ACQ_EV_DONE;
+                    }
+                }
+                else {
+                    /* Armed with pre-trigger */
+                    if (quiet < holdoff) {
+                        quiet++;
+                    }
+
+                    if (crossing(v)) {
+
+                        if (filled >= pre && quiet >= holdoff) {
+                            /* v is the trigger sample at index pre */
+                            first = (pos >= pre + 1) ? pos - pre - 1 : pos + sz - pre - 1;
+                            remaining = sz - pre - 1;
+                            if (remaining == 0) {
+                                state = ACQ_DONE;
+                                return ACQ_EV_DONE;
+                            }
+                            state = ACQ_RUNNING;
+                            return ACQ_EV_NONE;
+                        }
+
+                        quiet = 0;
+                    }
+
+                    if (filled < pre) {
+                        filled++;
+                    }
+                    prev = v;
+                }
+            }
+
+            return ACQ_EV_NONE;
+        }
+};
+
+#endif
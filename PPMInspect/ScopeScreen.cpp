@@ -42,20 +42,24 @@ const char* triggerModes[TRIGGER_MODES] = {
     "f", "+", "-"
 };
 
-#define RESOLUTION_STEPS 7
+#define RESOLUTION_STEPS 10
 
-/* Resolution per grid division */
+/* Resolution per grid division. Up to 50u equivalent time sampling. */
 const char* resolutionSteps[RESOLUTION_STEPS] = {
+    " 10u"," 20u"," 50u",
     "100u","200u","500u",
     "  1m","  2m","  5m",
     " 10m"
 };
 
-#define OVERSAMPLING_STEPS 2
+#define OVERSAMPLING_STEPS 4
 
+/* Off, average, peak detect, deep capture */
 const char* oversamplingSteps[OVERSAMPLING_STEPS] = {
     " ",
-    "O"
+    "O",
+    "P",
+    "D"
 };
 
 #define RANGE_STEPS 2
@@ -65,6 +69,7 @@ const char* rangeSteps[RANGE_STEPS] = {
     "1V"
 };
 
+/* dataArray holds the maximum, the peak detect minimum is PPM::getMinArray() */
 uint8_t dataArray[ARRAY_SZ];
 uint8_t startIndex;
 uint32_t frame;
@@ -79,6 +84,7 @@ void ScopeScreen::activate(TextUI* ui)
     startIndex = 0;
     frame = 0;
     freeze = false;
+    pan = 0;
 
     for (uint8_t i = 0; i < ARRAY_SZ; i++) {
         dataArray[i] = 0;
@@ -87,6 +93,8 @@ void ScopeScreen::activate(TextUI* ui)
 
 void ScopeScreen::deactivate(TextUI* ui)
 {
+    ppmH.stopScope();
+
     // Make sure we are in scope mode.
     enablePWMMode(false);
 }
@@ -99,8 +107,9 @@ void ScopeScreen::update(TextUI* ui)
     uint32_t left;
     uint8_t idx;
     long scaled;
-    long divisor;
     boolean ok;
+    uint8_t trigX;
+    uint8_t *dataMin = ppmH.getMinArray();
 
     if (freeze) {
         return;
@@ -128,7 +137,7 @@ void ScopeScreen::update(TextUI* ui)
 
                 if (left <= PWM_HISTORY) {
                     idx = (uint8_t)((last + PWM_HISTORY - left) % PWM_HISTORY);
-                    scaled = map(pwm->pulseH_usec[idx], 900, 2100, 0, 55);
+                    scaled = map(pwm->pulseH_us10[idx], 9000, 21000, 0, 55);
                 }
                 else {
                     scaled = 0; // no data for this sample
@@ -152,8 +161,8 @@ void ScopeScreen::update(TextUI* ui)
 
                 if (left <= PWM_HISTORY) {
                     idx = (uint8_t)((last + PWM_HISTORY - left) % PWM_HISTORY);
-                    scaled = pwm->pulseH_usec[idx] + pwm->pulseL_usec[idx];
-                    scaled = map(pwm->pulseH_usec[idx], 0, scaled, 0, 55);
+                    scaled = pwm->pulseH_us10[idx] + pwm->pulseL_us10[idx];
+                    scaled = map(pwm->pulseH_us10[idx], 0, scaled, 0, 55);
                 }
                 else {
                     scaled = 0; // no data for this sample
@@ -172,47 +181,144 @@ void ScopeScreen::update(TextUI* ui)
     else {
         /* The array gotten from fetchArray() is not adjusted. It is raw data from ADC.
          * 15V input is approximately 255.
+         * fetchArray() does not block. It returns false until a new capture is complete.
          */
-        ok = ppmH.fetchArray(dataArray, ARRAY_SZ, resToUSec(resolution), oversampling, triggerMode, triggerLevel, triggerDelay * 100);
+        scopeparam_t param;
 
-        if (ok) {
-        /* We need to map 15.7V == 255 to 2V == 8 because the grid size in Y direction is 8 pixel
-         * and we want 2V per Y grid division.
-         *
-         * 2V == 8 -> 15.7V == 62.8 -> 255/62.8 = 4.06
-         */
-            if (range == 0) { /* 2V / div */
-                divisor = 406;
-            }
-            else if (range == 1) { /* 1V / div */
-                divisor = 203;
-            }
+        param.resUsec = resToUSec(resolution);
+        param.triggerDelay = triggerDelay * 100;
+        param.triggerLevel = triggerLevel;
+        param.oversampling = oversampling;
+        param.triggerMode = triggerMode;
+        param.pretrigger = pretrigger;
+
+        ok = ppmH.fetchArray(dataArray, dataMin, ARRAY_SZ, &param);
+
+        /* Live view starts at the trigger. ETS resolutions do not support deep capture. */
+        pan = 0;
+        if (ok && oversampling == ACQ_OS_DEEP && showDeep(ui)) {
+            return;
+        }
 
-            for (uint8_t x = 0; x < ARRAY_SZ; x++) {
-                scaled = (long)dataArray[x] * 1000 / (1000 + 4 * settings.vppmAdjust);
-                scaled = scaled * 100 / divisor;
-                dataArray[x] = (scaled > 55) ? 55 : scaled;
+        if (ok) {
+            scale(dataArray);
+            if (oversampling == ACQ_OS_PEAK) {
+                scale(dataMin);
             }
         }
     }
 
     if (ok) {
-        lcd->drawGrid(dataArray, ARRAY_SZ, startIndex, 0, 8, 127, 63, grid ? 10 : 0, marker);
+        /* Trigger position as captured, equivalent time sampling may have less
+         * pre-trigger than set. drawGrid() starts with the second sample.
+         */
+        capturePre = (pwmMode || isRollMode() || triggerMode == 0 || pretrigger == 0) ? 0 : ppmH.getScopePre();
+        trigX = capturePre ? capturePre - 1 : 0;
+        /* The PWM scan reuses the scope memory, redraw all */
+        lcd->setGridShadow(pwmMode ? nullptr : ppmH.getGridShadow());
+        lcd->drawGrid(dataArray, (!pwmMode && oversampling == ACQ_OS_PEAK) ? dataMin : nullptr, ARRAY_SZ, startIndex, 0, 8, 127, 63, grid ? 10 : 0, marker, trigX);
         marker = !marker;
     }
 }
 
+/* Map raw ADC values to pixel */
+void ScopeScreen::scale(uint8_t arr[])
+{
+    long scaled;
+    long divisor;
+
+    /* We need to map 15.7V == 255 to 2V == 8 because the grid size in Y direction is 8 pixel
+     * and we want 2V per Y grid division.
+     *
+     * 2V == 8 -> 15.7V == 62.8 -> 255/62.8 = 4.06
+     */
+    if (range == 0) { /* 2V / div */
+        divisor = 406;
+    }
+    else { /* 1V / div */
+        divisor = 203;
+    }
+
+    for (uint8_t x = 0; x < ARRAY_SZ; x++) {
+        scaled = (long)arr[x] * 1000 / (1000 + 4 * settings.vppmAdjust);
+        scaled = scaled * 100 / divisor;
+        arr[x] = (scaled > 55) ? 55 : scaled;
+    }
+}
+
+/*
+ * Decode the visible part of a deep capture.
+ * One pixel covers 1 << zoom samples and is drawn from min to max.
+ */
+boolean ScopeScreen::showDeep(TextUI* ui)
+{
+    uint32_t samples;
+    uint8_t *dataMin = ppmH.getMinArray();
+
+    samples = ppmH.deepWindow(pan, 1 << zoom, dataArray, dataMin, ARRAY_SZ);
+    if (samples == 0) {
+        return false;
+    }
+    deepSamples = samples;
+
+    scale(dataArray);
+    scale(dataMin);
+
+    /* Deep capture has no pretrigger. The trigger is at the left edge of the first screen. */
+    ui->getDisplay()->setGridShadow(ppmH.getGridShadow());
+    ui->getDisplay()->drawGrid(dataArray, dataMin, ARRAY_SZ, 0, 0, 8, 127, 63, grid ? 10 : 0, marker, 0);
+    marker = !marker;
+
+    return true;
+}
+
+/* Move the deep capture view by half a screen. Wraps at both ends. */
+void ScopeScreen::panDeep(TextUI* ui, boolean forward)
+{
+    uint32_t half = (uint32_t)(ARRAY_SZ / 2) << zoom;
+
+    if (forward) {
+        pan = (pan + half < deepSamples) ? pan + half : 0;
+    }
+    else {
+        pan = (pan >= half) ? pan - half : (deepSamples > half ? (deepSamples - 1) / half * half : 0);
+    }
+
+    showDeep(ui);
+}
+
+/* Send the frozen scope display over Serial. Samples are display scaled. */
+void ScopeScreen::sendCapture()
+{
+    adcblock_t blk;
+
+    blk.sample_usec = resToUSec(resolution);
+    blk.triggerDelay_usec = triggerDelay * 100;
+    blk.triggerLevel = triggerLevel;
+    /* 8 pixel per division */
+    blk.lsb_mV = (range == 0) ? 250 : 125;
+    blk.oversampling = oversampling;
+    blk.triggerMode = isRollMode() ? 0 : triggerMode;
+    blk.count = ARRAY_SZ;
+    blk.pretrigger = (blk.triggerMode == 0) ? 0 : capturePre;
+
+    ppmH.sendArray(dataArray, &blk);
+}
+
 /* Resolution per pixel */
 uint16_t ScopeScreen::resToUSec(uint8_t res)
 {
     switch (res) {
-    case 0: return 10;
-    case 1: return 20;
-    case 2: return 50;
-    case 3: return 100;
-    case 4: return 200;
-    case 5: return 500;
-    case 6: return 1000;
+    case 0: return 1;
+    case 1: return 2;
+    case 2: return 5;
+    case 3: return 10;
+    case 4: return 20;
+    case 5: return 50;
+    case 6: return 100;
+    case 7: return 200;
+    case 8: return 500;
+    case 9: return 1000;
     }
 
     return 100;
@@ -251,7 +357,40 @@ void ScopeScreen::handleEvent(TextUI* ui, Event* e)
 {
     if (!ui->inEditMode()) {
 
-        if (e->getType() == EVENT_TYPE_KEY) {
+        if (e->getType() == EVENT_TYPE_KEY && freeze && isDeepMode()) {
+
+            /* Zoom and pan through a frozen deep capture */
+            switch (e->getKey()) {
+
+            case KEY_UP:
+                panDeep(ui, true);
+                e->markProcessed();
+                break;
+
+            case KEY_RESET: // long Up
+                panDeep(ui, false);
+                e->markProcessed();
+                break;
+
+            case KEY_FUNCTION: // long Down
+                zoom = (zoom + 1) % (DEEP_ZOOM_MAX + 1);
+                pan &= ~(((uint32_t)1 << zoom) - 1);
+                showDeep(ui);
+                e->markProcessed();
+                break;
+
+            case KEY_DOWN:
+                freeze = false;
+                e->markProcessed();
+                break;
+
+            case KEY_CLEAR: // long Enter
+                ui->popScreen();
+                e->markProcessed();
+                break;
+            }
+        }
+        else if (e->getType() == EVENT_TYPE_KEY) {
 
             switch (e->getKey()) {
 
@@ -260,6 +399,8 @@ void ScopeScreen::handleEvent(TextUI* ui, Event* e)
                     pwmMode = PWMMODE_PCT;
                 else if (pwmMode == PWMMODE_PCT)
                     pwmMode = PWMMODE_SERVO;
+                else
+                    pretrigger = (pretrigger + PRETRIGGER_STEP) % 100;
                 refresh = true;
                 e->markProcessed();
                 break;
@@ -277,6 +418,9 @@ void ScopeScreen::handleEvent(TextUI* ui, Event* e)
 
             case KEY_DOWN:
                 freeze = !freeze;
+                if (freeze && !pwmMode) {
+                    sendCapture();
+                }
                 e->markProcessed();
                 break;
             }
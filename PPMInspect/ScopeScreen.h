@@ -32,6 +32,12 @@
 
 #define ARRAY_SZ     ((byte)128)
 
+/* Pre-trigger cycles 0, 25, 50, 75 % */
+#define PRETRIGGER_STEP 25
+
+/* Deep capture zoom 1 .. 32 samples per pixel */
+#define DEEP_ZOOM_MAX   5
+
 #define PWMMODE_OFF     0
 #define PWMMODE_SERVO   1
 #define PWMMODE_PCT     2
@@ -41,20 +47,36 @@ class ScopeScreen : public TextUIScreen
 private:
     PPM &ppmH;
 
-    uint8_t resolution = 3; // 100 usec
+    uint8_t resolution = 6; // 100 usec
     uint8_t triggerMode = 0; // free running
     fixfloat1_t triggerLevel = 20; // 2.0V
     uint16_t triggerDelay = 0;
+    uint8_t pretrigger = 0; // percent
     uint8_t oversampling = 0; // disable oversampling
     uint8_t range = 0; // Y Range. Default is 2V/div
     boolean grid = true;
     boolean marker = false;
+    /* Trigger index of the capture shown, 0 without pre-trigger */
+    uint8_t capturePre = 0;
 
     /* This changes display mode from scope to pwm view. */
     uint8_t pwmMode = PWMMODE_OFF;
     boolean refresh = true;
     boolean freeze = false;
 
+    /* Deep capture view. 1 << zoom samples per pixel, first sample shown. */
+    uint8_t zoom = 0;
+    uint32_t pan = 0;
+    uint32_t deepSamples = 0;
+
+    void sendCapture();
+    void scale(uint8_t arr[]);
+    boolean isDeepMode() { return !pwmMode && oversampling == ACQ_OS_DEEP; }
+    /* Slow sample periods scroll continuously, see ScopeAcq.h */
+    boolean isRollMode() { return !pwmMode && oversampling != ACQ_OS_DEEP && resToUSec(resolution) >= SCOPE_ROLL_USEC; }
+    boolean showDeep(TextUI *ui);
+    void panDeep(TextUI *ui, boolean forward);
+
 public:
     ScopeScreen(PPM &ppm);
 
@@ -0,0 +1,219 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "ServoDecoder.h"
+
+/* Times are kept in 16 bit */
+static uint16_t sat16(uint32_t v) {
+
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+void ServoDecoder::reset(uint8_t pins, uint8_t shift) {
+
+    tickShift = shift;
+    timeoutTicks = ((uint32_t)SERVO_TIMEOUT_MSEC * 1000) << shift;
+    lastPins = pins & SERVO_PIN_MASK;
+    risen = 0;
+    skewed = 0;
+    refPeriod = 0;
+}
+
+/* Signed ticks to 0.1 usec, rounded */
+int32_t ServoDecoder::ticksToUs10(int32_t ticks) const {
+
+    int32_t half = (1 << tickShift) / 2;
+
+    return (ticks * 10 + ((ticks < 0) ? -half : half)) / (1 << tickShift);
+}
+
+boolean ServoDecoder::portEdge(servo_t* wSet, uint32_t ticks, uint8_t pins) {
+
+    uint8_t active = wSet->active;
+    uint32_t frames = wSet->frames;
+    uint8_t changed;
+    boolean lost = (pins & SERVO_LOST) != 0;
+
+    if (lost) {
+        /* Edges in between are unknown. Start over with the next rising edges. */
+        risen = 0;
+    }
+
+    expire(wSet, ticks);
+
+    if (!(pins & SERVO_IDLE)) {
+
+        pins &= SERVO_PIN_MASK;
+        changed = pins ^ lastPins;
+        lastPins = pins;
+
+        /* Demultiplex. All pins changed since the last snapshot share its timestamp. */
+        for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+            uint8_t m = 1 << ch;
+
+            if (changed & m) {
+                lastEdge[ch] = ticks;
+                if (lost) {
+                    /* Changed somewhere in the gap, the timestamp is too late */
+                }
+                else if (pins & m) {
+                    rise(wSet, ch, ticks);
+                }
+                else {
+                    fall(wSet, ch, ticks);
+                }
+            }
+        }
+    }
+
+    if (wSet->active != active) {
+        setReference(wSet);
+    }
+
+    if (wSet->active != active || wSet->frames != frames) {
+        rankChannels(wSet);
+        return true;
+    }
+
+    return false;
+}
+
+void ServoDecoder::rise(servo_t* wSet, uint8_t ch, uint32_t ticks) {
+
+    uint8_t m = 1 << ch;
+    uint8_t ref = wSet->reference;
+    servoch_t* c = &wSet->ch[ch];
+
+    if (risen & m) {
+        uint32_t period = ticks - lastRise[ch];
+
+        c->period_usec = sat16(period >> tickShift);
+        wSet->active |= m;
+        if (ch == ref) {
+            refPeriod = period;
+        }
+    }
+    lastRise[ch] = ticks;
+    risen |= m;
+
+    if (!(wSet->active & m) || !(wSet->active & (1 << ref))) {
+        return;
+    }
+
+    if (ch == ref) {
+        wSet->frames++;
+    }
+    else if (risen & (1 << ref)) {
+        int32_t dt = (int32_t)(ticks - lastRise[ref]);
+        int32_t skew;
+
+        /* Closer to the next reference edge, so this channel comes first */
+        if (dt > (int32_t)(refPeriod / 2)) {
+            dt -= refPeriod;
+        }
+        skew = ticksToUs10(dt);
+
+        c->skew_us10 = skew;
+        if (!(skewed & m)) {
+            c->skewMin_us10 = c->skewMax_us10 = skew;
+            skewed |= m;
+        }
+        else if (skew < c->skewMin_us10) {
+            c->skewMin_us10 = skew;
+        }
+        else if (skew > c->skewMax_us10) {
+            c->skewMax_us10 = skew;
+        }
+    }
+}
+
+void ServoDecoder::fall(servo_t* wSet, uint8_t ch, uint32_t ticks) {
+
+    if (risen & (1 << ch)) {
+        /* At most timeoutTicks, see expire() */
+        uint32_t pulse_q4 = (ticks - lastRise[ch]) << (4 - tickShift);
+
+        wSet->ch[ch].pulse_us10 = sat16(PPMDecoder::toUs10(pulse_q4));
+    }
+}
+
+/* Channels without an edge for SERVO_TIMEOUT_MSEC lost their signal */
+void ServoDecoder::expire(servo_t* wSet, uint32_t ticks) {
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        uint8_t m = 1 << ch;
+
+        if (((wSet->active | risen) & m) && (ticks - lastEdge[ch]) > timeoutTicks) {
+            wSet->active &= ~m;
+            risen &= ~m;
+            skewed &= ~m;
+            memset(&wSet->ch[ch], 0, sizeof(servoch_t));
+        }
+    }
+}
+
+/* The lowest active channel. Skews start over when it changes. */
+void ServoDecoder::setReference(servo_t* wSet) {
+
+    uint8_t ref = 0;
+
+    while (ref < SERVO_CHANNELS && !(wSet->active & (1 << ref))) {
+        ref++;
+    }
+
+    if (ref != wSet->reference) {
+        wSet->reference = ref;
+        /* Until its next rising edge */
+        refPeriod = (ref < SERVO_CHANNELS) ? ((uint32_t)wSet->ch[ref].period_usec << tickShift) : 0;
+        skewed = 0;
+        for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+            wSet->ch[ch].skew_us10 = 0;
+            wSet->ch[ch].skewMin_us10 = 0;
+            wSet->ch[ch].skewMax_us10 = 0;
+        }
+    }
+}
+
+/* Output order. The reference and channels with a skew are ranked, ties by channel number. */
+void ServoDecoder::rankChannels(servo_t* wSet) {
+
+    uint8_t ranked = (skewed | (1 << wSet->reference)) & wSet->active;
+
+    for (uint8_t ch = 0; ch < SERVO_CHANNELS; ch++) {
+        uint8_t r = 0;
+
+        if (ranked & (1 << ch)) {
+            r = 1;
+            for (uint8_t o = 0; o < SERVO_CHANNELS; o++) {
+                if ((ranked & (1 << o)) && (wSet->ch[o].skew_us10 < wSet->ch[ch].skew_us10
+                        || (wSet->ch[o].skew_us10 == wSet->ch[ch].skew_us10 && o < ch))) {
+                    r++;
+                }
+            }
+        }
+        wSet->rank[ch] = r;
+    }
+}
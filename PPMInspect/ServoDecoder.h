@@ -0,0 +1,106 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _ServoDecoder_h_
+#define _ServoDecoder_h_
+
+#include "Config.h"
+#include "PPMDecoder.h"
+
+/* Flags above SERVO_PIN_MASK in a port snapshot */
+
+/* Snapshots got dropped before this one because the ring was full */
+#define SERVO_LOST      0x80
+/* Timeout only, the pins were not read. Expires channels. */
+#define SERVO_IDLE      0x40
+
+/* One servo output. Times in 0.1 usec, the period in usec. */
+typedef struct servoch_t {
+
+    uint16_t pulse_us10;      /* Last high time */
+    uint16_t period_usec;     /* Rising edge to rising edge */
+    /* Rising edge after the rising edge of the reference channel.
+     * Negative if it comes before, within +/- half a reference period.
+     */
+    int32_t  skew_us10;
+    int32_t  skewMin_us10;
+    int32_t  skewMax_us10;
+} servoch_t;
+
+typedef struct servo_t {
+
+    uint8_t  active;                  /* Bit per channel with a period */
+    uint8_t  reference;               /* Lowest active channel, only valid if active != 0 */
+    uint8_t  rank[SERVO_CHANNELS];    /* Output order by skew, 1 is first. 0 if inactive. */
+    uint16_t droppedEdges;
+    uint32_t frames;                  /* Periods of the reference channel */
+    servoch_t ch[SERVO_CHANNELS];
+} servo_t;
+
+/*
+ * Hardware independent servo PWM decoder for several inputs.
+ *
+ * The decoder is fed with port snapshots. Each is a timestamp in timer ticks
+ * (see PPMDecoder) and the pin levels, bit n is channel n. Every pin that
+ * differs from the previous snapshot had an edge at that time, so edges of
+ * several channels within one interrupt share one timestamp.
+ *
+ * The lowest active channel is the reference for the skew, the delay between
+ * channel outputs. A set is published once per reference period and when
+ * channels come or go.
+ */
+class ServoDecoder {
+
+    private:
+        uint8_t  tickShift = DECODER_SHIFT_500NS;
+        uint32_t timeoutTicks;
+        /* Pin levels of the previous snapshot */
+        uint8_t  lastPins;
+        /* Channels with a valid lastRise */
+        uint8_t  risen;
+        /* Channels with a skew since the reference changed */
+        uint8_t  skewed;
+        uint32_t lastRise[SERVO_CHANNELS];
+        uint32_t lastEdge[SERVO_CHANNELS];
+        /* Last period of the reference in ticks, skews wrap at half of it */
+        uint32_t refPeriod;
+
+        void rise( servo_t *wSet, uint8_t ch, uint32_t ticks);
+        void fall( servo_t *wSet, uint8_t ch, uint32_t ticks);
+        void expire( servo_t *wSet, uint32_t ticks);
+        void setReference( servo_t *wSet);
+        void rankChannels( servo_t *wSet);
+        int32_t ticksToUs10( int32_t ticks) const;
+
+    public:
+        /* Restart with the pin levels at ticks. shift is DECODER_SHIFT_* */
+        void reset( uint8_t pins, uint8_t shift = DECODER_SHIFT_500NS);
+
+        /* One port snapshot, pins with SERVO_LOST and SERVO_IDLE flags */
+        boolean portEdge( servo_t *wSet, uint32_t ticks, uint8_t pins);
+};
+
+#endif
@@ -0,0 +1,203 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "ServoScreen.h"
+
+#define ROW_COUNT 15
+
+/* Rows of the channel and skew tables */
+#define PULSE_ROW  1
+#define SKEW_ROW   8
+
+/* Skew and range are shown up to +/- 9999.9 usec */
+#define SKEW_MAX_US10  99999L
+
+const char s1[] PROGMEM = "Frames";
+const char s2[] PROGMEM = "D8";
+const char s3[] PROGMEM = "D9";
+const char s4[] PROGMEM = "D10";
+const char s5[] PROGMEM = "D11";
+const char s6[] PROGMEM = "D12";
+const char s7[] PROGMEM = "D13";
+const char s8[] PROGMEM = "Skew";
+const char s9[] PROGMEM = " D8";
+const char s10[] PROGMEM = " D9";
+const char s11[] PROGMEM = " D10";
+const char s12[] PROGMEM = " D11";
+const char s13[] PROGMEM = " D12";
+const char s14[] PROGMEM = " D13";
+const char s15[] PROGMEM = "E: Edges lost";
+
+const char* const ServoScreenRowNames[ROW_COUNT] PROGMEM = {
+    s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12, s13, s14, s15 };
+
+const uint8_t Columns[ROW_COUNT] = {
+    1, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 1 };
+
+static fixfloat1_t clampSkew(int32_t v)
+{
+    return (v > SKEW_MAX_US10) ? SKEW_MAX_US10 : ((v < -SKEW_MAX_US10) ? -SKEW_MAX_US10 : v);
+}
+
+ServoScreen::ServoScreen(PPM& ppm) : ppmH(ppm)
+{
+    update();
+}
+
+void ServoScreen::update()
+{
+    currentData = ppmH.getServo();
+    hasNewData = true;
+}
+
+/* TextUI */
+
+void ServoScreen::activate(TextUI* ui)
+{
+    ppmH.startServoScan();
+}
+
+void ServoScreen::deactivate(TextUI* ui)
+{
+    ppmH.stopScan();
+}
+
+void ServoScreen::handleEvent(TextUI* ui, Event* e)
+{
+    if (e->getType() == EVENT_TYPE_KEY) {
+
+        switch (e->getKey()) {
+        case KEY_CLEAR: // long Enter
+            ui->popScreen();
+            e->markProcessed();
+            break;
+
+        case KEY_RESET: // long Up
+            ppmH.stopScan();
+            delay(500);
+            ppmH.startServoScan();
+            e->markProcessed();
+            break;
+        }
+    }
+    else if (e->getType() == EVENT_TYPE_TIMER) {
+        update();
+    }
+}
+
+const char* ServoScreen::getHeader()
+{
+    return nullptr;
+}
+
+const char* ServoScreen::getMenuName()
+{
+    return TextUI::copyToBuffer((const char*)F("Servo scan"));
+}
+
+uint8_t ServoScreen::getRowCount()
+{
+    return ROW_COUNT;
+}
+
+const char* ServoScreen::getRowName(uint8_t row)
+{
+    return TextUI::copyToBuffer((const char*)pgm_read_ptr(&ServoScreenRowNames[row]));
+}
+
+uint8_t ServoScreen::getColCount(uint8_t row)
+{
+    return Columns[row];
+}
+
+bool ServoScreen::hasChanged(uint8_t row, uint8_t col)
+{
+    return hasNewData;
+}
+
+void ServoScreen::endRefresh()
+{
+    hasNewData = false;
+}
+
+void ServoScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    if (row == 0) {
+        cell->setInt32(11, currentData->frames, 10, 0, 0);
+    }
+    else if (row >= PULSE_ROW && row < PULSE_ROW + SERVO_CHANNELS) {
+        /* Pulse, period and output order */
+        uint8_t ch = row - PULSE_ROW;
+        const servoch_t* c = &currentData->ch[ch];
+
+        if (!(currentData->active & (1 << ch))) {
+            if (col == 0) {
+                cell->setLabel(8, F("---"), 3);
+            }
+            else if (col == 1) {
+                cell->setLabel(14, F("---"), 3);
+            }
+            else {
+                cell->setLabel(20, F(" "), 1);
+            }
+        }
+        else if (col == 0) {
+            cell->setFloat1(4, c->pulse_us10, 7, 0, 0);
+        }
+        else if (col == 1) {
+            cell->setInt16(12, c->period_usec, 5, 0, 0);
+        }
+        else {
+            cell->setInt8(19, currentData->rank[ch], 2, 0, 0);
+        }
+    }
+    else if (row == SKEW_ROW - 1) {
+        cell->setLabel(15, F(" Range"), 6);
+    }
+    else if (row >= SKEW_ROW && row < SKEW_ROW + SERVO_CHANNELS) {
+        /* Skew against the reference channel and its range */
+        uint8_t ch = row - SKEW_ROW;
+        const servoch_t* c = &currentData->ch[ch];
+
+        if (!(currentData->active & (1 << ch)) || currentData->rank[ch] == 0) {
+            if (col == 0) {
+                cell->setLabel(10, F("---"), 3);
+            }
+            else {
+                cell->setLabel(18, F("---"), 3);
+            }
+        }
+        else if (col == 0) {
+            cell->setFloat1(6, clampSkew(c->skew_us10), 7, 0, 0);
+        }
+        else {
+            cell->setFloat1(15, clampSkew(c->skewMax_us10 - c->skewMin_us10), 6, 0, 0);
+        }
+    }
+    else if (row == ROW_COUNT - 1) {
+        cell->setInt16(16, currentData->droppedEdges, 5, 0, 0);
+    }
+}
@@ -0,0 +1,157 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "StreamScreen.h"
+
+#define ROW_COUNT 4
+
+const char s1[] PROGMEM = "PPM";
+const char s2[] PROGMEM = "Packets";
+const char s3[] PROGMEM = "E: Packets drop";
+const char s4[] PROGMEM = "E: Edges lost";
+
+const char* const StreamScreenRowNames[ROW_COUNT] PROGMEM = { s1, s2, s3, s4 };
+
+const uint8_t StreamColumns[ROW_COUNT] = { 3, 1, 1, 1 };
+
+StreamScreen::StreamScreen(PPM& ppm) : ppmH(ppm)
+{
+    update();
+}
+
+void StreamScreen::update()
+{
+    currentData = ppmH.getPPM();
+    currentStream = ppmH.getStream();
+    hasNewData = true;
+}
+
+/* TextUI */
+
+void StreamScreen::activate(TextUI* ui)
+{
+    ppmH.startPPMScan();
+    ppmH.startStream();
+}
+
+void StreamScreen::deactivate(TextUI* ui)
+{
+    ppmH.stopStream();
+    ppmH.stopScan();
+}
+
+const char* StreamScreen::getHeader()
+{
+    return nullptr;
+}
+
+const char* StreamScreen::getMenuName()
+{
+    return TextUI::copyToBuffer((const char*)F("Edge stream"));
+}
+
+uint8_t StreamScreen::getRowCount()
+{
+    return ROW_COUNT;
+}
+
+const char* StreamScreen::getRowName(uint8_t row)
+{
+    return TextUI::copyToBuffer((const char*)pgm_read_ptr(&StreamScreenRowNames[row]));
+}
+
+void StreamScreen::handleEvent(TextUI* ui, Event* e)
+{
+    if (e->getType() == EVENT_TYPE_KEY) {
+
+        switch (e->getKey()) {
+        case KEY_CLEAR: // long Enter
+            ui->popScreen();
+            e->markProcessed();
+            break;
+
+        case KEY_RESET: // long Up
+            ppmH.stopStream();
+            ppmH.stopScan();
+            delay(500);
+            ppmH.startPPMScan();
+            ppmH.startStream();
+            e->markProcessed();
+            break;
+        }
+    }
+    else if (e->getType() == EVENT_TYPE_TIMER) {
+        update();
+    }
+}
+
+uint8_t StreamScreen::getColCount(uint8_t row)
+{
+    return StreamColumns[row];
+}
+
+bool StreamScreen::hasChanged(uint8_t row, uint8_t col)
+{
+    return hasNewData;
+}
+
+void StreamScreen::endRefresh()
+{
+    hasNewData = false;
+}
+
+void StreamScreen::getValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    if (row == 0) {
+        if (col == 0) {
+            cell->setLabel(5, currentData->sync ? F("SYNC") : F("----"), 4);
+        }
+        else if (col == 1) {
+            cell->setInt8(9, currentData->channels, 3, 0, 0);
+        }
+        else {
+            cell->setLabel(13, F("Channels"), 8);
+        }
+    }
+    else if (currentStream == nullptr) {
+        /* Streaming needs ENABLE_EDGE_RING */
+        cell->setLabel(16, F("  n/a"), 5);
+    }
+    else if (row == 1) {
+        cell->setInt32(11, currentStream->packets, 10, 0, 0);
+    }
+    else if (row == 2) {
+        cell->setInt16(16, currentStream->dropped, 5, 0, 0);
+    }
+    else {
+        cell->setInt16(16, currentData->droppedEdges, 5, 0, 0);
+    }
+}
+
+void StreamScreen::setValue(uint8_t row, uint8_t col, Cell* cell)
+{
+    /* noop */
+}
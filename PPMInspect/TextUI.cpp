@@ -135,18 +135,18 @@ Event *TextUI::getEvent() {
 
   if( event.getType() == EVENT_TYPE_NONE ) {
 
-    if( timer_msec && (now >= nextTimer_msec)) {
+    if( timer_msec && (int32_t)(now - nextTimer_msec) >= 0) {
     
       nextTimer_msec += timer_msec;
-      if( nextTimer_msec <= now) {
+      if( (int32_t)(nextTimer_msec - now) <= 0) {
 	nextTimer_msec = now + timer_msec;
       }
       event.setTimerEvent();
     
-    } else if( now >= nextTick_msec ) {
+    } else if( (int32_t)(now - nextTick_msec) >= 0) {
 
       nextTick_msec += EVENT_TICK_msec;
-      if( nextTick_msec <= now) {
+      if( (int32_t)(nextTick_msec - now) <= 0) {
       	nextTick_msec = now + EVENT_TICK_msec;
       }
       event.setTickEvent();
@@ -156,6 +156,22 @@ Event *TextUI::getEvent() {
   return &event;
 }
 
+boolean TextUI::isBusy() {
+
+  return refresh != REFRESH_OK
+    || (CURRENT_SCREEN != nullptr && CURRENT_SCREEN->isBusy());
+}
+
+unsigned long TextUI::nextEventTime() {
+
+  /* Compare differences, millis() wraps after 49.7 days */
+  if( timer_msec && (int32_t)(nextTimer_msec - nextTick_msec) < 0) {
+    return nextTimer_msec;
+  }
+
+  return nextTick_msec;
+}
+
 void TextUI::setReversedNav( boolean v) {
 
   reversedNav = v;
@@ -29,7 +29,17 @@
 
 #include "Arduino.h"
 
+/* Strings in flash memory, F() and __FlashStringHelper.
+ * Other platforms define it when their Arduino.h provides them.
+ */
+#if defined(ARDUINO) && !defined(TEXTUI_FLASH_STRINGS)
+    #define TEXTUI_FLASH_STRINGS
+#endif
+
+/* Define TEXTUI_NO_DEBUG to silence the log on other platforms */
+#ifndef TEXTUI_NO_DEBUG
 #define TEXTUI_DEBUG
+#endif
 
 #ifdef TEXTUI_DEBUG
     #if defined(ARDUINO)
@@ -391,6 +401,7 @@ public:
      * @brief Draw data
      * 
      * @param dataArray data buffer
+     * @param minArray  minimum per sample, drawn as vertical span up to dataArray ( nullptr means off )
      * @param sz        array size
      * @param si        array start index (The array is used round robin)
      * @param x0        start (left)
@@ -399,8 +410,29 @@ public:
      * @param y1        end (bottom)
      * @param grid      grid size ( 0 means off )
      * @param marker    enable draw marker
+     * @param trigX     x of the trigger marker ( 0 means off )
      */
-    virtual void drawGrid( uint8_t dataArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t grid, boolean marker);
+    virtual void drawGrid( uint8_t dataArray[], uint8_t minArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t grid, boolean marker, uint8_t trigX);
+
+    /**
+     * @brief Memory for drawGrid() to remember the last graph.
+     * 
+     * Drivers that redraw only what changed keep 2 bytes per column there.
+     * The content must stay untouched between drawGrid() calls, a different
+     * pointer starts over with a full redraw.
+     * 
+     * @param shadow 2 * 128 bytes ( nullptr redraws the whole graph every time )
+     */
+    virtual void setGridShadow( uint8_t *shadow) {}
+
+    /**
+     * @brief Wait until everything drawn so far is on the display.
+     * 
+     * Drivers with queued transfers return from drawing before the display
+     * is updated. Screens call this before anything that must not be
+     * disturbed by the display interrupt.
+     */
+    virtual void flush() {}
 
     /**
      * @brief Print signed integer.
@@ -544,7 +576,7 @@ public:
      */
     void printStr(const char str[], uint8_t width, int8_t editIdx);
 
-#ifdef ARDUINO
+#ifdef TEXTUI_FLASH_STRINGS
     /**
      * @brief Print character string from flash memory.
      * 
@@ -719,7 +751,7 @@ public:
      * @param sz uint8_t: String buffer size
      */
     void setLabel(uint8_t screenX, const char *v, uint8_t sz);
-#ifdef ARDUINO
+#ifdef TEXTUI_FLASH_STRINGS
     /**
      * @brief Set the cell to a character string label in flash memory.
      * 
@@ -1033,6 +1065,17 @@ public:
      */
     virtual bool needsRefresh() { return false; };
 
+    /**
+     * @brief Screen wants to be called in every loop.
+     * 
+     * If this method returns true the screen gets events of type
+     * EVENT_TYPE_NONE and the main loop does not sleep.
+     * The default implemetation returns 'false'.
+     * 
+     * @returns bool: 'true' while the screen is busy.
+     */
+    virtual bool isBusy() { return false; }
+
     /**
      * @brief Check if a cell value has changed.
      * 
@@ -1406,6 +1449,27 @@ public:
      */
     Event *getEvent();
 
+    /**
+     * @brief Check for work without an event.
+     * 
+     * A pending screen refresh or a busy screen (TextUIScreen::isBusy()).
+     * If getEvent() returned EVENT_TYPE_NONE and this method returns 'false'
+     * handle() has nothing to do. The main loop may sleep until the next
+     * interrupt or nextEventTime().
+     * 
+     * @return boolean: 'true' if handle() should be called.
+     */
+    boolean isBusy();
+
+    /**
+     * @brief Time of the next timer or tick event.
+     * 
+     * millis() wraps, compare (int32_t)(nextEventTime() - millis()).
+     * 
+     * @return unsigned long: millis() of the next event.
+     */
+    unsigned long nextEventTime();
+
     /**
      * @brief Main entry point into user interface processing.
      * 
@@ -139,7 +139,7 @@ void TextUILcd::printStr( const char str[], uint8_t width, int8_t editIdx) {
   } 
 }
 
-#ifdef ARDUINO
+#ifdef TEXTUI_FLASH_STRINGS
 
 void TextUILcd::printStr( const __FlashStringHelper *str) {
   
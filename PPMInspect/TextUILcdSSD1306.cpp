@@ -28,11 +28,16 @@
 
 TextUILcdSSD1306::TextUILcdSSD1306( const DevType *device ) {
 
-#ifdef TEXTUI_LCD_USE_AVRI2C
+#if defined(TEXTUI_LCD_USE_AVRI2C)
 
   delay(100);
   lcd.begin( device, DISPLAY_I2C_ADDRESS);
 
+#elif defined(TEXTUI_LCD_USE_TWIQ)
+
+  /* Without a display the transfers are dropped on NACK */
+  lcd.begin( device, DISPLAY_I2C_ADDRESS);
+
 #else
 
   Wire.begin();
@@ -56,19 +61,29 @@ TextUILcdSSD1306::TextUILcdSSD1306( const DevType *device ) {
 
 void TextUILcdSSD1306::clear() {
 
+  gridValid = false;
   lcd.clear();
 }
 
 void TextUILcdSSD1306::clear( uint8_t x0, uint8_t r0, uint8_t x1, uint8_t r1) {
 
+  touchRows( r0, r1);
   lcd.clear( x0, x1, r0, r1);
 }
 
 void TextUILcdSSD1306::clearEOL() {
 
+  touchRows( lcd.row(), lcd.row() + lcd.fontRows() -1);
   lcd.clearToEOL();
 }
 
+void TextUILcdSSD1306::touchRows( uint8_t r0, uint8_t r1) {
+
+  if( gridValid && r1 >= gridY0 / 8 && r0 <= gridY1 / 8) {
+    gridValid = false;
+  }
+}
+
 bool TextUILcdSSD1306::colorSupport() {
 
   return false;
@@ -101,6 +116,7 @@ void TextUILcdSSD1306::editColors() {
 
 void TextUILcdSSD1306::setInvert( bool inv) {
 
+  invert = inv;
   lcd.setInvertMode( inv);
 }
 
@@ -141,9 +157,55 @@ void TextUILcdSSD1306::setColumn( uint8_t c) {
 
 void TextUILcdSSD1306::printChar( char ch) {
 
+  touchRows( lcd.row(), lcd.row() + lcd.fontRows() -1);
   lcd.write( ch);
 }
 
+void TextUILcdSSD1306::flush() {
+
+#ifdef TEXTUI_LCD_USE_TWIQ
+  lcd.flush();
+#endif
+}
+
+/* Bits of one display row (8 pixel high) covered by a vertical line from d0y to d1y. */
+static uint8_t gridMask( uint8_t row, uint8_t d0y, uint8_t d1y)
+{
+  uint8_t d0Row = d0y / 8;
+  uint8_t d1Row = d1y / 8;
+  uint8_t m;
+
+  if( row == d0Row && d0Row == d1Row) {
+    /* Start (d0y) and end (d1y) are within the same row.
+     * Draw a line from d0y to d1y.
+     */
+    m = 255 - ((1 << (d0y % 8)) -1);
+    m &= (1 << ((d1y % 8) +1)) -1;
+
+  } else if( row == d0Row) {
+    /* Start (d0y) is within row.
+     * Draw a line from d0y to end of row.
+     */
+    m = 255 - ((1 << (d0y % 8)) -1);
+
+  } else if( row == d1Row) {
+    /* End (d1y) is within row.
+     * Draw a line from start to d1y.
+     */
+    m = (1 << ((d1y % 8) +1)) -1;
+
+  } else if (row < d0Row || row > d1Row) {
+      /* Outside of d0y - d1y. */
+      m = 0;
+
+  } else {
+    /* Inside of d0y - d1y. */
+    m = 0xff;
+  }
+
+  return m;
+}
+
 /* Draw a graph optionally with grid.
  * Y grid size is always 8.
  * 
@@ -156,12 +218,19 @@ void TextUILcdSSD1306::printChar( char ch) {
  * y1
  * gridX        - Grid size in X direction, 0 disables grid
  * marker       - Draw update marker 
+ *
+ * With a shadow the span of each column is kept there, see setGridShadow().
+ * Only bytes that differ from the last graph are sent. Changed bytes
+ * less than TEXTUI_GRID_JOIN apart go out as one transfer.
  */
-void TextUILcdSSD1306::drawGrid( uint8_t dataArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t gridX, boolean marker)
+void TextUILcdSSD1306::drawGrid( uint8_t dataArray[], uint8_t minArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t gridX, boolean marker, uint8_t trigX)
 {
   uint8_t m;
+  uint8_t old;
   uint8_t y;
+  uint8_t yMin;
   uint8_t prevY;
+  uint8_t prevYMin;
   uint8_t x;
   uint8_t ii;
 
@@ -169,81 +238,145 @@ void TextUILcdSSD1306::drawGrid( uint8_t dataArray[], uint8_t sz, uint8_t si, ui
   uint8_t endRow;
   uint8_t row;
   
-  uint8_t d0Row;
-  uint8_t d1Row;
   uint8_t d0y;
   uint8_t d1y;
-  
+
+  boolean full;
+  /* Changed byte not yet sent. The last byte of a transfer ends it. */
+  boolean held;
+  uint8_t heldM = 0;
+  /* Unchanged bytes since the last changed one */
+  uint8_t gap;
+  uint8_t gapM[TEXTUI_GRID_JOIN];
+  uint8_t g;
+
+  if( x1 >= TEXTUI_GRID_WIDTH) {
+    x1 = TEXTUI_GRID_WIDTH -1;
+  }
+
   startRow = y0 / 8;
   endRow = y1 / 8;
 
+  full = !gridShadow || !gridValid || x0 != gridX0 || y0 != gridY0 || x1 != gridX1 || y1 != gridY1
+      || gridX != gridSize || trigX != gridTrigX || invert != gridInvert;
+
   for( row = startRow; row <= endRow; row++) {
-    lcd.setCol( x0);
-    lcd.setRow( row);
 
     prevY = y1 - dataArray[si];
+    prevYMin = minArray ? y1 - minArray[si] : prevY;
     ii = 1;
+    held = false;
+    gap = 0;
+
+    for( x = x0; x <= x1; x++) {
 
-    for( x = x0; (x <= x1) && (ii < sz); x++) {
-      y = y1 - dataArray[(si + ii) % sz];
-      ii++;
+      if( ii < sz) {
+        y = y1 - dataArray[(si + ii) % sz];
+        yMin = minArray ? y1 - minArray[(si + ii) % sz] : y;
+        ii++;
 
-      /* Compute row and y value of the vertical line to draw.
-       * d0 has the lower numeric value.
-       */
-      if( y < prevY) {
-        d0y = y; d1y = prevY;
+        /* Compute y values of the vertical line to draw.
+         * d0 has the lower numeric value.
+         * The line covers min to max of this sample and connects to the previous one.
+         */
+        d0y = y;
+        d1y = yMin;
+        if( prevYMin < d0y) {
+          d0y = prevYMin;
+        }
+        if( prevY > d1y) {
+          d1y = prevY;
+        }
+        prevY = y;
+        prevYMin = yMin;
       } else {
-        d0y = prevY; d1y = y;
+        /* Past the data */
+        d0y = d1y = TEXTUI_GRID_NONE;
       }
 
-      d0Row = d0y / 8;
-      d1Row = d1y / 8;
+      m = 0;
+      if( d0y != TEXTUI_GRID_NONE) {
+        m = gridMask( row, d0y, d1y);
+        if( gridX && ((x % gridX) == 0)) {
+          m |= 0b10000000; 
+        }
+        if( trigX && x == trigX) {
+          m |= 0b00010001;
+        }
+      }
 
-      if( row == d0Row && d0Row == d1Row) {
-        /* Start (d0y) and end (d1y) are within the same row.
-         * Draw a line from d0y to d1y.
-         */
-        m = 255 - ((1 << (d0y % 8)) -1);
-        m &= (1 << ((d1y % 8) +1)) -1;
-        
-      } else if( row == d0Row) {
-        /* Start (d0y) is within row.
-         * Draw a line from d0y to end of row.
-         */
-        m = 255 - ((1 << (d0y % 8)) -1);
-        
-      } else if( row == d1Row) {
-        /* End (d1y) is within row.
-         * Draw a line from start to d1y.
-         */
-        m = (1 << ((d1y % 8) +1)) -1;
-        
-      } else if (row < d0Row || row > d1Row) {
-          /* Outside of d0y - d1y. */
-          m = 0;
-          
-      } else {
-        /* Inside of d0y - d1y. */
-        m = 0xff;
+      /* Same for the last graph */
+      old = 0;
+      if( !full && gridShadow[x] != TEXTUI_GRID_NONE) {
+        old = gridMask( row, gridShadow[x], gridShadow[TEXTUI_GRID_WIDTH + x]);
+        if( gridX && ((x % gridX) == 0)) {
+          old |= 0b10000000; 
+        }
+        if( trigX && x == trigX) {
+          old |= 0b00010001;
+        }
+      }
+      if( gridShadow && row == endRow) {
+        gridShadow[x] = d0y;
+        gridShadow[TEXTUI_GRID_WIDTH + x] = d1y;
       }
 
-      if( gridX && ((x % gridX) == 0)) {
-        m |= 0b10000000; 
+      if( row == startRow && x == x1) {
+        /* Update marker */
+        if( marker) {
+          m = 0x0f;
+        }
+        if( gridMarker) {
+          old = 0x0f;
+        }
+      }
+
+      if( full || m != old) {
+        if( held) {
+          /* Join with the open transfer */
+          lcd.ssd1306WriteRamBuf( heldM);
+          for( g = 0; g < gap; g++) {
+            lcd.ssd1306WriteRamBuf( gapM[g]);
+          }
+        } else {
+          lcd.setCol( x);
+          lcd.setRow( row);
+        }
+        held = true;
+        heldM = m;
+        gap = 0;
+
+      } else if( held) {
+        if( gap < TEXTUI_GRID_JOIN) {
+          gapM[gap++] = m;
+        } else {
+          /* Too far, end the transfer */
+          lcd.ssd1306WriteRam( heldM);
+          held = false;
+        }
       }
-        
-      lcd.ssd1306WriteRam( m);
-      prevY = y;
     }
 
-    for( ; x <= x1; x++) {
-      lcd.ssd1306WriteRam( 0);
+    if( held) {
+      lcd.ssd1306WriteRam( heldM);
     }
   }
 
-  if( marker) {
-    lcd.setCol( x1);
-    lcd.setRow( startRow);
-    lcd.ssd1306WriteRam( 0x0f);
+  gridX0 = x0;
+  gridY0 = y0;
+  gridX1 = x1;
+  gridY1 = y1;
+  gridSize = gridX;
+  gridTrigX = trigX;
+  gridMarker = marker;
+  gridInvert = invert;
+  gridValid = true;
+}
+
+void TextUILcdSSD1306::setGridShadow( uint8_t *shadow) {
+
+  if( shadow != gridShadow) {
+    gridShadow = shadow;
+    gridValid = false;
   }
 }
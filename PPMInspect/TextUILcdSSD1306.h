@@ -31,14 +31,34 @@
 
 #undef TEXTUI_LCD_USE_AVRI2C
 
-#ifdef TEXTUI_LCD_USE_AVRI2C
+/* Interrupt driven transfers through SSD1306AsciiTwiQ, drawing does not wait for the bus.
+ * Undefine to use Wire.
+ */
+#ifdef ARDUINO
+  #define TEXTUI_LCD_USE_TWIQ
+#endif
+
+#if defined(TEXTUI_LCD_USE_AVRI2C)
   #include "SSD1306AsciiAvrI2c.h"
+#elif defined(TEXTUI_LCD_USE_TWIQ)
+  #include "SSD1306AsciiTwiQ.h"
 #else
   #include "SSD1306AsciiWire.h"
 #endif
 
 const uint8_t DISPLAY_I2C_ADDRESS = 0x3C;
 
+/* Widest graph drawn by drawGrid() */
+#define TEXTUI_GRID_WIDTH   128
+
+/* Unchanged bytes drawGrid() sends to join two changed spans into one transfer.
+ * Addressing a new span costs 3 command transfers, 9 bytes on the bus.
+ */
+#define TEXTUI_GRID_JOIN      8
+
+/* drawGrid() column without data */
+#define TEXTUI_GRID_NONE   0xff
+
 /**
  * @brief A driver for OLED displays with SSD1306 / SH1106 and similar controller.
  * 
@@ -57,12 +77,31 @@ const uint8_t DISPLAY_I2C_ADDRESS = 0x3C;
 class TextUILcdSSD1306 : public TextUILcd {
 
   private:
-#ifdef TEXTUI_LCD_USE_AVRI2C
+#if defined(TEXTUI_LCD_USE_AVRI2C)
     SSD1306AsciiAvrI2c lcd;
+#elif defined(TEXTUI_LCD_USE_TWIQ)
+    SSD1306AsciiTwiQ lcd;
 #else
     SSD1306AsciiWire lcd;
 #endif
 
+    /* Shadow of the last graph drawn. Vertical span of each column, tops first,
+     * and the settings used. The display content is known as long as gridValid is true.
+     * The memory belongs to the caller, see setGridShadow().
+     */
+    uint8_t *gridShadow = nullptr;
+    uint8_t gridX0, gridY0, gridX1, gridY1;
+    uint8_t gridSize;
+    uint8_t gridTrigX;
+    boolean gridMarker;
+    boolean gridInvert;
+    boolean gridValid = false;
+
+    boolean invert = false;
+
+    /* Anything written to rows r0 - r1 overwrites the graph */
+    void touchRows( uint8_t r0, uint8_t r1);
+
   public:
     /**
      * @brief Construct a new TextUILcdSSD1306 driver.
@@ -102,10 +141,13 @@ class TextUILcdSSD1306 : public TextUILcd {
 
     void printChar( char ch);
 
+    void flush();
+
     /**
      * @brief Draw data
      * 
      * @param dataArray data buffer
+     * @param minArray  minimum per sample, drawn as vertical span up to dataArray ( nullptr means off )
      * @param sz        array size
      * @param si        array start index (The array is used round robin)
      * @param x0        start (left)
@@ -114,8 +156,19 @@ class TextUILcdSSD1306 : public TextUILcd {
      * @param y1        end (bottom)
      * @param grid      grid size ( 0 means off )
      * @param marker    enable draw marker
+     * @param trigX     x of the trigger marker ( 0 means off )
      */
-    void drawGrid( uint8_t dataArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t grid, boolean marker);
+    void drawGrid( uint8_t dataArray[], uint8_t minArray[], uint8_t sz, uint8_t si, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t grid, boolean marker, uint8_t trigX);
+
+    /**
+     * @brief Redraw the whole graph with the next drawGrid().
+     *
+     * drawGrid() only sends the bytes that changed since the last call.
+     * Text and clear() invalidate the graph themselves.
+     */
+    void invalidateGrid() { gridValid = false; }
+
+    void setGridShadow( uint8_t *shadow);
 };
 
 #endif
@@ -0,0 +1,200 @@
+/*
+  TextUI. A simple text based UI.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <util/atomic.h>
+
+#include "TextUIPcintKbd.h"
+
+#define STATE_BIT_PRESSED       0
+#define STATE_BIT_SHORT         1
+#define STATE_BIT_LONG          2
+#define STATE_BIT_REPEAT        3
+
+#define BUTTON_DEBOUNCE_msec           20
+#define BUTTON_LONG_TIMEOUT_msec      250
+#define BUTTON_REPEAT_TIMEOUT_msec   1000
+#define BUTTON_REPEAT_SPEED_msec       50
+
+#define BTN_CLEAR_STATE( b)     buttonState[b] = 0
+
+#define BTN_WAS_PRESSED( b )    (buttonState[b] & 1)
+#define BTN_SHORT_PRESSED( b )  (buttonState[b] & 2)
+#define BTN_LONG_PRESSED( b )   (buttonState[b] & 4)
+#define BTN_SHORT_REPEAT( b )   (buttonState[b] & 8)
+
+/* Written by the ISR */
+static volatile uint8_t kbdPins;
+static volatile bool kbdBouncing = false;
+static volatile unsigned long kbdFirstEdge;
+static volatile unsigned long kbdLastEdge;
+static uint8_t kbdMask;
+
+ISR(PCINT2_vect) {
+
+  uint8_t pins = PIND & kbdMask;
+  unsigned long now;
+
+  if( pins == kbdPins) {
+    return;
+  }
+
+  now = millis();
+  kbdPins = pins;
+  kbdLastEdge = now;
+  if( !kbdBouncing) {
+    kbdFirstEdge = now;
+    kbdBouncing = true;
+  }
+}
+
+TextUIPcintKbd::TextUIPcintKbd(uint8_t count, uint8_t ports[], uint8_t skey[], uint8_t lkey[])
+{
+  buttonCount = count;
+
+  buttonMask = new uint8_t[count];
+  shortKey = new uint8_t[count];
+  memcpy( shortKey, skey, count);
+  longKey = new uint8_t[count];
+  memcpy( longKey, lkey, count);
+
+  buttonState = new uint8_t[count];
+
+  kbdMask = 0;
+  for( uint8_t b = 0; b < buttonCount; b++) {
+    pinMode( ports[b], INPUT_PULLUP);
+    buttonMask[b] = digitalPinToBitMask( ports[b]);
+    kbdMask |= buttonMask[b];
+    BTN_CLEAR_STATE( b);
+  }
+
+  ATOMIC_BLOCK( ATOMIC_RESTORESTATE) {
+    stablePins = kbdPins = PIND & kbdMask;
+    PCMSK2 |= kbdMask;
+    PCIFR = bit(PCIF2);
+    PCICR |= bit(PCIE2);
+  }
+}
+
+bool TextUIPcintKbd::debounce( unsigned long now)
+{
+  bool pend = false;
+  uint8_t pins;
+  uint8_t changed;
+  unsigned long edge;
+
+  ATOMIC_BLOCK( ATOMIC_RESTORESTATE) {
+    if( now - kbdLastEdge < BUTTON_DEBOUNCE_msec) {
+      return false;
+    }
+    pins = kbdPins;
+    edge = kbdFirstEdge;
+    kbdBouncing = false;
+  }
+
+  changed = pins ^ stablePins;
+  stablePins = pins;
+
+  for( uint8_t b = 0; b < buttonCount; b++) {
+
+    if( !(changed & buttonMask[b])) {
+      continue;
+    }
+
+    if( !(pins & buttonMask[b])) {
+      held |= buttonMask[b];
+      if( buttonState[b] == 0) {
+        bitSet( buttonState[b], STATE_BIT_PRESSED);
+        pressedTimeStamp = repeatTimeStamp = edge;
+      }
+    }
+    else {
+      held &= ~buttonMask[b];
+      if( BTN_SHORT_REPEAT( b)) {
+        BTN_CLEAR_STATE( b);
+      }
+      else if( BTN_WAS_PRESSED( b)) {
+        /* Duration from the first edge of the press to the first edge of the release */
+        bitSet( buttonState[b],
+                (edge - pressedTimeStamp > BUTTON_LONG_TIMEOUT_msec)
+                ? STATE_BIT_LONG
+                : STATE_BIT_SHORT);
+        pend = true;
+      }
+    }
+  }
+
+  return pend;
+}
+
+bool TextUIPcintKbd::pending()
+{
+  bool pend = false;
+  unsigned long now;
+
+  /* Nothing happened */
+  if( !kbdBouncing && held == 0) {
+    return false;
+  }
+
+  now = millis();
+
+  if( kbdBouncing) {
+    /* No repeat until the pins are stable, the button may be released */
+    return debounce( now);
+  }
+
+  for( uint8_t b = 0; b < buttonCount; b++) {
+    if( (held & buttonMask[b]) && BTN_WAS_PRESSED( b)
+        && now - pressedTimeStamp > BUTTON_REPEAT_TIMEOUT_msec && now - repeatTimeStamp > BUTTON_REPEAT_SPEED_msec) {
+      repeatTimeStamp = now;
+      bitSet( buttonState[b], STATE_BIT_REPEAT);
+      pend = true;
+    }
+  }
+
+  return pend;
+}
+
+void TextUIPcintKbd::setEvent(Event *e)
+{
+  for( uint8_t b = 0; b < buttonCount; b++) {
+
+    if( BTN_SHORT_PRESSED( b)) {
+      e->setKeyEvent( shortKey[b], 1);
+      BTN_CLEAR_STATE( b);
+      break;
+    }
+    else if( BTN_LONG_PRESSED( b)) {
+      e->setKeyEvent( longKey[b], 1);
+      BTN_CLEAR_STATE( b);
+      break;
+    }
+    else if( BTN_SHORT_REPEAT( b)) {
+      e->setKeyEvent( shortKey[b], 1);
+      break;
+    }
+  }
+}
@@ -0,0 +1,98 @@
+/*
+  TextUI. A simple text based UI.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _TextUIPcintKbd_h_
+#define _TextUIPcintKbd_h_
+
+#include "TextUI.h"
+
+/**
+ * @brief An interrupt driven driver for buttons on port D.
+ * 
+ * Same keys and timing as TextUISimpleKbd: short press, long press
+ * and auto repeat.
+ * 
+ * The pin change interrupt PCINT2 timestamps every edge. A level counts once
+ * it was stable for BUTTON_DEBOUNCE_msec. The press duration is measured
+ * from the first edge of the press to the first edge of the release,
+ * bouncing does not change it.
+ * 
+ * pending() returns right away unless an edge came in or a button is held.
+ * 
+ * All buttons must be on port D (Arduino pins 0 - 7). Only one instance.
+ * 
+ *  Example:   
+ *  
+ *      #include "TextUI.h"
+ *      #include "TextUIPcintKbd.h"
+ * 
+ *      const uint8_t BUTTON_COUNT = 3;
+ *      uint8_t buttons[BUTTON_COUNT] = { 5, 6, 7 };
+ *      uint8_t shortKeys[BUTTON_COUNT] = { KEY_UP, KEY_ENTER, KEY_DOWN };
+ *      uint8_t longKeys[BUTTON_COUNT] = { KEY_NONE, KEY_BACK, KEY_CLEAR };
+ *
+ *      TextUI textUI;
+ *      textUI.setInput( new TextUIPcintKbd( BUTTON_COUNT, buttons, shortKeys, longKeys));
+ */
+class TextUIPcintKbd : public TextUIInput {
+
+  private:
+    uint8_t buttonCount;
+    uint8_t *buttonMask;
+    uint8_t *shortKey;
+    uint8_t *longKey;
+
+    /* A per key bitmap, see TextUISimpleKbd */
+    uint8_t *buttonState;
+
+    /* Debounced pins, a bit is 0 while the button is pressed */
+    uint8_t stablePins;
+    /* Buttons held down */
+    uint8_t held = 0;
+
+    unsigned long pressedTimeStamp = 0;
+    unsigned long repeatTimeStamp = 0;
+
+    /* Take over the pins once they are stable. Returns true on a release. */
+    bool debounce( unsigned long now);
+
+  public:
+    /**
+     * @brief Construct a new TextUIPcintKbd object.
+     * 
+     * @param count uint8_t: Number of elements in ports, skey and lkey arrays
+     * @param ports uint8_t[]: Arduino port numbers, 0 - 7
+     * @param skey uint8_t[]: Event key for short press
+     * @param lkey uint8_t[]: Event key for long press
+     */
+    TextUIPcintKbd( uint8_t count, uint8_t ports[], uint8_t skey[], uint8_t lkey[]);
+
+    /* TextUIInput */
+    bool pending();
+    void setEvent( Event *e);
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*
+  PPMInspect. A PPM signal analysis tool.
+
+  MIT License
+
+  Copyright (c) 2023 wlowi
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef _TwiQueue_h_
+#define _TwiQueue_h_
+
+#include "Arduino.h"
+
+/* Must be a power of 2 */
+#define TWIQ_SIZE           128
+#define TWIQ_MASK           (TWIQ_SIZE - 1)
+
+/* Record header: data or commands and the byte count */
+#define TWIQ_HDR_DATA       0x80
+#define TWIQ_HDR_COUNT      0x7f
+
+/* Kind of byte for put() */
+#define TWIQ_CMD            0x00
+#define TWIQ_DATA           TWIQ_HDR_DATA
+
+/* No open record */
+#define TWIQ_NONE           0xff
+
+/* SSD1306 control byte in front of a transfer */
+#define TWIQ_CONTROL_CMD    0x00
+#define TWIQ_CONTROL_DATA   0x40
+
+/* TWI master transmitter status (TWSR & 0xf8) */
+#define TWIQ_ST_START       0x08
+#define TWIQ_ST_REP_START   0x10
+#define TWIQ_ST_SLA_ACK     0x18
+#define TWIQ_ST_SLA_NACK    0x20
+#define TWIQ_ST_DATA_ACK    0x28
+#define TWIQ_ST_DATA_NACK   0x30
+#define TWIQ_ST_ARB_LOST    0x38
+
+/* What the TWI has to do next */
+#define TWIQ_ACT_START      1
+#define TWIQ_ACT_SEND       2
+#define TWIQ_ACT_STOP       3
+
+/*
+ * Hardware independent part of the interrupt driven display transport.
+ *
+ * put() queues display bytes as records: a header byte and up to 127
+ * bytes of one kind, sent as one I2C transfer with the SSD1306 control
+ * byte in front. The newest record stays open and put() appends to it
+ * until the kind changes, it is full or put() is told it is the last byte.
+ * Consecutive commands share one transfer.
+ *
+ * event() is the TWI state machine, called from the TWI interrupt with
+ * the status code. It returns the next action, for TWIQ_ACT_SEND the
+ * byte is in data. The current record is closed when its last byte
+ * was sent, then the next record follows with a repeated start.
+ * A NACK or lost arbitration drops the rest of the record.
+ *
+ * put(), close() and start() must be called with interrupts disabled.
+ * Records are published byte by byte, nothing waits for a close.
+ */
+class TwiQueue {
+
+    private:
+        uint8_t buf[TWIQ_SIZE];
+        /* Producer: next free byte and header of the open record */
+        volatile uint8_t head = 0;
+        volatile uint8_t open = TWIQ_NONE;
+        /* Consumer: header of the record on the bus and its bytes sent */
+        volatile uint8_t tail = 0;
+        uint8_t sent;
+        uint8_t sla;
+
+        /* Done with the record at tail. Returns the next action. */
+        uint8_t next() {
+
+            uint8_t t = tail;
+
+            if( open == t) {
+                open = TWIQ_NONE;
+            }
+            tail = (t + 1 + (buf[t] & TWIQ_HDR_COUNT)) & TWIQ_MASK;
+
+            if( tail != head) {
+                return TWIQ_ACT_START;
+            }
+
+            busy = false;
+            return TWIQ_ACT_STOP;
+        }
+
+    public:
+        /* A transfer is running. The next put() does not need start(). */
+        volatile bool busy = false;
+        /* Records dropped because of a NACK or lost arbitration */
+        volatile uint16_t errors = 0;
+        /* Byte for TWIQ_ACT_SEND */
+        uint8_t data;
+
+        void begin( uint8_t address) {
+            head = tail = 0;
+            open = TWIQ_NONE;
+            busy = false;
+            errors = 0;
+            sla = address << 1;
+        }
+
+        uint8_t space() const {
+            return TWIQ_SIZE - 1 - ((head - tail) & TWIQ_MASK);
+        }
+
+        bool idle() const { return !busy; }
+
+        /*
+         * Queue one byte of kind TWIQ_CMD or TWIQ_DATA.
+         * last closes the record after this byte.
+         * Returns false if the queue is full.
+         */
+        bool put( uint8_t b, uint8_t kind, bool last) {
+
+            uint8_t h = head;
+            uint8_t o = open;
+
+            if( o == TWIQ_NONE || (buf[o] & TWIQ_HDR_DATA) != kind || (buf[o] & TWIQ_HDR_COUNT) == TWIQ_HDR_COUNT) {
+                if( space() < 2) {
+                    return false;
+                }
+                o = h;
+                buf[o] = kind;
+                h = (h + 1) & TWIQ_MASK;
+            }
+            else if( space() < 1) {
+                return false;
+            }
+
+            buf[h] = b;
+            buf[o]++;
+            head = (h + 1) & TWIQ_MASK;
+            open = last ? TWIQ_NONE : o;
+
+            return true;
+        }
+
+        /* Later bytes start a new record */
+        void close() { open = TWIQ_NONE; }
+
+        /* Returns true if the caller has to send a start condition */
+        bool start() {
+
+            if( busy || head == tail) {
+                return false;
+            }
+            busy = true;
+            return true;
+        }
+
+        uint8_t event( uint8_t status) {
+
+            switch( status) {
+
+            case TWIQ_ST_START:
+            case TWIQ_ST_REP_START:
+                sent = 0;
+                data = sla;
+                return TWIQ_ACT_SEND;
+
+            case TWIQ_ST_SLA_ACK:
+                data = (buf[tail] & TWIQ_HDR_DATA) ? TWIQ_CONTROL_DATA : TWIQ_CONTROL_CMD;
+                return TWIQ_ACT_SEND;
+
+            case TWIQ_ST_DATA_ACK:
+                /* The open record may have grown since the last byte */
+                if( sent < (buf[tail] & TWIQ_HDR_COUNT)) {
+                    data = buf[(tail + 1 + sent) & TWIQ_MASK];
+                    sent++;
+                    return TWIQ_ACT_SEND;
+                }
+                return next();
+
+            default:
+                /* NACK, lost arbitration or bus error */
+                errors++;
+                return next();
+            }
+        }
+};
+
+#endif
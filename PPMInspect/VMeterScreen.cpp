@@ -42,10 +42,13 @@ void VMeterScreen::reset()
 void VMeterScreen::update()
 {
     fixfloat1_t v;
+    boolean ready;
     
-    v = ppmH.readADC();
-    
-    if( v != voltage) {
+    ready = ppmH.fetchADC( ADC_VM, &v);
+    /* The next conversion runs while the loop goes on */
+    ppmH.requestADC( ADC_VM);
+
+    if( ready && v != voltage) {
       voltage = v;
       hasNewData = true;
 
@@ -75,6 +75,9 @@ class VMeterScreen : public TextUIScreen {
     bool hasChanged( uint8_t row, uint8_t col);
     void endRefresh();
 
+    /* Min/max samples in every loop */
+    bool isBusy() { return enableMinMax; }
+
     void getValue( uint8_t row, uint8_t col, Cell *cell);
     void setValue( uint8_t row, uint8_t col, Cell *cell);
 };